@@ -0,0 +1,521 @@
+/**
+ *  <!-- mksqlite: A MATLAB Interface to SQLite -->
+ *
+ *  @file      backup.hpp
+ *  @brief     Throttled online backup in a background thread
+ *  @details   A backup job copies a database file page by page with the
+ *             incremental sqlite3_backup_* API in a worker thread. It uses
+ *             its own read-only connection to the source file, so the
+ *             database slot stays usable meanwhile. Progress is polled,
+ *             a running job can be cancelled. Sidecar segments referenced
+ *             by the copy are copied along (see sidecar.hpp).
+ *  @authors   Martin Kortmann <mail@kortmann.de>,
+ *             Andreas Martin  <andimartin@users.sourceforge.net>
+ *  @version   2.5
+ *  @date      2008-2017
+ *  @copyright Distributed under LGPL
+ *  @pre
+ *  @warning   In rollback journal mode each write to the source restarts
+ *             the backup. In WAL mode the job reads one snapshot, writers
+ *             are not blocked and no restarts occur.
+ *  @bug
+ */
+
+#pragma once
+
+//#include "config.h"
+//#include "sqlite/sqlite3.h"
+//#include "utils.hpp"
+//#include "sidecar.hpp"
+#include <string>
+#include <vector>
+#include <set>
+#include <cstring>
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+  #include "blosc/win32/pthread.h"
+#else
+  #include <pthread.h>
+#endif
+
+
+/**
+ * \brief Incremental backup of one database file
+ */
+class BackupJob
+{
+public:
+    /// Job states
+    enum state_e { BACKUP_RUNNING, BACKUP_DONE, BACKUP_FAILED, BACKUP_CANCELLED };
+
+    /// Snapshot of the job progress
+    struct Status
+    {
+        state_e         state;      ///< Job state
+        int             remaining;  ///< Pages still to be copied
+        int             pagecount;  ///< Total number of pages of the source
+        std::string     errmsg;     ///< Error message if state is BACKUP_FAILED
+
+        Status() : state( BACKUP_RUNNING ), remaining( -1 ), pagecount( -1 ) {}
+    };
+
+private:
+    sqlite3*            m_src;          ///< Source connection (owned if m_thread_started)
+    sqlite3*            m_dest;         ///< Destination connection
+    std::string         m_srcfile;      ///< Source file name (empty for in-memory databases)
+    std::string         m_destfile;     ///< Destination file name
+    int                 m_pages;        ///< Pages copied per step
+    int                 m_sleep_ms;     ///< Pause between two steps
+    bool                m_wal;          ///< Source in WAL mode, hold one read transaction
+    volatile bool       m_cancel;       ///< Cancellation requested
+    bool                m_thread_started;   ///< Worker thread running (must be joined)
+    pthread_t           m_thread;       ///< Worker thread
+    pthread_mutex_t     m_mutex;        ///< Protects m_status
+    Status              m_status;       ///< Current progress
+
+    /// inhibit copy constructor and assignment operator
+    /// @{
+    BackupJob( const BackupJob& );
+    BackupJob& operator=( const BackupJob& );
+    /// @}
+
+public:
+    /// Standard ctor
+    BackupJob() :
+      m_src( NULL ),
+      m_dest( NULL ),
+      m_pages( -1 ),
+      m_sleep_ms( 0 ),
+      m_wal( false ),
+      m_cancel( false ),
+      m_thread_started( false )
+    {
+        pthread_mutex_init( &m_mutex, NULL );
+    }
+
+
+    /// Dtor cancels a running job
+    ~BackupJob()
+    {
+        (void)cancel();
+        closeAll();
+        pthread_mutex_destroy( &m_mutex );
+    }
+
+
+    /**
+     * \brief Start the backup of database \p db into file \p dest
+     *
+     * \param[in] db Source database (a database slot)
+     * \param[in] dest Destination file name (UTF-8), overwritten
+     * \param[in] pages Number of pages copied per step (-1: all)
+     * \param[in] sleep_ms Pause between two steps in milliseconds
+     * \param[out] err Error, if the job could not be started
+     * \returns true if the job was started
+     *
+     * File databases are copied by a worker thread. In-memory databases
+     * have no file to open a second connection on, they are copied at
+     * once by the calling thread.
+     * Sidecar segments referenced by the copy are copied after the pages
+     * (\p dest + "-segNNNN").
+     */
+    bool start( sqlite3* db, const char* dest, int pages, int sleep_ms, SQLerror& err )
+    {
+        const char* filename = sqlite3_db_filename( db, "main" );
+        int rc;
+
+        m_pages    = pages > 0 ? pages : -1;
+        m_sleep_ms = sleep_ms > 0 ? sleep_ms : 0;
+
+        rc = sqlite3_open_v2( dest, &m_dest, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL );
+
+        if( SQLITE_OK != rc )
+        {
+            err.setSqlError( m_dest, rc );
+            closeAll();
+            return false;
+        }
+
+        sqlite3_extended_result_codes( m_dest, true );
+        m_destfile = sqlite3_db_filename( m_dest, "main" );
+
+        if( !filename || !*filename )
+        {
+            // in-memory source: copy synchronously by the slot's connection
+            m_src   = db;
+            m_pages = -1;
+            run();
+            m_src = NULL;
+            closeAll();
+            return true;
+        }
+
+        m_srcfile = filename;
+        rc = sqlite3_open_v2( filename, &m_src, SQLITE_OPEN_READONLY, NULL );
+
+        if( SQLITE_OK != rc )
+        {
+            err.setSqlError( m_src, rc );
+            closeAll();
+            return false;
+        }
+
+        sqlite3_extended_result_codes( m_src, true );
+        sqlite3_busy_timeout( m_src, CONFIG_BUSYTIMEOUT );
+        m_wal = isWal( m_src );
+
+        if( 0 != pthread_create( &m_thread, NULL, &BackupJob::worker, this ) )
+        {
+            err.set( MSG_ERRINTERNAL );
+            closeAll();
+            return false;
+        }
+
+        m_thread_started = true;
+        return true;
+    }
+
+
+    /**
+     * \brief Copy a database file into database \p db (synchronously)
+     *
+     * Sidecar segments referenced are copied to the names of the destination
+     * file. A source holding sidecar references can't be restored into an
+     * in-memory database, since the references would not resolve there.
+     *
+     * \param[in] db Destination database (a database slot, e.g. in-memory)
+     * \param[in] src Source file name (UTF-8)
+     * \param[in,out] sidecar Sidecar storage of \p db
+     * \param[out] err Error, if any
+     * \returns Number of copied pages, or -1 on error
+     */
+    static int restore( sqlite3* db, const char* src, SidecarStore& sidecar, SQLerror& err )
+    {
+        sqlite3*        srcdb   = NULL;
+        sqlite3_backup* backup  = NULL;
+        const char*     dbfile  = sqlite3_db_filename( db, "main" );
+        std::string     srcfile;
+        std::string     destfile( dbfile ? dbfile : "" );
+        int             pages   = -1;
+        int             rc      = sqlite3_open_v2( src, &srcdb, SQLITE_OPEN_READONLY, NULL );
+
+        if( SQLITE_OK != rc )
+        {
+            err.setSqlError( srcdb, rc );
+            sqlite3_close( srcdb );
+            return -1;
+        }
+
+        sqlite3_busy_timeout( srcdb, CONFIG_BUSYTIMEOUT );
+        srcfile = sqlite3_db_filename( srcdb, "main" );
+
+        if( destfile.empty() )
+        {
+            std::set<uint32_t> referenced;
+
+            (void)SidecarStore::referencedSegments( srcdb, referenced );
+
+            if( !referenced.empty() )
+            {
+                err.set( MSG_SIDECARNOFILE );
+                sqlite3_close( srcdb );
+                return -1;
+            }
+        }
+
+        backup = sqlite3_backup_init( db, "main", srcdb, "main" );
+
+        if( !backup )
+        {
+            err.setSqlError( db, sqlite3_errcode( db ) );
+            sqlite3_close( srcdb );
+            return -1;
+        }
+
+        (void)sqlite3_backup_step( backup, -1 );
+        pages = sqlite3_backup_pagecount( backup );
+        rc    = sqlite3_backup_finish( backup );
+
+        if( SQLITE_OK != rc )
+        {
+            err.setSqlError( db, rc );
+            pages = -1;
+        }
+        else if( !destfile.empty() )
+        {
+            // segments may be overwritten, the one currently written has to be reopened
+            size_t  threshold = sidecar.threshold();
+            int     err_id;
+
+            sidecar.detach();
+            err_id = SidecarStore::copySegments( db, srcfile, destfile );
+            (void)sidecar.attach( threshold );
+
+            if( MSG_NOERROR != err_id )
+            {
+                err.set( err_id );
+                pages = -1;
+            }
+        }
+
+        sqlite3_close( srcdb );
+        return pages;
+    }
+
+
+    /// Get a snapshot of the progress
+    Status status()
+    {
+        pthread_mutex_lock( &m_mutex );
+        Status status = m_status;
+        pthread_mutex_unlock( &m_mutex );
+
+        return status;
+    }
+
+
+    /// Returns true if the job has finished (done, failed or cancelled)
+    bool finished()
+    {
+        return status().state != BACKUP_RUNNING;
+    }
+
+
+    /**
+     * \brief Cancel a running job and wait for the worker thread
+     *
+     * The destination file is left incomplete. A finished job is not
+     * changed. Returns the final status.
+     */
+    Status cancel()
+    {
+        m_cancel = true;
+
+        if( m_thread_started )
+        {
+            pthread_join( m_thread, NULL );
+            m_thread_started = false;
+        }
+
+        return status();
+    }
+
+
+private:
+    /// Thread function
+    static void* worker( void* arg )
+    {
+        BackupJob* self = (BackupJob*)arg;
+
+        self->run();
+        self->closeAll();
+
+        return NULL;
+    }
+
+
+    /// Copy all pages, step by step
+    void run()
+    {
+        sqlite3_backup* backup  = NULL;
+        state_e         state   = BACKUP_DONE;
+        std::string     errmsg;
+        int             rc;
+
+        // WAL mode: one read transaction keeps the snapshot, concurrent
+        // writes on other connections go to the WAL and don't restart the copy
+        if( m_wal && SQLITE_OK != sqlite3_exec( m_src, "BEGIN; SELECT count(*) FROM sqlite_master;", NULL, NULL, NULL ) )
+        {
+            m_wal = false;
+        }
+
+        backup = sqlite3_backup_init( m_dest, "main", m_src, "main" );
+
+        if( !backup )
+        {
+            setFinal( BACKUP_FAILED, sqlite3_errmsg( m_dest ) );
+            endRead();
+            return;
+        }
+
+        for( ;; )
+        {
+            rc = sqlite3_backup_step( backup, m_pages );
+
+            pthread_mutex_lock( &m_mutex );
+            m_status.remaining = sqlite3_backup_remaining( backup );
+            m_status.pagecount = sqlite3_backup_pagecount( backup );
+            pthread_mutex_unlock( &m_mutex );
+
+            if( SQLITE_DONE == rc )
+            {
+                break;
+            }
+
+            if( SQLITE_OK != rc && SQLITE_BUSY != rc && SQLITE_LOCKED != rc )
+            {
+                state = BACKUP_FAILED;
+                break;
+            }
+
+            if( m_cancel )
+            {
+                state = BACKUP_CANCELLED;
+                break;
+            }
+
+            if( m_sleep_ms > 0 )
+            {
+                ::utils_sleep_ms( m_sleep_ms );
+            }
+        }
+
+        rc = sqlite3_backup_finish( backup );
+
+        if( BACKUP_DONE == state && SQLITE_OK != rc )
+        {
+            state = BACKUP_FAILED;
+        }
+
+        if( BACKUP_FAILED == state )
+        {
+            errmsg = sqlite3_errmsg( m_dest );
+        }
+
+        endRead();
+
+        // the copy refers to segments named after the destination file
+        if( BACKUP_DONE == state && !m_srcfile.empty() )
+        {
+            int err_id = SidecarStore::copySegments( m_dest, m_srcfile, m_destfile );
+
+            if( MSG_NOERROR != err_id )
+            {
+                state  = BACKUP_FAILED;
+                errmsg = ::getLocaleMsg( err_id );
+            }
+        }
+
+        setFinal( state, errmsg.c_str() );
+    }
+
+
+    /// Set final state
+    void setFinal( state_e state, const char* errmsg )
+    {
+        pthread_mutex_lock( &m_mutex );
+        m_status.state  = state;
+        m_status.errmsg = errmsg ? errmsg : "";
+        pthread_mutex_unlock( &m_mutex );
+    }
+
+
+    /// End the read transaction opened in WAL mode
+    void endRead()
+    {
+        if( m_wal )
+        {
+            (void)sqlite3_exec( m_src, "COMMIT;", NULL, NULL, NULL );
+        }
+    }
+
+
+    /// Close own connections
+    void closeAll()
+    {
+        sqlite3_close( m_src );
+        sqlite3_close( m_dest );
+        m_src  = NULL;
+        m_dest = NULL;
+    }
+
+
+    /// Returns true if the journal mode of \p db is WAL
+    static bool isWal( sqlite3* db )
+    {
+        sqlite3_stmt* stmt = NULL;
+        bool wal = false;
+
+        if( SQLITE_OK == sqlite3_prepare_v2( db, "PRAGMA journal_mode;", -1, &stmt, NULL )
+            && SQLITE_ROW == sqlite3_step( stmt ) )
+        {
+            const char* mode = (const char*)sqlite3_column_text( stmt, 0 );
+            wal = mode && 0 == strcmp( mode, "wal" );
+        }
+
+        sqlite3_finalize( stmt );
+        return wal;
+    }
+};
+
+
+/**
+ * \brief Backup jobs, referenced by handles (1-based)
+ */
+class BackupJobs
+{
+    std::vector<BackupJob*> m_jobs;    ///< Jobs, NULL if released
+
+public:
+    /// Dtor cancels all jobs
+    ~BackupJobs()
+    {
+        (void)releaseAll();
+    }
+
+
+    /// Take ownership of \p job, returns its handle
+    int add( BackupJob* job )
+    {
+        for( size_t i = 0; i < m_jobs.size(); i++ )
+        {
+            if( !m_jobs[i] )
+            {
+                m_jobs[i] = job;
+                return (int)i + 1;
+            }
+        }
+
+        m_jobs.push_back( job );
+        return (int)m_jobs.size();
+    }
+
+
+    /// Get job by handle, NULL if invalid
+    BackupJob* get( int handle )
+    {
+        return handle > 0 && handle <= (int)m_jobs.size() ? m_jobs[handle - 1] : NULL;
+    }
+
+
+    /// Cancel (if running) and delete a job
+    void release( int handle )
+    {
+        BackupJob* job = get( handle );
+
+        if( job )
+        {
+            delete job;
+            m_jobs[handle - 1] = NULL;
+        }
+    }
+
+
+    /// Cancel and delete all jobs, returns the number of running jobs cancelled
+    int releaseAll()
+    {
+        int nRunning = 0;
+
+        for( size_t i = 0; i < m_jobs.size(); i++ )
+        {
+            if( m_jobs[i] )
+            {
+                nRunning += m_jobs[i]->finished() ? 0 : 1;
+                delete m_jobs[i];
+            }
+        }
+
+        m_jobs.clear();
+        return nRunning;
+    }
+};
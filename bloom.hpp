@@ -0,0 +1,341 @@
+/**
+ *  <!-- mksqlite: A MATLAB Interface to SQLite -->
+ *
+ *  @file      bloom.hpp
+ *  @brief     Blocked Bloom filters for semi-join prefiltering
+ *  @details   The SQL aggregate bloom_build(x, fp_rate) returns a Bloom
+ *             filter of all values x as typed BLOB (uint8 row vector).
+ *             bloom_contains(filter, x) probes it, false positives occur
+ *             at the given rate, false negatives never. A filter bound as
+ *             parameter is decoded once per statement.
+ *             Each value sets 8 bits in one block of 256 bits (one bit in
+ *             each 32 bit word), so a probe touches one cache line and the
+ *             8 word tests are independent (vectorized by the compiler).
+ *  @see       https://github.com/apache/parquet-format/blob/master/BloomFilter.md
+ *             (split block Bloom filter)
+ *  @authors   Martin Kortmann <mail@kortmann.de>,
+ *             Andreas Martin  <andimartin@users.sourceforge.net>
+ *  @version   2.5
+ *  @date      2008-2017
+ *  @copyright Distributed under LGPL
+ *  @pre
+ *  @warning   Values are hashed as by approx_count_distinct(), so 1 and 1.0
+ *             match, but '1' (text) doesn't.
+ *  @bug
+ */
+
+#pragma once
+
+//#include "config.h"
+//#include "sqlite/sqlite3.h"
+//#include "sketches.hpp"
+#include <string>
+#include <vector>
+#include <cmath>
+
+#define BLOOM_MAGIC             "BLM1"      ///< Identifies a serialized Bloom filter
+#define BLOOM_MAGIC_LEN         4           ///< Length of the identifier above
+#define BLOOM_BLOCK_WORDS       8           ///< 32 bit words per block (256 bits)
+#define BLOOM_MAX_BLOCKS        ( 1 << 24 ) ///< Filter size limit (512 MiB)
+
+
+/**
+ * \brief Split block Bloom filter
+ */
+class BloomFilter
+{
+    std::vector<uint32_t>   m_words;    ///< Blocks of BLOOM_BLOCK_WORDS words
+    uint64_t                m_blocks;   ///< Number of blocks
+
+public:
+    /// Ctor
+    explicit BloomFilter( uint64_t blocks = 1 )
+    : m_words( (size_t)blocks * BLOOM_BLOCK_WORDS, 0 ), m_blocks( blocks )
+    {
+    }
+
+
+    /// Number of blocks for \p n values at false positive rate \p fp_rate
+    static uint64_t blocksFor( double n, double fp_rate )
+    {
+        // each word is a Bloom filter with one hash function for the values of its block
+        double bits   = -(double)BLOOM_BLOCK_WORDS * std::max( n, 1.0 ) / log( 1.0 - pow( fp_rate, 1.0 / BLOOM_BLOCK_WORDS ) );
+        double blocks = std::max( ceil( bits / ( 32 * BLOOM_BLOCK_WORDS ) ), 1.0 );
+
+        // blocks are loaded unevenly, grow until the expected rate is kept
+        while( blocks < BLOOM_MAX_BLOCKS && expectedRate( n, blocks ) > fp_rate )
+        {
+            blocks = ceil( blocks * 1.05 );
+        }
+
+        return (uint64_t)std::min( blocks, (double)BLOOM_MAX_BLOCKS );
+    }
+
+
+    /// Expected false positive rate for \p n values in \p blocks blocks
+    static double expectedRate( double n, double blocks )
+    {
+        double lambda = n / blocks;     // mean number of values per block (Poisson distributed)
+        double p      = exp( -lambda ); // probability of k values in a block
+        double rate   = 0.0;
+        int    kmax   = (int)( lambda + 10 * sqrt( lambda ) + 20 );
+
+        for( int k = 0; k <= kmax; k++ )
+        {
+            rate += p * pow( 1.0 - pow( 1.0 - 1.0 / 32, k ), BLOOM_BLOCK_WORDS );
+            p    *= lambda / ( k + 1 );
+        }
+
+        return rate;
+    }
+
+
+    /// Add a hashed value
+    void add( uint64_t h )
+    {
+        uint32_t* block = &m_words[blockIndex( h ) * BLOOM_BLOCK_WORDS];
+        uint32_t  mask[BLOOM_BLOCK_WORDS];
+
+        masks( h, mask );
+
+        for( int i = 0; i < BLOOM_BLOCK_WORDS; i++ )
+        {
+            block[i] |= mask[i];
+        }
+    }
+
+
+    /// Returns true if the hashed value may be in the set, false if it isn't
+    bool contains( uint64_t h ) const
+    {
+        const uint32_t* block = &m_words[blockIndex( h ) * BLOOM_BLOCK_WORDS];
+        uint32_t        mask[BLOOM_BLOCK_WORDS];
+        uint32_t        missing = 0;
+
+        masks( h, mask );
+
+        // no early exit, the loop compiles to a few vector instructions
+        for( int i = 0; i < BLOOM_BLOCK_WORDS; i++ )
+        {
+            missing |= mask[i] & ~block[i];
+        }
+
+        return 0 == missing;
+    }
+
+
+    /// Serialize: magic, number of blocks, words (little endian)
+    void serialize( std::string& out ) const
+    {
+        out.assign( BLOOM_MAGIC, BLOOM_MAGIC_LEN );
+        out.reserve( BLOOM_MAGIC_LEN + 4 + m_words.size() * 4 );
+        SketchCodec::putUint( out, m_blocks, 4 );
+
+        for( size_t i = 0; i < m_words.size(); i++ )
+        {
+            SketchCodec::putUint( out, m_words[i], 4 );
+        }
+    }
+
+
+    /// Deserialize, returns false if \p in is no valid Bloom filter
+    bool deserialize( const std::string& in )
+    {
+        size_t   pos = BLOOM_MAGIC_LEN;
+        uint64_t blocks;
+
+        if(    0 != in.compare( 0, BLOOM_MAGIC_LEN, BLOOM_MAGIC )
+            || !SketchCodec::getUint( in, pos, 4, blocks ) || !blocks || blocks > BLOOM_MAX_BLOCKS
+            || in.size() != pos + blocks * BLOOM_BLOCK_WORDS * 4 )
+        {
+            return false;
+        }
+
+        std::vector<uint32_t> words( (size_t)blocks * BLOOM_BLOCK_WORDS );
+
+        for( size_t i = 0; i < words.size(); i++ )
+        {
+            uint64_t word;
+
+            if( !SketchCodec::getUint( in, pos, 4, word ) )
+            {
+                return false;
+            }
+            words[i] = (uint32_t)word;
+        }
+
+        m_blocks = blocks;
+        m_words.swap( words );
+
+        return true;
+    }
+
+
+    /// Destructor function for sqlite3_set_auxdata()
+    static void destroy( void* p )
+    {
+        delete (BloomFilter*)p;
+    }
+
+
+private:
+    /// Block of a hash (upper 32 bits, multiply-shift instead of modulo)
+    size_t blockIndex( uint64_t h ) const
+    {
+        return (size_t)( ( ( h >> 32 ) * m_blocks ) >> 32 );
+    }
+
+
+    /// One bit per word from the lower 32 bits of the hash
+    static void masks( uint64_t h, uint32_t* mask )
+    {
+        static const uint32_t salt[BLOOM_BLOCK_WORDS] = {
+            0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+            0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+        };
+        uint32_t key = (uint32_t)h;
+
+        for( int i = 0; i < BLOOM_BLOCK_WORDS; i++ )
+        {
+            mask[i] = 1U << ( ( key * salt[i] ) >> 27 );
+        }
+    }
+};
+
+
+/**
+ * \brief SQL functions on Bloom filters
+ */
+class BloomFunctions
+{
+    /// State of bloom_build()
+    struct BuildState
+    {
+        double                  fp_rate;    ///< False positive rate (from first row)
+        std::vector<uint64_t>   hashes;     ///< Hashes of all values (filter size is known at the end)
+    };
+
+public:
+    /// Register all functions at \p db
+    static void attach( sqlite3* db )
+    {
+        sqlite3_create_function( db, "bloom_build", 2, SQLITE_UTF8, NULL, NULL, buildStep, buildFinal );
+        sqlite3_create_function( db, "bloom_contains", 2, SQLITE_UTF8, NULL, contains, NULL, NULL );
+    }
+
+
+private:
+    /// Step of bloom_build()
+    static void buildStep( sqlite3_context* ctx, int argc, sqlite3_value** argv )
+    {
+        BuildState** pp = (BuildState**)sqlite3_aggregate_context( ctx, (int)sizeof( BuildState* ) );
+
+        if( !pp )
+        {
+            sqlite3_result_error_nomem( ctx );
+            return;
+        }
+
+        if( !*pp )
+        {
+            double fp_rate = sqlite3_value_double( argv[1] );
+
+            if( SQLITE_NULL == sqlite3_value_type( argv[1] ) || !( fp_rate > 0.0 && fp_rate < 1.0 ) )
+            {
+                sqlite3_result_error( ctx, "bloom_build(): false positive rate must be in the range 0..1!", -1 );
+                return;
+            }
+
+            *pp = new BuildState();
+            (*pp)->fp_rate = fp_rate;
+        }
+
+        if( SQLITE_NULL != sqlite3_value_type( argv[0] ) )
+        {
+            (*pp)->hashes.push_back( SketchCodec::hashValue( argv[0] ) );
+        }
+    }
+
+
+    /// Final of bloom_build()
+    static void buildFinal( sqlite3_context* ctx )
+    {
+        BuildState** pp = (BuildState**)sqlite3_aggregate_context( ctx, 0 );
+        std::string  out;
+
+        if( !pp || !*pp )
+        {
+            // no rows: empty filter
+            BloomFilter().serialize( out );
+        }
+        else
+        {
+            BloomFilter filter( BloomFilter::blocksFor( (double)(*pp)->hashes.size(), (*pp)->fp_rate ) );
+
+            for( size_t i = 0; i < (*pp)->hashes.size(); i++ )
+            {
+                filter.add( (*pp)->hashes[i] );
+            }
+
+            filter.serialize( out );
+            delete *pp;
+            *pp = NULL;
+        }
+
+        SketchCodec::resultBlob( ctx, out );
+    }
+
+
+    /**
+     * \brief bloom_contains(filter, x): 1 if x may be in the set, 0 if not
+     *
+     * The decoded filter is kept as auxiliary data of the argument, so a
+     * constant (bound) filter is decoded once per statement. Probes don't
+     * allocate memory.
+     */
+    static void contains( sqlite3_context* ctx, int argc, sqlite3_value** argv )
+    {
+        BloomFilter* filter = (BloomFilter*)sqlite3_get_auxdata( ctx, 0 );
+        BloomFilter* owned  = NULL;
+
+        if( SQLITE_NULL == sqlite3_value_type( argv[0] ) || SQLITE_NULL == sqlite3_value_type( argv[1] ) )
+        {
+            sqlite3_result_null( ctx );
+            return;
+        }
+
+        if( !filter )
+        {
+            std::string in;
+
+            owned = new BloomFilter();
+
+            if( !SketchCodec::fromBlob( argv[0], in ) || !owned->deserialize( in ) )
+            {
+                sqlite3_result_error( ctx, "bloom_contains(): argument is no Bloom filter!", -1 );
+                delete owned;
+                return;
+            }
+
+            // SQLite owns the filter now and may drop it at once (out of memory)
+            sqlite3_set_auxdata( ctx, 0, owned, BloomFilter::destroy );
+            filter = (BloomFilter*)sqlite3_get_auxdata( ctx, 0 );
+
+            if( filter )
+            {
+                owned = NULL;
+            }
+            else
+            {
+                // filter released by SQLite, decode a temporary copy
+                owned = new BloomFilter();
+                owned->deserialize( in );
+                filter = owned;
+            }
+        }
+
+        sqlite3_result_int( ctx, filter->contains( SketchCodec::hashValue( argv[1] ) ) ? 1 : 0 );
+
+        delete owned;
+    }
+};
@@ -52,6 +52,15 @@
   #include <pthread.h>
 #endif
 
+#if defined(_WIN32) && defined(__MINGW32__)
+  #include <windows.h>
+#elif defined(__APPLE__)
+  #include <sys/sysctl.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #include <cpuid.h>
+#endif
+
 
 /* Some useful units */
 #define KB 1024
@@ -63,8 +72,10 @@
 /* The maximum number of splits in a block for compression */
 #define MAX_SPLITS 16            /* Cannot be larger than 128 */
 
-/* The size of L1 cache.  32 KB is quite common nowadays. */
-#define L1 (32*KB)
+/* The size of L1 and L2 (data) caches.  Detected at blosc_init(), the
+   defaults are used if detection fails. */
+static int32_t L1 = 32*KB;
+static int32_t L2 = 256*KB;
 
 /* Wrapped function to adjust the number of threads used by blosc */
 int blosc_set_nthreads_(int);
@@ -370,6 +381,11 @@ static int blosc_c(int32_t blocksize, int32_t leftoverblock,
     shuffle(typesize, blocksize, src, tmp);
     _tmp = tmp;
   }
+  else if (params.flags & BLOSC_DOBITSHUFFLE) {
+    /* Bitshuffle this block */
+    bitshuffle(typesize, blocksize, src, tmp);
+    _tmp = tmp;
+  }
   else {
     _tmp = src;
   }
@@ -477,7 +493,8 @@ static int blosc_d(int32_t blocksize, int32_t leftoverblock,
   int compressor_format;
   const char *strclib;
 
-  if ((params.flags & BLOSC_DOSHUFFLE) && (typesize > 1)) {
+  if (((params.flags & BLOSC_DOSHUFFLE) && (typesize > 1)) ||
+      (params.flags & BLOSC_DOBITSHUFFLE)) {
     _tmp = tmp;
   }
   else {
@@ -562,6 +579,9 @@ static int blosc_d(int32_t blocksize, int32_t leftoverblock,
       }
     }
   }
+  else if (params.flags & BLOSC_DOBITSHUFFLE) {
+    bitunshuffle(typesize, blocksize, tmp, dest);
+  }
 
   /* Return the number of uncompressed bytes */
   return ntbytes;
@@ -829,6 +849,14 @@ static int32_t compute_blocksize(int32_t clevel, int32_t typesize,
     blocksize = blocksize / typesize * typesize;
   }
 
+  /* With several threads, each block and its shuffle and compression
+     buffers should stay in the L2 cache of the core working on it */
+  if (!force_blocksize && nthreads > 1 && blocksize > L2 / 2 &&
+      L2 / 2 >= L1) {
+    blocksize = L2 / 2;
+    blocksize = blocksize / typesize * typesize;
+  }
+
   /* blocksize must not exceed (64 KB * typesize) in order to allow
      BloscLZ to achieve better compression ratios (the ultimate reason
      for this is that hash_log in BloscLZ cannot be larger than 15) */
@@ -879,8 +907,8 @@ int blosc_compress(int clevel, int doshuffle, size_t typesize, size_t nbytes,
   }
 
   /* Shuffle */
-  if (doshuffle != 0 && doshuffle != 1) {
-    fprintf(stderr, "`shuffle` parameter must be either 0 or 1!\n");
+  if (doshuffle < BLOSC_NOSHUFFLE || doshuffle > BLOSC_BITSHUFFLE) {
+    fprintf(stderr, "`shuffle` parameter must be either 0, 1 or 2!\n");
     return -10;
   }
 
@@ -954,6 +982,10 @@ int blosc_compress(int clevel, int doshuffle, size_t typesize, size_t nbytes,
     /* Shuffle is active */
     *flags |= BLOSC_DOSHUFFLE;          /* bit 0 set to one in flags */
   }
+  else if (doshuffle == BLOSC_BITSHUFFLE) {
+    /* Bitshuffle is active */
+    *flags |= BLOSC_DOBITSHUFFLE;       /* bit 2 set to one in flags */
+  }
 
   *flags |= compressor_format << 5;        /* compressor format start at bit 5 */
 
@@ -1466,12 +1498,113 @@ static int init_threads(void)
   return(0);
 }
 
+/* Detect the sizes of the L1 and L2 data caches of the first CPU */
+static void detect_cache_sizes(void)
+{
+  size_t l1 = 0, l2 = 0;
+
+#if defined(_WIN32)
+  SYSTEM_LOGICAL_PROCESSOR_INFORMATION* info = NULL;
+  DWORD len = 0, i;
+
+  if (!GetLogicalProcessorInformation(NULL, &len) &&
+      GetLastError() == ERROR_INSUFFICIENT_BUFFER &&
+      (info = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION*)malloc(len)) != NULL) {
+    if (GetLogicalProcessorInformation(info, &len)) {
+      for (i = 0; i < len / sizeof(*info); i++) {
+        if (info[i].Relationship != RelationCache ||
+            info[i].Cache.Type == CacheInstruction) continue;
+        if (info[i].Cache.Level == 1 && !l1) l1 = info[i].Cache.Size;
+        if (info[i].Cache.Level == 2 && !l2) l2 = info[i].Cache.Size;
+      }
+    }
+    free(info);
+  }
+#elif defined(__APPLE__)
+  uint64_t value = 0;
+  size_t size = sizeof(value);
+
+  if (sysctlbyname("hw.l1dcachesize", &value, &size, NULL, 0) == 0) l1 = (size_t)value;
+  size = sizeof(value);
+  if (sysctlbyname("hw.l2cachesize", &value, &size, NULL, 0) == 0) l2 = (size_t)value;
+#elif defined(__linux__)
+  char path[64], type[32];
+  int i, level;
+  unsigned long size;
+  FILE* f;
+
+  for (i = 0; i < 8; i++) {
+    level = 0; size = 0; type[0] = 0;
+    sprintf(path, "/sys/devices/system/cpu/cpu0/cache/index%d/level", i);
+    if ((f = fopen(path, "r")) == NULL) break;
+    if (fscanf(f, "%d", &level) != 1) level = 0;
+    fclose(f);
+    sprintf(path, "/sys/devices/system/cpu/cpu0/cache/index%d/type", i);
+    if ((f = fopen(path, "r")) != NULL) {
+      if (fscanf(f, "%31s", type) != 1) type[0] = 0;
+      fclose(f);
+    }
+    sprintf(path, "/sys/devices/system/cpu/cpu0/cache/index%d/size", i);
+    if ((f = fopen(path, "r")) != NULL) {
+      if (fscanf(f, "%luK", &size) != 1) size = 0;  /* given in KB */
+      fclose(f);
+    }
+    if (strcmp(type, "Instruction") == 0) continue;
+    if (level == 1 && !l1) l1 = size * KB;
+    if (level == 2 && !l2) l2 = size * KB;
+  }
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  if (!l1 || !l2) {
+    unsigned int eax, ebx, ecx, edx, i;
+    size_t csize;
+
+    /* Deterministic cache parameters (Intel) */
+    if (__get_cpuid_max(0, 0) >= 4) {
+      for (i = 0; i < 8; i++) {
+        __cpuid_count(4, i, eax, ebx, ecx, edx);
+        if ((eax & 0x1f) == 0) break;            /* no more caches */
+        if ((eax & 0x1f) == 2) continue;         /* instruction cache */
+        csize = (size_t)((ebx >> 22) + 1) * (((ebx >> 12) & 0x3ff) + 1) *
+                ((ebx & 0xfff) + 1) * (ecx + 1);
+        if (((eax >> 5) & 7) == 1 && !l1) l1 = csize;
+        if (((eax >> 5) & 7) == 2 && !l2) l2 = csize;
+      }
+    }
+    /* Extended functions (AMD) */
+    if (__get_cpuid_max(0x80000000, 0) >= 0x80000006) {
+      __cpuid(0x80000005, eax, ebx, ecx, edx);
+      if (!l1) l1 = (size_t)(ecx >> 24) * KB;
+      __cpuid(0x80000006, eax, ebx, ecx, edx);
+      if (!l2) l2 = (size_t)(ecx >> 16) * KB;
+    }
+  }
+#endif
+
+  /* Accept plausible values only */
+  if (l1 >= 4*KB && l1 <= 1*MB) {
+    L1 = (int32_t)l1;
+  }
+  if (l2 >= (size_t)L1 && l2 <= 64*MB) {
+    L2 = (int32_t)l2;
+  }
+}
+
 void blosc_init(void) {
   /* Init global lock  */
   pthread_mutex_init(&global_comp_mutex, NULL);
+  detect_cache_sizes();
   init_lib = 1;
 }
 
+/* Get the sizes of the L1 and L2 data caches used for block sizes */
+void blosc_get_cache_sizes(size_t *l1, size_t *l2)
+{
+  *l1 = (size_t)L1;
+  *l2 = (size_t)L2;
+}
+
 int blosc_set_nthreads(int nthreads_new)
 {
   int ret;
@@ -43,8 +43,14 @@
 #define BLOSC_MAX_THREADS 256
 
 /* Codes for internal flags (see blosc_cbuffer_metainfo) */
-#define BLOSC_DOSHUFFLE 0x1
-#define BLOSC_MEMCPYED  0x2
+#define BLOSC_DOSHUFFLE    0x1
+#define BLOSC_MEMCPYED     0x2
+#define BLOSC_DOBITSHUFFLE 0x4
+
+/* Codes for the `doshuffle` parameter of blosc_compress() */
+#define BLOSC_NOSHUFFLE   0
+#define BLOSC_SHUFFLE     1
+#define BLOSC_BITSHUFFLE  2
 
 /* Codes for the different compressors shipped with Blosc */
 #define BLOSC_BLOSCLZ   0
@@ -116,8 +122,9 @@ void blosc_destroy(void);
   between 0 (no compression) and 9 (maximum compression).
 
   `doshuffle` specifies whether the shuffle compression preconditioner
-  should be applied or not.  0 means not applying it and 1 means
-  applying it.
+  should be applied or not.  0 means not applying it, 1 means applying
+  the byte shuffle and 2 means applying the bit shuffle
+  (BLOSC_NOSHUFFLE, BLOSC_SHUFFLE and BLOSC_BITSHUFFLE).
 
   `typesize` is the number of bytes for the atomic type in binary
   `src` buffer.  This is mainly useful for the shuffle preconditioner.
@@ -286,4 +293,11 @@ void blosc_cbuffer_versions(const void *cbuffer, int *version,
 void blosc_set_blocksize(size_t blocksize);
 
 
+/**
+  Get the sizes of the L1 and L2 data caches (in bytes) the automatic
+  blocksize is derived from.  They are detected by blosc_init().
+  */
+void blosc_get_cache_sizes(size_t *l1, size_t *l2);
+
+
 #endif
@@ -20,6 +20,35 @@
   #include <inttypes.h>
 #endif  /* _WIN32 */
 
+/* AVX2 kernels are compiled in whenever the compiler can emit them for
+   single functions; whether they are used is decided at runtime. */
+#if defined(__SSE2__) && \
+    (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+  #if defined(_MSC_VER) && (_MSC_VER >= 1700)
+    #define SHUFFLE_AVX2_ENABLED
+    #define AVX2_TARGET
+  #elif defined(__clang__)
+    #if (__clang_major__ > 3) || (__clang_major__ == 3 && __clang_minor__ >= 8)
+      #define SHUFFLE_AVX2_ENABLED
+      #define AVX2_TARGET __attribute__((target("avx2")))
+    #endif
+  #elif defined(__GNUC__)
+    #if (__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+      #define SHUFFLE_AVX2_ENABLED
+      #define AVX2_TARGET __attribute__((target("avx2")))
+    #endif
+  #endif
+#endif
+
+#if defined(SHUFFLE_AVX2_ENABLED)
+  #include <immintrin.h>
+  #if defined(_MSC_VER)
+    #include <intrin.h>
+  #else
+    #include <cpuid.h>
+  #endif
+#endif
+
 
 /* The non-SSE2 versions of shuffle and unshuffle */
 
@@ -58,6 +87,155 @@ static void _unshuffle(size_t bytesoftype, size_t blocksize,
 }
 
 
+/* Transpose the 8x8 bit matrix held in `x` (byte r is row r, bit c is
+   column c) */
+static uint64_t transpose8x8(uint64_t x)
+{
+  uint64_t t;
+
+  t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+  x = x ^ t ^ (t << 7);
+  t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+  x = x ^ t ^ (t << 14);
+  t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+  x = x ^ t ^ (t << 28);
+  return x;
+}
+
+/* Bitshuffle a block.  The first (blocksize / bytesoftype) elements,
+   rounded down to a multiple of 8, are transposed into 8*bytesoftype bit
+   planes: plane j*8+k holds bit k of byte j of every element, LSB first.
+   The remaining bytes are copied unchanged.  This can never fail. */
+void bitshuffle(size_t bytesoftype, size_t blocksize,
+                uint8_t* _src, uint8_t* _dest)
+{
+  size_t i, j, k, neblock, nplane;
+  const uint8_t* p;
+  uint64_t x;
+
+  neblock = (blocksize / bytesoftype) & ~(size_t)7;
+  nplane = neblock / 8;               /* Bytes per bit plane */
+  for (j = 0; j < bytesoftype; j++) {
+    for (i = 0; i < nplane; i++) {
+      /* Byte j of 8 consecutive elements */
+      p = _src + i*8*bytesoftype + j;
+      x = 0;
+      for (k = 0; k < 8; k++) {
+        x |= (uint64_t)p[k*bytesoftype] << (8*k);
+      }
+      x = transpose8x8(x);
+      for (k = 0; k < 8; k++) {
+        _dest[(j*8+k)*nplane+i] = (uint8_t)(x >> (8*k));
+      }
+    }
+  }
+  memcpy(_dest + neblock*bytesoftype, _src + neblock*bytesoftype,
+         blocksize - neblock*bytesoftype);
+}
+
+/* Bitunshuffle a block.  This can never fail. */
+void bitunshuffle(size_t bytesoftype, size_t blocksize,
+                  uint8_t* _src, uint8_t* _dest)
+{
+  size_t i, j, k, neblock, nplane;
+  uint8_t* p;
+  uint64_t x;
+
+  neblock = (blocksize / bytesoftype) & ~(size_t)7;
+  nplane = neblock / 8;
+  for (j = 0; j < bytesoftype; j++) {
+    for (i = 0; i < nplane; i++) {
+      x = 0;
+      for (k = 0; k < 8; k++) {
+        x |= (uint64_t)_src[(j*8+k)*nplane+i] << (8*k);
+      }
+      x = transpose8x8(x);
+      p = _dest + i*8*bytesoftype + j;
+      for (k = 0; k < 8; k++) {
+        p[k*bytesoftype] = (uint8_t)(x >> (8*k));
+      }
+    }
+  }
+  memcpy(_dest + neblock*bytesoftype, _src + neblock*bytesoftype,
+         blocksize - neblock*bytesoftype);
+}
+
+
+/* Instruction set used by shuffle() and unshuffle().  -1 means not
+   detected yet; detection is idempotent, so a race is harmless. */
+static int simd_level = -1;
+
+#if defined(SHUFFLE_AVX2_ENABLED)
+/* Check CPU and OS support (YMM state saved by XSAVE) for AVX2 */
+static int cpu_has_avx2(void)
+{
+  uint32_t xcr0;
+#if defined(_MSC_VER)
+  int info[4];
+
+  __cpuid(info, 0);
+  if (info[0] < 7) return 0;
+  __cpuid(info, 1);
+  if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28))) return 0;  /* OSXSAVE, AVX */
+  xcr0 = (uint32_t)_xgetbv(0);
+  if ((xcr0 & 6) != 6) return 0;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  unsigned int eax, ebx, ecx, edx, xcr0_hi;
+
+  if (__get_cpuid_max(0, 0) < 7) return 0;
+  __cpuid(1, eax, ebx, ecx, edx);
+  if (!(ecx & (1u << 27)) || !(ecx & (1u << 28))) return 0;    /* OSXSAVE, AVX */
+  __asm__ __volatile__(".byte 0x0f, 0x01, 0xd0"                /* xgetbv */
+                       : "=a"(xcr0), "=d"(xcr0_hi) : "c"(0));
+  if ((xcr0 & 6) != 6) return 0;
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  return (ebx & (1u << 5)) != 0;
+#endif
+}
+#endif
+
+/* Best instruction set supported by this build and the running CPU */
+int shuffle_simd_supported(void)
+{
+#if defined(SHUFFLE_AVX2_ENABLED)
+  static int has_avx2 = -1;
+
+  if (has_avx2 < 0) {
+    has_avx2 = cpu_has_avx2();
+  }
+  if (has_avx2) {
+    return SHUFFLE_AVX2;
+  }
+#endif
+#ifdef __SSE2__
+  return SHUFFLE_SSE2;
+#else
+  return SHUFFLE_GENERIC;
+#endif
+}
+
+/* Instruction set currently used */
+int shuffle_simd(void)
+{
+  if (simd_level < 0) {
+    simd_level = shuffle_simd_supported();
+  }
+  return simd_level;
+}
+
+/* Limit the instruction set (clamped to what is supported, a negative
+   value selects the best one).  Returns the instruction set now used. */
+int shuffle_set_simd(int level)
+{
+  int best = shuffle_simd_supported();
+
+  simd_level = (level < 0 || level > best) ? best : level;
+  return simd_level;
+}
+
+
 #ifdef __SSE2__
 
 /* The SSE2 versions of shuffle and unshuffle */
@@ -238,14 +416,401 @@ shuffle16(uint8_t* dest, uint8_t* src, size_t size)
 }
 
 
+#if defined(SHUFFLE_AVX2_ENABLED)
+
+/* The AVX2 versions of shuffle and unshuffle.  They run the SSE2
+   algorithms above on two groups of 16 elements at once, one group per
+   128-bit lane, so each output row gets 32 contiguous bytes per
+   iteration.  Loads and stores are unaligned. */
+
+/* Load the k-th 16 bytes of two consecutive groups into the lanes */
+static AVX2_TARGET __m256i
+load2x128(const uint8_t* src, size_t groupsize, size_t k)
+{
+  __m128i lo = _mm_loadu_si128((const __m128i*)(src+k*16));
+  __m128i hi = _mm_loadu_si128((const __m128i*)(src+groupsize+k*16));
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+/* Store `n` unshuffled vectors (low lanes: first group, high lanes:
+   second group) as 2*n*16 contiguous bytes */
+static AVX2_TARGET void
+store2x128(uint8_t* dest, const __m256i* ymm, size_t n)
+{
+  size_t k;
+
+  for (k = 0; k < n; k += 2) {
+    _mm256_storeu_si256((__m256i*)(dest+k*16),
+                        _mm256_permute2x128_si256(ymm[k], ymm[k+1], 0x20));
+    _mm256_storeu_si256((__m256i*)(dest+n*16+k*16),
+                        _mm256_permute2x128_si256(ymm[k], ymm[k+1], 0x31));
+  }
+}
+
+
+/* Routine optimized for shuffling a buffer for a type size of 2 bytes. */
+static AVX2_TARGET void
+shuffle2_avx2(uint8_t* dest, uint8_t* src, size_t size)
+{
+  size_t i, j, k;
+  size_t neblock, numof32belem;
+  __m256i ymm0[2], ymm1[2];
+
+  neblock = size / 2;
+  numof32belem = size / (32*2);
+  for (i = 0, j = 0; i < numof32belem; i++, j += 32*2) {
+    /* Fetch and transpose bytes, words and double words in groups of
+       64 bytes */
+    for (k = 0; k < 2; k++) {
+      ymm0[k] = load2x128(src+j, 16*2, k);
+      ymm0[k] = _mm256_shufflelo_epi16(ymm0[k], 0xd8);
+      ymm0[k] = _mm256_shufflehi_epi16(ymm0[k], 0xd8);
+      ymm0[k] = _mm256_shuffle_epi32(ymm0[k], 0xd8);
+      ymm1[k] = _mm256_shuffle_epi32(ymm0[k], 0x4e);
+      ymm0[k] = _mm256_unpacklo_epi8(ymm0[k], ymm1[k]);
+      ymm0[k] = _mm256_shuffle_epi32(ymm0[k], 0xd8);
+      ymm1[k] = _mm256_shuffle_epi32(ymm0[k], 0x4e);
+      ymm0[k] = _mm256_unpacklo_epi16(ymm0[k], ymm1[k]);
+      ymm0[k] = _mm256_shuffle_epi32(ymm0[k], 0xd8);
+    }
+    /* Transpose quad words */
+    ymm1[0] = _mm256_unpacklo_epi64(ymm0[0], ymm0[1]);
+    ymm1[1] = _mm256_unpackhi_epi64(ymm0[0], ymm0[1]);
+    /* Store the result vectors */
+    for (k = 0; k < 2; k++) {
+      _mm256_storeu_si256((__m256i*)(dest+k*neblock+i*32), ymm1[k]);
+    }
+  }
+}
+
+
+/* Routine optimized for shuffling a buffer for a type size of 4 bytes. */
+static AVX2_TARGET void
+shuffle4_avx2(uint8_t* dest, uint8_t* src, size_t size)
+{
+  size_t i, j, k;
+  size_t neblock, numof32belem;
+  __m256i ymm0[4], ymm1[4];
+
+  neblock = size / 4;
+  numof32belem = size / (32*4);
+  for (i = 0, j = 0; i < numof32belem; i++, j += 32*4) {
+    /* Fetch and transpose bytes and words in groups of 128 bytes */
+    for (k = 0; k < 4; k++) {
+      ymm0[k] = load2x128(src+j, 16*4, k);
+      ymm1[k] = _mm256_shuffle_epi32(ymm0[k], 0xd8);
+      ymm0[k] = _mm256_shuffle_epi32(ymm0[k], 0x8d);
+      ymm0[k] = _mm256_unpacklo_epi8(ymm1[k], ymm0[k]);
+      ymm1[k] = _mm256_shuffle_epi32(ymm0[k], 0x04e);
+      ymm0[k] = _mm256_unpacklo_epi16(ymm0[k], ymm1[k]);
+    }
+    /* Transpose double words */
+    for (k = 0; k < 2; k++) {
+      ymm1[k*2] = _mm256_unpacklo_epi32(ymm0[k*2], ymm0[k*2+1]);
+      ymm1[k*2+1] = _mm256_unpackhi_epi32(ymm0[k*2], ymm0[k*2+1]);
+    }
+    /* Transpose quad words */
+    for (k = 0; k < 2; k++) {
+      ymm0[k*2] = _mm256_unpacklo_epi64(ymm1[k], ymm1[k+2]);
+      ymm0[k*2+1] = _mm256_unpackhi_epi64(ymm1[k], ymm1[k+2]);
+    }
+    /* Store the result vectors */
+    for (k = 0; k < 4; k++) {
+      _mm256_storeu_si256((__m256i*)(dest+k*neblock+i*32), ymm0[k]);
+    }
+  }
+}
+
+
+/* Routine optimized for shuffling a buffer for a type size of 8 bytes. */
+static AVX2_TARGET void
+shuffle8_avx2(uint8_t* dest, uint8_t* src, size_t size)
+{
+  size_t i, j, k, l;
+  size_t neblock, numof32belem;
+  __m256i ymm0[8], ymm1[8];
+
+  neblock = size / 8;
+  numof32belem = size / (32*8);
+  for (i = 0, j = 0; i < numof32belem; i++, j += 32*8) {
+    /* Fetch and transpose bytes in groups of 256 bytes */
+    for (k = 0; k < 8; k++) {
+      ymm0[k] = load2x128(src+j, 16*8, k);
+      ymm1[k] = _mm256_shuffle_epi32(ymm0[k], 0x4e);
+      ymm1[k] = _mm256_unpacklo_epi8(ymm0[k], ymm1[k]);
+    }
+    /* Transpose words */
+    for (k = 0, l = 0; k < 4; k++, l +=2) {
+      ymm0[k*2] = _mm256_unpacklo_epi16(ymm1[l], ymm1[l+1]);
+      ymm0[k*2+1] = _mm256_unpackhi_epi16(ymm1[l], ymm1[l+1]);
+    }
+    /* Transpose double words */
+    for (k = 0, l = 0; k < 4; k++, l++) {
+      if (k == 2) l += 2;
+      ymm1[k*2] = _mm256_unpacklo_epi32(ymm0[l], ymm0[l+2]);
+      ymm1[k*2+1] = _mm256_unpackhi_epi32(ymm0[l], ymm0[l+2]);
+    }
+    /* Transpose quad words */
+    for (k = 0; k < 4; k++) {
+      ymm0[k*2] = _mm256_unpacklo_epi64(ymm1[k], ymm1[k+4]);
+      ymm0[k*2+1] = _mm256_unpackhi_epi64(ymm1[k], ymm1[k+4]);
+    }
+    /* Store the result vectors */
+    for (k = 0; k < 8; k++) {
+      _mm256_storeu_si256((__m256i*)(dest+k*neblock+i*32), ymm0[k]);
+    }
+  }
+}
+
+
+/* Routine optimized for shuffling a buffer for a type size of 16 bytes. */
+static AVX2_TARGET void
+shuffle16_avx2(uint8_t* dest, uint8_t* src, size_t size)
+{
+  size_t i, j, k, l;
+  size_t neblock, numof32belem;
+  __m256i ymm0[16], ymm1[16];
+
+  neblock = size / 16;
+  numof32belem = size / (32*16);
+  for (i = 0, j = 0; i < numof32belem; i++, j += 32*16) {
+    /* Fetch elements in groups of 512 bytes */
+    for (k = 0; k < 16; k++) {
+      ymm0[k] = load2x128(src+j, 16*16, k);
+    }
+    /* Transpose bytes */
+    for (k = 0, l = 0; k < 8; k++, l +=2) {
+      ymm1[k*2] = _mm256_unpacklo_epi8(ymm0[l], ymm0[l+1]);
+      ymm1[k*2+1] = _mm256_unpackhi_epi8(ymm0[l], ymm0[l+1]);
+    }
+    /* Transpose words */
+    for (k = 0, l = -2; k < 8; k++, l++) {
+      if ((k%2) == 0) l += 2;
+      ymm0[k*2] = _mm256_unpacklo_epi16(ymm1[l], ymm1[l+2]);
+      ymm0[k*2+1] = _mm256_unpackhi_epi16(ymm1[l], ymm1[l+2]);
+    }
+    /* Transpose double words */
+    for (k = 0, l = -4; k < 8; k++, l++) {
+      if ((k%4) == 0) l += 4;
+      ymm1[k*2] = _mm256_unpacklo_epi32(ymm0[l], ymm0[l+4]);
+      ymm1[k*2+1] = _mm256_unpackhi_epi32(ymm0[l], ymm0[l+4]);
+    }
+    /* Transpose quad words */
+    for (k = 0; k < 8; k++) {
+      ymm0[k*2] = _mm256_unpacklo_epi64(ymm1[k], ymm1[k+8]);
+      ymm0[k*2+1] = _mm256_unpackhi_epi64(ymm1[k], ymm1[k+8]);
+    }
+    /* Store the result vectors */
+    for (k = 0; k < 16; k++) {
+      _mm256_storeu_si256((__m256i*)(dest+k*neblock+i*32), ymm0[k]);
+    }
+  }
+}
+
+
+/* Routine optimized for unshuffling a buffer for a type size of 2 bytes. */
+static AVX2_TARGET void
+unshuffle2_avx2(uint8_t* dest, uint8_t* orig, size_t size)
+{
+  size_t i;
+  size_t neblock, numof32belem;
+  __m256i ymm1[2], ymm2[2];
+
+  neblock = size / 2;
+  numof32belem = neblock / 32;
+  for (i = 0; i < numof32belem; i++) {
+    /* Load the first 64 bytes in 2 YMM registers */
+    ymm1[0] = _mm256_loadu_si256((__m256i*)(orig+0*neblock+i*32));
+    ymm1[1] = _mm256_loadu_si256((__m256i*)(orig+1*neblock+i*32));
+    /* Shuffle bytes */
+    ymm2[0] = _mm256_unpacklo_epi8(ymm1[0], ymm1[1]);
+    ymm2[1] = _mm256_unpackhi_epi8(ymm1[0], ymm1[1]);
+    /* Store the result vectors in proper order */
+    store2x128(dest+i*32*2, ymm2, 2);
+  }
+}
+
+
+/* Routine optimized for unshuffling a buffer for a type size of 4 bytes. */
+static AVX2_TARGET void
+unshuffle4_avx2(uint8_t* dest, uint8_t* orig, size_t size)
+{
+  size_t i, j;
+  size_t neblock, numof32belem;
+  __m256i ymm0[4], ymm1[4];
+
+  neblock = size / 4;
+  numof32belem = neblock / 32;
+  for (i = 0; i < numof32belem; i++) {
+    /* Load the first 128 bytes in 4 YMM registers */
+    for (j = 0; j < 4; j++) {
+      ymm0[j] = _mm256_loadu_si256((__m256i*)(orig+j*neblock+i*32));
+    }
+    /* Shuffle bytes */
+    for (j = 0; j < 2; j++) {
+      ymm1[j] = _mm256_unpacklo_epi8(ymm0[j*2], ymm0[j*2+1]);
+      ymm1[2+j] = _mm256_unpackhi_epi8(ymm0[j*2], ymm0[j*2+1]);
+    }
+    /* Shuffle 2-byte words */
+    for (j = 0; j < 2; j++) {
+      ymm0[j] = _mm256_unpacklo_epi16(ymm1[j*2], ymm1[j*2+1]);
+      ymm0[2+j] = _mm256_unpackhi_epi16(ymm1[j*2], ymm1[j*2+1]);
+    }
+    /* Store the result vectors in proper order */
+    ymm1[0] = ymm0[0];
+    ymm1[1] = ymm0[2];
+    ymm1[2] = ymm0[1];
+    ymm1[3] = ymm0[3];
+    store2x128(dest+i*32*4, ymm1, 4);
+  }
+}
+
+
+/* Routine optimized for unshuffling a buffer for a type size of 8 bytes. */
+static AVX2_TARGET void
+unshuffle8_avx2(uint8_t* dest, uint8_t* orig, size_t size)
+{
+  size_t i, j;
+  size_t neblock, numof32belem;
+  __m256i ymm0[8], ymm1[8];
+
+  neblock = size / 8;
+  numof32belem = neblock / 32;
+  for (i = 0; i < numof32belem; i++) {
+    /* Load the first 256 bytes in 8 YMM registers */
+    for (j = 0; j < 8; j++) {
+      ymm0[j] = _mm256_loadu_si256((__m256i*)(orig+j*neblock+i*32));
+    }
+    /* Shuffle bytes */
+    for (j = 0; j < 4; j++) {
+      ymm1[j] = _mm256_unpacklo_epi8(ymm0[j*2], ymm0[j*2+1]);
+      ymm1[4+j] = _mm256_unpackhi_epi8(ymm0[j*2], ymm0[j*2+1]);
+    }
+    /* Shuffle 2-byte words */
+    for (j = 0; j < 4; j++) {
+      ymm0[j] = _mm256_unpacklo_epi16(ymm1[j*2], ymm1[j*2+1]);
+      ymm0[4+j] = _mm256_unpackhi_epi16(ymm1[j*2], ymm1[j*2+1]);
+    }
+    /* Shuffle 4-byte dwords */
+    for (j = 0; j < 4; j++) {
+      ymm1[j] = _mm256_unpacklo_epi32(ymm0[j*2], ymm0[j*2+1]);
+      ymm1[4+j] = _mm256_unpackhi_epi32(ymm0[j*2], ymm0[j*2+1]);
+    }
+    /* Store the result vectors in proper order */
+    ymm0[0] = ymm1[0];
+    ymm0[1] = ymm1[4];
+    ymm0[2] = ymm1[2];
+    ymm0[3] = ymm1[6];
+    ymm0[4] = ymm1[1];
+    ymm0[5] = ymm1[5];
+    ymm0[6] = ymm1[3];
+    ymm0[7] = ymm1[7];
+    store2x128(dest+i*32*8, ymm0, 8);
+  }
+}
+
+
+/* Routine optimized for unshuffling a buffer for a type size of 16 bytes. */
+static AVX2_TARGET void
+unshuffle16_avx2(uint8_t* dest, uint8_t* orig, size_t size)
+{
+  static const int order[16] = {0, 8, 4, 12, 2, 10, 6, 14,
+                                1, 9, 5, 13, 3, 11, 7, 15};
+  size_t i, j;
+  size_t neblock, numof32belem;
+  __m256i ymm1[16], ymm2[16];
+
+  neblock = size / 16;
+  numof32belem = neblock / 32;
+  for (i = 0; i < numof32belem; i++) {
+    /* Load the first 512 bytes in 16 YMM registers */
+    for (j = 0; j < 16; j++) {
+      ymm1[j] = _mm256_loadu_si256((__m256i*)(orig+j*neblock+i*32));
+    }
+    /* Shuffle bytes */
+    for (j = 0; j < 8; j++) {
+      ymm2[j] = _mm256_unpacklo_epi8(ymm1[j*2], ymm1[j*2+1]);
+      ymm2[8+j] = _mm256_unpackhi_epi8(ymm1[j*2], ymm1[j*2+1]);
+    }
+    /* Shuffle 2-byte words */
+    for (j = 0; j < 8; j++) {
+      ymm1[j] = _mm256_unpacklo_epi16(ymm2[j*2], ymm2[j*2+1]);
+      ymm1[8+j] = _mm256_unpackhi_epi16(ymm2[j*2], ymm2[j*2+1]);
+    }
+    /* Shuffle 4-byte dwords */
+    for (j = 0; j < 8; j++) {
+      ymm2[j] = _mm256_unpacklo_epi32(ymm1[j*2], ymm1[j*2+1]);
+      ymm2[8+j] = _mm256_unpackhi_epi32(ymm1[j*2], ymm1[j*2+1]);
+    }
+    /* Shuffle 8-byte qwords */
+    for (j = 0; j < 8; j++) {
+      ymm1[j] = _mm256_unpacklo_epi64(ymm2[j*2], ymm2[j*2+1]);
+      ymm1[8+j] = _mm256_unpackhi_epi64(ymm2[j*2], ymm2[j*2+1]);
+    }
+    /* Store the result vectors in proper order */
+    for (j = 0; j < 16; j++) {
+      ymm2[j] = ymm1[order[j]];
+    }
+    store2x128(dest+i*32*16, ymm2, 16);
+  }
+}
+
+
+/* Shuffle a block with AVX2.  Returns 0 if the block does not qualify. */
+static int shuffle_avx2(size_t bytesoftype, size_t blocksize,
+                        uint8_t* _src, uint8_t* _dest)
+{
+  if (blocksize == 0 || (blocksize % (32 * bytesoftype)) != 0) {
+    return 0;
+  }
+
+  switch (bytesoftype) {
+    case 2:  shuffle2_avx2(_dest, _src, blocksize);  return 1;
+    case 4:  shuffle4_avx2(_dest, _src, blocksize);  return 1;
+    case 8:  shuffle8_avx2(_dest, _src, blocksize);  return 1;
+    case 16: shuffle16_avx2(_dest, _src, blocksize); return 1;
+    default: return 0;
+  }
+}
+
+
+/* Unshuffle a block with AVX2.  Returns 0 if the block does not qualify. */
+static int unshuffle_avx2(size_t bytesoftype, size_t blocksize,
+                          uint8_t* _src, uint8_t* _dest)
+{
+  if (blocksize == 0 || (blocksize % (32 * bytesoftype)) != 0) {
+    return 0;
+  }
+
+  switch (bytesoftype) {
+    case 2:  unshuffle2_avx2(_dest, _src, blocksize);  return 1;
+    case 4:  unshuffle4_avx2(_dest, _src, blocksize);  return 1;
+    case 8:  unshuffle8_avx2(_dest, _src, blocksize);  return 1;
+    case 16: unshuffle16_avx2(_dest, _src, blocksize); return 1;
+    default: return 0;
+  }
+}
+
+#endif  /* SHUFFLE_AVX2_ENABLED */
+
+
 /* Shuffle a block.  This can never fail. */
 void shuffle(size_t bytesoftype, size_t blocksize,
              uint8_t* _src, uint8_t* _dest) {
   int unaligned_dest = (int)((uintptr_t)_dest % 16);
   int multiple_of_block = (blocksize % (16 * bytesoftype)) == 0;
   int too_small = (blocksize < 256);
+  int level = shuffle_simd();
 
-  if (unaligned_dest || !multiple_of_block || too_small) {
+#if defined(SHUFFLE_AVX2_ENABLED)
+  if (level >= SHUFFLE_AVX2 &&
+      shuffle_avx2(bytesoftype, blocksize, _src, _dest)) {
+    return;
+  }
+#endif
+
+  if (unaligned_dest || !multiple_of_block || too_small ||
+      level < SHUFFLE_SSE2) {
     /* _dest buffer is not aligned, not multiple of the vectorization size
      * or is too small.  Call the non-sse2 version. */
     _shuffle(bytesoftype, blocksize, _src, _dest);
@@ -458,8 +1023,17 @@ void unshuffle(size_t bytesoftype, size_t blocksize,
   int unaligned_dest = (int)((uintptr_t)_dest % 16);
   int multiple_of_block = (blocksize % (16 * bytesoftype)) == 0;
   int too_small = (blocksize < 256);
+  int level = shuffle_simd();
+
+#if defined(SHUFFLE_AVX2_ENABLED)
+  if (level >= SHUFFLE_AVX2 &&
+      unshuffle_avx2(bytesoftype, blocksize, _src, _dest)) {
+    return;
+  }
+#endif
 
-  if (unaligned_src || unaligned_dest || !multiple_of_block || too_small) {
+  if (unaligned_src || unaligned_dest || !multiple_of_block || too_small ||
+      level < SHUFFLE_SSE2) {
     /* _src or _dest buffer is not aligned, not multiple of the vectorization
      * size or is not too small.  Call the non-sse2 version. */
     _unshuffle(bytesoftype, blocksize, _src, _dest);
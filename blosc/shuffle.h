@@ -7,6 +7,21 @@
 **********************************************************************/
 
 
+/* Instruction sets for the shuffle/unshuffle routines */
+#define SHUFFLE_GENERIC 0
+#define SHUFFLE_SSE2    1
+#define SHUFFLE_AVX2    2
+
+/* Best instruction set supported by the build and the running CPU */
+int shuffle_simd_supported(void);
+
+/* Instruction set currently used by shuffle() and unshuffle() */
+int shuffle_simd(void);
+
+/* Limit the instruction set (a negative value selects the best one).
+   Returns the instruction set used from now on. */
+int shuffle_set_simd(int level);
+
 /* Shuffle/unshuffle routines */
 
 void shuffle(size_t bytesoftype, size_t blocksize,
@@ -14,3 +29,11 @@ void shuffle(size_t bytesoftype, size_t blocksize,
 
 void unshuffle(size_t bytesoftype, size_t blocksize,
                unsigned char* _src, unsigned char* _dest);
+
+/* Bitshuffle/bitunshuffle routines */
+
+void bitshuffle(size_t bytesoftype, size_t blocksize,
+                unsigned char* _src, unsigned char* _dest);
+
+void bitunshuffle(size_t bytesoftype, size_t blocksize,
+                  unsigned char* _src, unsigned char* _dest);
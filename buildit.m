@@ -93,9 +93,9 @@ end
 
 % get the mex arguments
 if buildrelease
-    buildargs = ['-DNDEBUG -DSQLITE_ENABLE_RTREE=1 -DSQLITE_THREADSAFE=2 -DHAVE_LZ4 -O '];
+    buildargs = ['-DNDEBUG -DSQLITE_ENABLE_RTREE=1 -DSQLITE_ENABLE_FTS5 -DSQLITE_ENABLE_JSON1 -DSQLITE_ENABLE_SESSION -DSQLITE_ENABLE_PREUPDATE_HOOK -DSQLITE_THREADSAFE=2 -DHAVE_USLEEP=1 -DHAVE_LZ4 -O '];
 else
-    buildargs = ['-UNDEBUG -DSQLITE_ENABLE_RTREE=1 -DSQLITE_THREADSAFE=2 -DHAVE_LZ4 -g -v '];
+    buildargs = ['-UNDEBUG -DSQLITE_ENABLE_RTREE=1 -DSQLITE_ENABLE_FTS5 -DSQLITE_ENABLE_JSON1 -DSQLITE_ENABLE_SESSION -DSQLITE_ENABLE_PREUPDATE_HOOK -DSQLITE_THREADSAFE=2 -DHAVE_USLEEP=1 -DHAVE_LZ4 -g -v '];
 end
 
 % additional libraries:
@@ -260,6 +260,7 @@ copyfile('Changelog.txt',           reldir);
 copyfile('mksqlite.m',              reldir);
 copyfile('mksqlite_en.m',           reldir);
 copyfile('sql.m',                   reldir);
+copyfile('mksqlite_result.m',       reldir);
 
 % x86 32-bit version (MSVC 2010 / Win7) / MATLAB Version 7.7.0.471 (R2008b)
 if exist( 'mksqlite.mexw32', 'file' )
@@ -296,6 +297,7 @@ copyfile('buildit.m',               srcdir);
 copyfile('mksqlite.m',              srcdir);
 copyfile('mksqlite_en.m',           srcdir);
 copyfile('sql.m',                   srcdir);
+copyfile('mksqlite_result.m',       srcdir);
 copyfile('mksqlite.cpp',            srcdir);
 copyfile('config.h',                srcdir);
 copyfile('global.hpp',              srcdir);
@@ -303,6 +305,18 @@ copyfile('heap_check.hpp',          srcdir);
 copyfile('locale.hpp',              srcdir);
 copyfile('number_compressor.hpp',   srcdir);
 copyfile('serialize.hpp',           srcdir);
+copyfile('shards.hpp',              srcdir);
+copyfile('sidecar.hpp',             srcdir);
+copyfile('backup.hpp',              srcdir);
+copyfile('carray.hpp',              srcdir);
+copyfile('checkpoint.hpp',          srcdir);
+copyfile('lazy_result.hpp',         srcdir);
+copyfile('sketches.hpp',            srcdir);
+copyfile('bloom.hpp',               srcdir);
+copyfile('changefeed.hpp',          srcdir);
+copyfile('changeset.hpp',           srcdir);
+copyfile('index_advisor.hpp',       srcdir);
+copyfile('regex_nfa.hpp',           srcdir);
 copyfile('sql_interface.hpp',       srcdir);
 copyfile('sql_builtin_functions.hpp',  srcdir);
 copyfile('typed_blobs.hpp',         srcdir);
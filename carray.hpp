@@ -0,0 +1,803 @@
+/**
+ *  <!-- mksqlite: A MATLAB Interface to SQLite -->
+ *
+ *  @file      carray.hpp
+ *  @brief     Table-valued function carray() for MATLAB arrays
+ *  @details   A MATLAB vector (numeric, logical or cellstr) bound to the
+ *             argument of carray() is exposed as a one-column table, e.g.
+ *             "SELECT * FROM t WHERE id IN carray(?)". Numeric data is read
+ *             directly from the MATLAB array, no copy is made.
+ *  @see       https://www.sqlite.org/carray.html
+ *  @authors   Martin Kortmann <mail@kortmann.de>,
+ *             Andreas Martin  <andimartin@users.sourceforge.net>
+ *  @version   2.5
+ *  @date      2008-2017
+ *  @copyright Distributed under LGPL
+ *  @pre
+ *  @warning   A binding refers to the MATLAB array it was created from. It
+ *             must not outlive the mksqlite call (statements are reset and
+ *             their bindings cleared, when the call leaves).
+ *  @bug
+ */
+
+#pragma once
+
+//#include "config.h"
+//#include "global.hpp"
+//#include "sqlite/sqlite3.h"
+//#include "utils.hpp"
+//#include "value.hpp"
+//#include "locale.hpp"
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+/// Pointer type tag, see sqlite3_bind_pointer()
+#define CARRAY_POINTER_TYPE "mksqlite_carray"
+
+
+/**
+ * \brief Values of one MATLAB array bound to carray()
+ *
+ * Numeric and logical arrays are referenced (zero-copy), strings of a cellstr
+ * are copied once. An index permutation in sorted order is built on demand,
+ * if the array is searched for a value repeatedly.
+ */
+class CarrayBinding
+{
+public:
+    /// Kind of values
+    enum kind_e {
+        KIND_INT,       ///< integer and logical classes (compared as 64 bit integers)
+        KIND_FLOAT,     ///< double and single
+        KIND_TEXT       ///< strings (UTF-8 or latin-1, see g_convertUTF8)
+    };
+
+private:
+    kind_e              m_kind;     ///< kind of values
+    mxClassID           m_clsid;    ///< MATLAB class of referenced data (numeric kinds only)
+    const void*         m_data;     ///< referenced MATLAB data (numeric kinds only, no ownership)
+    size_t              m_count;    ///< number of values
+    vector<char*>       m_text;     ///< copied strings (KIND_TEXT only)
+    vector<size_t>      m_sorted;   ///< indices in ascending order of their values, NaNs omitted
+    bool                m_isSorted; ///< true, if \p m_sorted has been built
+
+    // Not copyable, owns strings
+    CarrayBinding( const CarrayBinding& );
+    CarrayBinding& operator=( const CarrayBinding& );
+
+public:
+    /// Ctor
+    CarrayBinding() : m_kind( KIND_FLOAT ), m_clsid( mxUNKNOWN_CLASS ), m_data( NULL ), m_count( 0 ), m_isSorted( false )
+    {}
+
+
+    /// Dtor
+    ~CarrayBinding()
+    {
+        for( size_t i = 0; i < m_text.size(); i++ )
+        {
+            ::utils_free_ptr( m_text[i] );
+        }
+    }
+
+
+    /// Destructor function for sqlite3_bind_pointer()
+    static
+    void destroy( void* pBinding )
+    {
+        delete (CarrayBinding*)pBinding;
+    }
+
+
+    /**
+     * \brief Take values from a MATLAB array
+     *
+     * \param[in] pItem Real numeric or logical vector, string or cell array of strings
+     * \returns MSG_NOERROR on success, or MSG_CARRAYTYPE for unsupported arrays
+     *          (also uint64 values above intmax('int64'))
+     */
+    int assign( const mxArray* pItem )
+    {
+        ValueMex item( pItem );
+
+        m_count = item.NumElements();
+
+        switch( item.ClassID() )
+        {
+            case mxLOGICAL_CLASS:
+            case mxINT8_CLASS:
+            case mxUINT8_CLASS:
+            case mxINT16_CLASS:
+            case mxUINT16_CLASS:
+            case mxINT32_CLASS:
+            case mxUINT32_CLASS:
+            case mxINT64_CLASS:
+            case mxUINT64_CLASS:
+                m_kind = KIND_INT;
+                break;
+
+            case mxDOUBLE_CLASS:
+            case mxSINGLE_CLASS:
+                m_kind = KIND_FLOAT;
+                break;
+
+            case mxCHAR_CLASS:
+                // a single string
+                m_kind  = KIND_TEXT;
+                m_count = 1;
+                m_text.push_back( item.GetEncString() );
+                return MSG_NOERROR;
+
+            case mxCELL_CLASS:
+                m_kind = KIND_TEXT;
+                m_text.reserve( m_count );
+
+                for( size_t i = 0; i < m_count; i++ )
+                {
+                    ValueMex cell( mxGetCell( pItem, (mwIndex)i ) );
+
+                    if( cell.ClassID() != mxCHAR_CLASS || cell.NumElements() != cell.GetN() )
+                    {
+                        return MSG_CARRAYTYPE;
+                    }
+                    m_text.push_back( cell.GetEncString() );
+                }
+                return MSG_NOERROR;
+
+            default:
+                return MSG_CARRAYTYPE;
+        }
+
+        if( item.IsComplex() || mxIsSparse( pItem ) )
+        {
+            return MSG_CARRAYTYPE;
+        }
+
+        m_clsid = item.ClassID();
+        m_data  = item.Data();
+
+        // SQLite integers are signed, larger values would wrap negative
+        if( mxUINT64_CLASS == m_clsid )
+        {
+            for( size_t i = 0; i < m_count; i++ )
+            {
+                if( ( (const uint64_t*)m_data )[i] >> 63 )
+                {
+                    return MSG_CARRAYTYPE;
+                }
+            }
+        }
+
+        return MSG_NOERROR;
+    }
+
+
+    /// Number of values
+    size_t size() const
+    {
+        return m_count;
+    }
+
+
+    /// Kind of values
+    kind_e kind() const
+    {
+        return m_kind;
+    }
+
+
+    /// Integer value at \p index (KIND_INT only)
+    sqlite3_int64 getInt( size_t index ) const
+    {
+        switch( m_clsid )
+        {
+            case mxLOGICAL_CLASS: return (sqlite3_int64) ( (const mxLogical*)m_data )[index];
+            case mxINT8_CLASS:    return (sqlite3_int64) ( (const int8_t*)   m_data )[index];
+            case mxUINT8_CLASS:   return (sqlite3_int64) ( (const uint8_t*)  m_data )[index];
+            case mxINT16_CLASS:   return (sqlite3_int64) ( (const int16_t*)  m_data )[index];
+            case mxUINT16_CLASS:  return (sqlite3_int64) ( (const uint16_t*) m_data )[index];
+            case mxINT32_CLASS:   return (sqlite3_int64) ( (const int32_t*)  m_data )[index];
+            case mxUINT32_CLASS:  return (sqlite3_int64) ( (const uint32_t*) m_data )[index];
+            case mxINT64_CLASS:   return (sqlite3_int64) ( (const int64_t*)  m_data )[index];
+            case mxUINT64_CLASS:  return (sqlite3_int64) ( (const uint64_t*) m_data )[index];
+            default:
+                assert( false );
+                return 0;
+        }
+    }
+
+
+    /// Floating point value at \p index (numeric kinds only)
+    double getFloat( size_t index ) const
+    {
+        switch( m_clsid )
+        {
+            case mxDOUBLE_CLASS: return ( (const double*)m_data )[index];
+            case mxSINGLE_CLASS: return (double) ( (const float*)m_data )[index];
+            default:             return (double) getInt( index );
+        }
+    }
+
+
+    /// String at \p index (KIND_TEXT only)
+    const char* getText( size_t index ) const
+    {
+        return m_text[index];
+    }
+
+
+    /// Return value at \p index as SQL result
+    void result( sqlite3_context* ctx, size_t index ) const
+    {
+        switch( m_kind )
+        {
+            case KIND_INT:
+                sqlite3_result_int64( ctx, getInt( index ) );
+                break;
+
+            case KIND_FLOAT:
+            {
+                double value = getFloat( index );
+
+                if( value != value )
+                {
+                    // NaN is NULL in SQLite
+                    sqlite3_result_null( ctx );
+                }
+                else
+                {
+                    sqlite3_result_double( ctx, value );
+                }
+                break;
+            }
+
+            case KIND_TEXT:
+                sqlite3_result_text( ctx, m_text[index], -1, SQLITE_STATIC );
+                break;
+        }
+    }
+
+
+    /**
+     * \brief Range of indices (in sorted order) with values equal to \p value
+     *
+     * \param[in] value Value to search for
+     * \param[out] pFirst Begin of range
+     * \param[out] pLast End of range (excluding)
+     * \returns false, if \p value can't be compared with the kind of values
+     *          (caller has to scan all values then)
+     */
+    bool findEqual( sqlite3_value* value, const size_t** pFirst, const size_t** pLast )
+    {
+        int type = sqlite3_value_type( value );
+
+        if( ( m_kind == KIND_TEXT ) != ( type == SQLITE_TEXT ) || type == SQLITE_BLOB )
+        {
+            return false;
+        }
+
+        if( m_kind != KIND_TEXT && type != SQLITE_INTEGER && type != SQLITE_FLOAT )
+        {
+            // NULL never matches
+            *pFirst = *pLast = NULL;
+            return true;
+        }
+
+        if( m_kind == KIND_INT && type == SQLITE_FLOAT )
+        {
+            // only integral values within range can be compared as integers
+            double d = sqlite3_value_double( value );
+
+            if( !( d >= -9223372036854775808.0 && d < 9223372036854775808.0 ) )
+            {
+                return false;
+            }
+
+            if( d != floor( d ) )
+            {
+                *pFirst = *pLast = NULL;
+                return true;
+            }
+        }
+
+        sort();
+
+        const size_t* first = m_sorted.empty() ? NULL : &m_sorted[0];
+        const size_t* last  = first + m_sorted.size();
+
+        switch( m_kind )
+        {
+            case KIND_INT:
+            {
+                sqlite3_int64 key = sqlite3_value_int64( value );
+                IntCompare cmp( this );
+                first = std::lower_bound( first, last, key, cmp );
+                last  = std::upper_bound( first, last, key, cmp );
+                break;
+            }
+
+            case KIND_FLOAT:
+            {
+                double key = sqlite3_value_double( value );
+                FloatCompare cmp( this );
+                first = std::lower_bound( first, last, key, cmp );
+                last  = std::upper_bound( first, last, key, cmp );
+                break;
+            }
+
+            case KIND_TEXT:
+            {
+                const char* key = (const char*)sqlite3_value_text( value );
+                TextCompare cmp( this );
+                first = std::lower_bound( first, last, key, cmp );
+                last  = std::upper_bound( first, last, key, cmp );
+                break;
+            }
+        }
+
+        *pFirst = first;
+        *pLast  = last;
+
+        return true;
+    }
+
+private:
+    /// Comparison of integer values by their indices
+    struct IntCompare
+    {
+        const CarrayBinding* m_p;   ///< binding
+        IntCompare( const CarrayBinding* p ) : m_p( p ) {}
+        bool operator()( size_t a, size_t b ) const               { return m_p->getInt( a ) < m_p->getInt( b ); }
+        bool operator()( size_t a, sqlite3_int64 key ) const      { return m_p->getInt( a ) < key; }
+        bool operator()( sqlite3_int64 key, size_t b ) const      { return key < m_p->getInt( b ); }
+    };
+
+    /// Comparison of floating point values by their indices
+    struct FloatCompare
+    {
+        const CarrayBinding* m_p;   ///< binding
+        FloatCompare( const CarrayBinding* p ) : m_p( p ) {}
+        bool operator()( size_t a, size_t b ) const               { return m_p->getFloat( a ) < m_p->getFloat( b ); }
+        bool operator()( size_t a, double key ) const             { return m_p->getFloat( a ) < key; }
+        bool operator()( double key, size_t b ) const             { return key < m_p->getFloat( b ); }
+    };
+
+    /// Comparison of strings by their indices (binary collation)
+    struct TextCompare
+    {
+        const CarrayBinding* m_p;   ///< binding
+        TextCompare( const CarrayBinding* p ) : m_p( p ) {}
+        bool operator()( size_t a, size_t b ) const               { return strcmp( m_p->getText( a ), m_p->getText( b ) ) < 0; }
+        bool operator()( size_t a, const char* key ) const        { return strcmp( m_p->getText( a ), key ) < 0; }
+        bool operator()( const char* key, size_t b ) const        { return strcmp( key, m_p->getText( b ) ) < 0; }
+    };
+
+
+    /// Build sorted index permutation, if not done yet
+    void sort()
+    {
+        if( m_isSorted )
+        {
+            return;
+        }
+
+        m_sorted.reserve( m_count );
+
+        for( size_t i = 0; i < m_count; i++ )
+        {
+            if( m_kind == KIND_FLOAT && getFloat( i ) != getFloat( i ) )
+            {
+                continue;  // NaN (NULL) never matches
+            }
+            m_sorted.push_back( i );
+        }
+
+        switch( m_kind )
+        {
+            case KIND_INT:   std::sort( m_sorted.begin(), m_sorted.end(), IntCompare( this ) ); break;
+            case KIND_FLOAT: std::sort( m_sorted.begin(), m_sorted.end(), FloatCompare( this ) ); break;
+            case KIND_TEXT:  std::sort( m_sorted.begin(), m_sorted.end(), TextCompare( this ) ); break;
+        }
+
+        m_isSorted = true;
+    }
+};
+
+
+
+/**
+ * \brief Eponymous virtual table "carray"
+ *
+ * Schema is "CREATE TABLE x(value, pointer HIDDEN)", so carray(?) takes
+ * the bound array as its only argument. An equality constraint on "value"
+ * is resolved by binary search, if the array has at least
+ * CONFIG_CARRAY_SORT_THRESHOLD elements.
+ */
+class CarrayModule
+{
+    /// Column numbers
+    enum {
+        COL_VALUE,
+        COL_POINTER
+    };
+
+    /// Flags in idxNum
+    enum {
+        IDX_POINTER = 1,    ///< argv[0] is the bound array
+        IDX_EQUAL   = 2     ///< argv[1] is a value to search for
+    };
+
+    /// Cursor over the values of a binding
+    struct Cursor
+    {
+        sqlite3_vtab_cursor base;       ///< base class (must be first)
+        CarrayBinding*      m_binding;  ///< bound array (no ownership)
+        const size_t*       m_perm;     ///< indices to visit (NULL: all values in order)
+        size_t              m_pos;      ///< current position
+        size_t              m_end;      ///< end position
+    };
+
+public:
+    /// Register module with database \p db
+    static
+    int attach( sqlite3* db )
+    {
+        static sqlite3_module module = {
+            0,              /* iVersion */
+            NULL,           /* xCreate (eponymous only) */
+            xConnect,       /* xConnect */
+            xBestIndex,     /* xBestIndex */
+            xDisconnect,    /* xDisconnect */
+            NULL,           /* xDestroy */
+            xOpen,          /* xOpen */
+            xClose,         /* xClose */
+            xFilter,        /* xFilter */
+            xNext,          /* xNext */
+            xEof,           /* xEof */
+            xColumn,        /* xColumn */
+            xRowid,         /* xRowid */
+            NULL,           /* xUpdate */
+            NULL,           /* xBegin */
+            NULL,           /* xSync */
+            NULL,           /* xCommit */
+            NULL,           /* xRollback */
+            NULL,           /* xFindMethod */
+            NULL,           /* xRename */
+            NULL,           /* xSavepoint */
+            NULL,           /* xRelease */
+            NULL,           /* xRollbackTo */
+        };
+
+        return sqlite3_create_module( db, "carray", &module, NULL );
+    }
+
+private:
+    static
+    int xConnect( sqlite3* db, void* pAux, int argc, const char* const* argv, sqlite3_vtab** ppVtab, char** pzErr )
+    {
+        int rc = sqlite3_declare_vtab( db, "CREATE TABLE x(value, pointer HIDDEN)" );
+
+        if( SQLITE_OK == rc )
+        {
+            *ppVtab = (sqlite3_vtab*)sqlite3_malloc( sizeof( sqlite3_vtab ) );
+            if( !*ppVtab )
+            {
+                return SQLITE_NOMEM;
+            }
+            memset( *ppVtab, 0, sizeof( sqlite3_vtab ) );
+        }
+
+        return rc;
+    }
+
+
+    static
+    int xDisconnect( sqlite3_vtab* pVtab )
+    {
+        sqlite3_free( pVtab );
+        return SQLITE_OK;
+    }
+
+
+    static
+    int xOpen( sqlite3_vtab* pVtab, sqlite3_vtab_cursor** ppCursor )
+    {
+        Cursor* pCur = (Cursor*)sqlite3_malloc( sizeof( Cursor ) );
+
+        if( !pCur )
+        {
+            return SQLITE_NOMEM;
+        }
+
+        memset( pCur, 0, sizeof( Cursor ) );
+        *ppCursor = &pCur->base;
+
+        return SQLITE_OK;
+    }
+
+
+    static
+    int xClose( sqlite3_vtab_cursor* cur )
+    {
+        sqlite3_free( cur );
+        return SQLITE_OK;
+    }
+
+
+    static
+    int xBestIndex( sqlite3_vtab* pVtab, sqlite3_index_info* pIdxInfo )
+    {
+        int iPointer = -1;
+        int iEqual   = -1;
+
+        for( int i = 0; i < pIdxInfo->nConstraint; i++ )
+        {
+            const struct sqlite3_index_info::sqlite3_index_constraint* pCons = &pIdxInfo->aConstraint[i];
+
+            if( !pCons->usable || pCons->op != SQLITE_INDEX_CONSTRAINT_EQ )
+            {
+                continue;
+            }
+
+            if( pCons->iColumn == COL_POINTER )
+            {
+                iPointer = i;
+            }
+            else if( pCons->iColumn == COL_VALUE && iEqual < 0 )
+            {
+                const char* coll = sqlite3_vtab_collation( pIdxInfo, i );
+
+                if( !coll || 0 == sqlite3_stricmp( coll, "BINARY" ) )
+                {
+                    iEqual = i;
+                }
+            }
+        }
+
+        if( iPointer < 0 )
+        {
+            // carray() without argument: empty, but discourage this plan
+            pIdxInfo->estimatedCost = 2147483647.0;
+            pIdxInfo->estimatedRows = 2147483647;
+            pIdxInfo->idxNum = 0;
+            return SQLITE_OK;
+        }
+
+        pIdxInfo->aConstraintUsage[iPointer].argvIndex = 1;
+        pIdxInfo->aConstraintUsage[iPointer].omit = 1;
+        pIdxInfo->idxNum = IDX_POINTER;
+
+        if( iEqual >= 0 )
+        {
+            // SQLite checks the constraint again (omit = 0), since
+            // affinity rules may let other values match
+            pIdxInfo->aConstraintUsage[iEqual].argvIndex = 2;
+            pIdxInfo->idxNum |= IDX_EQUAL;
+            pIdxInfo->estimatedCost = 10.0;
+            pIdxInfo->estimatedRows = 10;
+        }
+        else
+        {
+            pIdxInfo->estimatedCost = 1000.0;
+            pIdxInfo->estimatedRows = 1000;
+        }
+
+        return SQLITE_OK;
+    }
+
+
+    static
+    int xFilter( sqlite3_vtab_cursor* cur, int idxNum, const char* idxStr, int argc, sqlite3_value** argv )
+    {
+        Cursor* pCur = (Cursor*)cur;
+
+        pCur->m_binding = NULL;
+        pCur->m_perm    = NULL;
+        pCur->m_pos     = 0;
+        pCur->m_end     = 0;
+
+        if( !( idxNum & IDX_POINTER ) || argc < 1 )
+        {
+            return SQLITE_OK;
+        }
+
+        CarrayBinding* binding = (CarrayBinding*)sqlite3_value_pointer( argv[0], CARRAY_POINTER_TYPE );
+
+        if( !binding )
+        {
+            return SQLITE_OK;
+        }
+
+        pCur->m_binding = binding;
+        pCur->m_end     = binding->size();
+
+        if( ( idxNum & IDX_EQUAL ) && argc >= 2 && binding->size() >= CONFIG_CARRAY_SORT_THRESHOLD )
+        {
+            const size_t* first;
+            const size_t* last;
+
+            if( binding->findEqual( argv[1], &first, &last ) )
+            {
+                pCur->m_perm = first;
+                pCur->m_end  = (size_t)( last - first );
+            }
+        }
+
+        return SQLITE_OK;
+    }
+
+
+    static
+    int xNext( sqlite3_vtab_cursor* cur )
+    {
+        ( (Cursor*)cur )->m_pos++;
+        return SQLITE_OK;
+    }
+
+
+    static
+    int xEof( sqlite3_vtab_cursor* cur )
+    {
+        Cursor* pCur = (Cursor*)cur;
+        return pCur->m_pos >= pCur->m_end;
+    }
+
+
+    /// Index of the current value in the binding
+    static
+    size_t currentIndex( const Cursor* pCur )
+    {
+        return pCur->m_perm ? pCur->m_perm[pCur->m_pos] : pCur->m_pos;
+    }
+
+
+    static
+    int xColumn( sqlite3_vtab_cursor* cur, sqlite3_context* ctx, int i )
+    {
+        Cursor* pCur = (Cursor*)cur;
+
+        if( i == COL_VALUE )
+        {
+            pCur->m_binding->result( ctx, currentIndex( pCur ) );
+        }
+        else
+        {
+            sqlite3_result_null( ctx );
+        }
+
+        return SQLITE_OK;
+    }
+
+
+    static
+    int xRowid( sqlite3_vtab_cursor* cur, sqlite3_int64* pRowid )
+    {
+        *pRowid = (sqlite3_int64)currentIndex( (Cursor*)cur ) + 1;
+        return SQLITE_OK;
+    }
+};
+
+
+
+/**
+ * \brief Find parameters passed to carray() in a SQL statement
+ *
+ * Scans for "carray ( <parameter> )", skipping string literals, quoted
+ * identifiers and comments. Unnamed parameters "?" are numbered as SQLite
+ * does; named parameters are resolved by sqlite3_bind_parameter_index().
+ *
+ * \param[in] stmt Prepared statement
+ * \param[in] query SQL text the statement was prepared from
+ * \param[out] params Parameter numbers (1 based) bound to carray()
+ */
+inline
+void carray_find_params( sqlite3_stmt* stmt, const char* query, vector<int>& params )
+{
+    params.clear();
+
+    if( !sqlite3_bind_parameter_count( stmt ) || !query )
+    {
+        return;
+    }
+
+    const char* p = query;
+    int lastParam = 0;         // highest parameter number so far
+    int state     = 0;         // 0: outside, 1: after "carray", 2: after "carray("
+
+    while( *p )
+    {
+        char c = *p;
+
+        // skip literals, quoted identifiers and comments
+        if( c == '\'' || c == '"' || c == '`' || c == '[' )
+        {
+            char end = ( c == '[' ) ? ']' : c;
+            for( p++; *p; p++ )
+            {
+                if( *p == end )
+                {
+                    if( end != ']' && p[1] == end ) { p++; continue; }
+                    break;
+                }
+            }
+            if( *p ) p++;
+            state = 0;
+            continue;
+        }
+
+        if( c == '-' && p[1] == '-' )
+        {
+            while( *p && *p != '\n' ) p++;
+            continue;
+        }
+
+        if( c == '/' && p[1] == '*' )
+        {
+            p += 2;
+            while( *p && !( p[0] == '*' && p[1] == '/' ) ) p++;
+            if( *p ) p += 2;
+            continue;
+        }
+
+        if( isspace( (unsigned char)c ) )
+        {
+            p++;
+            continue;
+        }
+
+        // parameters
+        if( c == '?' || c == ':' || c == '@' || c == '$' )
+        {
+            const char* start = p++;
+            int number;
+
+            if( c == '?' && isdigit( (unsigned char)*p ) )
+            {
+                number = 0;
+                while( isdigit( (unsigned char)*p ) )
+                {
+                    number = number * 10 + ( *p++ - '0' );
+                }
+            }
+            else if( c == '?' )
+            {
+                number = lastParam + 1;
+            }
+            else
+            {
+                while( isalnum( (unsigned char)*p ) || *p == '_' || ( *p & 0x80 ) ) p++;
+                string name( start, p - start );
+                number = sqlite3_bind_parameter_index( stmt, name.c_str() );
+            }
+
+            lastParam = max( lastParam, number );
+
+            if( state == 2 && number > 0 )
+            {
+                // parameter must be the only argument
+                const char* q = p;
+                while( isspace( (unsigned char)*q ) ) q++;
+                if( *q == ')' && find( params.begin(), params.end(), number ) == params.end() )
+                {
+                    params.push_back( number );
+                }
+            }
+            state = 0;
+            continue;
+        }
+
+        // identifiers and keywords
+        if( isalpha( (unsigned char)c ) || c == '_' || ( c & 0x80 ) )
+        {
+            const char* start = p;
+            while( isalnum( (unsigned char)*p ) || *p == '_' || *p == '$' || ( *p & 0x80 ) ) p++;
+            state = ( p - start == 6 && 0 == sqlite3_strnicmp( start, "carray", 6 ) ) ? 1 : 0;
+            continue;
+        }
+
+        state = ( state == 1 && c == '(' ) ? 2 : 0;
+        p++;
+    }
+}
@@ -0,0 +1,558 @@
+/**
+ *  <!-- mksqlite: A MATLAB Interface to SQLite -->
+ *
+ *  @file      changefeed.hpp
+ *  @brief     Row change tracking of a database connection
+ *  @details   An update hook records (table, operation, rowid) of each row
+ *             inserted, updated or deleted in the tracked tables. Changes
+ *             of a transaction are pending until it commits (dropped on
+ *             rollback), committed changes are kept in a ring buffer until
+ *             they are taken. When the ring buffer overflows the oldest
+ *             changes are lost, which is counted.
+ *             The update hook isn't told about partial rollbacks: a trace
+ *             callback brackets each statement and drops its changes when
+ *             it was rolled back (failing constraint), savepoints are
+ *             followed by their statements (SAVEPOINT, RELEASE, ROLLBACK TO).
+ *             The preupdate hook isn't used, the session extension (see
+ *             changeset.hpp) installs its own one.
+ *  @authors   Martin Kortmann <mail@kortmann.de>,
+ *             Andreas Martin  <andimartin@users.sourceforge.net>
+ *  @version   2.5
+ *  @date      2008-2017
+ *  @copyright Distributed under LGPL
+ *  @pre
+ *  @warning   Only changes made by this connection are seen. Tables
+ *             WITHOUT ROWID and rows deleted by REPLACE conflict resolution
+ *             aren't reported, an UPDATE of the rowid reports the new
+ *             rowid only. A failing statement whose INSTEAD OF (or BEFORE)
+ *             triggers changed rows may be misjudged.
+ *  @bug
+ */
+
+#pragma once
+
+//#include "config.h"
+//#include "sqlite/sqlite3.h"
+#include <string>
+#include <vector>
+#include <cctype>
+#include <cstring>
+
+
+/**
+ * \brief Change tracker of one database connection
+ */
+class ChangeFeed
+{
+public:
+    /// One row change
+    struct Change
+    {
+        int             table;      ///< Table (index into names())
+        int             op;         ///< SQLITE_INSERT, SQLITE_UPDATE or SQLITE_DELETE
+        sqlite3_int64   rowid;      ///< Row affected
+    };
+
+private:
+    /// Statement in progress (see onTrace())
+    struct Frame
+    {
+        sqlite3_stmt*   stmt;       ///< Statement
+        size_t          pending;    ///< m_pending.size() on start
+        double          pendingLost;///< m_pendingLost on start
+        int             total;      ///< sqlite3_total_changes() on start
+        int             events;     ///< Update hook calls meanwhile
+    };
+
+    /// Savepoint of the open transaction
+    struct Savepoint
+    {
+        std::string     name;       ///< Savepoint name
+        size_t          pending;    ///< m_pending.size() on creation
+        double          pendingLost;///< m_pendingLost on creation
+    };
+
+    sqlite3*                    m_db;       ///< Connection (hooks installed)
+    bool                        m_all;      ///< Track all tables
+    std::vector<std::string>    m_names;    ///< Tracked tables (all seen so far, if m_all is set)
+    int                         m_last;     ///< Index of the table last looked up
+    std::vector<Change>         m_ring;     ///< Committed changes (ring buffer)
+    size_t                      m_head;     ///< Index of the oldest change in m_ring
+    size_t                      m_count;    ///< Number of changes in m_ring
+    std::vector<Change>         m_pending;  ///< Changes of the open transaction
+    double                      m_lost;     ///< Changes dropped since last taken
+    double                      m_pendingLost;  ///< Changes of the open transaction dropped
+    bool                        m_dropping; ///< Authorizer: DROP TABLE in progress
+    std::vector<Frame>          m_frames;   ///< Statements in progress, innermost last
+    std::vector<Savepoint>      m_savepoints;   ///< Savepoints, innermost last
+
+    /// inhibit copy constructor and assignment operator
+    /// @{
+    ChangeFeed( const ChangeFeed& );
+    ChangeFeed& operator=( const ChangeFeed& );
+    /// @}
+
+public:
+    /// Standard ctor
+    ChangeFeed() : m_db( NULL ), m_all( false ), m_last( -1 ), m_head( 0 ), m_count( 0 ),
+                   m_lost( 0.0 ), m_pendingLost( 0.0 ), m_dropping( false )
+    {
+    }
+
+
+    /// Dtor
+    ~ChangeFeed()
+    {
+        stop();
+    }
+
+
+    /**
+     * \brief Start tracking (restarts a running tracker, changes are discarded)
+     *
+     * \param[in] db Database connection
+     * \param[in] tables Names of the tables to track, all tables if empty
+     * \param[in] capacity Size of the ring buffer (changes)
+     */
+    void start( sqlite3* db, const std::vector<std::string>& tables, size_t capacity )
+    {
+        stop();
+
+        m_db    = db;
+        m_all   = tables.empty();
+        m_names = tables;
+        m_last  = -1;
+        m_ring.resize( capacity ? capacity : 1 );
+        m_head  = 0;
+        m_count = 0;
+        m_lost  = 0.0;
+        m_pending.clear();
+        m_pendingLost = 0.0;
+        m_dropping = false;
+        m_frames.clear();
+        m_savepoints.clear();
+
+        sqlite3_update_hook( m_db, &ChangeFeed::onUpdate, this );
+        sqlite3_commit_hook( m_db, &ChangeFeed::onCommit, this );
+        sqlite3_rollback_hook( m_db, &ChangeFeed::onRollback, this );
+        sqlite3_set_authorizer( m_db, &ChangeFeed::onAuthorize, this );
+        sqlite3_trace_v2( m_db, SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE, &ChangeFeed::onTrace, this );
+    }
+
+
+    /// Stop tracking and release all changes
+    void stop()
+    {
+        if( !m_db )
+        {
+            return;
+        }
+
+        sqlite3_update_hook( m_db, NULL, NULL );
+        sqlite3_commit_hook( m_db, NULL, NULL );
+        sqlite3_rollback_hook( m_db, NULL, NULL );
+        sqlite3_set_authorizer( m_db, NULL, NULL );
+        sqlite3_trace_v2( m_db, 0, NULL, NULL );
+
+        m_db = NULL;
+        m_names.clear();
+        std::vector<Change>().swap( m_ring );
+        std::vector<Change>().swap( m_pending );
+        m_frames.clear();
+        m_savepoints.clear();
+        m_head  = 0;
+        m_count = 0;
+        m_lost  = 0.0;
+    }
+
+
+    /// Returns true if changes are tracked
+    bool running()
+    {
+        return NULL != m_db;
+    }
+
+
+    /// Table names, referenced by Change::table
+    const std::vector<std::string>& names()
+    {
+        return m_names;
+    }
+
+
+    /**
+     * \brief Take all committed changes, oldest first
+     *
+     * \param[out] changes Changes
+     * \returns Number of changes lost by ring buffer overflow since last taken
+     */
+    double take( std::vector<Change>& changes )
+    {
+        double lost = m_lost;
+
+        changes.clear();
+        changes.reserve( m_count );
+
+        for( size_t i = 0; i < m_count; i++ )
+        {
+            changes.push_back( m_ring[( m_head + i ) % m_ring.size()] );
+        }
+
+        m_head  = 0;
+        m_count = 0;
+        m_lost  = 0.0;
+
+        return lost;
+    }
+
+
+private:
+    /// Table index of \p name, -1 if not tracked
+    int lookup( const char* name )
+    {
+        if( m_last >= 0 && 0 == sqlite3_stricmp( m_names[m_last].c_str(), name ) )
+        {
+            return m_last;
+        }
+
+        for( size_t i = 0; i < m_names.size(); i++ )
+        {
+            if( 0 == sqlite3_stricmp( m_names[i].c_str(), name ) )
+            {
+                return m_last = (int)i;
+            }
+        }
+
+        if( !m_all )
+        {
+            return -1;
+        }
+
+        m_names.push_back( name );
+        return m_last = (int)m_names.size() - 1;
+    }
+
+
+    /// Update hook: a row of \p table changed (pending until commit)
+    static void onUpdate( void* p, int op, const char* dbname, const char* table, sqlite3_int64 rowid )
+    {
+        ChangeFeed* self  = (ChangeFeed*)p;
+        int         index = self->lookup( table );
+
+        if( !self->m_frames.empty() )
+        {
+            self->m_frames.back().events++;
+        }
+
+        if( index < 0 )
+        {
+            return;
+        }
+
+        // a transaction larger than the ring buffer would overflow it anyway
+        if( self->m_pending.size() >= self->m_ring.size() )
+        {
+            self->m_pendingLost++;
+            return;
+        }
+
+        Change change = { index, op, rowid };
+        self->m_pending.push_back( change );
+    }
+
+
+    /// Commit hook: pending changes become visible
+    static int onCommit( void* p )
+    {
+        ChangeFeed* self = (ChangeFeed*)p;
+        size_t      size = self->m_ring.size();
+
+        for( size_t i = 0; i < self->m_pending.size(); i++ )
+        {
+            if( self->m_count == size )
+            {
+                // overwrite the oldest change
+                self->m_head = ( self->m_head + 1 ) % size;
+                self->m_count--;
+                self->m_lost++;
+            }
+
+            self->m_ring[( self->m_head + self->m_count ) % size] = self->m_pending[i];
+            self->m_count++;
+        }
+
+        self->m_lost += self->m_pendingLost;
+        self->m_pending.clear();
+        self->m_pendingLost = 0.0;
+        self->m_savepoints.clear();
+
+        return 0;   // don't veto
+    }
+
+
+    /// Rollback hook: pending changes are discarded
+    static void onRollback( void* p )
+    {
+        ChangeFeed* self = (ChangeFeed*)p;
+
+        self->m_pending.clear();
+        self->m_pendingLost = 0.0;
+        self->m_savepoints.clear();
+    }
+
+
+    /// Discard pending changes made after \p pending changes were recorded
+    void discard( size_t pending, double pendingLost )
+    {
+        if( pending < m_pending.size() )
+        {
+            m_pending.resize( pending );
+        }
+
+        if( pendingLost < m_pendingLost )
+        {
+            m_pendingLost = pendingLost;
+        }
+    }
+
+
+    /**
+     * \brief Trace callback: brackets statements, follows savepoints
+     *
+     * SQLITE_TRACE_STMT is reported when a statement starts (its SQL text,
+     * trigger programs and nested statements have a "--" comment instead),
+     * SQLITE_TRACE_PROFILE when it ends. A rolled back statement (failing
+     * constraint with ABORT) reports no changes, while changes made by
+     * triggers are counted by sqlite3_total_changes() even then. So the
+     * update hook calls of a statement without changes are undone, if
+     * they weren't counted.
+     */
+    static int onTrace( unsigned type, void* p, void* stmt, void* x )
+    {
+        ChangeFeed*   self = (ChangeFeed*)p;
+        sqlite3_stmt* pStmt = (sqlite3_stmt*)stmt;
+
+        if( type == SQLITE_TRACE_STMT )
+        {
+            if( (const char*)x == sqlite3_sql( pStmt ) )
+            {
+                self->savepoint( (const char*)x );
+
+                Frame frame = { pStmt, self->m_pending.size(), self->m_pendingLost,
+                                sqlite3_total_changes( self->m_db ), 0 };
+                self->m_frames.push_back( frame );
+            }
+        }
+        else if( type == SQLITE_TRACE_PROFILE )
+        {
+            for( size_t i = self->m_frames.size(); i > 0; i-- )
+            {
+                Frame& frame = self->m_frames[i-1];
+
+                if( frame.stmt == pStmt )
+                {
+                    if( frame.events > 0 && 0 == sqlite3_changes( self->m_db ) &&
+                        sqlite3_total_changes( self->m_db ) - frame.total < frame.events )
+                    {
+                        self->discard( frame.pending, frame.pendingLost );
+                    }
+
+                    self->m_frames.erase( self->m_frames.begin() + ( i - 1 ) );
+                    break;
+                }
+            }
+        }
+
+        return 0;
+    }
+
+
+    /// Skip white space and comments
+    static const char* skipSpace( const char* s )
+    {
+        for(;;)
+        {
+            if( isspace( (unsigned char)*s ) )
+            {
+                s++;
+            }
+            else if( s[0] == '-' && s[1] == '-' )
+            {
+                while( *s && *s != '\n' ) s++;
+            }
+            else if( s[0] == '/' && s[1] == '*' )
+            {
+                const char* end = strstr( s + 2, "*/" );
+                s = end ? end + 2 : s + strlen( s );
+            }
+            else
+            {
+                return s;
+            }
+        }
+    }
+
+
+    /// Consume keyword \p kw at \p s (advanced past it and white space on match)
+    static bool keyword( const char*& s, const char* kw )
+    {
+        size_t len = strlen( kw );
+
+        if( 0 != sqlite3_strnicmp( s, kw, (int)len ) || isalnum( (unsigned char)s[len] ) || s[len] == '_' )
+        {
+            return false;
+        }
+
+        s = skipSpace( s + len );
+        return true;
+    }
+
+
+    /// Name at \p s (identifier, quoted by "", '', [] or ``)
+    static std::string name( const char* s )
+    {
+        std::string result;
+        char        close = 0;
+
+        switch( *s )
+        {
+            case '"': case '\'': case '`': close = *s++; break;
+            case '[': close = ']'; s++; break;
+        }
+
+        for( ; *s; s++ )
+        {
+            if( close )
+            {
+                if( *s == close )
+                {
+                    if( close == ']' || s[1] != close )
+                    {
+                        break;
+                    }
+                    s++;    // doubled quote
+                }
+            }
+            else if( !isalnum( (unsigned char)*s ) && *s != '_' && *s != '$' && !( *s & 0x80 ) )
+            {
+                break;
+            }
+            result += *s;
+        }
+
+        return result;
+    }
+
+
+    /// Index of the innermost savepoint \p name, -1 if none
+    int findSavepoint( const std::string& name )
+    {
+        for( size_t i = m_savepoints.size(); i > 0; i-- )
+        {
+            if( 0 == sqlite3_stricmp( m_savepoints[i-1].name.c_str(), name.c_str() ) )
+            {
+                return (int)i - 1;
+            }
+        }
+
+        return -1;
+    }
+
+
+    /// Follow SAVEPOINT, RELEASE and ROLLBACK TO statements
+    void savepoint( const char* sql )
+    {
+        const char* s = skipSpace( sql );
+
+        if( keyword( s, "SAVEPOINT" ) )
+        {
+            Savepoint sp = { name( s ), m_pending.size(), m_pendingLost };
+            m_savepoints.push_back( sp );
+        }
+        else if( keyword( s, "RELEASE" ) )
+        {
+            keyword( s, "SAVEPOINT" );
+
+            int i = findSavepoint( name( s ) );
+            if( i >= 0 )
+            {
+                m_savepoints.resize( i );
+            }
+        }
+        else if( keyword( s, "ROLLBACK" ) )
+        {
+            keyword( s, "TRANSACTION" );
+
+            if( keyword( s, "TO" ) )
+            {
+                keyword( s, "SAVEPOINT" );
+
+                int i = findSavepoint( name( s ) );
+                if( i >= 0 )
+                {
+                    // the savepoint itself remains
+                    discard( m_savepoints[i].pending, m_savepoints[i].pendingLost );
+                    m_savepoints.resize( i + 1 );
+                }
+            }
+        }
+    }
+
+
+    /**
+     * \brief Authorizer: keep "DELETE FROM table" from bypassing the update hook
+     *
+     * A DELETE without WHERE clause truncates the table and doesn't call
+     * the update hook. Returning SQLITE_IGNORE for the delete action
+     * disables this optimization, the statement is executed as usual.
+     * DROP TABLE (VIEW) authorizes deletes from the table and from
+     * sqlite_master, which must not be ignored (it wouldn't be dropped).
+     */
+    static int onAuthorize( void* p, int action, const char* arg1, const char* arg2, const char* dbname, const char* trigger )
+    {
+        ChangeFeed* self     = (ChangeFeed*)p;
+        bool        dropping = self->m_dropping;
+
+        self->m_dropping = false;
+
+        switch( action )
+        {
+            case SQLITE_DROP_TABLE:
+            case SQLITE_DROP_TEMP_TABLE:
+            case SQLITE_DROP_VIEW:
+            case SQLITE_DROP_TEMP_VIEW:
+            case SQLITE_DROP_VTABLE:
+                self->m_dropping = true;
+                break;
+
+            case SQLITE_DELETE:
+                if( !dropping && arg1 && 0 != sqlite3_strnicmp( arg1, "sqlite_", 7 ) && self->isTracked( arg1 ) )
+                {
+                    return SQLITE_IGNORE;
+                }
+                break;
+        }
+
+        return SQLITE_OK;
+    }
+
+
+    /// Returns true if changes of \p name are tracked (doesn't add it to the names)
+    bool isTracked( const char* name )
+    {
+        if( m_all )
+        {
+            return true;
+        }
+
+        for( size_t i = 0; i < m_names.size(); i++ )
+        {
+            if( 0 == sqlite3_stricmp( m_names[i].c_str(), name ) )
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
@@ -0,0 +1,430 @@
+/**
+ *  <!-- mksqlite: A MATLAB Interface to SQLite -->
+ *
+ *  @file      changeset.hpp
+ *  @brief     Incremental sync of databases by changesets
+ *  @details   A session (SQLite session extension) records the changes of
+ *             the tables attached. Its changeset holds the inserted,
+ *             updated (primary key, old and new values) and deleted rows,
+ *             which is applied to another database with a copy of the
+ *             tables. Conflicts (rows changed or missing there) are
+ *             resolved by a policy. Taking a changeset restarts the
+ *             session, so each changeset holds the changes since the
+ *             previous one.
+ *  @see       https://www.sqlite.org/sessionintro.html
+ *  @authors   Martin Kortmann <mail@kortmann.de>,
+ *             Andreas Martin  <andimartin@users.sourceforge.net>
+ *  @version   2.5
+ *  @date      2008-2017
+ *  @copyright Distributed under LGPL
+ *  @pre       SQLite built with SQLITE_ENABLE_SESSION and
+ *             SQLITE_ENABLE_PREUPDATE_HOOK (see buildit.m)
+ *  @warning   Tables without PRIMARY KEY aren't recorded.
+ *  @bug
+ */
+
+#pragma once
+
+//#include "config.h"
+//#include "sqlite/sqlite3.h"
+//#include "locale.hpp"
+#include <string>
+#include <vector>
+#include <cstring>
+
+
+/**
+ * \brief Session recording the changes of one database
+ */
+class ChangesetSession
+{
+public:
+    /// Conflict resolution when a changeset is applied
+    enum policy_e
+    {
+        POLICY_ABORT,       ///< Apply no change at all (default)
+        POLICY_OMIT,        ///< Skip conflicting changes
+        POLICY_REPLACE      ///< Overwrite conflicting rows (skip changes of missing rows)
+    };
+
+    /// Conflicts by kind (see sqlite3changeset_apply())
+    struct Conflicts
+    {
+        int     data;           ///< Row to update or delete has different values
+        int     notfound;       ///< Row to update or delete doesn't exist
+        int     conflict;       ///< Row to insert exists (primary key)
+        int     constraint;     ///< Other constraint violated
+        int     foreign_key;    ///< Foreign keys violated by the changeset
+
+        Conflicts() : data( 0 ), notfound( 0 ), conflict( 0 ), constraint( 0 ), foreign_key( 0 ) {}
+
+        /// Sum of all conflicts
+        int total() const
+        {
+            return data + notfound + conflict + constraint + foreign_key;
+        }
+    };
+
+private:
+    sqlite3*                    m_db;       ///< Database connection
+    sqlite3_session*            m_session;  ///< Session recording the main database
+    std::vector<std::string>    m_tables;   ///< Tables attached, all if empty
+
+    /// State of sqlite3changeset_apply()
+    struct ApplyContext
+    {
+        policy_e    policy;     ///< Conflict resolution
+        Conflicts   conflicts;  ///< Conflicts counted
+    };
+
+    /// inhibit copy constructor and assignment operator
+    /// @{
+    ChangesetSession( const ChangesetSession& );
+    ChangesetSession& operator=( const ChangesetSession& );
+    /// @}
+
+public:
+    /// Standard ctor
+    ChangesetSession() : m_db( NULL ), m_session( NULL )
+    {
+    }
+
+
+    /// Dtor
+    ~ChangesetSession()
+    {
+        stop();
+    }
+
+
+    /**
+     * \brief Start recording changes (a running session is restarted)
+     *
+     * \param[in] db Database connection
+     * \param[in] tables Tables to record, all tables if empty
+     * \returns SQLite result code
+     */
+    int start( sqlite3* db, const std::vector<std::string>& tables )
+    {
+        stop();
+
+        m_db     = db;
+        m_tables = tables;
+
+        int rc = open();
+
+        if( SQLITE_OK != rc )
+        {
+            m_db = NULL;
+            m_tables.clear();
+        }
+
+        return rc;
+    }
+
+
+    /// Stop recording, changes not taken are discarded
+    void stop()
+    {
+        if( m_session )
+        {
+            sqlite3session_delete( m_session );
+            m_session = NULL;
+        }
+
+        m_db = NULL;
+        m_tables.clear();
+    }
+
+
+    /// Returns true if changes are recorded
+    bool running()
+    {
+        return NULL != m_session;
+    }
+
+
+    /**
+     * \brief Take the changeset and restart the session
+     *
+     * \param[out] changeset Changes since the session started
+     * \returns SQLite result code
+     */
+    int take( std::string& changeset )
+    {
+        int     size = 0;
+        void*   data = NULL;
+        int     rc   = sqlite3session_changeset( m_session, &size, &data );
+
+        if( SQLITE_OK == rc )
+        {
+            changeset.assign( (const char*)data, (size_t)size );
+
+            sqlite3session_delete( m_session );
+            m_session = NULL;
+            rc = open();
+        }
+
+        sqlite3_free( data );
+
+        return rc;
+    }
+
+
+    /**
+     * \brief Apply a changeset in one transaction
+     *
+     * \param[in] db Database connection
+     * \param[in] changeset Changeset (see take())
+     * \param[in] policy Conflict resolution
+     * \param[out] conflicts Conflicts occurred
+     * \returns SQLite result code, SQLITE_ABORT if a conflict rolled back the changeset,
+     *          SQLITE_CORRUPT if the changeset is malformed
+     */
+    static int apply( sqlite3* db, const std::string& changeset, policy_e policy, Conflicts& conflicts )
+    {
+        ApplyContext context;
+
+        context.policy = policy;
+
+        if( !isWellFormed( changeset ) )
+        {
+            return SQLITE_CORRUPT;
+        }
+
+        int rc = sqlite3changeset_apply( db, (int)changeset.size(), (void*)changeset.data(),
+                                         NULL, &ChangesetSession::onConflict, &context );
+
+        conflicts = context.conflicts;
+
+        return rc;
+    }
+
+
+private:
+    /// Create the session and attach the tables
+    int open()
+    {
+        int rc = sqlite3session_create( m_db, "main", &m_session );
+
+        if( SQLITE_OK != rc )
+        {
+            m_session = NULL;
+            return rc;
+        }
+
+        if( m_tables.empty() )
+        {
+            rc = sqlite3session_attach( m_session, NULL );
+        }
+
+        for( size_t i = 0; SQLITE_OK == rc && i < m_tables.size(); i++ )
+        {
+            rc = sqlite3session_attach( m_session, m_tables[i].c_str() );
+        }
+
+        if( SQLITE_OK != rc )
+        {
+            sqlite3session_delete( m_session );
+            m_session = NULL;
+        }
+
+        return rc;
+    }
+
+
+    /// Read a varint (SQLite format) at \p pos, returns false beyond \p end
+    static bool getVarint( const unsigned char*& pos, const unsigned char* end, uint64_t& value )
+    {
+        value = 0;
+
+        for( int i = 0; i < 9; i++ )
+        {
+            if( pos >= end )
+            {
+                return false;
+            }
+
+            unsigned char byte = *pos++;
+
+            if( i == 8 )
+            {
+                value = ( value << 8 ) | byte;
+                return true;
+            }
+
+            value = ( value << 7 ) | ( byte & 0x7f );
+
+            if( !( byte & 0x80 ) )
+            {
+                return true;
+            }
+        }
+
+        return true;
+    }
+
+
+    /// Skip a record of \p nCol values, returns false if truncated or malformed
+    static bool skipRecord( const unsigned char*& pos, const unsigned char* end, uint64_t nCol )
+    {
+        for( uint64_t i = 0; i < nCol; i++ )
+        {
+            uint64_t bytes = 0;
+
+            if( pos >= end )
+            {
+                return false;
+            }
+
+            switch( *pos++ )
+            {
+                case 0:                 // undefined (unchanged column)
+                case SQLITE_NULL:
+                    break;
+
+                case SQLITE_INTEGER:
+                case SQLITE_FLOAT:
+                    bytes = 8;
+                    break;
+
+                case SQLITE_TEXT:
+                case SQLITE_BLOB:
+                    if( !getVarint( pos, end, bytes ) )
+                    {
+                        return false;
+                    }
+                    break;
+
+                default:
+                    return false;
+            }
+
+            if( bytes > (uint64_t)( end - pos ) )
+            {
+                return false;
+            }
+
+            pos += bytes;
+        }
+
+        return true;
+    }
+
+
+    /**
+     * \brief Check the structure of a changeset
+     *
+     * SQLite (3.24) doesn't terminate on some truncated changesets, so
+     * foreign data is checked before it's applied. Patchsets are
+     * rejected.
+     */
+    static bool isWellFormed( const std::string& changeset )
+    {
+        const unsigned char* pos  = (const unsigned char*)changeset.data();
+        const unsigned char* end  = pos + changeset.size();
+        uint64_t             nCol = 0;
+
+        while( pos < end )
+        {
+            unsigned char op = *pos++;
+
+            if( 'T' == op )
+            {
+                // table header: column count, primary key flags, name
+                if( !getVarint( pos, end, nCol ) || !nCol || nCol > 65536 || nCol > (uint64_t)( end - pos ) )
+                {
+                    return false;
+                }
+
+                pos += nCol;
+                pos  = (const unsigned char*)memchr( pos, 0, end - pos );
+
+                if( !pos )
+                {
+                    return false;
+                }
+
+                pos++;
+                continue;
+            }
+
+            // change: operation, indirect flag, record(s)
+            if( !nCol || pos >= end )
+            {
+                return false;
+            }
+
+            pos++;
+
+            switch( op )
+            {
+                case SQLITE_INSERT:
+                case SQLITE_DELETE:
+                    if( !skipRecord( pos, end, nCol ) )
+                    {
+                        return false;
+                    }
+                    break;
+
+                case SQLITE_UPDATE:
+                    if( !skipRecord( pos, end, nCol ) || !skipRecord( pos, end, nCol ) )
+                    {
+                        return false;
+                    }
+                    break;
+
+                default:
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+
+    /// Conflict handler of sqlite3changeset_apply()
+    static int onConflict( void* p, int eConflict, sqlite3_changeset_iter* iter )
+    {
+        ApplyContext* context = (ApplyContext*)p;
+        bool          bCanReplace = false;
+
+        switch( eConflict )
+        {
+            case SQLITE_CHANGESET_DATA:
+                context->conflicts.data++;
+                bCanReplace = true;
+                break;
+
+            case SQLITE_CHANGESET_CONFLICT:
+                context->conflicts.conflict++;
+                bCanReplace = true;
+                break;
+
+            case SQLITE_CHANGESET_NOTFOUND:
+                context->conflicts.notfound++;
+                break;
+
+            case SQLITE_CHANGESET_CONSTRAINT:
+                context->conflicts.constraint++;
+                break;
+
+            case SQLITE_CHANGESET_FOREIGN_KEY:
+                context->conflicts.foreign_key++;
+                break;
+        }
+
+        switch( context->policy )
+        {
+            case POLICY_OMIT:
+                return SQLITE_CHANGESET_OMIT;
+
+            case POLICY_REPLACE:
+                // REPLACE is valid for differing or existing rows only
+                return bCanReplace ? SQLITE_CHANGESET_REPLACE : SQLITE_CHANGESET_OMIT;
+
+            default:
+                return SQLITE_CHANGESET_ABORT;
+        }
+    }
+};
@@ -0,0 +1,476 @@
+/**
+ *  <!-- mksqlite: A MATLAB Interface to SQLite -->
+ *
+ *  @file      checkpoint.hpp
+ *  @brief     Background WAL checkpoints
+ *  @details   In WAL mode SQLite checkpoints automatically on the commit
+ *             which lets the WAL exceed 1000 pages, so a random INSERT
+ *             pays for copying the whole WAL back into the database. The
+ *             checkpointer takes this off the database connection: a WAL
+ *             hook replaces the automatic checkpoint and reports the WAL
+ *             size, a worker thread with its own connection checkpoints.
+ *  @authors   Martin Kortmann <mail@kortmann.de>,
+ *             Andreas Martin  <andimartin@users.sourceforge.net>
+ *  @version   2.5
+ *  @date      2008-2017
+ *  @copyright Distributed under LGPL
+ *  @pre
+ *  @warning
+ *  @bug
+ */
+
+#pragma once
+
+//#include "config.h"
+//#include "sqlite/sqlite3.h"
+//#include "utils.hpp"
+//#include "locale.hpp"
+#include <cstring>
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+  #include "blosc/win32/pthread.h"
+#else
+  #include <pthread.h>
+#endif
+
+/**
+ * \file
+ * Checkpoint policy of the worker thread, woken every interval:
+ * - PASSIVE when the WAL holds \p threshold frames not yet checkpointed.
+ *   It never waits for locks, readers limit how far it gets.
+ * - RESTART when the WAL grew to CHECKPOINT_RESTART_FACTOR times
+ *   \p threshold frames, but less than \p threshold are left to copy.
+ *   Under steady writes the WAL is never completely checkpointed at the
+ *   moment of a commit, so writers wouldn't wrap it around otherwise.
+ * - RESTART when no commit happened during the last interval and frames
+ *   are left, so the next writer starts at the beginning of the WAL
+ *   instead of letting it grow.
+ * - TRUNCATE when idle for CHECKPOINT_TRUNCATE_MS, which releases the
+ *   disk space of the WAL file.
+ *
+ * The worker's connection has no busy handler: RESTART and TRUNCATE give
+ * up immediately (counted as busy) instead of stalling readers or writers.
+ * A writer committing in a tight loop holds the write lock most of the
+ * time, so the worker may fall behind. When the WAL exceeds
+ * CHECKPOINT_LIMIT_FACTOR times \p threshold frames the writer runs a
+ * PASSIVE checkpoint itself after its commit (counted as forced), as the
+ * automatic checkpoint would, after waiting for a running checkpoint of
+ * the worker. Its next write transaction starts the WAL
+ * over, unless readers held frames back. This bounds the WAL at the
+ * expense of that commit's latency.
+ */
+
+#define CHECKPOINT_TRUNCATE_MS  1000    ///< idle time (ms) before the WAL file is truncated
+#define CHECKPOINT_SLICE_MS     10      ///< granularity (ms) of the worker's waits
+#define CHECKPOINT_RESTART_FACTOR 4     ///< WAL size (in thresholds) for a RESTART under load
+#define CHECKPOINT_LIMIT_FACTOR 8       ///< WAL size (in thresholds) for a checkpoint by the writer
+#define CHECKPOINT_AUTO_DEFAULT 1000    ///< SQLite's automatic checkpoint threshold (pages)
+
+
+/**
+ * \brief Checkpoint manager of one database in WAL mode
+ */
+class WalCheckpointer
+{
+public:
+    /// Statistics
+    struct Stats
+    {
+        bool            running;        ///< Worker thread active
+        int             threshold;      ///< WAL frames triggering a passive checkpoint
+        int             interval_ms;    ///< Wake-up interval of the worker
+        int             wal_frames;     ///< Frames in the WAL (last commit)
+        int             backlog;        ///< Frames not checkpointed by the last attempt (held by readers)
+        double          checkpointed;   ///< Total frames copied to the database
+        int             passive;        ///< Number of PASSIVE checkpoints
+        int             restart;        ///< Number of RESTART checkpoints
+        int             truncate;       ///< Number of TRUNCATE checkpoints
+        int             forced;         ///< Number of checkpoints by the writer (WAL over the limit)
+        int             busy;           ///< Attempts refused due to locks
+        double          last_ms;        ///< Duration of the last checkpoint
+        double          max_ms;         ///< Longest checkpoint
+        double          total_ms;       ///< Total time spent in checkpoints
+
+        Stats() : running( false ), threshold( 0 ), interval_ms( 0 ), wal_frames( 0 ), backlog( 0 ),
+                  checkpointed( 0.0 ), passive( 0 ), restart( 0 ), truncate( 0 ), forced( 0 ), busy( 0 ),
+                  last_ms( 0.0 ), max_ms( 0.0 ), total_ms( 0.0 ) {}
+    };
+
+private:
+    sqlite3*            m_db;           ///< User connection (wal hook installed)
+    sqlite3*            m_ckpt;         ///< Connection of the worker thread
+    pthread_t           m_thread;       ///< Worker thread
+    pthread_mutex_t     m_mutex;        ///< Protects m_stats, m_commits and m_stop
+    pthread_mutex_t     m_ckptMutex;    ///< Held while checkpointing (writer waits for the worker)
+    Stats               m_stats;        ///< Statistics
+    long                m_commits;      ///< Commits reported by the wal hook
+    bool                m_stop;         ///< Worker shall terminate
+    int                 m_autoCheckpoint;   ///< Automatic checkpoint (pages) before start, restored on stop
+
+    /// inhibit copy constructor and assignment operator
+    /// @{
+    WalCheckpointer( const WalCheckpointer& );
+    WalCheckpointer& operator=( const WalCheckpointer& );
+    /// @}
+
+public:
+    /// Standard ctor
+    WalCheckpointer() : m_db( NULL ), m_ckpt( NULL ), m_commits( 0 ), m_stop( false ), m_autoCheckpoint( CHECKPOINT_AUTO_DEFAULT )
+    {
+        pthread_mutex_init( &m_mutex, NULL );
+        pthread_mutex_init( &m_ckptMutex, NULL );
+    }
+
+
+    /// Dtor
+    ~WalCheckpointer()
+    {
+        stop();
+        pthread_mutex_destroy( &m_mutex );
+        pthread_mutex_destroy( &m_ckptMutex );
+    }
+
+
+    /**
+     * \brief Start checkpointing (restarts a running checkpointer)
+     *
+     * \param[in] db Database connection, main database in WAL mode
+     * \param[in] threshold WAL frames triggering a passive checkpoint
+     * \param[in] interval_ms Wake-up interval of the worker in milliseconds
+     * \returns Error ID (see \ref MSG_IDS)
+     */
+    int start( sqlite3* db, int threshold, int interval_ms )
+    {
+        const char* filename = sqlite3_db_filename( db, "main" );
+
+        stop();
+
+        if( !filename || !*filename || !isWal( db ) )
+        {
+            return MSG_NOTWALMODE;
+        }
+
+        // a new connection attaches to the WAL by its first read
+        if( SQLITE_OK != sqlite3_open_v2( filename, &m_ckpt, SQLITE_OPEN_READWRITE, NULL ) || !isWal( m_ckpt ) )
+        {
+            sqlite3_close( m_ckpt );
+            m_ckpt = NULL;
+            return MSG_CANTOPEN;
+        }
+
+        m_db      = db;
+        m_stop    = false;
+        m_commits = 0;
+        m_stats   = Stats();
+        m_stats.threshold   = threshold > 0 ? threshold : CHECKPOINT_AUTO_DEFAULT;
+        m_stats.interval_ms = interval_ms > 0 ? interval_ms : 100;
+        m_stats.running     = true;
+        m_autoCheckpoint    = autoCheckpoint( db );
+
+        // replaces the automatic checkpoint on commit
+        sqlite3_wal_hook( m_db, &WalCheckpointer::walHook, this );
+
+        if( 0 != pthread_create( &m_thread, NULL, &WalCheckpointer::worker, this ) )
+        {
+            m_stats.running = false;
+            stop();
+            return MSG_ERRINTERNAL;
+        }
+
+        return MSG_NOERROR;
+    }
+
+
+    /// Stop the worker and restore the automatic checkpoint
+    void stop()
+    {
+        if( !m_db )
+        {
+            return;
+        }
+
+        if( m_stats.running )
+        {
+            pthread_mutex_lock( &m_mutex );
+            m_stop = true;
+            pthread_mutex_unlock( &m_mutex );
+
+            pthread_join( m_thread, NULL );
+            m_stats.running = false;
+        }
+
+        // 0 (disabled) removes the wal hook
+        sqlite3_wal_autocheckpoint( m_db, m_autoCheckpoint );
+        sqlite3_close( m_ckpt );
+        m_ckpt = NULL;
+        m_db   = NULL;
+    }
+
+
+    /// Returns true if the worker is active
+    bool running()
+    {
+        return NULL != m_db;
+    }
+
+
+    /// Get a snapshot of the statistics
+    Stats stats()
+    {
+        pthread_mutex_lock( &m_mutex );
+        Stats stats = m_stats;
+        pthread_mutex_unlock( &m_mutex );
+
+        return stats;
+    }
+
+
+    /// Returns true if the journal mode of the main database is WAL
+    static bool isWal( sqlite3* db )
+    {
+        sqlite3_stmt* stmt = NULL;
+        bool wal = false;
+
+        if( SQLITE_OK == sqlite3_prepare_v2( db, "PRAGMA main.journal_mode;", -1, &stmt, NULL )
+            && SQLITE_ROW == sqlite3_step( stmt ) )
+        {
+            const char* mode = (const char*)sqlite3_column_text( stmt, 0 );
+            wal = mode && 0 == strcmp( mode, "wal" );
+        }
+
+        sqlite3_finalize( stmt );
+        return wal;
+    }
+
+
+    /// Returns the automatic checkpoint threshold (pages) of \p db, 0 if disabled
+    static int autoCheckpoint( sqlite3* db )
+    {
+        sqlite3_stmt* stmt = NULL;
+        int pages = CHECKPOINT_AUTO_DEFAULT;
+
+        if( SQLITE_OK == sqlite3_prepare_v2( db, "PRAGMA wal_autocheckpoint;", -1, &stmt, NULL )
+            && SQLITE_ROW == sqlite3_step( stmt ) )
+        {
+            pages = sqlite3_column_int( stmt, 0 );
+        }
+
+        sqlite3_finalize( stmt );
+        return pages;
+    }
+
+
+private:
+    /// WAL hook, called by the user connection after each commit
+    static int walHook( void* arg, sqlite3* db, const char* dbname, int nFrames )
+    {
+        WalCheckpointer* self = (WalCheckpointer*)arg;
+
+        if( 0 == strcmp( dbname, "main" ) )
+        {
+            pthread_mutex_lock( &self->m_mutex );
+            self->m_stats.wal_frames = nFrames;
+            self->m_commits++;
+            bool bLimit = nFrames >= CHECKPOINT_LIMIT_FACTOR * self->m_stats.threshold;
+            pthread_mutex_unlock( &self->m_mutex );
+
+            if( bLimit )
+            {
+                // the worker fell behind, the writer waits for its checkpoint
+                // and checkpoints itself (doesn't wait for readers)
+                int     nLog  = 0;
+                int     nCkpt = 0;
+                double  t0    = ::utils_get_wall_time();
+
+                pthread_mutex_lock( &self->m_ckptMutex );
+                int     rc    = sqlite3_wal_checkpoint_v2( db, dbname, SQLITE_CHECKPOINT_PASSIVE, &nLog, &nCkpt );
+                pthread_mutex_unlock( &self->m_ckptMutex );
+
+                double  ms    = ( ::utils_get_wall_time() - t0 ) * 1000.0;
+
+                pthread_mutex_lock( &self->m_mutex );
+
+                self->m_stats.last_ms   = ms;
+                self->m_stats.total_ms += ms;
+                self->m_stats.max_ms    = ms > self->m_stats.max_ms ? ms : self->m_stats.max_ms;
+
+                if( SQLITE_OK == rc )
+                {
+                    self->m_stats.forced++;
+                    self->m_stats.backlog = nLog > nCkpt ? nLog - nCkpt : 0;
+                }
+                else
+                {
+                    self->m_stats.busy++;
+                }
+
+                pthread_mutex_unlock( &self->m_mutex );
+            }
+        }
+
+        return SQLITE_OK;
+    }
+
+
+    /// Thread function
+    static void* worker( void* arg )
+    {
+        WalCheckpointer* self = (WalCheckpointer*)arg;
+
+        self->run();
+
+        return NULL;
+    }
+
+
+    /// Worker loop
+    void run()
+    {
+        long    lastCommits = 0;
+        int     backfilled  = 0;    // frames of the current WAL already checkpointed
+        int     idle_ms     = 0;
+        bool    truncated   = true;
+        int     slept_ms    = 0;
+
+        for( ;; )
+        {
+            ::utils_sleep_ms( CHECKPOINT_SLICE_MS );
+            slept_ms += CHECKPOINT_SLICE_MS;
+
+            pthread_mutex_lock( &m_mutex );
+            bool  bStop     = m_stop;
+            long  commits   = m_commits;
+            int   frames    = m_stats.wal_frames;
+            int   threshold = m_stats.threshold;
+            int   interval  = m_stats.interval_ms;
+            pthread_mutex_unlock( &m_mutex );
+
+            if( bStop )
+            {
+                break;
+            }
+
+            if( slept_ms < interval )
+            {
+                continue;
+            }
+
+            slept_ms = 0;
+
+            if( commits != lastCommits )
+            {
+                truncated = false;
+                idle_ms   = 0;
+            }
+            else
+            {
+                idle_ms += interval;
+            }
+
+            if( frames < backfilled )
+            {
+                // the WAL was restarted by a writer
+                backfilled = 0;
+            }
+
+            int mode = -1;
+
+            if( frames >= CHECKPOINT_LIMIT_FACTOR * threshold )
+            {
+                // over the limit the writer checkpoints, don't compete for the lock
+            }
+            else if( frames - backfilled >= threshold )
+            {
+                mode = SQLITE_CHECKPOINT_PASSIVE;
+            }
+            else if( frames >= CHECKPOINT_RESTART_FACTOR * threshold )
+            {
+                mode = SQLITE_CHECKPOINT_RESTART;
+            }
+            else if( commits == lastCommits && !truncated )
+            {
+                if( frames > backfilled )
+                {
+                    mode = SQLITE_CHECKPOINT_RESTART;
+                }
+                else if( idle_ms >= CHECKPOINT_TRUNCATE_MS )
+                {
+                    mode = SQLITE_CHECKPOINT_TRUNCATE;
+                }
+            }
+
+            lastCommits = commits;
+
+            if( mode >= 0 )
+            {
+                checkpoint( mode, frames, backfilled, truncated );
+            }
+
+            // a passive checkpoint left little to copy, wrap a large WAL around
+            if( SQLITE_CHECKPOINT_PASSIVE == mode 
+                && frames >= CHECKPOINT_RESTART_FACTOR * threshold && frames - backfilled < threshold )
+            {
+                checkpoint( SQLITE_CHECKPOINT_RESTART, frames, backfilled, truncated );
+            }
+        }
+    }
+
+
+    /// Run a checkpoint on the worker's connection and update the statistics
+    void checkpoint( int mode, int& frames, int& backfilled, bool& truncated )
+    {
+        int     nLog  = 0;
+        int     nCkpt = 0;
+        double  t0    = ::utils_get_wall_time();
+
+        pthread_mutex_lock( &m_ckptMutex );
+        int     rc    = sqlite3_wal_checkpoint_v2( m_ckpt, "main", mode, &nLog, &nCkpt );
+        pthread_mutex_unlock( &m_ckptMutex );
+
+        double  ms    = ( ::utils_get_wall_time() - t0 ) * 1000.0;
+
+        pthread_mutex_lock( &m_mutex );
+
+        m_stats.last_ms   = ms;
+        m_stats.total_ms += ms;
+        m_stats.max_ms    = ms > m_stats.max_ms ? ms : m_stats.max_ms;
+
+        if( SQLITE_OK == rc )
+        {
+            m_stats.checkpointed += nCkpt > backfilled ? nCkpt - backfilled : 0;
+            m_stats.backlog       = nLog > nCkpt ? nLog - nCkpt : 0;
+            frames                = nLog;
+            backfilled            = nCkpt;
+
+            switch( mode )
+            {
+                case SQLITE_CHECKPOINT_PASSIVE:
+                    m_stats.passive++;
+                    break;
+
+                case SQLITE_CHECKPOINT_RESTART:
+                    m_stats.restart++;
+                    break;
+
+                default:
+                    m_stats.truncate++;
+                    truncated = true;
+                    break;
+            }
+
+            if( SQLITE_CHECKPOINT_PASSIVE != mode )
+            {
+                // the next writer starts at the beginning of the WAL
+                m_stats.wal_frames = 0;
+                frames     = 0;
+                backfilled = 0;
+            }
+        }
+        else
+        {
+            m_stats.busy++;
+        }
+
+        pthread_mutex_unlock( &m_mutex );
+    }
+};
@@ -31,6 +31,9 @@
 /// Flag: check compressed against original data
 #define CONFIG_COMPRESSION_CHECK      BOOL_TRUE     ///< check is on by default
 
+/// Flag: store logical arrays in typed blobs as packed bits
+#define CONFIG_BITPACK_LOGICALS       BOOL_FALSE    ///< one byte per element by default (compatible with older versions)
+
 /// Convert UTF-8 to ascii, otherwise set slCharacterEncoding('UTF-8')
 #define CONFIG_CONVERT_UTF8           BOOL_TRUE     ///< use UTF8 encoding by default
 
@@ -46,9 +49,22 @@
         RESULT_TYPE_ARRAYOFSTRUCTS, ///< Array of structs
         RESULT_TYPE_STRUCTOFARRAYS, ///< Struct of arrays
         RESULT_TYPE_MATRIX,         ///< Matrix/cell array
+        RESULT_TYPE_HANDLE,         ///< Handle to native column buffers (see lazy_result.hpp)
     
         /// Limit for bound checking only
-        RESULT_TYPE_MAX_ID = RESULT_TYPE_MATRIX
+        RESULT_TYPE_MAX_ID = RESULT_TYPE_HANDLE
+    };
+
+    /**
+     * \brief Stacking of typed BLOB columns (struct of arrays results)
+     */
+    enum STACK_BLOBS {
+        STACK_BLOBS_OFF,            ///< cell array for each BLOB column
+        STACK_BLOBS_ON,             ///< matrix, cell array if rows don't match
+        STACK_BLOBS_STRICT,         ///< matrix, error if rows don't match
+    
+        /// Limit for bound checking only
+        STACK_BLOBS_MAX_ID = STACK_BLOBS_STRICT
     };
 
     #define CONFIG_MKSQLITE_VERSION_STRING  "2.5"         ///< mksqlite version string
@@ -62,15 +78,47 @@
     /// SQLite itself limits BLOBs to 1MB, mksqlite limits to INT32_MAX
     #define CONFIG_MKSQLITE_MAX_BLOB_SIZE   ((mwSize)INT32_MAX)  ///< max. size in bytes of a blob
 
+    /// Sidecar storage: segment files are continued, until they would exceed this size
+    #define CONFIG_SIDECAR_SEGMENT_SIZE     ((uint64_t)1 << 30)  ///< max. size in bytes of a sidecar segment file (1 GiB)
+
     /// Early bind mxSerialize and mxDeserialize
     /// BOOL_TRUE: mksqlite has to be linked with MATLAB lib, BOOL_FALSE: dynamic calls to MATLAB functions
     #ifndef CONFIG_EARLY_BIND_SERIALIZE
     #define CONFIG_EARLY_BIND_SERIALIZE     BOOL_FALSE    ///< early binding if off by default
     #endif
 
+    /// Allocate numeric result elements uninitialized (mxCreateUninitNumericMatrix, MATLAB R2015a and later)
+    #ifndef CONFIG_UNINIT_ALLOC
+    #define CONFIG_UNINIT_ALLOC             BOOL_TRUE     ///< set to BOOL_FALSE for older MATLAB versions
+    #endif
+
     /// Data organisation of query results
     #define CONFIG_RESULT_TYPE              RESULT_TYPE_ARRAYOFSTRUCTS   ///< return array of structs by default
 
     /// Wrap parameters
     #define CONFIG_PARAM_WRAPPING           BOOL_FALSE    ///< paramter wrapping is off by default
+
+    /// Prepared statements (and their field names) kept for reuse, per database
+    #define CONFIG_STMT_CACHE_SIZE          16            ///< 0 disables statement caching
+
+    /// Stacking of typed BLOB columns into one matrix
+    #define CONFIG_STACK_BLOBS              STACK_BLOBS_OFF  ///< cell arrays by default
+
+    /// carray(): equality lookups on arrays of this size (or larger) use binary search
+    #define CONFIG_CARRAY_SORT_THRESHOLD    64            ///< smaller arrays are scanned linearly
+
+    /// Sketches: HyperLogLog uses 2^precision registers (relative error about 1.04/sqrt(2^precision))
+    #define CONFIG_SKETCH_HLL_PRECISION     14            ///< 16 KiB per sketch, about 0.8% error
+
+    /// Sketches: t-digest compression (number of centroids, about)
+    #define CONFIG_SKETCH_TDIGEST_COMPRESSION   200.0     ///< higher values are more accurate
+
+    /// Results held by handles (RESULT_TYPE_HANDLE): least recently used are released beyond this size
+    #define CONFIG_RESULT_BUDGET            ( 1024.0 * 1024 * 1024 )  ///< memory budget in bytes (1 GiB)
+
+    /// Change tracking ('track_changes'): committed changes kept until taken, oldest are dropped beyond
+    #define CONFIG_CHANGES_CAPACITY         65536         ///< 16 bytes per change
+
+    /// Index advisor ('index_advisor'): statements recently run kept for analysis
+    #define CONFIG_ADVISOR_HISTORY          32            ///< oldest statements are dropped beyond
 #endif
@@ -259,6 +259,7 @@ typedef unsigned char byte;  ///< byte type
 int             g_compression_level     = CONFIG_COMPRESSION_LEVEL;    
 const char*     g_compression_type      = CONFIG_COMPRESSION_TYPE; 
 int             g_compression_check     = CONFIG_COMPRESSION_CHECK;
+int             g_bitpack_logicals      = CONFIG_BITPACK_LOGICALS;
 /** @} */
 
 /// Flag: String representation (utf8 or ansi)
@@ -286,6 +287,12 @@ const double    g_NaN                   = DBL_NAN;
     /// Wrap parameters
     int             g_param_wrapping        = CONFIG_PARAM_WRAPPING;
 
+    /// Number of prepared statements cached per database
+    int             g_stmt_cache_size       = CONFIG_STMT_CACHE_SIZE;
+
+    /// Stacking of typed BLOB columns (see STACK_BLOBS)
+    int             g_stack_blobs           = CONFIG_STACK_BLOBS;
+
 #endif  // defined( MATLAB_MEX_FILE )
 
 #endif  // defined( MAIN_MODULE )
@@ -0,0 +1,1699 @@
+/**
+ *  <!-- mksqlite: A MATLAB Interface to SQLite -->
+ *
+ *  @file      index_advisor.hpp
+ *  @brief     Index suggestions for a set of SQL statements
+ *  @details   The columns a statement filters (WHERE, ON, USING) or sorts
+ *             (ORDER BY, GROUP BY) by are candidates for an index. Each
+ *             candidate is created on an in-memory copy of the schema,
+ *             whose sqlite_stat1 holds the cardinalities of the real data,
+ *             so the query planner chooses as it would on the database.
+ *             The costs of the query plans (EXPLAIN QUERY PLAN) with and
+ *             without the candidate are estimated from these
+ *             cardinalities. Optionally the statements are timed on the
+ *             database with each suggested index created temporarily.
+ *             The statements recently run are kept as history.
+ *  @authors   Martin Kortmann <mail@kortmann.de>,
+ *             Andreas Martin  <andimartin@users.sourceforge.net>
+ *  @version   2.5
+ *  @date      2008-2017
+ *  @copyright Distributed under LGPL
+ *  @pre
+ *  @warning   Columns are found by a lexical analysis of the statements,
+ *             expressions (other than plain column references) aren't
+ *             considered. Cardinalities not in sqlite_stat1 are counted,
+ *             which reads the whole table.
+ *  @bug
+ */
+
+#pragma once
+
+//#include "config.h"
+//#include "global.hpp"
+//#include "sqlite/sqlite3.h"
+//#include "carray.hpp"
+//#include "utils.hpp"
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <cmath>
+#include <cctype>
+#include <cstring>
+
+#define ADVISOR_INDEX_PREFIX    "mksqlite_advisor_"     ///< Name prefix of the candidate indexes
+#define ADVISOR_MIN_SPEEDUP     1.1                     ///< Candidates must lower the cost by this factor
+#define ADVISOR_MAX_EQ_COLUMNS  4                       ///< Equality columns combined in one candidate
+#define ADVISOR_DEFAULT_ROWS    1048576.0               ///< Table size assumed without statistics (as SQLite does)
+
+
+/**
+ * \brief Index advisor of one database
+ */
+class IndexAdvisor
+{
+public:
+    /// Index suggested
+    struct Suggestion
+    {
+        std::string                 table;          ///< Table indexed
+        std::vector<std::string>    columns;        ///< Columns of the index
+        std::vector<int>            statements;     ///< Statements sped up (indices into the statements analyzed)
+        double                      cost;           ///< Estimated cost of these statements
+        double                      cost_indexed;   ///< Estimated cost of these statements with the index
+        double                      measured;       ///< Speedup measured (timed runs), NaN if not measured
+        std::string                 plan;           ///< Query plan (with the index) of the statement sped up most
+
+        /// Ctor
+        Suggestion() : cost( 0.0 ), cost_indexed( 0.0 ), measured( DBL_NAN ) {}
+
+        /// Estimated speedup of the statements
+        double speedup() const
+        {
+            return cost_indexed > 0.0 ? cost / cost_indexed : 0.0;
+        }
+
+        /// Index name (by table and columns)
+        std::string name() const
+        {
+            std::string name = "idx_" + table;
+
+            for( size_t i = 0; i < columns.size(); i++ )
+            {
+                name += "_" + columns[i];
+            }
+
+            return name;
+        }
+
+        /// CREATE INDEX statement
+        std::string create( const char* schema = "" ) const
+        {
+            std::string list;
+
+            for( size_t i = 0; i < columns.size(); i++ )
+            {
+                list += ( i ? ", " : "" ) + quote( columns[i] );
+            }
+
+            return "CREATE INDEX " + std::string( schema ) + quote( name() ) + " ON " + quote( table ) + "(" + list + ");";
+        }
+    };
+
+private:
+    /// Columns of a table used by one statement
+    struct Usage
+    {
+        std::vector<std::string>    eq;             ///< Compared for equality
+        std::vector<std::string>    range;          ///< Compared by <, <=, >, >= or BETWEEN
+        std::vector<std::string>    order;          ///< ORDER BY terms
+        std::vector<std::string>    group;          ///< GROUP BY terms
+    };
+
+    typedef std::map<std::string, Usage> UsageMap;  ///< Dictionary: table (lower case) => columns used
+
+    /// Table of the scratch database
+    struct TableInfo
+    {
+        std::string                 name;           ///< Table name
+        std::vector<std::string>    columns;        ///< Column names
+        std::string                 rowid;          ///< INTEGER PRIMARY KEY column (empty if none)
+        double                      rows;           ///< Number of rows (-1 until counted)
+
+        TableInfo() : rows( -1.0 ) {}
+    };
+
+    /// One statement to analyze
+    struct Statement
+    {
+        std::string                 sql;            ///< SQL (first statement only)
+        std::set<std::string>       tables;         ///< Tables read or written (lower case)
+        UsageMap                    usage;          ///< Columns used, by table
+        double                      cost;           ///< Estimated cost without candidates (<0 if not analyzed)
+        bool                        timeable;       ///< SELECT without parameters
+
+        Statement() : cost( -1.0 ), timeable( false ) {}
+    };
+
+    /// Lexical token
+    struct Token
+    {
+        enum type_e { IDENT, LITERAL, OP } type;    ///< Kind of token
+        std::string                 text;           ///< Identifier (unquoted) or operator
+        std::string                 lower;          ///< Lower case text (keywords, operators)
+    };
+
+    /// Node of EXPLAIN QUERY PLAN
+    struct PlanNode
+    {
+        int                         id;             ///< Node id
+        int                         parent;         ///< Parent node id
+        std::string                 detail;         ///< Description
+    };
+
+    std::vector<std::string>        m_history;      ///< Statements recently run, most recent last
+    sqlite3*                        m_db;           ///< Database analyzed (during advise())
+    sqlite3*                        m_scratch;      ///< In-memory copy of the schema (during advise())
+    std::map<std::string, TableInfo>            m_tables;   ///< Tables of the scratch database (lower case names)
+    std::map<std::string, std::vector<double> > m_stats;    ///< sqlite_stat1 of the scratch database: index (lower case) => rows, avg. rows per prefix
+    std::map<std::string, double>               m_distinct; ///< Distinct values counted: table and columns => count
+    std::set<std::string>                       m_functions;///< Placeholders of functions unknown to the scratch database
+
+    /// inhibit copy constructor and assignment operator
+    /// @{
+    IndexAdvisor( const IndexAdvisor& );
+    IndexAdvisor& operator=( const IndexAdvisor& );
+    /// @}
+
+public:
+    /// Standard ctor
+    IndexAdvisor() : m_db( NULL ), m_scratch( NULL )
+    {
+    }
+
+
+    /// Dtor
+    ~IndexAdvisor()
+    {
+        release();
+    }
+
+
+    /**
+     * \brief Record a statement run (SELECT, UPDATE and DELETE only)
+     *
+     * A statement recorded before moves to the end of the history, the
+     * oldest statements are dropped beyond CONFIG_ADVISOR_HISTORY.
+     */
+    void record( const char* query )
+    {
+        const char* pos = query;
+
+        while( pos && ( isspace( (unsigned char)*pos ) || '(' == *pos ) )
+        {
+            pos++;
+        }
+
+        if(    !pos
+            || (    0 != sqlite3_strnicmp( pos, "SELECT", 6 ) && 0 != sqlite3_strnicmp( pos, "WITH", 4 )
+                 && 0 != sqlite3_strnicmp( pos, "UPDATE", 6 ) && 0 != sqlite3_strnicmp( pos, "DELETE", 6 ) ) )
+        {
+            return;
+        }
+
+        std::vector<std::string>::iterator it = std::find( m_history.begin(), m_history.end(), std::string( query ) );
+
+        if( it != m_history.end() )
+        {
+            m_history.erase( it );
+        }
+
+        m_history.push_back( query );
+
+        if( m_history.size() > CONFIG_ADVISOR_HISTORY )
+        {
+            m_history.erase( m_history.begin() );
+        }
+    }
+
+
+    /// Statements recently run, most recent last
+    const std::vector<std::string>& history()
+    {
+        return m_history;
+    }
+
+
+    /// Forget all statements recorded
+    void clear()
+    {
+        m_history.clear();
+    }
+
+
+    /**
+     * \brief Suggest indexes for statements
+     *
+     * \param[in] db Database connection
+     * \param[in] statements SQL statements
+     * \param[in] bTimed Time the statements (SELECT without parameters) with and without each index suggested
+     * \param[out] suggestions Indexes suggested, highest estimated benefit first
+     * \returns SQLite result code (of the scratch database)
+     */
+    int advise( sqlite3* db, const std::vector<std::string>& statements, bool bTimed, std::vector<Suggestion>& suggestions )
+    {
+        std::vector<Statement> stmts( statements.size() );
+
+        suggestions.clear();
+        release();
+
+        m_db   = db;
+        int rc = openScratch();
+
+        if( SQLITE_OK != rc )
+        {
+            release();
+            return rc;
+        }
+
+        // tables and columns used
+        std::set<std::string> tables;
+
+        for( size_t i = 0; i < stmts.size(); i++ )
+        {
+            if( analyze( statements[i], stmts[i] ) )
+            {
+                tables.insert( stmts[i].tables.begin(), stmts[i].tables.end() );
+            }
+        }
+
+        // cardinalities of these tables, costs without candidates
+        for( std::set<std::string>::iterator it = tables.begin(); it != tables.end(); it++ )
+        {
+            loadStats( *it );
+        }
+
+        reloadStats();
+
+        for( size_t i = 0; i < stmts.size(); i++ )
+        {
+            if( !stmts[i].tables.empty() )
+            {
+                std::string plan;
+                stmts[i].cost = planCost( stmts[i].sql, plan );
+            }
+        }
+
+        // candidates of all statements, each evaluated once on all statements
+        std::vector<Suggestion>     candidates;
+        std::set<std::string>       keys;
+
+        for( size_t i = 0; i < stmts.size(); i++ )
+        {
+            if( stmts[i].cost > 0.0 )
+            {
+                addCandidates( stmts[i], candidates, keys );
+            }
+        }
+
+        std::vector<int>    best( stmts.size(), -1 );
+        std::vector<double> bestCost( stmts.size(), 0.0 );
+        std::vector<std::vector<std::string> > plans( candidates.size(), std::vector<std::string>( stmts.size() ) );
+
+        for( size_t c = 0; c < candidates.size(); c++ )
+        {
+            evaluate( candidates[c], (int)c, stmts, best, bestCost, plans[c] );
+        }
+
+        // each statement votes for its best candidate
+        std::map<int, size_t> index;
+
+        for( size_t i = 0; i < stmts.size(); i++ )
+        {
+            int c = best[i];
+
+            if( c < 0 )
+            {
+                continue;
+            }
+
+            if( !index.count( c ) )
+            {
+                index[c] = suggestions.size();
+                suggestions.push_back( candidates[c] );
+            }
+
+            Suggestion& s = suggestions[index[c]];
+
+            if( s.statements.empty() || stmts[i].cost - bestCost[i] > maxBenefit( s, stmts, bestCost ) )
+            {
+                s.plan = plans[c][i];
+            }
+
+            s.statements.push_back( (int)i );
+            s.cost         += stmts[i].cost;
+            s.cost_indexed += bestCost[i];
+        }
+
+        std::stable_sort( suggestions.begin(), suggestions.end(), &IndexAdvisor::byBenefit );
+
+        if( bTimed )
+        {
+            for( size_t i = 0; i < suggestions.size(); i++ )
+            {
+                suggestions[i].measured = measure( suggestions[i], stmts );
+            }
+        }
+
+        release();
+
+        return SQLITE_OK;
+    }
+
+
+    /// Quote an identifier
+    static std::string quote( const std::string& name )
+    {
+        std::string quoted = "\"";
+
+        for( size_t i = 0; i < name.size(); i++ )
+        {
+            quoted += name[i];
+
+            if( '"' == name[i] )
+            {
+                quoted += '"';
+            }
+        }
+
+        return quoted + "\"";
+    }
+
+
+private:
+    /// Close the scratch database, release all state of advise()
+    void release()
+    {
+        sqlite3_close( m_scratch );
+
+        m_scratch = NULL;
+        m_db      = NULL;
+        m_tables.clear();
+        m_stats.clear();
+        m_distinct.clear();
+        m_functions.clear();
+    }
+
+
+    /// Lower case copy of \p text
+    static std::string lower( const std::string& text )
+    {
+        std::string result( text );
+
+        for( size_t i = 0; i < result.size(); i++ )
+        {
+            result[i] = (char)tolower( (unsigned char)result[i] );
+        }
+
+        return result;
+    }
+
+
+    /// Run \p sql on \p db, returns the first column of the first row as number (or \p fallback)
+    static double queryNumber( sqlite3* db, const std::string& sql, double fallback )
+    {
+        sqlite3_stmt* stmt  = NULL;
+        double        value = fallback;
+
+        if( SQLITE_OK == sqlite3_prepare_v2( db, sql.c_str(), -1, &stmt, NULL )
+            && SQLITE_ROW == sqlite3_step( stmt ) && SQLITE_NULL != sqlite3_column_type( stmt, 0 ) )
+        {
+            value = sqlite3_column_double( stmt, 0 );
+        }
+
+        sqlite3_finalize( stmt );
+
+        return value;
+    }
+
+
+    /// Order of suggestions: highest benefit first
+    static bool byBenefit( const Suggestion& a, const Suggestion& b )
+    {
+        return a.cost - a.cost_indexed > b.cost - b.cost_indexed;
+    }
+
+
+    /// Highest benefit of the statements assigned to \p s yet
+    static double maxBenefit( const Suggestion& s, const std::vector<Statement>& stmts, const std::vector<double>& bestCost )
+    {
+        double benefit = 0.0;
+
+        for( size_t i = 0; i < s.statements.size(); i++ )
+        {
+            int k = s.statements[i];
+            benefit = std::max( benefit, stmts[k].cost - bestCost[k] );
+        }
+
+        return benefit;
+    }
+
+
+    /**
+     * \brief Create the scratch database: tables, indexes and views of the main database
+     *
+     * Triggers aren't copied, schema items which can't be created (virtual
+     * tables of unknown modules, i.e.) are omitted.
+     */
+    int openScratch()
+    {
+        int rc = sqlite3_open( ":memory:", &m_scratch );
+
+        if( SQLITE_OK != rc )
+        {
+            return rc;
+        }
+
+        CarrayModule::attach( m_scratch );
+
+        sqlite3_stmt* stmt = NULL;
+
+        rc = sqlite3_prepare_v2( m_db,
+                                 "SELECT sql FROM main.sqlite_master "
+                                 "WHERE type IN ('table','index','view') AND sql NOT NULL AND name NOT LIKE 'sqlite\\_%' ESCAPE '\\' "
+                                 "ORDER BY CASE type WHEN 'table' THEN 0 WHEN 'index' THEN 1 ELSE 2 END, rowid",
+                                 -1, &stmt, NULL );
+
+        while( SQLITE_OK == rc && SQLITE_ROW == sqlite3_step( stmt ) )
+        {
+            sqlite3_exec( m_scratch, (const char*)sqlite3_column_text( stmt, 0 ), NULL, NULL, NULL );
+        }
+
+        sqlite3_finalize( stmt );
+
+        if( SQLITE_OK == rc )
+        {
+            // creates sqlite_stat1
+            rc = sqlite3_exec( m_scratch, "ANALYZE sqlite_master", NULL, NULL, NULL );
+        }
+
+        return rc;
+    }
+
+
+    /// Columns of table \p name in the scratch database (NULL if there is no such table)
+    TableInfo* tableInfo( const std::string& name )
+    {
+        std::string key = lower( name );
+
+        if( m_tables.count( key ) )
+        {
+            return m_tables[key].columns.empty() ? NULL : &m_tables[key];
+        }
+
+        TableInfo&    info  = m_tables[key];
+        sqlite3_stmt* stmt  = NULL;
+        int           nPk   = 0;
+        std::string   pk, pktype;
+
+        info.name = name;
+
+        if( SQLITE_OK == sqlite3_prepare_v2( m_scratch, ( "PRAGMA main.table_info(" + quote( name ) + ")" ).c_str(), -1, &stmt, NULL ) )
+        {
+            while( SQLITE_ROW == sqlite3_step( stmt ) )
+            {
+                info.columns.push_back( (const char*)sqlite3_column_text( stmt, 1 ) );
+
+                if( sqlite3_column_int( stmt, 5 ) > 0 )
+                {
+                    nPk++;
+                    pk     = info.columns.back();
+                    pktype = sqlite3_column_text( stmt, 2 ) ? (const char*)sqlite3_column_text( stmt, 2 ) : "";
+                }
+            }
+        }
+
+        sqlite3_finalize( stmt );
+
+        // INTEGER PRIMARY KEY is the rowid (unless WITHOUT ROWID, where indexes on it are useless too)
+        if( 1 == nPk && 0 == sqlite3_stricmp( pktype.c_str(), "INTEGER" ) )
+        {
+            info.rowid = pk;
+        }
+
+        return info.columns.empty() ? NULL : &info;
+    }
+
+
+    /// Returns true if \p column is the rowid of \p info
+    static bool isRowid( const TableInfo* info, const std::string& column )
+    {
+        return    0 == sqlite3_stricmp( column.c_str(), info->rowid.c_str() )
+               || 0 == sqlite3_stricmp( column.c_str(), "rowid" )
+               || 0 == sqlite3_stricmp( column.c_str(), "_rowid_" )
+               || 0 == sqlite3_stricmp( column.c_str(), "oid" );
+    }
+
+
+    /// Number of distinct values of \p columns in \p table (counted on the database, cached)
+    double countDistinct( const TableInfo* info, const std::vector<std::string>& columns, size_t n )
+    {
+        std::string key  = lower( info->name );
+        std::string list;
+
+        for( size_t i = 0; i < n; i++ )
+        {
+            key  += "\x1f" + lower( columns[i] );
+            list += ( i ? "," : "" ) + quote( columns[i] );
+        }
+
+        if( !m_distinct.count( key ) )
+        {
+            m_distinct[key] = queryNumber( m_db, "SELECT count(*) FROM (SELECT DISTINCT " + list + " FROM main." + quote( info->name ) + ")", 1.0 );
+        }
+
+        return std::max( m_distinct[key], 1.0 );
+    }
+
+
+    /**
+     * \brief sqlite_stat1 entry of an index on \p columns
+     *
+     * \returns "rows avg1 avg2 ...", avgN rows having the same values in the first N columns
+     */
+    std::string indexStat( TableInfo* info, const std::vector<std::string>& columns, std::vector<double>& stat )
+    {
+        char buffer[32];
+
+        stat.assign( 1, std::max( info->rows, 1.0 ) );
+        _snprintf( buffer, sizeof( buffer ), "%.0f", stat[0] );
+
+        std::string text = buffer;
+
+        for( size_t n = 1; n <= columns.size(); n++ )
+        {
+            stat.push_back( std::max( ceil( stat[0] / countDistinct( info, columns, n ) ), 1.0 ) );
+            _snprintf( buffer, sizeof( buffer ), " %.0f", stat.back() );
+            text += buffer;
+        }
+
+        return text;
+    }
+
+
+    /// Write a sqlite_stat1 entry into the scratch database
+    void writeStat( const std::string& table, const char* index, const std::string& stat )
+    {
+        sqlite3_stmt* stmt = NULL;
+
+        if( SQLITE_OK == sqlite3_prepare_v2( m_scratch, "INSERT INTO sqlite_stat1(tbl, idx, stat) VALUES(?, ?, ?)", -1, &stmt, NULL ) )
+        {
+            sqlite3_bind_text( stmt, 1, table.c_str(), -1, SQLITE_TRANSIENT );
+            sqlite3_bind_text( stmt, 2, index, -1, SQLITE_TRANSIENT );
+            sqlite3_bind_text( stmt, 3, stat.c_str(), -1, SQLITE_TRANSIENT );
+            sqlite3_step( stmt );
+        }
+
+        sqlite3_finalize( stmt );
+    }
+
+
+    /// Parse a sqlite_stat1 entry into \p stat
+    static void parseStat( const char* text, std::vector<double>& stat )
+    {
+        stat.clear();
+
+        for( char* end = NULL; text && *text; text = end )
+        {
+            double value = strtod( text, &end );
+
+            if( end == text )
+            {
+                break;
+            }
+
+            stat.push_back( value );
+        }
+    }
+
+
+    /**
+     * \brief Copy the statistics of \p table and its indexes into the scratch database
+     *
+     * Entries missing in sqlite_stat1 of the database are computed.
+     */
+    void loadStats( const std::string& table )
+    {
+        TableInfo*    info = tableInfo( table );
+        sqlite3_stmt* stmt = NULL;
+        std::set<std::string> done;
+
+        if( !info )
+        {
+            return;
+        }
+
+        // statistics of the database (if analyzed)
+        if( SQLITE_OK == sqlite3_prepare_v2( m_db, "SELECT idx, stat FROM main.sqlite_stat1 WHERE tbl = ?", -1, &stmt, NULL ) )
+        {
+            sqlite3_bind_text( stmt, 1, info->name.c_str(), -1, SQLITE_TRANSIENT );
+
+            while( SQLITE_ROW == sqlite3_step( stmt ) )
+            {
+                const char*         index = (const char*)sqlite3_column_text( stmt, 0 );
+                const char*         text  = (const char*)sqlite3_column_text( stmt, 1 );
+                std::vector<double> stat;
+
+                parseStat( text, stat );
+
+                if( stat.empty() )
+                {
+                    continue;
+                }
+
+                info->rows = stat[0];
+                writeStat( info->name, index, text );
+
+                if( index )
+                {
+                    m_stats[lower( index )] = stat;
+                    done.insert( lower( index ) );
+                }
+            }
+        }
+
+        sqlite3_finalize( stmt );
+        stmt = NULL;
+
+        if( info->rows < 0.0 )
+        {
+            std::vector<double> stat;
+
+            info->rows = queryNumber( m_db, "SELECT count(*) FROM main." + quote( info->name ), 0.0 );
+            writeStat( info->name, NULL, indexStat( info, std::vector<std::string>(), stat ) );
+        }
+
+        // indexes not analyzed
+        std::vector<std::string> indexes;
+
+        if( SQLITE_OK == sqlite3_prepare_v2( m_scratch, ( "PRAGMA main.index_list(" + quote( info->name ) + ")" ).c_str(), -1, &stmt, NULL ) )
+        {
+            while( SQLITE_ROW == sqlite3_step( stmt ) )
+            {
+                const char* index = (const char*)sqlite3_column_text( stmt, 1 );
+
+                if( !done.count( lower( index ) ) )
+                {
+                    indexes.push_back( index );
+                }
+            }
+        }
+
+        sqlite3_finalize( stmt );
+
+        for( size_t i = 0; i < indexes.size(); i++ )
+        {
+            std::vector<std::string> columns;
+            bool                     bPlain = true;
+
+            stmt = NULL;
+
+            if( SQLITE_OK == sqlite3_prepare_v2( m_scratch, ( "PRAGMA main.index_info(" + quote( indexes[i] ) + ")" ).c_str(), -1, &stmt, NULL ) )
+            {
+                while( SQLITE_ROW == sqlite3_step( stmt ) )
+                {
+                    if( SQLITE_NULL == sqlite3_column_type( stmt, 2 ) )
+                    {
+                        // expression
+                        bPlain = false;
+                        break;
+                    }
+
+                    columns.push_back( (const char*)sqlite3_column_text( stmt, 2 ) );
+                }
+            }
+
+            sqlite3_finalize( stmt );
+
+            if( bPlain && !columns.empty() )
+            {
+                std::vector<double>& stat = m_stats[lower( indexes[i] )];
+                writeStat( info->name, indexes[i].c_str(), indexStat( info, columns, stat ) );
+            }
+        }
+    }
+
+
+    /// Make the query planner of the scratch database read sqlite_stat1 again
+    void reloadStats()
+    {
+        sqlite3_exec( m_scratch, "ANALYZE sqlite_master", NULL, NULL, NULL );
+    }
+
+
+    /// Authorizer collecting the tables used by a statement
+    static int onAuthorize( void* p, int action, const char* arg1, const char* arg2, const char* dbname, const char* trigger )
+    {
+        std::set<std::string>* tables = (std::set<std::string>*)p;
+
+        if(    ( SQLITE_READ == action || SQLITE_UPDATE == action || SQLITE_DELETE == action || SQLITE_INSERT == action )
+            && arg1 && dbname && 0 == sqlite3_stricmp( dbname, "main" ) && 0 != sqlite3_strnicmp( arg1, "sqlite_", 7 ) )
+        {
+            tables->insert( lower( arg1 ) );
+        }
+
+        return SQLITE_OK;
+    }
+
+
+    /// Placeholder of functions unknown to the scratch database (statements are never run there)
+    static void placeholderFunc( sqlite3_context* ctx, int argc, sqlite3_value** argv )
+    {
+        sqlite3_result_null( ctx );
+    }
+
+
+    /**
+     * \brief Prepare \p sql on the scratch database
+     *
+     * Functions unknown (application-defined) are replaced by placeholders.
+     *
+     * \param[in] sql SQL statement
+     * \param[out] tables Tables used (may be NULL)
+     * \param[out] tail End of the first statement in \p sql (may be NULL)
+     * \returns statement, NULL on failure
+     */
+    sqlite3_stmt* prepareScratch( const std::string& sql, std::set<std::string>* tables, const char** tail )
+    {
+        static const char noFunction[] = "no such function: ";
+        sqlite3_stmt*     stmt = NULL;
+
+        for( int retry = 0; retry < 16; retry++ )
+        {
+            sqlite3_set_authorizer( m_scratch, tables ? &IndexAdvisor::onAuthorize : NULL, tables );
+            int rc = sqlite3_prepare_v2( m_scratch, sql.c_str(), -1, &stmt, tail );
+            sqlite3_set_authorizer( m_scratch, NULL, NULL );
+
+            if( SQLITE_OK == rc )
+            {
+                return stmt;
+            }
+
+            const char* errmsg = sqlite3_errmsg( m_scratch );
+
+            if( 0 != strncmp( errmsg, noFunction, sizeof( noFunction ) - 1 ) )
+            {
+                break;
+            }
+
+            std::string name = errmsg + sizeof( noFunction ) - 1;
+
+            if( m_functions.count( lower( name ) ) )
+            {
+                break;
+            }
+
+            m_functions.insert( lower( name ) );
+            sqlite3_create_function( m_scratch, name.c_str(), -1, SQLITE_UTF8, NULL, placeholderFunc, NULL, NULL );
+
+            if( tables )
+            {
+                tables->clear();
+            }
+        }
+
+        return NULL;
+    }
+
+
+    /**
+     * \brief Find the tables and columns a statement uses
+     *
+     * \returns false if the statement can't be prepared (on the schema copy)
+     */
+    bool analyze( const std::string& sql, Statement& statement )
+    {
+        const char*   tail = NULL;
+        sqlite3_stmt* stmt = prepareScratch( sql, &statement.tables, &tail );
+
+        if( !stmt )
+        {
+            statement.tables.clear();
+            return false;
+        }
+
+        statement.sql.assign( sql.c_str(), tail ? tail - sql.c_str() : sql.size() );
+        statement.timeable = sqlite3_stmt_readonly( stmt ) && 0 == sqlite3_bind_parameter_count( stmt );
+        sqlite3_finalize( stmt );
+
+        // tables only, not views
+        for( std::set<std::string>::iterator it = statement.tables.begin(); it != statement.tables.end(); )
+        {
+            if( !tableInfo( *it ) )
+            {
+                statement.tables.erase( it++ );
+            }
+            else
+            {
+                it++;
+            }
+        }
+
+        std::vector<Token> tokens;
+        tokenize( statement.sql, tokens );
+        classify( tokens, statement );
+
+        return !statement.tables.empty();
+    }
+
+
+    /// Split \p sql into tokens (comments omitted)
+    static void tokenize( const std::string& sql, std::vector<Token>& tokens )
+    {
+        static const char* ops2[] = { "==", "<=", ">=", "!=", "<>", "||", "<<", ">>", NULL };
+        size_t pos = 0;
+        size_t len = sql.size();
+
+        while( pos < len )
+        {
+            char  c = sql[pos];
+            Token token;
+
+            if( isspace( (unsigned char)c ) )
+            {
+                pos++;
+                continue;
+            }
+
+            if( '-' == c && pos + 1 < len && '-' == sql[pos+1] )
+            {
+                pos = sql.find( '\n', pos );
+                pos = ( std::string::npos == pos ) ? len : pos + 1;
+                continue;
+            }
+
+            if( '/' == c && pos + 1 < len && '*' == sql[pos+1] )
+            {
+                pos = sql.find( "*/", pos + 2 );
+                pos = ( std::string::npos == pos ) ? len : pos + 2;
+                continue;
+            }
+
+            if( '"' == c || '`' == c || '[' == c || '\'' == c )
+            {
+                // quoted identifier or string literal (quotes doubled inside)
+                char close = ( '[' == c ) ? ']' : c;
+
+                token.type = ( '\'' == c ) ? Token::LITERAL : Token::IDENT;
+
+                for( pos++; pos < len; pos++ )
+                {
+                    if( sql[pos] == close )
+                    {
+                        if( ']' != close && pos + 1 < len && sql[pos+1] == close )
+                        {
+                            pos++;
+                        }
+                        else
+                        {
+                            break;
+                        }
+                    }
+
+                    token.text += sql[pos];
+                }
+
+                pos++;
+            }
+            else if( isalpha( (unsigned char)c ) || '_' == c || ( c & 0x80 ) )
+            {
+                size_t start = pos;
+
+                while( pos < len && ( isalnum( (unsigned char)sql[pos] ) || '_' == sql[pos] || '$' == sql[pos] || ( sql[pos] & 0x80 ) ) )
+                {
+                    pos++;
+                }
+
+                token.type = Token::IDENT;
+                token.text = sql.substr( start, pos - start );
+
+                // blob literal x'..'
+                if( 1 == token.text.size() && ( 'x' == c || 'X' == c ) && pos < len && '\'' == sql[pos] )
+                {
+                    continue;
+                }
+            }
+            else if( isdigit( (unsigned char)c ) || ( '.' == c && pos + 1 < len && isdigit( (unsigned char)sql[pos+1] ) ) )
+            {
+                // number (exponent sign included)
+                while( pos < len && ( isalnum( (unsigned char)sql[pos] ) || '.' == sql[pos]
+                                      || ( ( '+' == sql[pos] || '-' == sql[pos] ) && ( 'e' == sql[pos-1] || 'E' == sql[pos-1] ) ) ) )
+                {
+                    pos++;
+                }
+
+                token.type = Token::LITERAL;
+            }
+            else if( '?' == c || ':' == c || '@' == c || '$' == c )
+            {
+                // parameter
+                for( pos++; pos < len && ( isalnum( (unsigned char)sql[pos] ) || '_' == sql[pos] ); pos++ );
+
+                token.type = Token::LITERAL;
+            }
+            else
+            {
+                token.type = Token::OP;
+                token.text = c;
+
+                for( int i = 0; ops2[i]; i++ )
+                {
+                    if( 0 == sql.compare( pos, 2, ops2[i] ) )
+                    {
+                        token.text = ops2[i];
+                        break;
+                    }
+                }
+
+                pos += token.text.size();
+            }
+
+            token.lower = lower( token.text );
+            tokens.push_back( token );
+        }
+    }
+
+
+    /// Returns true if \p token is the operator or (unquoted) keyword \p text
+    static bool is( const std::vector<Token>& tokens, size_t i, const char* text )
+    {
+        return i < tokens.size() && tokens[i].lower == text;
+    }
+
+
+    /// Append \p column to \p list, if not yet there
+    static void addUnique( std::vector<std::string>& list, const std::string& column )
+    {
+        for( size_t i = 0; i < list.size(); i++ )
+        {
+            if( 0 == sqlite3_stricmp( list[i].c_str(), column.c_str() ) )
+            {
+                return;
+            }
+        }
+
+        list.push_back( column );
+    }
+
+
+    /**
+     * \brief Classify the column references of a statement by the clause and operator they're used with
+     *
+     * Clauses are tracked per parenthesis level, so subqueries are
+     * classified by their own clauses.
+     */
+    void classify( const std::vector<Token>& tokens, Statement& statement )
+    {
+        enum clause_e { CL_OTHER, CL_FROM, CL_FILTER, CL_USING, CL_ORDER, CL_GROUP };
+
+        static const char* notAlias[] = { "on", "using", "where", "group", "order", "limit", "join", "left", "right",
+                                          "full", "inner", "outer", "cross", "natural", "indexed", "not", "union",
+                                          "except", "intersect", "window", "having", "set", "returning", NULL };
+
+        std::vector<clause_e>               clauses( 1, CL_OTHER );
+        std::map<std::string, std::string>  aliases;    // alias (lower case) => table (lower case)
+
+        for( size_t i = 0; i < tokens.size(); i++ )
+        {
+            const Token& token  = tokens[i];
+            clause_e&    clause = clauses.back();
+
+            if( Token::OP == token.type )
+            {
+                if( "(" == token.text )
+                {
+                    clause_e current = clause;
+                    clauses.push_back( current );
+                }
+                else if( ")" == token.text && clauses.size() > 1 )
+                {
+                    clauses.pop_back();
+                }
+                continue;
+            }
+
+            if( Token::LITERAL == token.type )
+            {
+                continue;
+            }
+
+            // clause keywords
+            if( "where" == token.lower || "on" == token.lower )
+            {
+                clause = CL_FILTER;
+                continue;
+            }
+
+            if( "using" == token.lower )
+            {
+                clause = CL_USING;
+                continue;
+            }
+
+            if( "from" == token.lower || "join" == token.lower || "update" == token.lower )
+            {
+                clause = CL_FROM;
+                continue;
+            }
+
+            if( ( "order" == token.lower || "group" == token.lower ) && is( tokens, i + 1, "by" ) )
+            {
+                clause = ( "order" == token.lower ) ? CL_ORDER : CL_GROUP;
+                i++;
+                continue;
+            }
+
+            if(    "select" == token.lower || "set" == token.lower || "values" == token.lower || "limit" == token.lower
+                || "having" == token.lower || "union" == token.lower || "except" == token.lower || "intersect" == token.lower
+                || "window" == token.lower || "returning" == token.lower )
+            {
+                clause = CL_OTHER;
+                continue;
+            }
+
+            // qualified name: [schema.][table.]column
+            size_t first = i;
+
+            while( i + 2 < tokens.size() && is( tokens, i + 1, "." ) && Token::IDENT == tokens[i+2].type )
+            {
+                i += 2;
+            }
+
+            std::string name      = tokens[i].text;
+            std::string qualifier = ( i > first ) ? tokens[i-2].lower : "";
+
+            if( is( tokens, i + 1, "(" ) )
+            {
+                // function
+                continue;
+            }
+
+            if( CL_FROM == clause )
+            {
+                // table [AS] alias
+                std::string table = lower( name );
+                size_t      next  = i + 1;
+
+                if( !statement.tables.count( table ) )
+                {
+                    continue;
+                }
+
+                if( is( tokens, next, "as" ) )
+                {
+                    next++;
+                }
+
+                if( next < tokens.size() && Token::IDENT == tokens[next].type )
+                {
+                    bool bKeyword = false;
+
+                    for( int k = 0; notAlias[k]; k++ )
+                    {
+                        bKeyword |= ( tokens[next].lower == notAlias[k] );
+                    }
+
+                    if( !bKeyword )
+                    {
+                        aliases[tokens[next].lower] = table;
+                        i = next;
+                    }
+                }
+                continue;
+            }
+
+            if( CL_OTHER == clause )
+            {
+                continue;
+            }
+
+            // tables having this column
+            std::vector<std::string> owners;
+
+            for( std::set<std::string>::iterator it = statement.tables.begin(); it != statement.tables.end(); it++ )
+            {
+                if( !qualifier.empty() && qualifier != *it && !( aliases.count( qualifier ) && aliases[qualifier] == *it ) )
+                {
+                    continue;
+                }
+
+                TableInfo* info = tableInfo( *it );
+
+                for( size_t k = 0; info && k < info->columns.size(); k++ )
+                {
+                    if( 0 == sqlite3_stricmp( info->columns[k].c_str(), name.c_str() ) && !isRowid( info, name ) )
+                    {
+                        owners.push_back( *it );
+                        name = info->columns[k];
+                    }
+                }
+            }
+
+            if( owners.empty() )
+            {
+                continue;
+            }
+
+            // usage by clause and neighbouring tokens
+            const size_t after  = i + 1;
+            const bool   bFirst = first > 0;
+            int          kind   = 0;    // 1: equality, 2: range, 3: order, 4: group
+
+            if( CL_USING == clause )
+            {
+                kind = 1;
+            }
+            else if( CL_FILTER == clause )
+            {
+                if(    is( tokens, after, "=" ) || is( tokens, after, "==" ) || is( tokens, after, "in" )
+                    || ( is( tokens, after, "is" ) && !is( tokens, after + 1, "not" ) )
+                    || ( bFirst && ( is( tokens, first - 1, "=" ) || is( tokens, first - 1, "==" ) ) )
+                    || ( bFirst && is( tokens, first - 1, "is" ) && !is( tokens, first - 2, "not" ) ) )
+                {
+                    kind = 1;
+                }
+                else if(    is( tokens, after, "<" ) || is( tokens, after, "<=" ) || is( tokens, after, ">" )
+                         || is( tokens, after, ">=" ) || is( tokens, after, "between" )
+                         || ( bFirst && (    is( tokens, first - 1, "<" ) || is( tokens, first - 1, "<=" )
+                                          || is( tokens, first - 1, ">" ) || is( tokens, first - 1, ">=" ) ) ) )
+                {
+                    kind = 2;
+                }
+            }
+            else if(    bFirst && ( is( tokens, first - 1, "," ) || is( tokens, first - 1, "by" ) )
+                     && ( after >= tokens.size() || Token::OP != tokens[after].type
+                          || is( tokens, after, "," ) || is( tokens, after, ")" ) || is( tokens, after, ";" ) ) )
+            {
+                // plain column as ORDER BY or GROUP BY term
+                kind = ( CL_ORDER == clause ) ? 3 : 4;
+            }
+
+            for( size_t k = 0; kind && k < owners.size(); k++ )
+            {
+                Usage& usage = statement.usage[owners[k]];
+
+                switch( kind )
+                {
+                    case 1: addUnique( usage.eq, name ); break;
+                    case 2: addUnique( usage.range, name ); break;
+                    case 3: addUnique( usage.order, name ); break;
+                    case 4: addUnique( usage.group, name ); break;
+                }
+            }
+        }
+    }
+
+
+    /// Add candidate \p columns on \p table, if new
+    static void addCandidate( const std::string& table, const std::vector<std::string>& columns,
+                              std::vector<Suggestion>& candidates, std::set<std::string>& keys )
+    {
+        std::string key = table;
+
+        for( size_t i = 0; i < columns.size(); i++ )
+        {
+            key += "\x1f" + lower( columns[i] );
+        }
+
+        if( columns.empty() || keys.count( key ) )
+        {
+            return;
+        }
+
+        keys.insert( key );
+        candidates.push_back( Suggestion() );
+        candidates.back().table   = table;
+        candidates.back().columns = columns;
+    }
+
+
+    /**
+     * \brief Candidate indexes of a statement, per table
+     *
+     * - each column used alone
+     * - equality columns (most selective first), followed by the first range column
+     * - equality columns, followed by the ORDER BY (GROUP BY) columns
+     */
+    void addCandidates( const Statement& statement, std::vector<Suggestion>& candidates, std::set<std::string>& keys )
+    {
+        for( UsageMap::const_iterator it = statement.usage.begin(); it != statement.usage.end(); it++ )
+        {
+            TableInfo*   info  = tableInfo( it->first );
+            const Usage& usage = it->second;
+
+            if( !info )
+            {
+                continue;
+            }
+
+            const std::string& table = info->name;
+
+            // singles
+            for( size_t i = 0; i < usage.eq.size(); i++ )
+            {
+                addCandidate( table, std::vector<std::string>( 1, usage.eq[i] ), candidates, keys );
+            }
+
+            for( size_t i = 0; i < usage.range.size(); i++ )
+            {
+                addCandidate( table, std::vector<std::string>( 1, usage.range[i] ), candidates, keys );
+            }
+
+            // equality columns by selectivity
+            std::vector<std::pair<double, std::string> > ranked;
+            std::vector<std::string>                     eq;
+
+            for( size_t i = 0; i < usage.eq.size(); i++ )
+            {
+                ranked.push_back( std::make_pair( -countDistinct( info, std::vector<std::string>( 1, usage.eq[i] ), 1 ), usage.eq[i] ) );
+            }
+
+            std::stable_sort( ranked.begin(), ranked.end() );
+
+            for( size_t i = 0; i < ranked.size() && i < ADVISOR_MAX_EQ_COLUMNS; i++ )
+            {
+                eq.push_back( ranked[i].second );
+            }
+
+            addCandidate( table, eq, candidates, keys );
+
+            for( size_t i = 0; i < usage.range.size(); i++ )
+            {
+                if( std::find( eq.begin(), eq.end(), usage.range[i] ) == eq.end() )
+                {
+                    std::vector<std::string> columns( eq );
+                    columns.push_back( usage.range[i] );
+                    addCandidate( table, columns, candidates, keys );
+                    break;
+                }
+            }
+
+            // sort order
+            const std::vector<std::string>* orders[] = { &usage.order, &usage.group };
+
+            for( int k = 0; k < 2; k++ )
+            {
+                std::vector<std::string> columns( eq );
+
+                for( size_t i = 0; i < orders[k]->size(); i++ )
+                {
+                    addUnique( columns, (*orders[k])[i] );
+                }
+
+                if( columns.size() > eq.size() )
+                {
+                    addCandidate( table, columns, candidates, keys );
+                }
+            }
+        }
+    }
+
+
+    /**
+     * \brief Create candidate \p c on the scratch database and estimate the cost of the statements
+     *
+     * Statements using the candidate at lower cost than their best
+     * candidate so far are assigned to it.
+     */
+    void evaluate( const Suggestion& candidate, int c, const std::vector<Statement>& stmts,
+                   std::vector<int>& best, std::vector<double>& bestCost, std::vector<std::string>& plans )
+    {
+        char        number[16];
+        TableInfo*  info = tableInfo( candidate.table );
+        std::string list;
+
+        _snprintf( number, sizeof( number ), "%d", c );
+
+        std::string name = std::string( ADVISOR_INDEX_PREFIX ) + number;
+
+        for( size_t i = 0; i < candidate.columns.size(); i++ )
+        {
+            list += ( i ? "," : "" ) + quote( candidate.columns[i] );
+        }
+
+        if( !info || SQLITE_OK != sqlite3_exec( m_scratch, ( "CREATE INDEX " + quote( name ) + " ON " + quote( info->name )
+                                                             + "(" + list + ")" ).c_str(), NULL, NULL, NULL ) )
+        {
+            return;
+        }
+
+        writeStat( info->name, name.c_str(), indexStat( info, candidate.columns, m_stats[lower( name )] ) );
+        reloadStats();
+
+        for( size_t i = 0; i < stmts.size(); i++ )
+        {
+            if( stmts[i].cost <= 0.0 || !stmts[i].tables.count( lower( info->name ) ) )
+            {
+                continue;
+            }
+
+            std::string plan;
+            double      cost = planCost( stmts[i].sql, plan );
+
+            if(    cost > 0.0 && cost * ADVISOR_MIN_SPEEDUP <= stmts[i].cost
+                && std::string::npos != plan.find( name )
+                && ( best[i] < 0 || cost < bestCost[i] ) )
+            {
+                best[i]     = c;
+                bestCost[i] = cost;
+                plans[i]    = plan;
+            }
+        }
+
+        sqlite3_exec( m_scratch, ( "DROP INDEX " + quote( name ) ).c_str(), NULL, NULL, NULL );
+        m_stats.erase( lower( name ) );
+
+        // present the index by the name suggested
+        std::string suggested = candidate.name();
+
+        for( size_t i = 0; i < plans.size(); i++ )
+        {
+            size_t pos = plans[i].find( name );
+
+            if( best[i] == c && std::string::npos != pos )
+            {
+                plans[i].replace( pos, name.size(), suggested );
+            }
+        }
+    }
+
+
+    /**
+     * \brief Estimated cost of a statement (rows visited) by its query plan on the scratch database
+     *
+     * \param[in] sql Statement
+     * \param[out] plan Query plan (one line per node, indented by level)
+     * \returns Cost, 0 on failure
+     */
+    double planCost( const std::string& sql, std::string& plan )
+    {
+        sqlite3_stmt*         stmt = prepareScratch( "EXPLAIN QUERY PLAN " + sql, NULL, NULL );
+        std::vector<PlanNode> nodes;
+        std::map<int, int>    level;
+
+        plan.clear();
+
+        if( !stmt )
+        {
+            return 0.0;
+        }
+
+        while( SQLITE_ROW == sqlite3_step( stmt ) )
+        {
+            PlanNode node;
+
+            node.id     = sqlite3_column_int( stmt, 0 );
+            node.parent = sqlite3_column_int( stmt, 1 );
+            node.detail = (const char*)sqlite3_column_text( stmt, 3 );
+            level[node.id] = level.count( node.parent ) ? level[node.parent] + 1 : 0;
+
+            plan += std::string( 2 * level[node.id], ' ' ) + node.detail + "\n";
+            nodes.push_back( node );
+        }
+
+        sqlite3_finalize( stmt );
+
+        if( nodes.empty() )
+        {
+            return 0.0;
+        }
+
+        double rows;
+        return std::max( groupCost( nodes, 0, rows ), 1.0 );
+    }
+
+
+    /**
+     * \brief Cost of the plan nodes below \p parent
+     *
+     * Loops (SCAN, SEARCH) are nested: each visits its rows for each row
+     * of the loops before. Subqueries are added, correlated ones once per
+     * row.
+     *
+     * \param[in] nodes Query plan
+     * \param[in] parent Parent node id
+     * \param[out] rows Rows produced
+     * \returns Cost
+     */
+    double groupCost( const std::vector<PlanNode>& nodes, int parent, double& rows )
+    {
+        double cost    = 0.0;
+        double outer   = 1.0;
+        double subrows = 1.0;
+        int    sorts   = 0;
+
+        for( size_t i = 0; i < nodes.size(); i++ )
+        {
+            const PlanNode&    node   = nodes[i];
+            const std::string& detail = node.detail;
+
+            if( node.parent != parent )
+            {
+                continue;
+            }
+
+            bool bChildren = false;
+
+            for( size_t k = i + 1; k < nodes.size() && !bChildren; k++ )
+            {
+                bChildren = ( nodes[k].parent == node.id );
+            }
+
+            if( startsWith( detail, "SCAN TABLE " ) || startsWith( detail, "SEARCH TABLE " ) )
+            {
+                double setup   = 0.0;
+                double perRow  = 1.0;
+                double visited = loopRows( detail, setup, perRow );
+
+                cost  += setup + outer * visited * perRow;
+                outer *= visited;
+            }
+            else if( startsWith( detail, "SCAN SUBQUERY" ) )
+            {
+                // rows of the subquery materialized (or run as co-routine) before
+                cost  += outer * subrows;
+                outer *= subrows;
+            }
+            else if( startsWith( detail, "MULTI-INDEX OR" ) )
+            {
+                double visited = 0.0;
+                double subcost = 0.0;
+
+                for( size_t k = i + 1; k < nodes.size(); k++ )
+                {
+                    if( nodes[k].parent == node.id )
+                    {
+                        double r;
+                        subcost += groupCost( nodes, nodes[k].id, r );
+                        visited += r;
+                    }
+                }
+
+                cost  += outer * subcost;
+                outer *= std::max( visited, 1.0 );
+            }
+            else if( startsWith( detail, "USE TEMP B-TREE" ) )
+            {
+                sorts++;
+            }
+            else if( bChildren )
+            {
+                double subcost = groupCost( nodes, node.id, subrows );
+
+                cost += ( std::string::npos != detail.find( "CORRELATED" ) ) ? outer * subcost : subcost;
+            }
+        }
+
+        cost += sorts * outer * log2( outer + 1.0 );
+        rows  = outer;
+
+        return cost;
+    }
+
+
+    /// Returns true if \p text starts with \p prefix
+    static bool startsWith( const std::string& text, const char* prefix )
+    {
+        return 0 == strncmp( text.c_str(), prefix, strlen( prefix ) );
+    }
+
+
+    /// Table named at \p start of \p detail (names aren't quoted in query plans), NULL if unknown
+    TableInfo* planTable( const std::string& detail, size_t start )
+    {
+        TableInfo* found = NULL;
+
+        for( std::map<std::string, TableInfo>::iterator it = m_tables.begin(); it != m_tables.end(); it++ )
+        {
+            const std::string& name = it->second.name;
+            size_t             end  = start + name.size();
+
+            if(    !it->second.columns.empty() && end <= detail.size()
+                && 0 == sqlite3_strnicmp( detail.c_str() + start, name.c_str(), (int)name.size() )
+                && ( end == detail.size() || ' ' == detail[end] )
+                && ( !found || name.size() > found->name.size() ) )
+            {
+                found = &it->second;
+            }
+        }
+
+        return found;
+    }
+
+
+    /**
+     * \brief Rows visited by one loop of a query plan
+     *
+     * \param[in] detail "SCAN TABLE t ..." or "SEARCH TABLE t USING ... (a=? AND b>?)"
+     * \param[out] setup One time cost (automatic index)
+     * \param[out] perRow Cost per row (2 if the table is looked up by rowid from an index)
+     * \returns Rows visited
+     */
+    double loopRows( const std::string& detail, double& setup, double& perRow )
+    {
+        TableInfo*  info  = planTable( detail, detail.find( "TABLE " ) + 6 );
+        double      rows  = ( info && info->rows >= 0.0 ) ? std::max( info->rows, 1.0 ) : ADVISOR_DEFAULT_ROWS;
+        bool        bCovering = std::string::npos != detail.find( "COVERING INDEX" )
+                                || std::string::npos != detail.find( "PRIMARY KEY" );
+
+        setup  = 0.0;
+        perRow = ( std::string::npos != detail.find( " INDEX " ) && !bCovering ) ? 2.0 : 1.0;
+
+        if( startsWith( detail, "SCAN" ) )
+        {
+            return rows;
+        }
+
+        // constraints "(a=? AND b>?)"
+        size_t      open  = detail.rfind( '(' );
+        std::string terms = ( std::string::npos != open ) ? detail.substr( open ) : "";
+        int         nEq   = 0;
+        int         nRange = 0;
+
+        for( size_t pos = 0; std::string::npos != ( pos = terms.find( '?', pos ) ); pos++ )
+        {
+            char op = terms[pos - 1];
+
+            if( '<' == op || '>' == op || ( '=' == op && pos > 1 && ( '<' == terms[pos-2] || '>' == terms[pos-2] ) ) )
+            {
+                nRange++;
+            }
+            else
+            {
+                nEq++;
+            }
+        }
+
+        double visited = rows;
+
+        if( std::string::npos != detail.find( "INTEGER PRIMARY KEY" ) )
+        {
+            visited = nEq ? 1.0 : rows;
+        }
+        else if( std::string::npos != detail.find( "AUTOMATIC" ) )
+        {
+            // built for this statement
+            setup   = rows * log2( rows + 1.0 );
+            visited = nEq ? 10.0 : rows;
+        }
+        else if( std::string::npos == detail.find( "INDEX " ) )
+        {
+            // primary key of a WITHOUT ROWID table
+            visited = nEq ? 1.0 : rows;
+        }
+        else
+        {
+            // names aren't quoted in query plans
+            size_t      at    = detail.find( "INDEX " ) + 6;
+            size_t      end   = detail.find( " (", at );
+            std::string index = lower( detail.substr( at, std::string::npos == end ? std::string::npos : end - at ) );
+
+            if( m_stats.count( index ) && !m_stats[index].empty() )
+            {
+                const std::vector<double>& stat = m_stats[index];
+                visited = stat[std::min( (size_t)nEq, stat.size() - 1 )];
+            }
+            else
+            {
+                visited = nEq ? 10.0 : rows;
+            }
+        }
+
+        // SQLite assumes a range to select 1/4 of the rows, 1/64 if bounded on both sides
+        visited /= ( nRange >= 2 ) ? 64.0 : ( nRange ? 4.0 : 1.0 );
+
+        return std::max( visited, 1.0 );
+    }
+
+
+    /// Time of running \p sql on the database (best of 2 runs), <0 on failure
+    double timeStatement( const std::string& sql )
+    {
+        double best = -1.0;
+
+        for( int run = 0; run < 2; run++ )
+        {
+            sqlite3_stmt* stmt  = NULL;
+            double        start = utils_get_wall_time();
+            int           rc    = sqlite3_prepare_v2( m_db, sql.c_str(), -1, &stmt, NULL );
+
+            while( SQLITE_OK == rc && SQLITE_ROW == ( rc = sqlite3_step( stmt ) ) )
+            {
+                rc = SQLITE_OK;
+            }
+
+            double elapsed = utils_get_wall_time() - start;
+
+            sqlite3_finalize( stmt );
+
+            if( SQLITE_DONE != rc )
+            {
+                return -1.0;
+            }
+
+            best = ( best < 0.0 ) ? elapsed : std::min( best, elapsed );
+        }
+
+        return best;
+    }
+
+
+    /**
+     * \brief Speedup of the statements of \p s measured on the database
+     *
+     * The index is created in a savepoint, which is rolled back.
+     *
+     * \returns Ratio of the run times, NaN if not measured
+     */
+    double measure( const Suggestion& s, const std::vector<Statement>& stmts )
+    {
+        std::vector<int> timed;
+        std::vector<double> before;
+        double           t0 = 0.0;
+        double           t1 = 0.0;
+
+        for( size_t i = 0; i < s.statements.size(); i++ )
+        {
+            const Statement& stmt = stmts[s.statements[i]];
+            double           t    = stmt.timeable ? timeStatement( stmt.sql ) : -1.0;
+
+            if( t >= 0.0 )
+            {
+                timed.push_back( s.statements[i] );
+                before.push_back( t );
+            }
+        }
+
+        if( timed.empty() || SQLITE_OK != sqlite3_exec( m_db, "SAVEPOINT mksqlite_advisor", NULL, NULL, NULL ) )
+        {
+            return DBL_NAN;
+        }
+
+        bool bOk = SQLITE_OK == sqlite3_exec( m_db, s.create( "main." ).c_str(), NULL, NULL, NULL );
+
+        for( size_t i = 0; bOk && i < timed.size(); i++ )
+        {
+            double t = timeStatement( stmts[timed[i]].sql );
+
+            bOk = ( t >= 0.0 );
+            t0 += before[i];
+            t1 += t;
+        }
+
+        sqlite3_exec( m_db, "ROLLBACK TO mksqlite_advisor", NULL, NULL, NULL );
+        sqlite3_exec( m_db, "RELEASE mksqlite_advisor", NULL, NULL, NULL );
+
+        return ( bOk && t1 > 0.0 ) ? t0 / t1 : DBL_NAN;
+    }
+};
@@ -0,0 +1,393 @@
+/**
+ *  <!-- mksqlite: A MATLAB Interface to SQLite -->
+ *
+ *  @file      lazy_result.hpp
+ *  @brief     Query results held in native column buffers
+ *  @details   With result type RESULT_TYPE_HANDLE a query returns a handle
+ *             instead of MATLAB arrays. The rows stay in native memory
+ *             (independent of MATLAB's memory manager), columns and rows
+ *             are converted on request only. Results are released by
+ *             their handle, or least recently used first, when all held
+ *             results exceed a memory budget.
+ *  @authors   Martin Kortmann <mail@kortmann.de>,
+ *             Andreas Martin  <andimartin@users.sourceforge.net>
+ *  @version   2.5
+ *  @date      2008-2017
+ *  @copyright Distributed under LGPL
+ *  @pre
+ *  @warning
+ *  @bug
+ */
+
+#pragma once
+
+//#include "config.h"
+//#include "value.hpp"
+//#include "shards.hpp"
+#include <string>
+#include <vector>
+#include <map>
+
+
+/**
+ * \brief Query result in native column buffers
+ */
+class LazyResult
+{
+public:
+    typedef ShardSet::Cell Cell;    ///< Field value in native memory
+
+    /// One result column
+    struct Column
+    {
+        std::string         sqlname;    ///< Column name (SQL)
+        std::string         name;       ///< Column name (MATLAB)
+        bool                isFloat;    ///< Pure double column (values in floats)
+        std::vector<double> floats;     ///< Values of a pure double column
+        std::vector<Cell>   cells;      ///< Values of other columns
+
+        Column() : isFloat( true ) {}
+    };
+
+    std::vector<Column>     m_cols;     ///< Columns
+    size_t                  m_rows;     ///< Row count
+    size_t                  m_bytes;    ///< Estimated memory usage
+    unsigned long           m_stamp;    ///< Time of last use (see LazyResults)
+
+    /// Standard ctor
+    LazyResult() : m_rows( 0 ), m_bytes( 0 ), m_stamp( 0 ) {}
+
+
+    /**
+     * \brief Copy a fetched query result into native buffers
+     *
+     * \param[in] cols Fetched columns (see SQLiface::fetch())
+     */
+    void assign( ValueSQLCols& cols )
+    {
+        m_cols.assign( cols.size(), Column() );
+        m_rows  = cols.size() ? cols[0].size() : 0;
+        m_bytes = sizeof( *this );
+
+        for( size_t j = 0; j < cols.size(); j++ )
+        {
+            Column& col = m_cols[j];
+
+            col.sqlname = cols[j].m_col_name;
+            col.name    = cols[j].m_name;
+            col.isFloat = !cols[j].m_isAnyType;
+
+            if( col.isFloat )
+            {
+                col.floats = cols[j].m_float;
+                m_bytes += col.floats.size() * sizeof( double );
+                continue;
+            }
+
+            col.cells.resize( cols[j].m_any.size() );
+
+            for( size_t i = 0; i < cols[j].m_any.size(); i++ )
+            {
+                const ValueSQL& value = cols[j].m_any[i];
+                Cell&           cell  = col.cells[i];
+
+                cell.type = value.m_typeID;
+
+                switch( value.m_typeID )
+                {
+                    case SQLITE_INTEGER:
+                        cell.i = value.m_integer;
+                        break;
+
+                    case SQLITE_FLOAT:
+                        cell.d = value.m_float;
+                        break;
+
+                    case SQLITE_TEXT:
+                        cell.bytes = value.m_text ? value.m_text : "";
+                        break;
+
+                    case SQLITE_BLOB:
+                    {
+                        ValueMex blob( value.m_blob );
+                        cell.bytes.assign( (const char*)blob.Data(), blob.ByData() );
+                        break;
+                    }
+
+                    default:
+                        cell.type = SQLITE_NULL;
+                        break;
+                }
+
+                m_bytes += sizeof( Cell ) + cell.bytes.size();
+            }
+        }
+    }
+
+
+    /// Get column index by MATLAB or SQL name, -1 if unknown
+    int findColumn( const std::string& name ) const
+    {
+        for( size_t j = 0; j < m_cols.size(); j++ )
+        {
+            if( m_cols[j].name == name || m_cols[j].sqlname == name )
+            {
+                return (int)j;
+            }
+        }
+
+        return -1;
+    }
+
+
+    /**
+     * \brief Build fetched columns from a selection of columns and rows
+     *
+     * \param[in] columns Column indices
+     * \param[in] rows Row indices (0-based), all rows if \p allRows is set
+     * \param[in] allRows Select all rows
+     * \param[out] cols Columns as fetched by SQLiface::fetch()
+     * \returns false on memory allocation error
+     *
+     * Texts refer to the native buffers, they must not be released
+     * before \p cols.
+     */
+    bool select( const std::vector<int>& columns, const std::vector<size_t>& rows, bool allRows, ValueSQLCols& cols )
+    {
+        size_t count = allRows ? m_rows : rows.size();
+
+        cols.clear();
+
+        // all columns first, since filled columns must not be relocated
+        for( size_t k = 0; k < columns.size(); k++ )
+        {
+            const Column& col = m_cols[columns[k]];
+
+            cols.push_back( ValueSQLCol( ValueSQLCol::StringPair( col.sqlname, col.name ) ) );
+        }
+
+        for( size_t k = 0; k < columns.size(); k++ )
+        {
+            const Column& col = m_cols[columns[k]];
+            ValueSQLCol&  dst = cols[k];
+
+            if( col.isFloat )
+            {
+                if( allRows )
+                {
+                    dst.m_float = col.floats;
+                }
+                else
+                {
+                    dst.m_float.resize( count );
+
+                    for( size_t i = 0; i < count; i++ )
+                    {
+                        dst.m_float[i] = col.floats[rows[i]];
+                    }
+                }
+
+                continue;
+            }
+
+            dst.swapToAnyType();
+            dst.m_any.reserve( count );
+
+            for( size_t i = 0; i < count; i++ )
+            {
+                const Cell& cell = col.cells[allRows ? i : rows[i]];
+
+                switch( cell.type )
+                {
+                    case SQLITE_INTEGER:
+                        dst.m_any.push_back( ValueSQL( cell.i ) );
+                        break;
+
+                    case SQLITE_FLOAT:
+                        dst.m_any.push_back( ValueSQL( cell.d ) );
+                        break;
+
+                    case SQLITE_TEXT:
+                        // refers to the native buffer (constant, not released)
+                        dst.m_any.push_back( ValueSQL( cell.bytes.c_str() ) );
+                        break;
+
+                    case SQLITE_BLOB:
+                    {
+                        size_t   bytes = cell.bytes.size();
+                        ValueMex item  = ValueMex( (int)bytes, bytes ? 1 : 0, ValueMex::UINT8_CLASS );
+
+                        if( !item.Item() )
+                        {
+                            cols.clear();
+                            return false;
+                        }
+
+                        if( bytes )
+                        {
+                            memcpy( item.Data(), cell.bytes.data(), bytes );
+                        }
+
+                        dst.m_any.push_back( ValueSQL( item.Detach() ) );
+                        break;
+                    }
+
+                    default:
+                        dst.m_any.push_back( ValueSQL() );
+                        break;
+                }
+            }
+        }
+
+        return true;
+    }
+};
+
+
+/**
+ * \brief Results referenced by handles, released least recently used first
+ */
+class LazyResults
+{
+    typedef std::map<int, LazyResult*> ResultMap;   ///< Dictionary: handle => result
+
+    ResultMap       m_results;      ///< Results held
+    int             m_next;         ///< Next handle
+    double          m_budget;       ///< Memory budget in bytes
+    double          m_total;        ///< Memory used by all results
+    unsigned long   m_clock;        ///< Use counter (LRU)
+
+public:
+    /// Standard ctor
+    LazyResults() : m_next( 1 ), m_budget( CONFIG_RESULT_BUDGET ), m_total( 0.0 ), m_clock( 0 ) {}
+
+
+    /// Dtor
+    ~LazyResults()
+    {
+        (void)releaseAll();
+    }
+
+
+    /// Take ownership of \p result, returns its handle
+    int add( LazyResult* result )
+    {
+        int handle = m_next++;
+
+        result->m_stamp = ++m_clock;
+        m_results[handle] = result;
+        m_total += result->m_bytes;
+        evict( handle );
+
+        return handle;
+    }
+
+
+    /// Get result by handle (and mark it as used), NULL if invalid or evicted
+    LazyResult* get( int handle )
+    {
+        ResultMap::iterator it = m_results.find( handle );
+
+        if( it == m_results.end() )
+        {
+            return NULL;
+        }
+
+        it->second->m_stamp = ++m_clock;
+        return it->second;
+    }
+
+
+    /// Release a result, returns false if \p handle is invalid
+    bool release( int handle )
+    {
+        ResultMap::iterator it = m_results.find( handle );
+
+        if( it == m_results.end() )
+        {
+            return false;
+        }
+
+        m_total -= it->second->m_bytes;
+        delete it->second;
+        m_results.erase( it );
+
+        return true;
+    }
+
+
+    /// Release all results, returns their count
+    int releaseAll()
+    {
+        int count = (int)m_results.size();
+
+        for( ResultMap::iterator it = m_results.begin(); it != m_results.end(); it++ )
+        {
+            delete it->second;
+        }
+
+        m_results.clear();
+        m_total = 0.0;
+
+        return count;
+    }
+
+
+    /// Set memory budget in bytes, returns the previous one
+    double setBudget( double budget )
+    {
+        double old = m_budget;
+
+        m_budget = budget;
+        evict( 0 );
+
+        return old;
+    }
+
+
+    /// Returns the memory budget in bytes
+    double budget()
+    {
+        return m_budget;
+    }
+
+
+    /// Returns the memory used by all results in bytes
+    double total()
+    {
+        return m_total;
+    }
+
+
+    /// Returns the number of results held
+    int count()
+    {
+        return (int)m_results.size();
+    }
+
+
+private:
+    /// Release least recently used results until the budget is kept (except \p keep)
+    void evict( int keep )
+    {
+        while( m_total > m_budget )
+        {
+            ResultMap::iterator lru = m_results.end();
+
+            for( ResultMap::iterator it = m_results.begin(); it != m_results.end(); it++ )
+            {
+                if( it->first != keep && ( lru == m_results.end() || it->second->m_stamp < lru->second->m_stamp ) )
+                {
+                    lru = it;
+                }
+            }
+
+            if( lru == m_results.end() )
+            {
+                break;
+            }
+
+            release( lru->first );
+        }
+    }
+};
@@ -106,6 +106,23 @@ int           getLocale     ();
 #define MSG_ERRNULLDBID                 51
 #define MSG_ERRINTERNAL                 52
 #define MSG_ABORTED                     53
+#define MSG_SIDECARNOFILE               54
+#define MSG_ERRSIDECAR                  55
+#define MSG_STACKMISMATCH               56
+#define MSG_CARRAYTYPE                  57
+#define MSG_INVALIDSTMTHANDLE           58
+#define MSG_SCRIPTSTMT                  59
+#define MSG_SHARDSNOTOPEN               60
+#define MSG_SHARDQUERY                  61
+#define MSG_SHARDMERGE                  62
+#define MSG_INVALIDBACKUP               63
+#define MSG_NOTWALMODE                  64
+#define MSG_INVALIDRESULT               65
+#define MSG_UNKNOWNCOLUMN               66
+#define MSG_NOSESSION                   67
+#define MSG_CHANGESETABORT              68
+#define MSG_INVALIDCHANGESET            69
+#define MSG_SESSIONINTRANSACTION        70
 /** @}  */
 
 
@@ -183,7 +200,11 @@ public:
             m_static_msg  = m_shared_msg;
             m_isPending   = true;
             
-            _snprintf( m_shared_msg, sizeof(m_shared_msg), "%s", strMsg );
+            // set_printf() passes the shared buffer itself
+            if( strMsg != m_shared_msg )
+            {
+                _snprintf( m_shared_msg, sizeof(m_shared_msg), "%s", strMsg );
+            }
         }
     }
     
@@ -205,6 +226,7 @@ public:
          else
          {
             set( ::getLocaleMsg( iMessageNr ), strId );
+            m_msgId = iMessageNr;  // set() above resets to MSG_PURESTRING
          }
     }
     
@@ -229,6 +251,7 @@ public:
             vsnprintf( m_shared_msg, sizeof( m_shared_msg ), message, va );
          }
          set( m_shared_msg, strId );
+         m_msgId = iMessageNr;  // set() above resets to MSG_PURESTRING
          
          va_end( va );
     }
@@ -370,6 +393,23 @@ static const char* messages_0[] =
 /* 51*/    "dbid of 0 only allowed for commands 'open' and 'close'!",
 /* 52*/    "Internal error!",
 /* 53*/    "Aborted (Ctrl+C)!",
+/* 54*/    "sidecar storage needs a file based database!",
+/* 55*/    "sidecar segment missing, damaged or not writable!",
+/* 56*/    "typed BLOBs in column '%s' differ in class or size and can't be stacked",
+/* 57*/    "carray() expects a real numeric or logical vector (uint64 up to intmax('int64')), or a cell array of strings!",
+/* 58*/    "invalid statement handle!",
+/* 59*/    "statement %d of script failed: %s",
+/* 60*/    "no shards open (or no files match)!",
+/* 61*/    "query on shard \"%s\" failed: %s",
+/* 62*/    "invalid shard merge: %s",
+/* 63*/    "invalid backup job handle!",
+/* 64*/    "checkpointer needs a file database in WAL mode (PRAGMA journal_mode=WAL)!",
+/* 65*/    "invalid result handle (released or exceeded the memory budget)!",
+/* 66*/    "unknown column '%s'",
+/* 67*/    "no session started (see 'session_start')!",
+/* 68*/    "changeset conflicts with the database, no changes applied!",
+/* 69*/    "invalid changeset!",
+/* 70*/    "changeset can't be taken within a transaction (uncommitted changes)!",
 };
 
 
@@ -441,6 +481,23 @@ static const char* messages_1[] =
 /* 51*/    "0 als dbid ist nur fuer die Befehle 'open' und 'close' erlaubt! ",
 /* 52*/    "Interner Fehler! ",
 /* 53*/    "Ausfuehrung abgebrochen (Ctrl+C)!",
+/* 54*/    "Sidecar Speicher benoetigt eine dateibasierte Datenbank! ",
+/* 55*/    "Sidecar Segment fehlt, ist beschaedigt oder nicht beschreibbar! ",
+/* 56*/    "typisierte BLOBs der Spalte '%s' unterscheiden sich in Typ oder Groesse und koennen nicht gestapelt werden",
+/* 57*/    "carray() erwartet einen reellen numerischen oder logischen Vektor (uint64 bis intmax('int64')), oder ein Cell-Array aus Strings! ",
+/* 58*/    "ungueltiger Statement Handle! ",
+/* 59*/    "Anweisung %d des Skripts fehlgeschlagen: %s",
+/* 60*/    "keine Shards geoeffnet (oder keine passenden Dateien)! ",
+/* 61*/    "Abfrage auf Shard \"%s\" fehlgeschlagen: %s",
+/* 62*/    "ungueltige Shard Zusammenfuehrung: %s",
+/* 63*/    "ungueltiger Backup Handle! ",
+/* 64*/    "Checkpointer benoetigt eine dateibasierte Datenbank im WAL Modus (PRAGMA journal_mode=WAL)! ",
+/* 65*/    "ungueltiger Ergebnis Handle (freigegeben oder Speicherbudget ueberschritten)! ",
+/* 66*/    "unbekannte Spalte '%s'",
+/* 67*/    "keine Session gestartet (siehe 'session_start')! ",
+/* 68*/    "Changeset steht in Konflikt mit der Datenbank, keine Aenderungen uebernommen! ",
+/* 69*/    "ungueltiges Changeset! ",
+/* 70*/    "Changeset kann nicht innerhalb einer Transaktion abgeholt werden (nicht festgeschriebene Aenderungen)! ",
 };
 
 /**
@@ -450,7 +507,8 @@ static const char* messages_1[] =
 const char* STR_RESULT_TYPES[] = {
     "array of structs",   // RESULT_TYPE_ARRAYOFSTRUCTS
     "struct of arrays",   // RESULT_TYPE_STRUCTOFARRAYS  
-    "matrix/cell array"   // RESULT_TYPE_MATRIX
+    "matrix/cell array",  // RESULT_TYPE_MATRIX
+    "result handle"       // RESULT_TYPE_HANDLE
 };
 
 
@@ -26,6 +26,9 @@
 //#include "typed_blobs.hpp"          // Packing into typed blobs with variable type storage
 //#include "utils.hpp"                // Utilities 
 #include "sql_interface.hpp"        // SQLite interface
+#include "shards.hpp"               // Scatter-gather queries on database files
+#include "backup.hpp"               // Online backup in a background thread
+#include "lazy_result.hpp"          // Query results held by handles
 //#include "locale.hpp"               // (Error-)Messages
 //#include <vector>
 
@@ -75,10 +78,11 @@ public:
     
     SQLstackitem m_db[COUNT_DB];     ///< SQLite database slots
     int          m_dbid;             ///< recent selected database id, base 0
+    int          m_stmt_serial;      ///< number of statement handles created so far
     
     
     /// Standard Ctor (first database slot is default)
-    SQLstack(): m_dbid(0) 
+    SQLstack(): m_dbid(0), m_stmt_serial(0)
     {
         sqlite3_initialize();
     };
@@ -125,6 +129,21 @@ public:
     }
     
     
+    /// Returns a new statement handle for the current database
+    int newStmtHandle()
+    {
+        // database slot is encoded in the handle
+        return ++m_stmt_serial * COUNT_DB + m_dbid + 1;
+    }
+    
+    
+    /// Returns the database slot (base 0) a statement handle belongs to, or -1 for invalid handles
+    int stmtHandleSlot( int handle )
+    {
+        return handle > COUNT_DB ? ( handle - 1 ) % COUNT_DB : -1;
+    }
+    
+    
     /// Outputs current status for each database slot
     void printStatuses( int dbid_req, int dbid )
     {
@@ -161,6 +180,16 @@ public:
     }
     
     
+    /// Shrinks the statement caches of all databases to the current cache size
+    void trimStmtCaches()
+    {
+        for( int i = 0; i < COUNT_DB; i++ )
+        {
+            m_db[i].stmtCacheTrim();
+        }
+    }
+    
+    
     /// Closes all open databases and returns the number of closed DBs, if any open
     int closeAllDbs()
     {
@@ -182,6 +211,11 @@ public:
 } SQLstack; ///< Holding the SQLiface slots
 
 
+static ShardSet Shards;  ///< Database files opened by 'shards_open'
+static BackupJobs Backups;  ///< Jobs started by 'backup'
+static LazyResults Results;  ///< Query results returned as handles (result type 3)
+
+
 /**
  * \brief Module deinitialization
  *
@@ -189,7 +223,11 @@ public:
  */
 void mex_module_deinit()
 {
-    if( SQLstack.closeAllDbs() > 0 )
+    // running backups read from the databases
+    (void)Backups.releaseAll();
+    (void)Results.releaseAll();
+    
+    if( SQLstack.closeAllDbs() + Shards.close() > 0 )
     {
         /*
          * inform the user, databases have been closed
@@ -224,9 +262,13 @@ void mex_module_init()
             PRINTF( ::getLocaleMsg( MSG_HELLO ), 
                     SQLITE_VERSION );
 
-            PRINTF( "Platform: %s, %s\n\n", 
+            size_t l1_size = 0, l2_size = 0;
+            blosc_get_cache_sizes( &l1_size, &l2_size );
+
+            PRINTF( "Platform: %s, %s, L1d %d KB, L2 %d KB\n\n", 
                     TBH_platform, 
-                    TBH_endian[0] == 'L' ? "little endian" : "big endian" );
+                    TBH_endian[0] == 'L' ? "little endian" : "big endian",
+                    (int)( l1_size / 1024 ), (int)( l2_size / 1024 ) );
 
             is_initialized = true;
         }
@@ -248,16 +290,36 @@ void mex_module_init()
 }
 
 
+/**
+ * \brief Create a numeric 1x1 matrix, its value is set by the caller
+ *
+ * @param[in] clsid MATLAB class of the element
+ * @returns the MATLAB array or NULL if out of memory
+ *
+ * The element isn't initialized with zero, if the MATLAB version
+ * provides uninitialized allocation (see CONFIG_UNINIT_ALLOC).
+ */
+inline mxArray* createUninitScalar( mxClassID clsid )
+{
+#if CONFIG_UNINIT_ALLOC
+    return mxCreateUninitNumericMatrix( 1, 1, clsid, mxREAL );
+#else
+    return mxCreateNumericMatrix( 1, 1, clsid, mxREAL );
+#endif
+}
+
+
 /**
  * \brief Transfer fetched SQL value into MATLAB array
  *
  * @param[in] value encapsulated SQL field value
  * @param[out] err_id Error ID (see \ref MSG_IDS)
+ * @param[in] sidecar sidecar storage to resolve references with (optional)
  * @returns a MATLAB array due to value type (string or numeric content)
  *
  * @see g_result_type
  */
-ValueMex createItemFromValueSQL( const ValueSQL& value, int& err_id )
+ValueMex createItemFromValueSQL( const ValueSQL& value, int& err_id, const SidecarStore* sidecar )
 {
     mxArray* item = NULL;
 
@@ -275,7 +337,7 @@ ValueMex createItemFromValueSQL( const ValueSQL& value, int& err_id )
         break;
 
       case SQLITE_INTEGER:
-        item = mxCreateNumericMatrix( 1, 1, mxINT64_CLASS, mxREAL );
+        item = createUninitScalar( mxINT64_CLASS );
 
         if(item)
         {
@@ -284,7 +346,12 @@ ValueMex createItemFromValueSQL( const ValueSQL& value, int& err_id )
         break;
 
       case SQLITE_FLOAT:
-        item = mxCreateDoubleScalar( value.m_float );
+        item = createUninitScalar( mxDOUBLE_CLASS );
+
+        if(item)
+        {
+            *mxGetPr( item ) = value.m_float;
+        }
         break;
 
       case SQLITE_TEXT:
@@ -315,10 +382,19 @@ ValueMex createItemFromValueSQL( const ValueSQL& value, int& err_id )
                 const void* blob         = ValueMex( value.m_blob ).Data();
                 double      process_time = 0.0;
                 double      ratio = 0.0;
-                int         err_id;
 
-                /* blob_unpack() modifies g_finalize_msg */
-                err_id = blob_unpack( blob, blob_size, can_serialize(), &item, &process_time, &ratio );
+                if( sidecar && SidecarRef::isRef( blob, blob_size ) )
+                {
+                    // BLOB is stored externally, unpacked from mapped segment file
+                    err_id = sidecar->unpack( blob, can_serialize(), &item );
+                }
+                else
+                {
+                    int err_id;
+                    
+                    /* blob_unpack() modifies g_finalize_msg */
+                    err_id = blob_unpack( blob, blob_size, can_serialize(), &item, &process_time, &ratio );
+                }
             }
         } 
         else 
@@ -347,11 +423,12 @@ ValueMex createItemFromValueSQL( const ValueSQL& value, int& err_id )
  * @param[in] bStreamable true, if serialization is active
  * @param[out] iTypeComplexity see ValueMex::type_complexity_e
  * @param[out] err_id Error ID (see \ref MSG_IDS)
+ * @param[in] sidecar sidecar storage for large typed BLOBs (optional)
  * @returns a SQL value type
  *
  * @see g_result_type
  */
-ValueSQL createValueSQLFromItem( const ValueMex& item, bool bStreamable, int& iTypeComplexity, int& err_id )
+ValueSQL createValueSQLFromItem( const ValueMex& item, bool bStreamable, int& iTypeComplexity, int& err_id, SidecarStore* sidecar )
 {
     iTypeComplexity = item.Item() ? item.Complexity( bStreamable ) : ValueMex::TC_EMPTY;
 
@@ -360,7 +437,7 @@ ValueSQL createValueSQLFromItem( const ValueMex& item, bool bStreamable, int& iT
     switch( iTypeComplexity )
     {
         case ValueMex::TC_COMPLEX:
-          // structs, cells and complex data 
+          // structs and cells 
           // can only be stored as officially undocumented byte stream feature
           // (SQLite typed ByteStream BLOB)
           if( !bStreamable || !typed_blobs_mode_on() )
@@ -369,6 +446,17 @@ ValueSQL createValueSQLFromItem( const ValueMex& item, bool bStreamable, int& iT
               break;
           }
           
+          /* fallthrough */
+        case ValueMex::TC_TYPED_ARRAY:
+          // complex arrays and sparse matrices are stored
+          // natively in typed BLOBs (real and imaginary lanes, 
+          // delta coded sparse indices)
+          if( !typed_blobs_mode_on() )
+          {
+              err_id = MSG_INVALIDARG;
+              break;
+          }
+          
           /* fallthrough */
         case ValueMex::TC_SIMPLE_ARRAY:
           // multidimensional non-complex numeric or char arrays
@@ -392,9 +480,24 @@ ValueSQL createValueSQLFromItem( const ValueMex& item, bool bStreamable, int& iT
               size_t blob_size     = 0;
               double process_time  = 0.0;
               double ratio         = 0.0;
+              bool   bSidecar      = sidecar && sidecar->isOn();
 
               /* blob_pack() modifies g_finalize_msg */
-              err_id = blob_pack( item.Item(), bStreamable, &blob, &blob_size, &process_time, &ratio );
+              err_id = blob_pack( item.Item(), bStreamable, &blob, &blob_size, &process_time, &ratio,
+                                  g_compression_type, g_compression_level, 
+                                  bSidecar ? (size_t)-1 : CONFIG_MKSQLITE_MAX_BLOB_SIZE );
+              
+              // large BLOBs are stored in the sidecar, the database holds a reference only
+              if( MSG_NOERROR == err_id && bSidecar && sidecar->accepts( blob_size ) )
+              {
+                  void*  ref      = NULL;
+                  size_t ref_size = 0;
+
+                  err_id = sidecar->store( blob, blob_size, &ref, &ref_size );
+                  blob_free( &blob );
+                  blob      = ref;
+                  blob_size = ref_size;
+              }
               
               if( MSG_NOERROR == err_id )
               {
@@ -414,12 +517,8 @@ ValueSQL createValueSQLFromItem( const ValueMex& item, bool bStreamable, int& iT
               case ValueMex::INT32_CLASS:
               case ValueMex::UINT16_CLASS:
               case ValueMex::UINT32_CLASS:
-                  // scalar integer value
-                  value = ValueSQL( (sqlite3_int64)item.GetInt() );
-                  break;
-                  
               case ValueMex::INT64_CLASS:
-                  // scalar integer value
+                  // scalar integer value (uint32 exceeds int)
                   value = ValueSQL( item.GetInt64() );
                   break;
 
@@ -485,6 +584,7 @@ class Mksqlite
     const char*       m_query;            ///< \p m_command, or a translation from \p m_command
     int               m_dbid_req;         ///< requested database id (user input) -1="arg missing", 0="next free slot" or 1..COUNT_DB
     int               m_dbid;             ///< selected database slot (1..COUNT_DB)
+    int               m_stmt_handle;      ///< statement handle to execute (command 'exec'), or 0
     SQLerror          m_err;              ///< recent error
     SQLiface*         m_interface;        ///< interface (holding current SQLite statement) to current database
     
@@ -501,7 +601,7 @@ public:
     Mksqlite( int nlhs, mxArray** plhs, int nrhs, const mxArray** prhs )
     : m_nlhs( nlhs ), m_plhs( plhs ), 
       m_narg( nrhs ), m_parg( prhs ),
-      m_command(NULL), m_query(NULL), m_dbid_req(-1), m_dbid(1), m_interface( NULL )
+      m_command(NULL), m_query(NULL), m_dbid_req(-1), m_dbid(1), m_stmt_handle(0), m_interface( NULL )
     {
         /*
          * no argument -> fail
@@ -1023,7 +1123,8 @@ public:
         if( !m_interface->setEnableLoadExtension( flagOnOff ) )
         {
             const char* errid = NULL;
-            m_err.set( m_interface->getErr(&errid), errid );
+            const char* errmsg = m_interface->getErr( &errid );
+            m_err.set( errmsg, errid );
             return false;
         }
 
@@ -1097,7 +1198,8 @@ public:
                                              SQLstack.current().getException() ) )
         {
             const char* errid = NULL;
-            m_err.set( m_interface->getErr(&errid), errid );
+            const char* errmsg = m_interface->getErr( &errid );
+            m_err.set( errmsg, errid );
             return false;
         }
         
@@ -1176,7 +1278,8 @@ public:
                                              SQLstack.current().getException() ) )
         {
             const char* errid = NULL;
-            m_err.set( m_interface->getErr(&errid), errid );
+            const char* errmsg = m_interface->getErr( &errid );
+            m_err.set( errmsg, errid );
             return false;
         }
         
@@ -1261,6 +1364,18 @@ public:
             {
                 g_compression_type = BLOSC_DEFAULT_ID;
             } 
+            else if( STRMATCH( new_compressor, BLOSC_LZ4_BIT_ID ) )
+            {
+                g_compression_type = BLOSC_LZ4_BIT_ID;
+            } 
+            else if( STRMATCH( new_compressor, BLOSC_LZ4HC_BIT_ID ) )
+            {
+                g_compression_type = BLOSC_LZ4HC_BIT_ID;
+            } 
+            else if( STRMATCH( new_compressor, BLOSC_DEFAULT_BIT_ID ) )
+            {
+                g_compression_type = BLOSC_DEFAULT_BIT_ID;
+            } 
             else if( STRMATCH( new_compressor, QLIN16_ID ) )
             {
                 g_compression_type = QLIN16_ID;
@@ -1288,75 +1403,91 @@ public:
     
     
     /**
-     * \brief Handle status command
+     * \brief Handle command selecting the instruction set of the blosc shuffle filter
      *
      * \param[in] strCmdMatchName Command name
-     * \returns true on success
      * 
-     * Try to interpret current command as status command.
-     * \p strCmdMatchName holds the mksqlite command name.
+     * Optional argument is one of "auto", "avx2", "sse2" or "generic".
+     * Settings beyond the capabilities of the CPU fall back to the best
+     * supported one. m_plhs[0] will be set to the name of the instruction
+     * set used before.
      */
-    bool cmdTryHandleStatus( const char* strCmdMatchName )
+    bool cmdTryHandleCompressionSimd( const char* strCmdMatchName )
     {
-        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) ) 
+        static const char* names[] = { "generic", "sse2", "avx2" };
+
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
         {
             return false;
         }
         
         // Global command, dbid useless
+        warnOnDefDbid();
         
-        /*
-         * There should be no argument to status
-         */
-        if( m_narg > 0 )
+        if( m_narg > 1 ) 
         {
             m_err.set( MSG_UNEXPECTEDARG );
             return false;
         }
 
-        if( !m_nlhs )
-        {
-            SQLstack.printStatuses( m_dbid_req, m_dbid );
-        }
-        else 
+        int old_level = shuffle_simd();
+        
+        if( m_narg > 0 )
         {
-            if( m_dbid_req == 0 )
+            const mxArray* arg = NULL;
+            int new_level = -2;
+
+            if( !argGetNextLiteral( arg ) )
             {
-                mxArray* result = mxCreateCellMatrix( SQLstack.COUNT_DB, 1 );
-                for( int i = 0; result && i < SQLstack.COUNT_DB; i++ )
+                // argGetNextLiteral() sets m_err
+                return false;
+            }
+
+            char* buffer = ::utils_getString( arg );
+            if( buffer )
+            {
+                if( STRMATCH( buffer, "auto" ) )
                 {
-                    mxArray* item = mxGetCell( result, i );
-                    mxSetCell( result, i, mxCreateString( SQLstack.m_db[i].isOpen() ? "OPEN" : "CLOSED" ) );
-                    mxDestroyArray( item );
+                    new_level = -1;
                 }
-
-                if( result )
+                for( int i = 0; i < (int)( sizeof( names ) / sizeof( names[0] ) ); i++ )
                 {
-                    m_plhs[0] = result;
+                    if( STRMATCH( buffer, names[i] ) )
+                    {
+                        new_level = i;
+                    }
                 }
+                ::utils_free_ptr( buffer );
             }
-            else
+            
+            if( new_level < -1 )
             {
-                m_plhs[0] = mxCreateString( SQLstack.m_db[m_dbid].isOpen() ? "OPEN" : "CLOSED" );
+                m_err.set( MSG_INVALIDARG );
+                return false;
             }
+            
+            (void)shuffle_set_simd( new_level );
         }
         
+        m_plhs[0] = mxCreateString( names[old_level] );
+
         return true;
     }
     
     
     /**
-     * \brief Handle language command
+     * \brief Handle command setting the blosc block size
      *
      * \param[in] strCmdMatchName Command name
-     * \returns true on success
      * 
-     * Try to interpret current command as status command.
-     * \p strCmdMatchName holds the mksqlite command name.
+     * Arguments are the compressor name, the element size in bytes and
+     * optionally the new block size in bytes (0=automatic). The setting
+     * applies to all blosc compressions of elements of this size.
+     * m_plhs[0] will be set to the block size used before.
      */
-    bool cmdTryHandleLanguage( const char* strCmdMatchName )
+    bool cmdTryHandleCompressionBlocksize( const char* strCmdMatchName )
     {
-        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) ) 
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
         {
             return false;
         }
@@ -1364,309 +1495,3497 @@ public:
         // Global command, dbid useless
         warnOnDefDbid();
         
-        /*
-         * There should be one numeric argument
-         */
-        if( m_narg < 1 ) 
+        if( m_narg < 2 ) 
         {
             m_err.set( MSG_MISSINGARG );
             return false;
         }
-        else if( m_narg > 1 ) 
+        else if( m_narg > 3 ) 
         {
             m_err.set( MSG_UNEXPECTEDARG );
             return false;
         }
-
-        if( !mxIsNumeric( m_parg[0] ) )
+        
+        const mxArray* arg = NULL;
+        const char* blosc_name = NULL;
+        bool bSetBlocksize = ( m_narg > 2 );
+        int element_size = 0;
+        int blocksize = 0;
+        
+        if( !argGetNextLiteral( arg ) )
         {
-            m_err.set( MSG_NUMARGEXPCT );
+            // argGetNextLiteral() sets m_err
             return false;
-        } else {
-            int iLang = ValueMex( m_parg[0] ).GetInt();
+        }
+        
+        if(1)
+        {
+            NumberCompressor compressor;
+            char* name = ::utils_getString( arg );
             
-            if( !setLocale( iLang ) )
+            if( name && compressor.setCompressor( name, 1 ) )
             {
-                m_err.set( MSG_INVALIDARG );
-                return false;
+                blosc_name = compressor.getBloscCompressorName();
             }
+            ::utils_free_ptr( name );
         }
-
-        return true;
-    }
-    
-    
-    /**
-     * @brief Get the filename of current database
-     * 
-     * @param strCmdMatchName Command name
-     * @return true on success
-     * 
-     * filename will be given in m_plhs[0]
-     */
-    bool cmdTryHandleFilename( const char* strCmdMatchName )
-    {
-        char *db_filename = NULL;
-        char *db_name     = NULL;
-
-        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
-        {
-            return false;
-        }
-
-        SQLstack.switchTo( m_dbid-1 );
-
-        // database must be open to change settings
-        if( !ensureDbIsOpen() )
+        
+        if( !argGetNextInteger( element_size ) || ( bSetBlocksize && !argGetNextInteger( blocksize ) ) )
         {
-            // ensureDbIsOpen() sets m_err
+            // argGetNextInteger() sets m_err
             return false;
         }
         
-        /*
-         * There should be not more than 1 argument to get the db filename
-         */
-        if( m_narg > 1 )
+        if( !blosc_name || element_size < 1 || element_size > BLOSC_MAX_TYPESIZE 
+            || blocksize < 0 || blocksize > BLOSC_MAX_BUFFERSIZE )
         {
-            m_err.set( MSG_UNEXPECTEDARG );
+            m_err.set( MSG_INVALIDARG );
             return false;
         }
-
-        // Check if database name is given (for attached databases)
-        if( m_narg == 1 )
-        {
-            if( !mxIsChar( m_parg[0] ) )
-            {
-                m_err.set( MSG_LITERALARGEXPCT );
-                return false;
-            } else {
-                db_name = ValueMex( m_parg[0] ).GetEncString();
-            }
-        }
-
-        db_filename = ::utils_strnewdup( m_interface->getDbFilename( db_name ), /*flagConvertUTF8*/ true );
-
-        if( NULL == db_filename )
-        {
-            m_plhs[0] = mxCreateString( "" );  // Memory based database
-        }
-        else
+        
+        int& entry = NumberCompressor::bloscBlocksize( blosc_name, (size_t)element_size );
+        
+        m_plhs[0] = mxCreateDoubleScalar( (double)entry );
+        
+        if( bSetBlocksize )
         {
-            m_plhs[0] = mxCreateString( db_filename );  // File based database
+            entry = blocksize;
         }
-
-        ::utils_free_ptr( db_name );
-        ::utils_free_ptr( db_filename );
-
+        
         return true;
     }
-
-
+    
+    
     /**
-     * \brief Handle streaming setting command
+     * \brief Handle command sweeping blosc block sizes on a sample array
      *
      * \param[in] strCmdMatchName Command name
-     * \returns true on success
      * 
-     * Try to interpret current command as streaming switch.
-     * \p strCmdMatchName holds the mksqlite command name.
-     * m_plhs[0] will be set to the old setting.
+     * Arguments are the compressor name, the compression level, a real numeric
+     * or logical sample array and optionally a flag to apply the best block size.
+     * The sample is compressed with automatic block size and with block sizes
+     * of 4 KB up to 16 MB (powers of 2, not beyond the sample size).
+     * m_plhs[0] will be set to a struct array holding block size, compression
+     * ratio and throughput (MB/s) of each run. The selected row is the fastest
+     * one (packing and unpacking), whose compressed size doesn't exceed the
+     * smallest one by more than 5%.
      */
-    bool cmdTryHandleStreaming( const char* strCmdMatchName )
+    bool cmdTryHandleCompressionTune( const char* strCmdMatchName )
     {
-        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) ) 
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
         {
             return false;
         }
         
         // Global command, dbid useless
         warnOnDefDbid();
-
-        /*
-         *  Check max number of arguments
-         */
-        if( m_narg > 1 )
+        
+        if( m_narg < 3 ) 
+        {
+            m_err.set( MSG_MISSINGARG );
+            return false;
+        }
+        else if( m_narg > 4 ) 
         {
             m_err.set( MSG_UNEXPECTEDARG );
             return false;
         }
         
-        /*
-         *  try to read flag
-         */
-        int flagOnOff = g_streaming;
-        if( m_narg && !argGetNextInteger( flagOnOff, /*asBoolInt*/ true ) )
+        const mxArray* arg = NULL;
+        int level = 0, apply = 0;
+        
+        if( !argGetNextLiteral( arg ) || !argGetNextInteger( level ) )
+        {
+            // argGetNextLiteral() and argGetNextInteger() set m_err
+            return false;
+        }
+        
+        const mxArray* sample = m_parg[0];
+        m_parg++;
+        m_narg--;
+        
+        if( m_narg > 0 && !argGetNextInteger( apply, /*asBoolInt*/ true ) )
         {
             // argGetNextInteger() sets m_err
             return false;
         }
         
-        // Report, if serialization is not possible (reset flag then)
-        if( flagOnOff && !have_serialize() )
+        NumberCompressor compressor;
+        char* name = ::utils_getString( arg );
+        bool valid = name && level > 0 && level <= 9 && compressor.setCompressor( name, level ) 
+                     && compressor.getBloscCompressorName();
+        ::utils_free_ptr( name );
+        
+        if( !valid || !( mxIsNumeric( sample ) || mxIsLogical( sample ) ) 
+            || mxIsComplex( sample ) || mxIsSparse( sample ) || mxIsEmpty( sample ) )
         {
-            PRINTF( "%s\n", ::getLocaleMsg( MSG_STREAMINGNOTSUPPORTED ) );
-            flagOnOff = 0;
+            m_err.set( MSG_INVALIDARG );
+            return false;
         }
         
-        // Report, if user tries to use streaming with blobs turned off (reset flag then)
-        if( flagOnOff && !typed_blobs_mode_on() )
+        size_t element_size = mxGetElementSize( sample );
+        size_t nbytes       = mxGetNumberOfElements( sample ) * element_size;
+        
+        if( nbytes > BLOSC_MAX_BUFFERSIZE )
         {
-            PRINTF( "%s\n", ::getLocaleMsg( MSG_STREAMINGNEEDTYBLOBS ) );
-            flagOnOff = 0;
+            m_err.set( MSG_INVALIDARG );
+            return false;
         }
         
-        // always return current status
-        m_plhs[0] = mxCreateDoubleScalar( (double)g_streaming );
+        // block sizes to test, 0 for automatic
+        vector<int> blocksizes( 1, 0 );
+        for( size_t size = 4 * 1024; size <= nbytes && size <= 16 * 1024 * 1024; size *= 2 )
+        {
+            blocksizes.push_back( (int)size );
+        }
         
-        // store new value
-        g_streaming = flagOnOff;
+        // repeat each run to process 64 MB at least (limited to 50 runs)
+        int repeat = (int)( 64.0 * 1024 * 1024 / nbytes );
+        repeat = repeat < 1 ? 1 : ( repeat > 50 ? 50 : repeat );
         
-        return true;
-    }
-    
+        const char* fieldnames[] = { "blocksize", "ratio", "pack_MBps", "unpack_MBps", "selected" };
+        const int nfields = (int)( sizeof( fieldnames ) / sizeof( fieldnames[0] ) );
+        vector<double> used( blocksizes.size() ), csize( blocksizes.size() ), seconds( blocksizes.size() );
+        vector<char> cdata, rdata( nbytes );
+        mxArray* result = mxCreateStructMatrix( (int)blocksizes.size(), 1, nfields, fieldnames );
+        
+        for( size_t i = 0; i < blocksizes.size(); i++ )
+        {
+            double pack_time = 0.0, unpack_time = 0.0, t0;
+            bool ok = true;
+            
+            compressor.setBlocksize( blocksizes[i] );
+            
+            t0 = ::utils_get_wall_time();
+            for( int k = 0; k < repeat && ok; k++ )
+            {
+                ok = compressor.pack( mxGetData( sample ), nbytes, element_size, mxIsDouble( sample ) )
+                     && compressor.m_result_size > 0;
+            }
+            pack_time = ::utils_get_wall_time() - t0;
+            
+            if( ok )
+            {
+                size_t blosc_nbytes = 0, blosc_cbytes = 0, blosc_blocksize = 0;
+                
+                cdata.assign( (char*)compressor.m_result, (char*)compressor.m_result + compressor.m_result_size );
+                blosc_cbuffer_sizes( &cdata[0], &blosc_nbytes, &blosc_cbytes, &blosc_blocksize );
+                used[i]  = (double)blosc_blocksize;
+                csize[i] = (double)cdata.size();
+                
+                t0 = ::utils_get_wall_time();
+                for( int k = 0; k < repeat && ok; k++ )
+                {
+                    ok = compressor.unpack( &cdata[0], cdata.size(), &rdata[0], nbytes, element_size );
+                }
+                unpack_time = ::utils_get_wall_time() - t0;
+                
+                ok = ok && 0 == memcmp( &rdata[0], mxGetData( sample ), nbytes );
+            }
+            
+            if( !ok )
+            {
+                ::utils_destroy_array( result );
+                m_err.set( MSG_ERRCOMPRESSION );
+                return false;
+            }
+            
+            double megabytes = (double)nbytes * repeat / ( 1024.0 * 1024.0 );
+            seconds[i] = pack_time + unpack_time;
+            
+            mxSetField( result, (int)i, "blocksize",   mxCreateDoubleScalar( used[i] ) );
+            mxSetField( result, (int)i, "ratio",       mxCreateDoubleScalar( (double)nbytes / csize[i] ) );
+            mxSetField( result, (int)i, "pack_MBps",   mxCreateDoubleScalar( megabytes / ( pack_time > 0 ? pack_time : 1e-9 ) ) );
+            mxSetField( result, (int)i, "unpack_MBps", mxCreateDoubleScalar( megabytes / ( unpack_time > 0 ? unpack_time : 1e-9 ) ) );
+        }
+        
+        // select the fastest run, not exceeding the smallest size by more than 5%
+        size_t best = 0;
+        double min_size = csize[0];
+        
+        for( size_t i = 1; i < csize.size(); i++ )
+        {
+            min_size = csize[i] < min_size ? csize[i] : min_size;
+        }
+        
+        for( size_t i = 0; i < csize.size(); i++ )
+        {
+            if( csize[i] <= 1.05 * min_size && ( csize[best] > 1.05 * min_size || seconds[i] < seconds[best] ) )
+            {
+                best = i;
+            }
+        }
+        
+        for( size_t i = 0; i < csize.size(); i++ )
+        {
+            mxSetField( result, (int)i, "selected", mxCreateLogicalScalar( i == best ) );
+        }
+        
+        if( apply )
+        {
+            NumberCompressor::bloscBlocksize( compressor.getBloscCompressorName(), element_size ) = blocksizes[best];
+        }
+        
+        m_plhs[0] = result;
+        
+        return true;
+    }
+    
     
     /**
-     * \brief Handle result type command
+     * \brief Handle status command
      *
      * \param[in] strCmdMatchName Command name
      * \returns true on success
      * 
-     * Try to interpret current command as result type.
+     * Try to interpret current command as status command.
      * \p strCmdMatchName holds the mksqlite command name.
-     * m_plhs[0] will be set to the old setting.
      */
-    bool cmdTryHandleResultType( const char* strCmdMatchName )
+    bool cmdTryHandleStatus( const char* strCmdMatchName )
     {
-        int new_result_type;
-        int old_result_type = g_result_type;
-        
         if( errPending() || !STRMATCH( m_command, strCmdMatchName ) ) 
         {
             return false;
         }
         
         // Global command, dbid useless
-        warnOnDefDbid();
-
+        
         /*
-         * There should be one integer argument
+         * There should be no argument to status
          */
-        if( m_narg > 1 )
+        if( m_narg > 0 )
         {
             m_err.set( MSG_UNEXPECTEDARG );
             return false;
         }
-        
-        // No arguments, then serve current state
-        if( !m_narg )
+
+        if( !m_nlhs )
         {
-            if( !m_nlhs )
+            SQLstack.printStatuses( m_dbid_req, m_dbid );
+        }
+        else 
+        {
+            if( m_dbid_req == 0 )
             {
-               // Print current result type
-                PRINTF( "%s(%d)\n", ::getLocaleMsg( MSG_RESULTTYPE ), g_result_type );
-            } 
-            else 
+                mxArray* result = mxCreateCellMatrix( SQLstack.COUNT_DB, 1 );
+                for( int i = 0; result && i < SQLstack.COUNT_DB; i++ )
+                {
+                    mxArray* item = mxGetCell( result, i );
+                    mxSetCell( result, i, mxCreateString( SQLstack.m_db[i].isOpen() ? "OPEN" : "CLOSED" ) );
+                    mxDestroyArray( item );
+                }
+
+                if( result )
+                {
+                    m_plhs[0] = result;
+                }
+            }
+            else
             {
-               // Return current result type
-                m_plhs[0] = mxCreateDoubleScalar( g_result_type );
+                m_plhs[0] = mxCreateString( SQLstack.m_db[m_dbid].isOpen() ? "OPEN" : "CLOSED" );
             }
-            return true;
         }
         
-        // next parameter must be on/off flag
-        if( m_narg && !argGetNextInteger( new_result_type, /*asBoolInt*/ false  ) )
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle language command
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Try to interpret current command as status command.
+     * \p strCmdMatchName holds the mksqlite command name.
+     */
+    bool cmdTryHandleLanguage( const char* strCmdMatchName )
+    {
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) ) 
         {
-            // argGetNextInteger() sets m_err
             return false;
         }
         
-        // action on change only
-        if( new_result_type != old_result_type )
+        // Global command, dbid useless
+        warnOnDefDbid();
+        
+        /*
+         * There should be one numeric argument
+         */
+        if( m_narg < 1 ) 
         {
-            if( new_result_type < 0 || new_result_type > RESULT_TYPE_MAX_ID )
+            m_err.set( MSG_MISSINGARG );
+            return false;
+        }
+        else if( m_narg > 1 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+
+        if( !mxIsNumeric( m_parg[0] ) )
+        {
+            m_err.set( MSG_NUMARGEXPCT );
+            return false;
+        } else {
+            int iLang = ValueMex( m_parg[0] ).GetInt();
+            
+            if( !setLocale( iLang ) )
             {
                 m_err.set( MSG_INVALIDARG );
                 return false;
             }
-        
-            g_result_type = new_result_type;
         }
-        
-        // always return the old value
-        m_plhs[0] = mxCreateDoubleScalar( (double)old_result_type );
 
         return true;
     }
     
     
     /**
-     * \brief Handle set busy timeout command
+     * @brief Get the filename of current database
+     * 
+     * @param strCmdMatchName Command name
+     * @return true on success
+     * 
+     * filename will be given in m_plhs[0]
+     */
+    bool cmdTryHandleFilename( const char* strCmdMatchName )
+    {
+        char *db_filename = NULL;
+        char *db_name     = NULL;
+
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+
+        SQLstack.switchTo( m_dbid-1 );
+
+        // database must be open to change settings
+        if( !ensureDbIsOpen() )
+        {
+            // ensureDbIsOpen() sets m_err
+            return false;
+        }
+        
+        /*
+         * There should be not more than 1 argument to get the db filename
+         */
+        if( m_narg > 1 )
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+
+        // Check if database name is given (for attached databases)
+        if( m_narg == 1 )
+        {
+            if( !mxIsChar( m_parg[0] ) )
+            {
+                m_err.set( MSG_LITERALARGEXPCT );
+                return false;
+            } else {
+                db_name = ValueMex( m_parg[0] ).GetEncString();
+            }
+        }
+
+        db_filename = ::utils_strnewdup( m_interface->getDbFilename( db_name ), /*flagConvertUTF8*/ true );
+
+        if( NULL == db_filename )
+        {
+            m_plhs[0] = mxCreateString( "" );  // Memory based database
+        }
+        else
+        {
+            m_plhs[0] = mxCreateString( db_filename );  // File based database
+        }
+
+        ::utils_free_ptr( db_name );
+        ::utils_free_ptr( db_filename );
+
+        return true;
+    }
+
+
+    /**
+     * \brief Handle streaming setting command
      *
      * \param[in] strCmdMatchName Command name
+     * \returns true on success
      * 
-     * Try to interpret current command as busy timeout switch.
+     * Try to interpret current command as streaming switch.
      * \p strCmdMatchName holds the mksqlite command name.
      * m_plhs[0] will be set to the old setting.
      */
-    bool cmdTryHandleSetBusyTimeout( const char* strCmdMatchName )
+    bool cmdTryHandleStreaming( const char* strCmdMatchName )
+    {
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) ) 
+        {
+            return false;
+        }
+        
+        // Global command, dbid useless
+        warnOnDefDbid();
+
+        /*
+         *  Check max number of arguments
+         */
+        if( m_narg > 1 )
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        /*
+         *  try to read flag
+         */
+        int flagOnOff = g_streaming;
+        if( m_narg && !argGetNextInteger( flagOnOff, /*asBoolInt*/ true ) )
+        {
+            // argGetNextInteger() sets m_err
+            return false;
+        }
+        
+        // Report, if serialization is not possible (reset flag then)
+        if( flagOnOff && !have_serialize() )
+        {
+            PRINTF( "%s\n", ::getLocaleMsg( MSG_STREAMINGNOTSUPPORTED ) );
+            flagOnOff = 0;
+        }
+        
+        // Report, if user tries to use streaming with blobs turned off (reset flag then)
+        if( flagOnOff && !typed_blobs_mode_on() )
+        {
+            PRINTF( "%s\n", ::getLocaleMsg( MSG_STREAMINGNEEDTYBLOBS ) );
+            flagOnOff = 0;
+        }
+        
+        // always return current status
+        m_plhs[0] = mxCreateDoubleScalar( (double)g_streaming );
+        
+        // store new value
+        g_streaming = flagOnOff;
+        
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle result type command
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Try to interpret current command as result type.
+     * \p strCmdMatchName holds the mksqlite command name.
+     * m_plhs[0] will be set to the old setting.
+     */
+    bool cmdTryHandleResultType( const char* strCmdMatchName )
+    {
+        int new_result_type;
+        int old_result_type = g_result_type;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) ) 
+        {
+            return false;
+        }
+        
+        // Global command, dbid useless
+        warnOnDefDbid();
+
+        /*
+         * There should be one integer argument
+         */
+        if( m_narg > 1 )
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        // No arguments, then serve current state
+        if( !m_narg )
+        {
+            if( !m_nlhs )
+            {
+               // Print current result type
+                PRINTF( "%s(%d)\n", ::getLocaleMsg( MSG_RESULTTYPE ), g_result_type );
+            } 
+            else 
+            {
+               // Return current result type
+                m_plhs[0] = mxCreateDoubleScalar( g_result_type );
+            }
+            return true;
+        }
+        
+        // next parameter must be on/off flag
+        if( m_narg && !argGetNextInteger( new_result_type, /*asBoolInt*/ false  ) )
+        {
+            // argGetNextInteger() sets m_err
+            return false;
+        }
+        
+        // action on change only
+        if( new_result_type != old_result_type )
+        {
+            if( new_result_type < 0 || new_result_type > RESULT_TYPE_MAX_ID )
+            {
+                m_err.set( MSG_INVALIDARG );
+                return false;
+            }
+        
+            g_result_type = new_result_type;
+        }
+        
+        // always return the old value
+        m_plhs[0] = mxCreateDoubleScalar( (double)old_result_type );
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle BLOB stacking command
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Try to interpret current command as BLOB stacking mode (see STACK_BLOBS).
+     * \p strCmdMatchName holds the mksqlite command name.
+     * m_plhs[0] will be set to the old setting.
+     */
+    bool cmdTryHandleStackBlobs( const char* strCmdMatchName )
+    {
+        int old_mode = g_stack_blobs;
+        int new_mode = old_mode;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) ) 
+        {
+            return false;
+        }
+        
+        // Global command, dbid useless
+        warnOnDefDbid();
+
+        /*
+         * There should be one integer argument
+         */
+        if( m_narg > 1 )
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( m_narg && !argGetNextInteger( new_mode, /*asBoolInt*/ false  ) )
+        {
+            // argGetNextInteger() sets m_err
+            return false;
+        }
+        
+        if( new_mode < 0 || new_mode > STACK_BLOBS_MAX_ID )
+        {
+            m_err.set( MSG_INVALIDARG );
+            return false;
+        }
+        
+        g_stack_blobs = new_mode;
+        
+        // always return the old value
+        m_plhs[0] = mxCreateDoubleScalar( (double)old_mode );
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle statement cache size command
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Try to interpret current command as statement cache size setting.
+     * \p strCmdMatchName holds the mksqlite command name.
+     * m_plhs[0] will be set to the old setting.
+     */
+    bool cmdTryHandleStmtCache( const char* strCmdMatchName )
+    {
+        int old_cache_size = g_stmt_cache_size;
+        int new_cache_size = old_cache_size;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) ) 
+        {
+            return false;
+        }
+        
+        // Global command, dbid useless
+        warnOnDefDbid();
+
+        /*
+         * There should be one integer argument
+         */
+        if( m_narg > 1 )
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( m_narg && !argGetNextInteger( new_cache_size, /*asBoolInt*/ false  ) )
+        {
+            // argGetNextInteger() sets m_err
+            return false;
+        }
+        
+        // action on change only
+        if( new_cache_size != old_cache_size )
+        {
+            if( new_cache_size < 0 )
+            {
+                m_err.set( MSG_INVALIDARG );
+                return false;
+            }
+
+            g_stmt_cache_size = new_cache_size;
+            SQLstack.trimStmtCaches();
+        }
+        
+        // always return the old value
+        m_plhs[0] = mxCreateDoubleScalar( (double)old_cache_size );
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle set busy timeout command
+     *
+     * \param[in] strCmdMatchName Command name
+     * 
+     * Try to interpret current command as busy timeout switch.
+     * \p strCmdMatchName holds the mksqlite command name.
+     * m_plhs[0] will be set to the old setting.
+     */
+    bool cmdTryHandleSetBusyTimeout( const char* strCmdMatchName )
+    {
+        int iTimeout;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        // database must be open to set busy timeout
+        if( !ensureDbIsOpen() )
+        {
+            // ensureDbIsOpen() sets m_err
+            return false;
+        }
+        
+        /*
+         * There should be one argument, the Timeout in ms
+         */
+        if( m_narg > 1 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( !m_narg && !m_interface->getBusyTimeout( iTimeout ) )
+        {
+            const char* errid = NULL;
+            /*
+             * Anything wrong? free the database id and inform the user
+             */
+            PRINTF( "%s\n", ::getLocaleMsg( MSG_BUSYTIMEOUTFAIL ) );
+            const char* errmsg = m_interface->getErr( &errid );
+            m_err.set( errmsg, errid );
+            return false;
+        }
+        
+        if( m_narg && !argGetNextInteger( iTimeout, /*asBoolInt*/ false  ) )
+        {
+            // argGetNextInteger() sets m_err
+            return false;
+        }
+        
+        // Note that negative timeout values are allowed:
+        // "Calling this routine with an argument less than or equal 
+        // to zero turns off all busy handlers."
+        
+        if( !m_interface->setBusyTimeout( iTimeout ) )
+        {
+            const char* errid = NULL;
+            /*
+             * Anything wrong? free the database id and inform the user
+             */
+            PRINTF( "%s\n", ::getLocaleMsg( MSG_BUSYTIMEOUTFAIL ) );
+            const char* errmsg = m_interface->getErr( &errid );
+            m_err.set( errmsg, errid );
+            return false;
+        }
+        
+        // always return old timeout value
+        m_plhs[0] = mxCreateDoubleScalar( (double)iTimeout );
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle sidecar storage command
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Try to interpret current command as sidecar threshold setting.
+     * \p strCmdMatchName holds the mksqlite command name.
+     * m_plhs[0] will be set to the old setting.
+     */
+    bool cmdTryHandleSidecar( const char* strCmdMatchName )
+    {
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        SQLstack.switchTo( m_dbid-1 );
+
+        // database must be open to activate sidecar storage
+        if( !ensureDbIsOpen() )
+        {
+            // ensureDbIsOpen() sets m_err
+            return false;
+        }
+        
+        /*
+         * There should be one argument, the threshold in bytes
+         */
+        if( m_narg > 1 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        size_t old_threshold = m_interface->getSidecar()->threshold();
+        int    new_threshold = (int)old_threshold;
+        
+        if( m_narg && !argGetNextInteger( new_threshold, /*asBoolInt*/ false  ) )
+        {
+            // argGetNextInteger() sets m_err
+            return false;
+        }
+        
+        if( new_threshold < 0 )
+        {
+            m_err.set( MSG_INVALIDARG );
+            return false;
+        }
+        
+        if( !m_interface->setSidecar( (size_t)new_threshold ) )
+        {
+            const char* errid = NULL;
+            const char* errmsg = m_interface->getErr( &errid );
+            m_err.set( errmsg, errid );
+            return false;
+        }
+        
+        // always return the old value
+        m_plhs[0] = mxCreateDoubleScalar( (double)old_threshold );
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle sidecar garbage collection command
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Deletes sidecar segment files no more referenced by the database.
+     * m_plhs[0] will be set to the number of deleted segment files.
+     */
+    bool cmdTryHandleSidecarGc( const char* strCmdMatchName )
+    {
+        int removed = 0;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        SQLstack.switchTo( m_dbid-1 );
+
+        // database must be open to be scanned
+        if( !ensureDbIsOpen() )
+        {
+            // ensureDbIsOpen() sets m_err
+            return false;
+        }
+        
+        if( m_narg > 0 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( !m_interface->collectSidecar( removed ) )
+        {
+            const char* errid = NULL;
+            const char* errmsg = m_interface->getErr( &errid );
+            m_err.set( errmsg, errid );
+            return false;
+        }
+        
+        m_plhs[0] = mxCreateDoubleScalar( (double)removed );
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Get a statement handle from argument list
+     *
+     * \param[out] refHandle Statement handle
+     * \param[out] refSlot Database slot (base 0) the handle belongs to
+     */
+    bool argGetNextStmtHandle( int& refHandle, int& refSlot )
+    {
+        if( !argGetNextInteger( refHandle, /*asBoolInt*/ false ) )
+        {
+            // argGetNextInteger() sets m_err
+            return false;
+        }
+
+        refSlot = SQLstack.stmtHandleSlot( refHandle );
+
+        if( refSlot < 0 )
+        {
+            m_err.set( MSG_INVALIDSTMTHANDLE );
+            return false;
+        }
+
+        return true;
+    }
+
+
+    /**
+     * \brief Handle prepare command
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Prepares a SQL statement which is held until it is finalized.
+     * m_plhs[0] will be set to the statement handle, m_plhs[1] (optional)
+     * to a struct with the parameter and column names.
+     */
+    bool cmdTryHandlePrepare( const char* strCmdMatchName )
+    {
+        const mxArray* sql = NULL;
+        ValueSQLCol::StringPairList names;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        SQLstack.switchTo( m_dbid-1 );
+
+        if( !ensureDbIsOpen() )
+        {
+            // ensureDbIsOpen() sets m_err
+            return false;
+        }
+        
+        /*
+         * There should be one argument, the SQL statement
+         */
+        if( m_narg > 1 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( !argGetNextLiteral( sql ) )
+        {
+            // argGetNextLiteral() sets m_err
+            return false;
+        }
+        
+        char* command = ValueMex( sql ).GetString();
+        char* query   = createQuery( command );
+        int   handle  = SQLstack.newStmtHandle();
+        
+        ::utils_free_ptr( command );
+
+        if( !query )
+        {
+            // createQuery() sets m_err
+            return false;
+        }
+
+        if( !m_interface->prepareHandle( query, handle, names ) )
+        {
+            const char* errid = NULL;
+            const char* errmsg = m_interface->getErr( &errid );
+            m_err.set( errmsg, errid );
+            ::utils_free_ptr( query );
+            return false;
+        }
+        
+        ::utils_free_ptr( query );
+
+        m_plhs[0] = mxCreateDoubleScalar( (double)handle );
+
+        // Parameter and column names, resolved once
+        if( m_nlhs > 1 )
+        {
+            const char* fieldnames[] = { "params", "columns" };
+            const vector<string>& params = m_interface->getParameterNames();
+            mxArray* info    = mxCreateStructMatrix( 1, 1, 2, fieldnames );
+            mxArray* pnames  = mxCreateCellMatrix( (int)params.size(), 1 );
+            mxArray* cnames  = mxCreateCellMatrix( (int)names.size(), 1 );
+
+            for( int i = 0; i < (int)params.size(); i++ )
+            {
+                mxSetCell( pnames, i, mxCreateString( params[i].c_str() ) );
+            }
+
+            for( int i = 0; i < (int)names.size(); i++ )
+            {
+                mxSetCell( cnames, i, mxCreateString( names[i].first.c_str() ) );
+            }
+
+            mxSetField( info, 0, "params", pnames );
+            mxSetField( info, 0, "columns", cnames );
+            m_plhs[1] = info;
+        }
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle exec command
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns always false (command is either dispatched as query, or failed)
+     * 
+     * Reads the statement handle and selects its database. The statement
+     * is then dispatched as SQL query (see cmdHandleSQLStatement()), 
+     * remaining arguments are bound to its parameters.
+     */
+    bool cmdTryHandleExec( const char* strCmdMatchName )
+    {
+        int slot;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+
+        if( !argGetNextStmtHandle( m_stmt_handle, slot ) )
+        {
+            // argGetNextStmtHandle() sets m_err
+            return false;
+        }
+
+        // the handle selects the database
+        if( m_dbid_req > 0 && m_dbid_req != slot + 1 )
+        {
+            m_err.set( MSG_INVALIDSTMTHANDLE );
+            return false;
+        }
+        
+        m_dbid = slot + 1;
+
+        return false;  // dispatch as query
+    }
+    
+    
+    /**
+     * \brief Handle finalize command
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Finalizes the statement held by a handle.
+     */
+    bool cmdTryHandleFinalize( const char* strCmdMatchName )
+    {
+        int handle, slot;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+
+        // the handle selects the database
+        warnOnDefDbid();
+
+        if( m_narg > 1 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( !argGetNextStmtHandle( handle, slot ) )
+        {
+            // argGetNextStmtHandle() sets m_err
+            return false;
+        }
+
+        if( !SQLstack.m_db[slot].preparedFinalize( handle ) )
+        {
+            m_err.set( MSG_INVALIDSTMTHANDLE );
+            return false;
+        }
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Read a SQL script file
+     *
+     * \param[in] filename Name of the file
+     * \returns File content (terminated by a null character), or NULL if the
+     *          file can't be read. The caller has to free it by utils_free_ptr().
+     */
+    char* readScriptFile( const char* filename )
+    {
+        char* script = NULL;
+        FILE* file   = fopen( filename, "rb" );
+
+        if( file )
+        {
+            long size = ( 0 == fseek( file, 0, SEEK_END ) ) ? ftell( file ) : -1;
+
+            if( size >= 0 && 0 == fseek( file, 0, SEEK_SET ) )
+            {
+                script = (char*)MEM_ALLOC( (size_t)size + 1, 1 );
+
+                if( script && fread( script, 1, (size_t)size, file ) == (size_t)size )
+                {
+                    script[size] = 0;
+                }
+                else
+                {
+                    ::utils_free_ptr( script );
+                }
+            }
+            fclose( file );
+        }
+
+        return script;
+    }
+    
+    
+    /**
+     * \brief Handle script execution command
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Executes all statements of a SQL script, given as text or file name.
+     * An optional flag runs the script inside one transaction.
+     * m_plhs[0] will be set to the number of changed rows for each statement,
+     * m_plhs[1] to the execution times in seconds and m_plhs[2] to the 
+     * statement texts.
+     */
+    bool cmdTryHandleExecScript( const char* strCmdMatchName )
+    {
+        const mxArray*  arg           = NULL;
+        int             bTransaction  = 0;
+        char*           script        = NULL;
+        vector<int>     changes;
+        vector<double>  times;
+        vector<string>  texts;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        SQLstack.switchTo( m_dbid-1 );
+
+        if( !ensureDbIsOpen() )
+        {
+            // ensureDbIsOpen() sets m_err
+            return false;
+        }
+        
+        /*
+         * Arguments: script text or file name, optional transaction flag
+         */
+        if( m_narg > 2 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( !argGetNextLiteral( arg ) )
+        {
+            // argGetNextLiteral() sets m_err
+            return false;
+        }
+        
+        if( m_narg && !argGetNextInteger( bTransaction, /*asBoolInt*/ true ) )
+        {
+            // argGetNextInteger() sets m_err
+            return false;
+        }
+        
+        char* text = ValueMex( arg ).GetString();
+        
+        // A single line without semicolon may name a script file (UTF-8 encoded)
+        if( !strpbrk( text, ";\n" ) )
+        {
+            script = readScriptFile( text );
+        }
+
+        if( !script )
+        {
+            script = createQuery( text );
+        }
+        
+        ::utils_free_ptr( text );
+        
+        if( !script )
+        {
+            // createQuery() sets m_err
+            return false;
+        }
+
+        if( !m_interface->execScript( script, bTransaction != 0, changes, times, texts ) )
+        {
+            const char* errid = NULL;
+            const char* errmsg = m_interface->getErr( &errid );
+            m_err.set( errmsg, errid );
+        }
+        
+        ::utils_free_ptr( script );
+        
+        if( errPending() )
+        {
+            return false;
+        }
+
+        m_plhs[0] = mxCreateDoubleMatrix( changes.size(), 1, mxREAL );
+        for( size_t i = 0; i < changes.size(); i++ )
+        {
+            mxGetPr( m_plhs[0] )[i] = (double)changes[i];
+        }
+
+        if( m_nlhs > 1 )
+        {
+            m_plhs[1] = mxCreateDoubleMatrix( times.size(), 1, mxREAL );
+            for( size_t i = 0; i < times.size(); i++ )
+            {
+                mxGetPr( m_plhs[1] )[i] = times[i];
+            }
+        }
+
+        if( m_nlhs > 2 )
+        {
+            m_plhs[2] = mxCreateCellMatrix( (int)texts.size(), 1 );
+            for( size_t i = 0; i < texts.size(); i++ )
+            {
+                mxSetCell( m_plhs[2], (int)i, mxCreateString( texts[i].c_str() ) );
+            }
+        }
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Quote a string as SQL text literal
+     */
+    static string sqlQuote( const string& text )
+    {
+        string quoted = "'";
+
+        for( size_t i = 0; i < text.size(); i++ )
+        {
+            quoted += text[i];
+
+            if( text[i] == '\'' )
+            {
+                quoted += '\'';
+            }
+        }
+
+        return quoted + "'";
+    }
+    
+    
+    /**
+     * \brief Quote a string as SQL identifier
+     */
+    static string sqlIdent( const string& name )
+    {
+        string quoted = "\"";
+
+        for( size_t i = 0; i < name.size(); i++ )
+        {
+            quoted += name[i];
+
+            if( name[i] == '"' )
+            {
+                quoted += '"';
+            }
+        }
+
+        return quoted + "\"";
+    }
+    
+    
+    /**
+     * \brief Handle command building an indexable REGEXP constraint
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Arguments are a column (or expression) and a regular expression.
+     * If the pattern begins with "^" and a literal prefix, each matching
+     * text begins with this prefix. The prefix gives a range constraint
+     * (column >= 'ABC' AND column < 'ABD'), which SQLite can satisfy by an
+     * index on column, followed by the REGEXP operator as residual check.
+     * Numbers sort before any text, so the range is emitted only if the
+     * optional third argument, the declared type of the column, gives
+     * TEXT affinity (numbers are stored as text then). Otherwise the
+     * clause is the REGEXP operator only.
+     * m_plhs[0] will be set to the WHERE clause, m_plhs[1] and m_plhs[2] to 
+     * the lower and upper bound (empty, if none).
+     */
+    bool cmdTryHandleRegexpWhere( const char* strCmdMatchName )
+    {
+        const mxArray*  arg           = NULL;
+        char*           column        = NULL;
+        char*           pattern       = NULL;
+        char*           type          = NULL;
+        bool            hasType       = false;
+        bool            isText        = false;
+        string          lower, upper, clause;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        // Global command, dbid useless
+        warnOnDefDbid();
+        
+        if( m_narg < 2 ) 
+        {
+            m_err.set( MSG_MISSINGARG );
+            return false;
+        }
+        
+        if( m_narg > 3 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        hasType = ( m_narg == 3 );
+        
+        // argGetNextLiteral() sets m_err
+        if( argGetNextLiteral( arg ) )
+        {
+            column = ::utils_getString( arg );
+        }
+        
+        if( argGetNextLiteral( arg ) )
+        {
+            pattern = ::utils_getString( arg );
+        }
+        
+        if( hasType && argGetNextLiteral( arg ) )
+        {
+            type = ::utils_getString( arg );
+        }
+        
+        if( !column || !pattern || ( hasType && !type ) )
+        {
+            if( !errPending() )
+            {
+                m_err.set( MSG_ERRMEMORY );
+            }
+            
+            ::utils_free_ptr( column );
+            ::utils_free_ptr( pattern );
+            ::utils_free_ptr( type );
+            return false;
+        }
+        
+        // TEXT affinity: type contains "CHAR", "CLOB" or "TEXT", but not "INT"
+        if( type )
+        {
+            for( char* p = type; *p; p++ )
+            {
+                *p = (char)toupper( (unsigned char)*p );
+            }
+            
+            isText = !strstr( type, "INT" ) && ( strstr( type, "CHAR" ) || strstr( type, "CLOB" ) || strstr( type, "TEXT" ) );
+            ::utils_free_ptr( type );
+        }
+        
+        // Upper bound: increment the last byte of the prefix, dropping
+        // trailing 0xFF bytes (no upper bound, if none is left)
+        lower = RegexNfa( pattern ).anchoredPrefix();
+        upper = lower;
+        
+        while( !upper.empty() && (unsigned char)upper[upper.size()-1] == 0xFF )
+        {
+            upper.erase( upper.size()-1 );
+        }
+        
+        if( !upper.empty() )
+        {
+            upper[upper.size()-1] = (char)( (unsigned char)upper[upper.size()-1] + 1 );
+        }
+        
+        clause = "(";
+        if( isText && !lower.empty() )
+        {
+            clause += string( column ) + " >= " + sqlQuote( lower ) + " AND ";
+        }
+        if( isText && !upper.empty() )
+        {
+            clause += string( column ) + " < " + sqlQuote( upper ) + " AND ";
+        }
+        clause += string( column ) + " REGEXP " + sqlQuote( pattern ) + ")";
+        
+        ::utils_free_ptr( column );
+        ::utils_free_ptr( pattern );
+        
+        m_plhs[0] = mxCreateString( clause.c_str() );
+        
+        if( m_nlhs > 1 )
+        {
+            m_plhs[1] = mxCreateString( lower.c_str() );
+        }
+        
+        if( m_nlhs > 2 )
+        {
+            m_plhs[2] = mxCreateString( upper.c_str() );
+        }
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Get next argument as list of names
+     *
+     * \param[out] names Names from a cell array of strings or a comma
+     *                   separated string (white spaces trimmed)
+     */
+    bool argGetNextNameList( vector<string>& names )
+    {
+        if( errPending() ) return false;
+
+        if( m_narg < 1 ) 
+        {
+            m_err.set( MSG_MISSINGARG );
+            return false;
+        }
+        
+        const mxArray* arg = m_parg[0];
+        vector<string> items;
+        
+        if( mxIsCell( arg ) )
+        {
+            for( size_t i = 0; i < mxGetNumberOfElements( arg ); i++ )
+            {
+                char* item = ::utils_getString( mxGetCell( arg, i ) );
+                
+                if( !item )
+                {
+                    m_err.set( MSG_INVALIDARG );
+                    return false;
+                }
+                
+                items.push_back( item );
+                ::utils_free_ptr( item );
+            }
+        }
+        else if( mxGetClassID( arg ) == mxCHAR_CLASS )
+        {
+            char* text = ::utils_getString( arg );
+            
+            for( char* item = text ? strtok( text, "," ) : NULL; item; item = strtok( NULL, "," ) )
+            {
+                items.push_back( item );
+            }
+            
+            ::utils_free_ptr( text );
+        }
+        else
+        {
+            m_err.set( MSG_LITERALARGEXPCT );
+            return false;
+        }
+        
+        m_parg++;
+        m_narg--;
+        
+        for( size_t i = 0; i < items.size(); i++ )
+        {
+            size_t first = items[i].find_first_not_of( " \t\r\n" );
+            size_t last  = items[i].find_last_not_of( " \t\r\n" );
+            
+            if( first != string::npos )
+            {
+                names.push_back( items[i].substr( first, last - first + 1 ) );
+            }
+        }
+        
+        if( names.empty() )
+        {
+            m_err.set( MSG_INVALIDARG );
+            return false;
+        }
+        
+        return true;
+    }
+    
+    
+    /**
+     * \brief Get next argument as changeset
+     *
+     * \param[out] changeset Changeset from a uint8 array, plain or as typed
+     *                       BLOB (see 'session_changeset')
+     */
+    bool argGetNextChangeset( string& changeset )
+    {
+        if( errPending() ) return false;
+
+        if( m_narg < 1 ) 
+        {
+            m_err.set( MSG_MISSINGARG );
+            return false;
+        }
+        
+        if( mxUINT8_CLASS != mxGetClassID( m_parg[0] ) )
+        {
+            m_err.set( MSG_INVALIDARG );
+            return false;
+        }
+        
+        const void* data  = mxGetData( m_parg[0] );
+        size_t      bytes = mxGetNumberOfElements( m_parg[0] );
+        mxClassID   clsid = mxUNKNOWN_CLASS;
+        size_t      numel = 0;
+        
+        if( bytes < sizeof( TypedBLOBHeaderBase ) || !((TypedBLOBHeaderBase*)data)->validMagic() )
+        {
+            // plain changeset
+            changeset.assign( (const char*)data, bytes );
+        }
+        else if(    MSG_NOERROR != blob_unpack_into( data, bytes, &clsid, &numel, NULL )
+                 || mxUINT8_CLASS != clsid )
+        {
+            m_err.set( MSG_INVALIDARG );
+            return false;
+        }
+        else
+        {
+            changeset.resize( numel );
+            
+            if( numel && MSG_NOERROR != blob_unpack_into( data, bytes, &clsid, &numel, &changeset[0] ) )
+            {
+                m_err.set( MSG_INVALIDARG );
+                return false;
+            }
+        }
+        
+        m_parg++;
+        m_narg--;
+        
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle command creating a full text index
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Arguments are a table name and its text columns (cell array or comma
+     * separated). Creates the FTS5 table <table>_fts with external content
+     * (the text is not stored twice), fills it from the table and creates
+     * triggers on the table, which keep the index up to date. An existing
+     * index of the same name is replaced.
+     * m_plhs[0] will be set to the name of the FTS5 table.
+     */
+    bool cmdTryHandleFtsIndex( const char* strCmdMatchName )
+    {
+        const mxArray*  arg           = NULL;
+        char*           table         = NULL;
+        char*           script        = NULL;
+        vector<string>  columns;
+        vector<int>     changes;
+        vector<double>  times;
+        vector<string>  texts;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        SQLstack.switchTo( m_dbid-1 );
+
+        if( !ensureDbIsOpen() )
+        {
+            // ensureDbIsOpen() sets m_err
+            return false;
+        }
+        
+        if( m_narg > 2 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( !argGetNextLiteral( arg ) || !argGetNextNameList( columns ) )
+        {
+            // argGetNextLiteral() and argGetNextNameList() set m_err
+            return false;
+        }
+        
+        table = ::utils_getString( arg );
+        if( !table )
+        {
+            m_err.set( MSG_ERRMEMORY );
+            return false;
+        }
+        
+        string fts = string( table ) + "_fts";
+        string cols, newCols, oldCols;
+        
+        for( size_t i = 0; i < columns.size(); i++ )
+        {
+            string sep = i ? ", " : "";
+            
+            cols    += sep + sqlIdent( columns[i] );
+            newCols += sep + "new." + sqlIdent( columns[i] );
+            oldCols += sep + "old." + sqlIdent( columns[i] );
+        }
+        
+        string insertNew = "INSERT INTO " + sqlIdent( fts ) + "(rowid, " + cols + ") "
+                           "VALUES (new.rowid, " + newCols + "); ";
+        string deleteOld = "INSERT INTO " + sqlIdent( fts ) + "(" + sqlIdent( fts ) + ", rowid, " + cols + ") "
+                           "VALUES ('delete', old.rowid, " + oldCols + "); ";
+        string sql = 
+            "DROP TRIGGER IF EXISTS " + sqlIdent( fts + "_ai" ) + "; "
+            "DROP TRIGGER IF EXISTS " + sqlIdent( fts + "_ad" ) + "; "
+            "DROP TRIGGER IF EXISTS " + sqlIdent( fts + "_au" ) + "; "
+            "DROP TABLE IF EXISTS " + sqlIdent( fts ) + "; "
+            "CREATE VIRTUAL TABLE " + sqlIdent( fts ) + " USING fts5(" + cols + ", "
+                "content=" + sqlQuote( table ) + "); "
+            "CREATE TRIGGER " + sqlIdent( fts + "_ai" ) + " AFTER INSERT ON " + sqlIdent( table ) + " BEGIN " 
+                + insertNew + "END; "
+            "CREATE TRIGGER " + sqlIdent( fts + "_ad" ) + " AFTER DELETE ON " + sqlIdent( table ) + " BEGIN " 
+                + deleteOld + "END; "
+            "CREATE TRIGGER " + sqlIdent( fts + "_au" ) + " AFTER UPDATE ON " + sqlIdent( table ) + " BEGIN " 
+                + deleteOld + insertNew + "END; "
+            "INSERT INTO " + sqlIdent( fts ) + "(" + sqlIdent( fts ) + ") VALUES ('rebuild')";
+        
+        ::utils_free_ptr( table );
+        
+        script = createQuery( sql.c_str() );
+        if( !script )
+        {
+            // createQuery() sets m_err
+            return false;
+        }
+
+        if( !m_interface->execScript( script, /*bTransaction*/ true, changes, times, texts ) )
+        {
+            const char* errid = NULL;
+            const char* errmsg = m_interface->getErr( &errid );
+            m_err.set( errmsg, errid );
+        }
+        
+        ::utils_free_ptr( script );
+        
+        if( errPending() )
+        {
+            return false;
+        }
+        
+        m_plhs[0] = mxCreateString( fts.c_str() );
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle full text search command
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Arguments are the table name (as passed to fts_index), the FTS5 query
+     * and an optional maximum number of results.
+     * m_plhs[0] will be set to the rowids of matching rows (best first),
+     * m_plhs[1] to their bm25 ranks (lower is better).
+     */
+    bool cmdTryHandleFtsSearch( const char* strCmdMatchName )
+    {
+        const mxArray*          arg           = NULL;
+        char*                   table         = NULL;
+        char*                   text          = NULL;
+        char*                   query         = NULL;
+        int                     limit         = -1;
+        vector<sqlite3_int64>   rowids;
+        vector<double>          ranks;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        SQLstack.switchTo( m_dbid-1 );
+
+        if( !ensureDbIsOpen() )
+        {
+            // ensureDbIsOpen() sets m_err
+            return false;
+        }
+        
+        if( m_narg > 3 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        // argGetNextLiteral() and argGetNextInteger() set m_err
+        if( argGetNextLiteral( arg ) )
+        {
+            table = ::utils_getString( arg );
+        }
+        
+        if( argGetNextLiteral( arg ) )
+        {
+            text = ::utils_getString( arg );
+        }
+        
+        if( m_narg )
+        {
+            argGetNextInteger( limit );
+        }
+        
+        if( !errPending() && ( !table || !text ) )
+        {
+            m_err.set( MSG_ERRMEMORY );
+        }
+        
+        if( !errPending() )
+        {
+            string fts = sqlIdent( string( table ) + "_fts" );
+            char   strLimit[32];
+            
+            sprintf( strLimit, " LIMIT %d", limit );
+            
+            query = createQuery( ( "SELECT rowid, rank FROM " + fts + " WHERE " + fts + " MATCH " 
+                                   + sqlQuote( text ) + " ORDER BY rank" + strLimit ).c_str() );
+        }
+        
+        ::utils_free_ptr( table );
+        ::utils_free_ptr( text );
+        
+        if( !query )
+        {
+            // m_err is set
+            return false;
+        }
+        
+        if( !m_interface->queryRankedRowids( query, rowids, ranks ) )
+        {
+            const char* errid = NULL;
+            const char* errmsg = m_interface->getErr( &errid );
+            m_err.set( errmsg, errid );
+        }
+        
+        ::utils_free_ptr( query );
+        
+        if( errPending() )
+        {
+            return false;
+        }
+        
+        m_plhs[0] = mxCreateDoubleMatrix( rowids.size(), 1, mxREAL );
+        for( size_t i = 0; i < rowids.size(); i++ )
+        {
+            mxGetPr( m_plhs[0] )[i] = (double)rowids[i];
+        }
+        
+        if( m_nlhs > 1 )
+        {
+            m_plhs[1] = mxCreateDoubleMatrix( ranks.size(), 1, mxREAL );
+            for( size_t i = 0; i < ranks.size(); i++ )
+            {
+                mxGetPr( m_plhs[1] )[i] = ranks[i];
+            }
+        }
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle command opening a set of database files (shards)
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Arguments are a file name pattern (wildcards * and ?) and an optional
+     * maximum number of worker threads (0 or omitted: number of CPUs).
+     * All matching files are opened read-only, shards opened before are 
+     * closed. m_plhs[0] will be set to the number of shards, m_plhs[1] 
+     * to their file names.
+     */
+    bool cmdTryHandleShardsOpen( const char* strCmdMatchName )
+    {
+        const mxArray*  arg           = NULL;
+        char*           pattern       = NULL;
+        int             threads       = 0;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        // Global command, dbid useless
+        warnOnDefDbid();
+        
+        if( m_narg > 2 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( !argGetNextLiteral( arg ) || ( m_narg && !argGetNextInteger( threads ) ) )
+        {
+            // argGetNextLiteral() and argGetNextInteger() set m_err
+            return false;
+        }
+        
+        // file names are UTF-8 encoded
+        pattern = ValueMex( arg ).GetString( /*flagUTF*/ true );
+        
+        if( !pattern )
+        {
+            m_err.set( MSG_ERRMEMORY );
+            return false;
+        }
+        
+        (void)Shards.open( pattern, threads, m_err );
+        ::utils_free_ptr( pattern );
+        
+        if( errPending() )
+        {
+            return false;
+        }
+        
+        m_plhs[0] = mxCreateDoubleScalar( (double)Shards.count() );
+        
+        if( m_nlhs > 1 )
+        {
+            m_plhs[1] = mxCreateCellMatrix( (int)Shards.count(), 1 );
+            
+            for( size_t i = 0; i < Shards.count(); i++ )
+            {
+                mxSetCell( m_plhs[1], (int)i, mxCreateString( Shards.filename( i ).c_str() ) );
+            }
+        }
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle command closing all shards
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * m_plhs[0] will be set to the number of closed shards.
+     */
+    bool cmdTryHandleShardsClose( const char* strCmdMatchName )
+    {
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        // Global command, dbid useless
+        warnOnDefDbid();
+        
+        if( m_narg > 0 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        m_plhs[0] = mxCreateDoubleScalar( (double)Shards.close() );
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Convert a MATLAB value to a shard query parameter
+     *
+     * \param[in] item Empty array, string or real numeric (or logical) scalar
+     * \param[out] cell Parameter value
+     * \returns false if \p item has an unsupported type
+     */
+    static bool shardParam( const mxArray* item, ShardSet::Cell& cell )
+    {
+        ValueMex value( item );
+        
+        if( value.IsEmpty() )
+        {
+            cell.type = SQLITE_NULL;
+            return true;
+        }
+        
+        if( value.ClassID() == mxCHAR_CLASS )
+        {
+            char* text = value.GetEncString();
+            
+            if( !text )
+            {
+                return false;
+            }
+            
+            cell.type  = SQLITE_TEXT;
+            cell.bytes = text;
+            ::utils_free_ptr( text );
+            return true;
+        }
+        
+        if( !value.IsScalar() || value.IsComplex() || !( mxIsNumeric( item ) || mxIsLogical( item ) ) )
+        {
+            return false;
+        }
+        
+        switch( value.ClassID() )
+        {
+            case mxDOUBLE_CLASS:
+            case mxSINGLE_CLASS:
+                cell.type = SQLITE_FLOAT;
+                cell.d    = value.GetScalar();
+                break;
+                
+            case mxINT64_CLASS:
+                cell.type = SQLITE_INTEGER;
+                cell.i    = value.GetInt64();
+                break;
+                
+            default:
+                cell.type = SQLITE_INTEGER;
+                cell.i    = (sqlite3_int64)value.GetScalar();
+                break;
+        }
+        
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle scatter-gather query on all shards
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Arguments are the SQL statement, an optional cell array of parameter
+     * values and an optional merge specification (see ShardSet::merge()).
+     * The query runs on all shards in parallel, the merged rows are 
+     * returned like a common query result (see g_result_type), m_plhs[1]
+     * will be set to the row count.
+     */
+    bool cmdTryHandleShardsQuery( const char* strCmdMatchName )
+    {
+        const mxArray*              arg           = NULL;
+        const mxArray*              params        = NULL;
+        char*                       text          = NULL;
+        char*                       query         = NULL;
+        string                      spec, errmsg;
+        vector<ShardSet::Cell>      values;
+        vector<ShardSet::Result>    results;
+        ShardSet::Result            merged;
+        ValueSQLCol::StringPairList names;
+        ValueSQLCols                cols;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        // Global command, dbid useless
+        warnOnDefDbid();
+        
+        if( !Shards.count() )
+        {
+            m_err.set( MSG_SHARDSNOTOPEN );
+            return false;
+        }
+        
+        if( m_narg > 3 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( !argGetNextLiteral( arg ) )
+        {
+            // argGetNextLiteral() sets m_err
+            return false;
+        }
+        
+        // parameters
+        if( m_narg && ( mxIsCell( m_parg[0] ) || mxIsEmpty( m_parg[0] ) ) )
+        {
+            params = m_parg[0];
+            m_parg++;
+            m_narg--;
+            
+            for( size_t i = 0; mxIsCell( params ) && i < mxGetNumberOfElements( params ); i++ )
+            {
+                values.push_back( ShardSet::Cell() );
+                
+                if( !shardParam( mxGetCell( params, i ), values.back() ) )
+                {
+                    m_err.set( MSG_INVALIDARG );
+                    return false;
+                }
+            }
+        }
+        
+        // merge specification
+        if( m_narg )
+        {
+            const mxArray* merge = NULL;
+            
+            if( !argGetNextLiteral( merge ) )
+            {
+                // argGetNextLiteral() sets m_err
+                return false;
+            }
+            
+            char* buffer = ::utils_getString( merge );
+            spec = buffer ? buffer : "";
+            ::utils_free_ptr( buffer );
+        }
+        
+        if( m_narg )
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        text  = ValueMex( arg ).GetString();
+        query = text ? createQuery( text ) : NULL;
+        ::utils_free_ptr( text );
+        
+        if( !query )
+        {
+            if( !errPending() )
+            {
+                m_err.set( MSG_ERRMEMORY );
+            }
+            return false;
+        }
+        
+        Shards.query( query, values, results );
+        ::utils_free_ptr( query );
+        
+        for( size_t i = 0; i < results.size(); i++ )
+        {
+            if( SQLITE_OK != results[i].rc )
+            {
+                m_err.set_printf( MSG_SHARDQUERY, m_err.trans_err_to_ident( results[i].rc ), 
+                                  Shards.filename( i ).c_str(), results[i].errmsg.c_str() );
+                return false;
+            }
+        }
+        
+        if( !ShardSet::merge( spec, results, merged, errmsg ) )
+        {
+            m_err.set_printf( MSG_SHARDMERGE, NULL, errmsg.c_str() );
+            return false;
+        }
+        
+        results.clear();
+        
+        /*** Convert to column vectors, as fetched by SQLiface::fetch() ***/
+        
+        if( !SQLiface::makeFieldNames( merged.names, names ) )
+        {
+            m_err.set( MSG_ERRVARNAME );
+            return false;
+        }
+        
+        for( size_t j = 0; j < names.size(); j++ )
+        {
+            cols.push_back( ValueSQLCol( names[j] ) );
+        }
+        
+        for( size_t i = 0; i < merged.rows.size() && !errPending(); i++ )
+        {
+            ShardSet::Row& row = merged.rows[i];
+            
+            for( size_t j = 0; j < cols.size() && !errPending(); j++ )
+            {
+                ValueSQL value;
+                
+                switch( row[j].type )
+                {
+                    case SQLITE_INTEGER:
+                        value = ValueSQL( row[j].i );
+                        break;
+                        
+                    case SQLITE_FLOAT:
+                        value = ValueSQL( row[j].d );
+                        break;
+                        
+                    case SQLITE_TEXT:
+                        value = ValueSQL( (char*)utils_strnewdup( row[j].bytes.c_str(), g_convertUTF8 ) );
+                        break;
+                        
+                    case SQLITE_BLOB:
+                    {
+                        size_t   bytes = row[j].bytes.size();
+                        ValueMex item  = ValueMex( (int)bytes, bytes ? 1 : 0, ValueMex::UINT8_CLASS );
+                        
+                        if( !item.Item() )
+                        {
+                            m_err.set( MSG_ERRMEMORY );
+                            continue;
+                        }
+                        
+                        if( bytes )
+                        {
+                            memcpy( item.Data(), row[j].bytes.data(), bytes );
+                        }
+                        
+                        value = ValueSQL( item.Detach() );
+                        break;
+                    }
+                    
+                    default:
+                        break;
+                }
+                
+                cols[j].append( value );
+            }
+            
+            // release native memory early
+            ShardSet::Row().swap( row );
+        }
+        
+        if( errPending() )
+        {
+            return false;
+        }
+        
+        if( !cols.size() )
+        {
+            m_plhs[0] = mxCreateDoubleMatrix( 0, 0, mxREAL );
+        }
+        else
+        {
+            m_plhs[0] = createResult( cols );
+            
+            if( !m_plhs[0] )
+            {
+                m_err.set( MSG_CANTCREATEOUTPUT );
+                return false;
+            }
+        }
+        
+        if( m_nlhs > 1 )
+        {
+            m_plhs[1] = mxCreateDoubleScalar( (double)merged.rows.size() );
+        }
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle command starting an online backup
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Arguments are the destination file name, optional the number of
+     * pages copied per step (default 100, -1 copies all at once) and the
+     * pause between two steps in milliseconds (default 10).
+     * m_plhs[0] will be set to the job handle (see 'backup_status').
+     */
+    bool cmdTryHandleBackup( const char* strCmdMatchName )
+    {
+        const mxArray*  arg           = NULL;
+        char*           dest          = NULL;
+        int             pages         = 100;
+        int             sleep_ms      = 10;
+        BackupJob*      job           = NULL;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        SQLstack.switchTo( m_dbid-1 );
+
+        if( !ensureDbIsOpen() )
+        {
+            // ensureDbIsOpen() sets m_err
+            return false;
+        }
+        
+        if( m_narg > 3 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        // argGetNextLiteral() and argGetNextInteger() set m_err
+        if( !argGetNextLiteral( arg ) 
+            || ( m_narg && !argGetNextInteger( pages ) ) 
+            || ( m_narg && !argGetNextInteger( sleep_ms ) ) )
+        {
+            return false;
+        }
+        
+        // file names are UTF-8 encoded
+        dest = ValueMex( arg ).GetString( /*flagUTF*/ true );
+        job  = new BackupJob;
+        
+        if( !dest || !job )
+        {
+            ::utils_free_ptr( dest );
+            delete job;
+            m_err.set( MSG_ERRMEMORY );
+            return false;
+        }
+        
+        if( !job->start( SQLstack.current().dbid(), dest, pages, sleep_ms, m_err ) )
+        {
+            ::utils_free_ptr( dest );
+            delete job;
+            return false;
+        }
+        
+        ::utils_free_ptr( dest );
+        m_plhs[0] = mxCreateDoubleScalar( (double)Backups.add( job ) );
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Create a struct from the progress of a backup job
+     *
+     * \param[in] status Job status
+     * \returns Struct with fields state, progress, remaining, pagecount and message
+     */
+    static mxArray* createBackupStatus( const BackupJob::Status& status )
+    {
+        static const char* states[]     = { "running", "done", "failed", "cancelled" };
+        const char*        fieldnames[] = { "state", "progress", "remaining", "pagecount", "message" };
+        const int          nfields      = (int)( sizeof( fieldnames ) / sizeof( fieldnames[0] ) );
+        double             progress     = 0.0;
+        mxArray*           result       = mxCreateStructMatrix( 1, 1, nfields, fieldnames );
+        
+        if( status.state == BackupJob::BACKUP_DONE )
+        {
+            progress = 1.0;
+        }
+        else if( status.pagecount > 0 )
+        {
+            progress = (double)( status.pagecount - status.remaining ) / status.pagecount;
+        }
+        
+        mxSetFieldByNumber( result, 0, 0, mxCreateString( states[status.state] ) );
+        mxSetFieldByNumber( result, 0, 1, mxCreateDoubleScalar( progress ) );
+        mxSetFieldByNumber( result, 0, 2, mxCreateDoubleScalar( (double)status.remaining ) );
+        mxSetFieldByNumber( result, 0, 3, mxCreateDoubleScalar( (double)status.pagecount ) );
+        mxSetFieldByNumber( result, 0, 4, mxCreateString( status.errmsg.c_str() ) );
+        
+        return result;
+    }
+    
+    
+    /**
+     * \brief Handle commands polling or cancelling a backup job
+     *
+     * \param[in] strCmdMatchName Command name
+     * \param[in] bCancel true to cancel the job
+     * \returns true on success
+     * 
+     * Argument is the job handle. m_plhs[0] will be set to the job status
+     * (see createBackupStatus()). The job is released when it's cancelled
+     * or its final state has been reported, the handle is invalid then.
+     */
+    bool cmdTryHandleBackupStatus( const char* strCmdMatchName, bool bCancel )
+    {
+        int                 handle        = 0;
+        BackupJob*          job           = NULL;
+        BackupJob::Status   status;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        // Global command, dbid useless
+        warnOnDefDbid();
+        
+        if( m_narg > 1 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( !argGetNextInteger( handle ) )
+        {
+            // argGetNextInteger() sets m_err
+            return false;
+        }
+        
+        job = Backups.get( handle );
+        
+        if( !job )
+        {
+            m_err.set( MSG_INVALIDBACKUP );
+            return false;
+        }
+        
+        status = bCancel ? job->cancel() : job->status();
+        
+        if( bCancel || status.state != BackupJob::BACKUP_RUNNING )
+        {
+            Backups.release( handle );
+        }
+        
+        m_plhs[0] = createBackupStatus( status );
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle command restoring a database file into a database
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Argument is the source file name. Its content replaces the database
+     * (e.g. an in-memory database for fast analysis). m_plhs[0] will be 
+     * set to the number of copied pages.
+     */
+    bool cmdTryHandleRestore( const char* strCmdMatchName )
+    {
+        const mxArray*  arg           = NULL;
+        char*           src           = NULL;
+        int             pages         = 0;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        SQLstack.switchTo( m_dbid-1 );
+
+        if( !ensureDbIsOpen() )
+        {
+            // ensureDbIsOpen() sets m_err
+            return false;
+        }
+        
+        if( m_narg > 1 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( !argGetNextLiteral( arg ) )
+        {
+            // argGetNextLiteral() sets m_err
+            return false;
+        }
+        
+        // file names are UTF-8 encoded
+        src = ValueMex( arg ).GetString( /*flagUTF*/ true );
+        
+        if( !src )
+        {
+            m_err.set( MSG_ERRMEMORY );
+            return false;
+        }
+        
+        pages = BackupJob::restore( SQLstack.current().dbid(), src, SQLstack.current().sidecar(), m_err );
+        ::utils_free_ptr( src );
+        
+        if( pages < 0 )
+        {
+            return false;
+        }
+        
+        m_plhs[0] = mxCreateDoubleScalar( (double)pages );
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Create a struct from WAL checkpointer statistics
+     *
+     * \param[in] stats Statistics
+     * \returns Struct with one field per statistic
+     */
+    static mxArray* createCheckpointerStats( const WalCheckpointer::Stats& stats )
+    {
+        const char* fieldnames[] = { "running", "threshold", "interval_ms", "wal_frames", "backlog", 
+                                     "checkpointed", "passive", "restart", "truncate", "forced", "busy", 
+                                     "last_ms", "max_ms", "total_ms" };
+        const double values[]    = { stats.running ? 1.0 : 0.0, (double)stats.threshold, (double)stats.interval_ms, 
+                                     (double)stats.wal_frames, (double)stats.backlog, stats.checkpointed, 
+                                     (double)stats.passive, (double)stats.restart, (double)stats.truncate, 
+                                     (double)stats.forced, (double)stats.busy, stats.last_ms, stats.max_ms, stats.total_ms };
+        const int   nfields      = (int)( sizeof( fieldnames ) / sizeof( fieldnames[0] ) );
+        mxArray*    result       = mxCreateStructMatrix( 1, 1, nfields, fieldnames );
+        
+        for( int i = 0; i < nfields; i++ )
+        {
+            mxSetFieldByNumber( result, 0, i, mxCreateDoubleScalar( values[i] ) );
+        }
+        
+        return result;
+    }
+    
+    
+    /**
+     * \brief Handle command controlling background WAL checkpoints
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Optional arguments are the number of WAL frames triggering a passive
+     * checkpoint (0 stops the checkpointer) and the wake-up interval in 
+     * milliseconds (default 100). Without arguments the setting is kept.
+     * m_plhs[0] will be set to the statistics (see createCheckpointerStats()).
+     */
+    bool cmdTryHandleWalCheckpointer( const char* strCmdMatchName )
+    {
+        int threshold   = 0;
+        int interval_ms = 100;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        SQLstack.switchTo( m_dbid-1 );
+
+        if( !ensureDbIsOpen() )
+        {
+            // ensureDbIsOpen() sets m_err
+            return false;
+        }
+        
+        if( m_narg > 2 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( m_narg )
+        {
+            // argGetNextInteger() sets m_err
+            if( !argGetNextInteger( threshold, /*asBoolInt*/ false ) 
+                || ( m_narg && !argGetNextInteger( interval_ms, /*asBoolInt*/ false ) ) )
+            {
+                return false;
+            }
+            
+            if( threshold < 0 || interval_ms <= 0 )
+            {
+                m_err.set( MSG_INVALIDARG );
+                return false;
+            }
+            
+            if( !m_interface->setCheckpointer( threshold, interval_ms ) )
+            {
+                const char* errid = NULL;
+                const char* errmsg = m_interface->getErr( &errid );
+                m_err.set( errmsg, errid );
+                return false;
+            }
+        }
+        
+        m_plhs[0] = createCheckpointerStats( m_interface->getCheckpointerStats() );
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle command running a WAL checkpoint
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Optional argument is the checkpoint mode ("passive" (default), "full",
+     * "restart" or "truncate"). m_plhs[0] will be set to the number of 
+     * frames in the WAL, m_plhs[1] to the number of frames checkpointed 
+     * and m_plhs[2] to 1 if other connections blocked the checkpoint.
+     */
+    bool cmdTryHandleWalCheckpoint( const char* strCmdMatchName )
+    {
+        const mxArray*  arg           = NULL;
+        char*           modename      = NULL;
+        int             mode          = SQLITE_CHECKPOINT_PASSIVE;
+        int             nLog          = 0;
+        int             nCkpt         = 0;
+        bool            bBusy         = false;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        SQLstack.switchTo( m_dbid-1 );
+
+        if( !ensureDbIsOpen() )
+        {
+            // ensureDbIsOpen() sets m_err
+            return false;
+        }
+        
+        if( m_narg > 1 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( m_narg )
+        {
+            if( !argGetNextLiteral( arg ) )
+            {
+                // argGetNextLiteral() sets m_err
+                return false;
+            }
+            
+            modename = ::utils_getString( arg );
+            
+            if( STRMATCH( modename, "passive" ) )
+            {
+                mode = SQLITE_CHECKPOINT_PASSIVE;
+            }
+            else if( STRMATCH( modename, "full" ) )
+            {
+                mode = SQLITE_CHECKPOINT_FULL;
+            }
+            else if( STRMATCH( modename, "restart" ) )
+            {
+                mode = SQLITE_CHECKPOINT_RESTART;
+            }
+            else if( STRMATCH( modename, "truncate" ) )
+            {
+                mode = SQLITE_CHECKPOINT_TRUNCATE;
+            }
+            else
+            {
+                m_err.set( MSG_INVALIDARG );
+            }
+            
+            ::utils_free_ptr( modename );
+            
+            if( errPending() )
+            {
+                return false;
+            }
+        }
+        
+        if( !m_interface->walCheckpoint( mode, nLog, nCkpt, bBusy ) )
+        {
+            const char* errid = NULL;
+            const char* errmsg = m_interface->getErr( &errid );
+            m_err.set( errmsg, errid );
+            return false;
+        }
+        
+        m_plhs[0] = mxCreateDoubleScalar( (double)nLog );
+        
+        if( m_nlhs > 1 )
+        {
+            m_plhs[1] = mxCreateDoubleScalar( (double)nCkpt );
+        }
+        
+        if( m_nlhs > 2 )
+        {
+            m_plhs[2] = mxCreateDoubleScalar( bBusy ? 1.0 : 0.0 );
+        }
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Get a result handle from argument list
+     *
+     * \param[out] refResult Result held by the handle
+     * \returns false if the argument is no valid handle (m_err is set)
+     */
+    bool argGetNextResult( LazyResult*& refResult )
+    {
+        int handle = 0;
+        
+        if( !argGetNextInteger( handle, /*asBoolInt*/ false ) )
+        {
+            // argGetNextInteger() sets m_err
+            return false;
+        }
+        
+        refResult = Results.get( handle );
+        
+        if( !refResult )
+        {
+            m_err.set( MSG_INVALIDRESULT );
+            return false;
+        }
+        
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle command returning the layout of a result held by a handle
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Argument is the result handle. m_plhs[0] will be set to a struct
+     * with the fields rows, columns (MATLAB names), sqlnames and bytes.
+     */
+    bool cmdTryHandleResultInfo( const char* strCmdMatchName )
+    {
+        LazyResult* result = NULL;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        // Global command, dbid useless
+        warnOnDefDbid();
+        
+        if( m_narg > 1 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( !argGetNextResult( result ) )
+        {
+            // argGetNextResult() sets m_err
+            return false;
+        }
+        
+        const char* fieldnames[] = { "rows", "columns", "sqlnames", "bytes" };
+        int         ncols        = (int)result->m_cols.size();
+        mxArray*    info         = mxCreateStructMatrix( 1, 1, 4, fieldnames );
+        mxArray*    names        = mxCreateCellMatrix( 1, ncols );
+        mxArray*    sqlnames     = mxCreateCellMatrix( 1, ncols );
+        
+        for( int j = 0; j < ncols; j++ )
+        {
+            mxSetCell( names, j, mxCreateString( result->m_cols[j].name.c_str() ) );
+            mxSetCell( sqlnames, j, mxCreateString( result->m_cols[j].sqlname.c_str() ) );
+        }
+        
+        mxSetFieldByNumber( info, 0, 0, mxCreateDoubleScalar( (double)result->m_rows ) );
+        mxSetFieldByNumber( info, 0, 1, names );
+        mxSetFieldByNumber( info, 0, 2, sqlnames );
+        mxSetFieldByNumber( info, 0, 3, mxCreateDoubleScalar( (double)result->m_bytes ) );
+        
+        m_plhs[0] = info;
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle command converting columns of a result held by a handle
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Arguments are the result handle, optional the column names (cell 
+     * array or comma separated, empty for all columns) and the rows 
+     * (indices or logical mask, empty for all rows). m_plhs[0] will be 
+     * set to a struct of arrays holding the requested columns only.
+     */
+    bool cmdTryHandleResultCols( const char* strCmdMatchName )
+    {
+        LazyResult*     result        = NULL;
+        vector<string>  names;
+        vector<int>     columns;
+        vector<size_t>  rows;
+        bool            allRows       = true;
+        ValueSQLCols    cols;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        // Global command, dbid useless
+        warnOnDefDbid();
+        
+        if( m_narg > 3 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( !argGetNextResult( result ) )
+        {
+            // argGetNextResult() sets m_err
+            return false;
+        }
+        
+        /*** Columns ***/
+        
+        if( m_narg && !mxIsEmpty( m_parg[0] ) )
+        {
+            if( !argGetNextNameList( names ) )
+            {
+                // argGetNextNameList() sets m_err
+                return false;
+            }
+            
+            for( size_t k = 0; k < names.size(); k++ )
+            {
+                int j = result->findColumn( names[k] );
+                
+                if( j < 0 )
+                {
+                    m_err.set_printf( MSG_UNKNOWNCOLUMN, NULL, names[k].c_str() );
+                    return false;
+                }
+                
+                columns.push_back( j );
+            }
+        }
+        else
+        {
+            if( m_narg )
+            {
+                m_parg++;
+                m_narg--;
+            }
+            
+            for( int j = 0; j < (int)result->m_cols.size(); j++ )
+            {
+                columns.push_back( j );
+            }
+        }
+        
+        /*** Rows ***/
+        
+        if( m_narg && !mxIsEmpty( m_parg[0] ) )
+        {
+            const mxArray* arg = m_parg[0];
+            size_t         n   = mxGetNumberOfElements( arg );
+            
+            allRows = false;
+            
+            if( mxIsLogical( arg ) )
+            {
+                const mxLogical* mask = mxGetLogicals( arg );
+                
+                if( n != result->m_rows )
+                {
+                    m_err.set( MSG_INVALIDARG );
+                    return false;
+                }
+                
+                for( size_t i = 0; i < n; i++ )
+                {
+                    if( mask[i] )
+                    {
+                        rows.push_back( i );
+                    }
+                }
+            }
+            else if( mxIsDouble( arg ) && !mxIsComplex( arg ) )
+            {
+                const double* indices = mxGetPr( arg );
+                
+                rows.resize( n );
+                
+                for( size_t i = 0; i < n; i++ )
+                {
+                    double index = indices[i];
+                    
+                    if( index < 1 || index > (double)result->m_rows || index != floor( index ) )
+                    {
+                        m_err.set( MSG_INVALIDARG );
+                        return false;
+                    }
+                    
+                    rows[i] = (size_t)index - 1;
+                }
+            }
+            else
+            {
+                m_err.set( MSG_INVALIDARG );
+                return false;
+            }
+        }
+        
+        /*** Convert selected columns only ***/
+        
+        if( !result->select( columns, rows, allRows, cols ) )
+        {
+            m_err.set( MSG_ERRMEMORY );
+            return false;
+        }
+        
+        m_plhs[0] = createResultAsStructOfArrays( cols );
+        
+        if( errPending() )
+        {
+            ::utils_destroy_array( m_plhs[0] );
+            return false;
+        }
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle command releasing a result held by a handle
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Argument is the result handle. m_plhs[0] will be set to 1 if the 
+     * result was released, 0 if the handle was invalid already.
+     */
+    bool cmdTryHandleResultFree( const char* strCmdMatchName )
+    {
+        int handle = 0;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        // Global command, dbid useless
+        warnOnDefDbid();
+        
+        if( m_narg > 1 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( !argGetNextInteger( handle, /*asBoolInt*/ false ) )
+        {
+            // argGetNextInteger() sets m_err
+            return false;
+        }
+        
+        m_plhs[0] = mxCreateDoubleScalar( Results.release( handle ) ? 1.0 : 0.0 );
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle command setting the memory budget of results held by handles
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Optional argument is the budget in bytes. When exceeded, least
+     * recently used results are released. m_plhs[0] will be set to the
+     * old budget, m_plhs[1] to the memory used and m_plhs[2] to the 
+     * number of results held.
+     */
+    bool cmdTryHandleResultBudget( const char* strCmdMatchName )
+    {
+        double budget = 0.0;
+        double old_budget;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        // Global command, dbid useless
+        warnOnDefDbid();
+        
+        if( m_narg > 1 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( m_narg )
+        {
+            if( !mxIsNumeric( m_parg[0] ) || mxGetNumberOfElements( m_parg[0] ) != 1 
+                || ( budget = ValueMex( m_parg[0] ).GetScalar() ) < 0 )
+            {
+                m_err.set( MSG_INVALIDARG );
+                return false;
+            }
+            
+            m_parg++;
+            m_narg--;
+            
+            old_budget = Results.setBudget( budget );
+        }
+        else
+        {
+            old_budget = Results.budget();
+        }
+        
+        m_plhs[0] = mxCreateDoubleScalar( old_budget );
+        
+        if( m_nlhs > 1 )
+        {
+            m_plhs[1] = mxCreateDoubleScalar( Results.total() );
+        }
+        
+        if( m_nlhs > 2 )
+        {
+            m_plhs[2] = mxCreateDoubleScalar( (double)Results.count() );
+        }
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle command controlling the tracking of row changes
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * First argument are the tables to track (cell array or comma separated
+     * list, "*" for all tables) or 0 to stop tracking. Optional second
+     * argument is the number of committed changes kept until taken
+     * (default CONFIG_CHANGES_CAPACITY). Without arguments the setting is 
+     * kept. Tracking restarts with no changes. m_plhs[0] will be set to 1
+     * if changes are tracked, 0 otherwise.
+     */
+    bool cmdTryHandleTrackChanges( const char* strCmdMatchName )
+    {
+        vector<string>  tables;
+        bool            bEnable  = true;
+        int             capacity = CONFIG_CHANGES_CAPACITY;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        SQLstack.switchTo( m_dbid-1 );
+
+        if( !ensureDbIsOpen() )
+        {
+            // ensureDbIsOpen() sets m_err
+            return false;
+        }
+        
+        if( m_narg > 2 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( m_narg )
+        {
+            if( mxIsNumeric( m_parg[0] ) )
+            {
+                int flag = 0;
+                
+                // argGetNextInteger() sets m_err
+                if( !argGetNextInteger( flag, /*asBoolInt*/ true ) )
+                {
+                    return false;
+                }
+                
+                if( flag )
+                {
+                    m_err.set( MSG_INVALIDARG );
+                    return false;
+                }
+                
+                bEnable = false;
+            }
+            else if( !argGetNextNameList( tables ) )
+            {
+                // argGetNextNameList() sets m_err
+                return false;
+            }
+            
+            if( 1 == tables.size() && tables[0] == "*" )
+            {
+                // all tables
+                tables.clear();
+            }
+            
+            if( m_narg && ( !argGetNextInteger( capacity, /*asBoolInt*/ false ) || capacity <= 0 ) )
+            {
+                if( !errPending() )
+                {
+                    m_err.set( MSG_INVALIDARG );
+                }
+                return false;
+            }
+            
+            if( !m_interface->setChangeTracking( bEnable, tables, (size_t)capacity ) )
+            {
+                const char* errid = NULL;
+                const char* errmsg = m_interface->getErr( &errid );
+                m_err.set( errmsg, errid );
+                return false;
+            }
+        }
+        
+        m_plhs[0] = mxCreateDoubleScalar( m_interface->getChangeFeed().running() ? 1.0 : 0.0 );
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle command taking the tracked row changes
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Returns and clears all committed changes, oldest first. m_plhs[0] 
+     * will be set to a struct with the column vectors table (cell),
+     * op (cell: "INSERT", "UPDATE" or "DELETE") and rowid. m_plhs[1] will
+     * be set to the number of changes lost (buffer overflow) meanwhile.
+     */
+    bool cmdTryHandleChanges( const char* strCmdMatchName )
+    {
+        const char*                 fieldnames[] = { "table", "op", "rowid" };
+        vector<ChangeFeed::Change>  changes;
+        double                      lost;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        SQLstack.switchTo( m_dbid-1 );
+
+        if( !ensureDbIsOpen() )
+        {
+            // ensureDbIsOpen() sets m_err
+            return false;
+        }
+        
+        if( m_narg ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        ChangeFeed&           feed  = m_interface->getChangeFeed();
+        const vector<string>& names = feed.names();
+        
+        lost = feed.take( changes );
+        
+        mxArray* result = mxCreateStructMatrix( 1, 1, 3, fieldnames );
+        mxArray* tables = mxCreateCellMatrix( (int)changes.size(), 1 );
+        mxArray* ops    = mxCreateCellMatrix( (int)changes.size(), 1 );
+        mxArray* rowids = mxCreateDoubleMatrix( (int)changes.size(), 1, mxREAL );
+        double*  prowid = mxGetPr( rowids );
+        
+        for( size_t i = 0; i < changes.size(); i++ )
+        {
+            const ChangeFeed::Change& change = changes[i];
+            const char*               op     = SQLITE_INSERT == change.op ? "INSERT" 
+                                             : SQLITE_DELETE == change.op ? "DELETE" : "UPDATE";
+            
+            mxSetCell( tables, i, mxCreateString( names[change.table].c_str() ) );
+            mxSetCell( ops, i, mxCreateString( op ) );
+            prowid[i] = (double)change.rowid;
+        }
+        
+        mxSetFieldByNumber( result, 0, 0, tables );
+        mxSetFieldByNumber( result, 0, 1, ops );
+        mxSetFieldByNumber( result, 0, 2, rowids );
+        
+        m_plhs[0] = result;
+        
+        if( m_nlhs > 1 )
+        {
+            m_plhs[1] = mxCreateDoubleScalar( lost );
+        }
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle command starting a session for changesets
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Optional argument are the tables to record (cell array or comma
+     * separated list, "*" for all tables (default)) or 0 to stop the
+     * session. A running session is restarted, changes not taken are lost.
+     * m_plhs[0] will be set to 1 if a session is running, 0 otherwise.
+     */
+    bool cmdTryHandleSessionStart( const char* strCmdMatchName )
+    {
+        vector<string>  tables;
+        bool            bEnable = true;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        SQLstack.switchTo( m_dbid-1 );
+
+        if( !ensureDbIsOpen() )
+        {
+            // ensureDbIsOpen() sets m_err
+            return false;
+        }
+        
+        if( m_narg > 1 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( m_narg )
+        {
+            if( mxIsNumeric( m_parg[0] ) )
+            {
+                int flag = 0;
+                
+                // argGetNextInteger() sets m_err
+                if( !argGetNextInteger( flag, /*asBoolInt*/ true ) )
+                {
+                    return false;
+                }
+                
+                bEnable = ( 0 != flag );
+            }
+            else if( !argGetNextNameList( tables ) )
+            {
+                // argGetNextNameList() sets m_err
+                return false;
+            }
+            
+            if( 1 == tables.size() && tables[0] == "*" )
+            {
+                // all tables
+                tables.clear();
+            }
+        }
+        
+        if( !m_interface->setSession( bEnable, tables ) )
+        {
+            const char* errid = NULL;
+            const char* errmsg = m_interface->getErr( &errid );
+            m_err.set( errmsg, errid );
+            return false;
+        }
+        
+        m_plhs[0] = mxCreateDoubleScalar( m_interface->isSessionRunning() ? 1.0 : 0.0 );
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle command taking the changeset of a session
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * The session is restarted, so the next changeset holds the changes
+     * from now on. Optional argument is a compression level (0..9, 
+     * default 0). m_plhs[0] will be set to the changeset as uint8 row 
+     * vector, as typed BLOB compressed by blosc (lz4) for levels above 0.
+     * m_plhs[1] will be set to the size of the uncompressed changeset.
+     */
+    bool cmdTryHandleSessionChangeset( const char* strCmdMatchName )
+    {
+        string  changeset;
+        int     level = 0;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        SQLstack.switchTo( m_dbid-1 );
+
+        if( !ensureDbIsOpen() )
+        {
+            // ensureDbIsOpen() sets m_err
+            return false;
+        }
+        
+        if( m_narg > 1 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        if( m_narg && !argGetNextInteger( level, /*asBoolInt*/ false ) )
+        {
+            // argGetNextInteger() sets m_err
+            return false;
+        }
+        
+        if( level < 0 || level > 9 )
+        {
+            m_err.set( MSG_INVALIDARG );
+            return false;
+        }
+        
+        if( !m_interface->takeChangeset( changeset ) )
+        {
+            const char* errid = NULL;
+            const char* errmsg = m_interface->getErr( &errid );
+            m_err.set( errmsg, errid );
+            return false;
+        }
+        
+        ValueMex item( 1, (mwIndex)changeset.size(), ValueMex::UINT8_CLASS );
+        
+        if( !item.Item() )
+        {
+            m_err.set( MSG_ERRMEMORY );
+            return false;
+        }
+        
+        if( changeset.size() )
+        {
+            memcpy( item.Data(), changeset.data(), changeset.size() );
+        }
+        
+        m_plhs[0] = item.Detach();
+        
+        if( level > 0 )
+        {
+            void*  blob         = NULL;
+            size_t blob_size    = 0;
+            double process_time = 0.0;
+            double ratio        = 0.0;
+            int    err_id       = blob_pack( m_plhs[0], false, &blob, &blob_size, &process_time, &ratio,
+                                             BLOSC_LZ4_ID, level, (size_t)-1 );
+            
+            ::utils_destroy_array( m_plhs[0] );
+            
+            if( MSG_NOERROR != err_id )
+            {
+                m_err.set( err_id );
+                return false;
+            }
+            
+            ValueMex packed( 1, (mwIndex)blob_size, ValueMex::UINT8_CLASS );
+            
+            if( packed.Item() )
+            {
+                memcpy( packed.Data(), blob, blob_size );
+            }
+            
+            blob_free( &blob );
+            
+            if( !packed.Item() )
+            {
+                m_err.set( MSG_ERRMEMORY );
+                return false;
+            }
+            
+            m_plhs[0] = packed.Detach();
+        }
+        
+        if( m_nlhs > 1 )
+        {
+            m_plhs[1] = mxCreateDoubleScalar( (double)changeset.size() );
+        }
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle command applying a changeset
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Arguments are the changeset (uint8 array, plain or as typed BLOB, 
+     * see 'session_changeset') and optionally the conflict policy:
+     * "abort" (default, nothing is applied on conflicts), "omit" (skip 
+     * conflicting changes) or "replace" (overwrite conflicting rows).
+     * m_plhs[0] will be set to the number of conflicts, m_plhs[1] to a
+     * struct with the conflicts by kind.
+     */
+    bool cmdTryHandleChangesetApply( const char* strCmdMatchName )
+    {
+        const char*                     fieldnames[] = { "data", "notfound", "conflict", "constraint", "foreign_key" };
+        ChangesetSession::policy_e      policy       = ChangesetSession::POLICY_ABORT;
+        ChangesetSession::Conflicts     conflicts;
+        string                          changeset;
+        
+        if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
+        {
+            return false;
+        }
+        
+        SQLstack.switchTo( m_dbid-1 );
+
+        if( !ensureDbIsOpen() )
+        {
+            // ensureDbIsOpen() sets m_err
+            return false;
+        }
+        
+        if( m_narg < 1 ) 
+        {
+            m_err.set( MSG_MISSINGARG );
+            return false;
+        }
+        
+        if( m_narg > 2 ) 
+        {
+            m_err.set( MSG_UNEXPECTEDARG );
+            return false;
+        }
+        
+        // argGetNextChangeset() sets m_err
+        if( !argGetNextChangeset( changeset ) )
+        {
+            return false;
+        }
+        
+        if( m_narg )
+        {
+            char* policyname = ValueMex( m_parg[0] ).GetString( true );
+            
+            if( STRMATCH( policyname, "abort" ) )
+            {
+                policy = ChangesetSession::POLICY_ABORT;
+            }
+            else if( STRMATCH( policyname, "omit" ) )
+            {
+                policy = ChangesetSession::POLICY_OMIT;
+            }
+            else if( STRMATCH( policyname, "replace" ) )
+            {
+                policy = ChangesetSession::POLICY_REPLACE;
+            }
+            else
+            {
+                m_err.set( MSG_INVALIDARG );
+            }
+            
+            ::utils_free_ptr( policyname );
+            
+            if( errPending() )
+            {
+                return false;
+            }
+            
+            m_parg++;
+            m_narg--;
+        }
+        
+        if( !m_interface->applyChangeset( changeset, policy, conflicts ) )
+        {
+            const char* errid = NULL;
+            const char* errmsg = m_interface->getErr( &errid );
+            m_err.set( errmsg, errid );
+            return false;
+        }
+        
+        m_plhs[0] = mxCreateDoubleScalar( (double)conflicts.total() );
+        
+        if( m_nlhs > 1 )
+        {
+            const double values[] = { (double)conflicts.data, (double)conflicts.notfound, (double)conflicts.conflict,
+                                      (double)conflicts.constraint, (double)conflicts.foreign_key };
+            mxArray*     result   = mxCreateStructMatrix( 1, 1, 5, fieldnames );
+            
+            for( int i = 0; i < 5; i++ )
+            {
+                mxSetFieldByNumber( result, 0, i, mxCreateDoubleScalar( values[i] ) );
+            }
+            
+            m_plhs[1] = result;
+        }
+
+        return true;
+    }
+    
+    
+    /**
+     * \brief Handle command suggesting indexes
+     *
+     * \param[in] strCmdMatchName Command name
+     * \returns true on success
+     * 
+     * Optional first argument are the SQL statements to analyze (cell
+     * array or string), the statements recently run if empty or omitted.
+     * Optional second argument enables timed runs (SELECT statements
+     * without parameters) with each index suggested created temporarily.
+     * m_plhs[0] will be set to a struct array (column) of the suggestions,
+     * highest estimated benefit first, with the fields create, table,
+     * columns, statements (indices of the statements sped up), speedup
+     * (estimated), measured (NaN if not timed) and plan. m_plhs[1] will be
+     * set to the statements analyzed (cell column).
+     */
+    bool cmdTryHandleIndexAdvisor( const char* strCmdMatchName )
     {
-        int iTimeout;
+        const char*                         fieldnames[] = { "create", "table", "columns", "statements", "speedup", "measured", "plan" };
+        vector<string>                      statements;
+        vector<IndexAdvisor::Suggestion>    suggestions;
+        int                                 bTimed = 0;
         
         if( errPending() || !STRMATCH( m_command, strCmdMatchName ) )
         {
             return false;
         }
         
-        // database must be open to set busy timeout
+        SQLstack.switchTo( m_dbid-1 );
+
         if( !ensureDbIsOpen() )
         {
             // ensureDbIsOpen() sets m_err
             return false;
         }
         
-        /*
-         * There should be one argument, the Timeout in ms
-         */
-        if( m_narg > 1 ) 
+        if( m_narg > 2 ) 
         {
             m_err.set( MSG_UNEXPECTEDARG );
             return false;
         }
         
-        if( !m_narg && !m_interface->getBusyTimeout( iTimeout ) )
+        if( m_narg )
         {
-            const char* errid = NULL;
-            /*
-             * Anything wrong? free the database id and inform the user
-             */
-            PRINTF( "%s\n", ::getLocaleMsg( MSG_BUSYTIMEOUTFAIL ) );
-            m_err.set( m_interface->getErr(&errid), errid );
-            return false;
+            const mxArray* arg = m_parg[0];
+            
+            if( mxIsCell( arg ) )
+            {
+                for( size_t i = 0; i < mxGetNumberOfElements( arg ); i++ )
+                {
+                    char* item = ::utils_getString( mxGetCell( arg, i ) );
+                    
+                    if( !item )
+                    {
+                        m_err.set( MSG_INVALIDARG );
+                        return false;
+                    }
+                    
+                    statements.push_back( item );
+                    ::utils_free_ptr( item );
+                }
+            }
+            else if( mxGetClassID( arg ) == mxCHAR_CLASS )
+            {
+                char* item = ::utils_getString( arg );
+                
+                if( item && *item )
+                {
+                    statements.push_back( item );
+                }
+                
+                ::utils_free_ptr( item );
+            }
+            else if( !mxIsEmpty( arg ) )
+            {
+                m_err.set( MSG_LITERALARGEXPCT );
+                return false;
+            }
+            
+            m_parg++;
+            m_narg--;
         }
         
-        if( m_narg && !argGetNextInteger( iTimeout, /*asBoolInt*/ false  ) )
+        if( m_narg && !argGetNextInteger( bTimed, /*asBoolInt*/ true ) )
         {
             // argGetNextInteger() sets m_err
             return false;
         }
         
-        // Note that negative timeout values are allowed:
-        // "Calling this routine with an argument less than or equal 
-        // to zero turns off all busy handlers."
-        
-        if( !m_interface->setBusyTimeout( iTimeout ) )
+        if( !m_interface->adviseIndexes( statements, bTimed != 0, suggestions ) )
         {
             const char* errid = NULL;
-            /*
-             * Anything wrong? free the database id and inform the user
-             */
-            PRINTF( "%s\n", ::getLocaleMsg( MSG_BUSYTIMEOUTFAIL ) );
-            m_err.set( m_interface->getErr(&errid), errid );
+            const char* errmsg = m_interface->getErr( &errid );
+            m_err.set( errmsg, errid );
             return false;
         }
         
-        // always return old timeout value
-        m_plhs[0] = mxCreateDoubleScalar( (double)iTimeout );
+        mxArray* result = mxCreateStructMatrix( (int)suggestions.size(), 1, 7, fieldnames );
+        
+        for( size_t i = 0; i < suggestions.size(); i++ )
+        {
+            const IndexAdvisor::Suggestion& s = suggestions[i];
+            
+            mxArray* columns = mxCreateCellMatrix( 1, (int)s.columns.size() );
+            mxArray* indices = mxCreateDoubleMatrix( 1, (int)s.statements.size(), mxREAL );
+            
+            for( size_t k = 0; k < s.columns.size(); k++ )
+            {
+                mxSetCell( columns, k, mxCreateString( s.columns[k].c_str() ) );
+            }
+            
+            for( size_t k = 0; k < s.statements.size(); k++ )
+            {
+                // 1-based
+                mxGetPr( indices )[k] = (double)( s.statements[k] + 1 );
+            }
+            
+            mxSetFieldByNumber( result, i, 0, mxCreateString( s.create().c_str() ) );
+            mxSetFieldByNumber( result, i, 1, mxCreateString( s.table.c_str() ) );
+            mxSetFieldByNumber( result, i, 2, columns );
+            mxSetFieldByNumber( result, i, 3, indices );
+            mxSetFieldByNumber( result, i, 4, mxCreateDoubleScalar( s.speedup() ) );
+            mxSetFieldByNumber( result, i, 5, mxCreateDoubleScalar( s.measured ) );
+            mxSetFieldByNumber( result, i, 6, mxCreateString( s.plan.c_str() ) );
+        }
+        
+        m_plhs[0] = result;
+        
+        if( m_nlhs > 1 )
+        {
+            mxArray* analyzed = mxCreateCellMatrix( (int)statements.size(), 1 );
+            
+            for( size_t i = 0; i < statements.size(); i++ )
+            {
+                mxSetCell( analyzed, i, mxCreateString( statements[i].c_str() ) );
+            }
+            
+            m_plhs[1] = analyzed;
+        }
 
         return true;
     }
@@ -1687,10 +5006,44 @@ public:
      * - result_type
      * - compression
      * - compression_check
+     * - compression_simd
+     * - compression_blocksize
+     * - compression_tune
+     * - bitpack_logicals
      * - show tables
      * - enable extension
      * - status
      * - setbusytimeout
+     * - stmt_cache
+     * - stack_blobs
+     * - sidecar
+     * - sidecar gc
+     * - prepare
+     * - exec
+     * - finalize
+     * - exec_script
+     * - regexp_where
+     * - fts_index
+     * - fts_search
+     * - shards_open
+     * - shards_close
+     * - shards_query
+     * - backup
+     * - backup_status
+     * - backup_cancel
+     * - restore
+     * - wal_checkpointer
+     * - wal_checkpoint
+     * - result_info
+     * - result_cols
+     * - result_free
+     * - result_budget
+     * - track_changes
+     * - changes
+     * - session_start
+     * - session_changeset
+     * - changeset_apply
+     * - index_advisor
      */
     bool cmdTryHandleNonSqlStatement()
     {
@@ -1698,6 +5051,7 @@ public:
             || cmdTryHandleFlag( "convertUTF8", g_convertUTF8 )
             || cmdTryHandleFlag( "NULLasNaN", g_NULLasNaN )
             || cmdTryHandleFlag( "compression_check", g_compression_check )
+            || cmdTryHandleFlag( "bitpack_logicals", g_bitpack_logicals )
             || cmdTryHandleFlag( "param_wrapping", g_param_wrapping )
             || cmdTryHandleStatus( "status" )
             || cmdTryHandleLanguage( "lang" )
@@ -1706,8 +5060,41 @@ public:
             || cmdTryHandleStreaming( "streaming" )
             || cmdTryHandleTypedBlob( "typedBLOBs" )
             || cmdTryHandleResultType( "result_type" )
+            || cmdTryHandleStmtCache( "stmt_cache" )
+            || cmdTryHandleStackBlobs( "stack_blobs" )
             || cmdTryHandleCompression( "compression" )
+            || cmdTryHandleCompressionSimd( "compression_simd" )
+            || cmdTryHandleCompressionBlocksize( "compression_blocksize" )
+            || cmdTryHandleCompressionTune( "compression_tune" )
             || cmdTryHandleSetBusyTimeout( "setbusytimeout" )
+            || cmdTryHandleSidecar( "sidecar" )
+            || cmdTryHandleSidecarGc( "sidecar gc" )
+            || cmdTryHandlePrepare( "prepare" )
+            || cmdTryHandleExec( "exec" )
+            || cmdTryHandleFinalize( "finalize" )
+            || cmdTryHandleExecScript( "exec_script" )
+            || cmdTryHandleRegexpWhere( "regexp_where" )
+            || cmdTryHandleFtsIndex( "fts_index" )
+            || cmdTryHandleFtsSearch( "fts_search" )
+            || cmdTryHandleShardsOpen( "shards_open" )
+            || cmdTryHandleShardsClose( "shards_close" )
+            || cmdTryHandleShardsQuery( "shards_query" )
+            || cmdTryHandleBackup( "backup" )
+            || cmdTryHandleBackupStatus( "backup_status", /*bCancel*/ false )
+            || cmdTryHandleBackupStatus( "backup_cancel", /*bCancel*/ true )
+            || cmdTryHandleRestore( "restore" )
+            || cmdTryHandleWalCheckpointer( "wal_checkpointer" )
+            || cmdTryHandleWalCheckpoint( "wal_checkpoint" )
+            || cmdTryHandleResultInfo( "result_info" )
+            || cmdTryHandleResultCols( "result_cols" )
+            || cmdTryHandleResultFree( "result_free" )
+            || cmdTryHandleResultBudget( "result_budget" )
+            || cmdTryHandleTrackChanges( "track_changes" )
+            || cmdTryHandleChanges( "changes" )
+            || cmdTryHandleSessionStart( "session_start" )
+            || cmdTryHandleSessionChangeset( "session_changeset" )
+            || cmdTryHandleChangesetApply( "changeset_apply" )
+            || cmdTryHandleIndexAdvisor( "index_advisor" )
             || cmdTryHandleEnableExtension( "enable extension" )
             || cmdTryHandleCreateFunction( "create function" )
             || cmdTryHandleCreateAggregation( "create aggregation" ) )
@@ -1784,7 +5171,8 @@ public:
         if( !SQLstack.current().closeDb( m_err ) )
         {
             const char* errid = NULL;
-            m_err.set( m_interface->getErr(&errid), errid );
+            const char* errmsg = m_interface->getErr( &errid );
+            m_err.set( errmsg, errid );
         }
         
         /*
@@ -1870,7 +5258,8 @@ public:
             if( !m_interface->setBusyTimeout( CONFIG_BUSYTIMEOUT ) )
             {
                 PRINTF( "%s\n", ::getLocaleMsg( MSG_BUSYTIMEOUTFAIL ) );
-                m_err.set( m_interface->getErr(&errid), errid );
+                const char* errmsg = m_interface->getErr( &errid );
+                m_err.set( errmsg, errid );
             }
         }
         
@@ -1939,7 +5328,7 @@ public:
     ValueMex createItemFromValueSQL( const ValueSQL& value )
     {
         int err_id = MSG_NOERROR;
-        ValueMex item = ::createItemFromValueSQL( value, err_id );
+        ValueMex item = ::createItemFromValueSQL( value, err_id, m_interface ? m_interface->getSidecar() : NULL );
 
         if( MSG_NOERROR != err_id )
         {
@@ -2002,31 +5391,99 @@ public:
      *  of the table, that \a cols holds. The struct field names are the column
      *  names, and may be modified due to MATLAB naming conventions.
      *
+     * The struct array is created with all its fields at once. Numeric
+     * scalars are allocated uninitialized and set from the column buffers
+     * directly, other values are converted by createItemFromValueSQL().
+     *
      * @see g_result_type
      */
     mxArray* createResultAsArrayOfStructs( ValueSQLCols& cols )
     {
+        int                 ncols     = (int)cols.size();
+        int                 nrows     = (int)cols[0].size();
+        vector<const char*> fieldnames;
+        vector<int>         fieldnum( ncols );
+        vector<bool>        isDuplicate( ncols, false );
+        
+        // field names, columns with equal names share one field (the last wins)
+        for( int i = 0; i < ncols; i++ )
+        {
+            int j;
+            
+            for( j = 0; j < (int)fieldnames.size(); j++ )
+            {
+                if( cols[i].m_name == fieldnames[j] )
+                {
+                    isDuplicate[i] = true;
+                    break;
+                }
+            }
+            
+            if( j == (int)fieldnames.size() )
+            {
+                fieldnames.push_back( cols[i].m_name.c_str() );
+            }
+            
+            fieldnum[i] = j;
+        }
+        
         /*
-         * Allocate an array of MATLAB structs to return as result
+         * Allocate an array of MATLAB structs with all fields to return as result
          */
-        mxArray* result = mxCreateStructMatrix( (int)cols[0].size(), 1, 0, NULL );
+        mxArray* result = mxCreateStructMatrix( nrows, 1, (int)fieldnames.size(), 
+                                                fieldnames.empty() ? NULL : &fieldnames[0] );
+        
+        if( !result )
+        {
+            m_err.set( MSG_ERRMEMORY );
+            return NULL;
+        }
 
         // iterate columns
-        for( int i = 0; !errPending() && i < (int)cols.size(); i++ )
+        for( int i = 0; !errPending() && i < ncols; i++ )
         {
-            int j;
-
-            // insert new field into struct
-            if( !result || -1 == ( j = mxAddField( result, cols[i].m_name.c_str() ) ) )
-            {
-                m_err.set( MSG_ERRMEMORY );
-            }
+            ValueSQLCol& col = cols[i];
+            int          j   = fieldnum[i];
 
             // iterate rows
-            for( int row = 0; !errPending() && row < (int)cols[i].size(); row++ )
+            for( int row = 0; !errPending() && row < nrows; row++ )
             {
+                mxArray* item = NULL;
+                
                 // get current table element at row and column
-                mxArray* item = createItemFromValueSQL( cols[i][row] ).Detach();
+                if( !col.m_isAnyType )
+                {
+                    // pure double column
+                    if( NULL != ( item = createUninitScalar( mxDOUBLE_CLASS ) ) )
+                    {
+                        *mxGetPr( item ) = col.m_float[row];
+                    }
+                }
+                else
+                {
+                    const ValueSQL& value = col.m_any[row];
+                    
+                    switch( value.m_typeID )
+                    {
+                        case SQLITE_FLOAT:
+                            if( NULL != ( item = createUninitScalar( mxDOUBLE_CLASS ) ) )
+                            {
+                                *mxGetPr( item ) = value.m_float;
+                            }
+                            break;
+                        
+                        case SQLITE_INTEGER:
+                            if( NULL != ( item = createUninitScalar( mxINT64_CLASS ) ) )
+                            {
+                                *(sqlite3_int64*)mxGetData( item ) = value.m_integer;
+                            }
+                            break;
+                        
+                        default:
+                            item = createItemFromValueSQL( value ).Detach();
+                            break;
+                    }
+                }
 
                 if( !item )
                 {
@@ -2037,12 +5494,16 @@ public:
                 }
                 else
                 {
-                    // destroy previous item
-                    mxDestroyArray( mxGetFieldByNumber( result, row, j ) );
-                    // and replace with new one
+                    if( isDuplicate[i] )
+                    {
+                        // destroy previous item
+                        mxDestroyArray( mxGetFieldByNumber( result, row, j ) );
+                    }
+                    
+                    // fields are empty (NULL) initially
                     mxSetFieldByNumber( result, row, j, item );
 
-                    cols[i].Destroy(row); // release memory
+                    col.Destroy(row); // release memory
                     item = NULL;  // Do not destroy! (Occupied by MATLAB struct now)
                 }
             } /* end for (rows) */
@@ -2052,6 +5513,106 @@ public:
     }
     
     
+    /**
+     * \brief Stack typed BLOBs of a column into one matrix
+     *
+     * @param[in] col column of a SQLite fetched table
+     * @returns a MATLAB matrix holding the elements of the typed BLOB from
+     *  each row in one column, or NULL if the rows don't match in class and 
+     *  number of elements (m_err is set then in mode STACK_BLOBS_STRICT).
+     *
+     * Each BLOB is unpacked directly into the matrix, without creating an
+     * array of its own. Only typed BLOBs in plain layout can be stacked.
+     *
+     * @see g_stack_blobs
+     */
+    mxArray* createStackedBlobs( ValueSQLCol& col )
+    {
+        const SidecarStore* sidecar = m_interface ? m_interface->getSidecar() : NULL;
+        mxArray*            column  = NULL;
+        mxClassID           clsid   = mxUNKNOWN_CLASS;
+        size_t              numel   = 0;
+        size_t              elbytes = 0;
+        int                 err_id  = MSG_NOERROR;
+
+        // iterate rows
+        for( int row = 0; MSG_NOERROR == err_id && row < (int)col.size(); row++ )
+        {
+            SidecarMapping  mapping;
+            const void*     blob      = NULL;
+            size_t          blob_size = 0;
+
+            if( col[row].m_typeID == SQLITE_BLOB )
+            {
+                blob      = ValueMex( col[row].m_blob ).Data();
+                blob_size = ValueMex( col[row].m_blob ).ByData();
+
+                // BLOB is stored externally
+                if( sidecar && SidecarRef::isRef( blob, blob_size ) )
+                {
+                    blob = sidecar->resolve( blob, mapping, &blob_size );
+                }
+            }
+
+            if( !blob )
+            {
+                err_id = MSG_UNSUPPTBH;
+                break;
+            }
+
+            // first row determines class and size of all
+            if( !column )
+            {
+                mwSize dims[2];
+
+                err_id = blob_unpack_into( blob, blob_size, &clsid, &numel, NULL );
+
+                if( MSG_NOERROR != err_id )
+                {
+                    break;
+                }
+
+                dims[0] = (mwSize)numel;
+                dims[1] = (mwSize)col.size();
+                elbytes = utils_elbytes( clsid );
+                column  = mxCreateNumericArray( 2, dims, clsid, mxREAL );
+
+                if( !column )
+                {
+                    m_err.set( MSG_ERRMEMORY );
+                    return NULL;
+                }
+            }
+
+            err_id = blob_unpack_into( blob, blob_size, &clsid, &numel, (char*)mxGetData( column ) + row * numel * elbytes );
+        } /* end for (rows) */
+
+        if( MSG_NOERROR != err_id )
+        {
+            ::utils_destroy_array( column );
+
+            if( MSG_UNSUPPTBH != err_id )
+            {
+                m_err.set( err_id );
+            }
+            else if( STACK_BLOBS_STRICT == g_stack_blobs )
+            {
+                m_err.set_printf( MSG_STACKMISMATCH, NULL, col.m_col_name.c_str() );
+            }
+
+            return NULL;
+        }
+
+        // release memory
+        for( int row = 0; row < (int)col.size(); row++ )
+        {
+            col.Destroy( row );
+        }
+
+        return column;
+    }
+
+
     /**
      * \brief Transform SQL fetch to MATLAB struct of arrays
      *
@@ -2060,9 +5621,10 @@ public:
      *  of the table, that \a cols holds. The struct field names are the column
      *  names, and may be modified due to MATLAB naming conventions. Pure
      *  numeric vectors are given as double arrays, other types will be 
-     *  returned as cell array.
+     *  returned as cell array. Typed BLOBs matching in class and size may
+     *  be stacked into a matrix.
      *
-     * @see g_result_type
+     * @see g_result_type, g_stack_blobs
      */
     mxArray* createResultAsStructOfArrays( ValueSQLCols& cols )
     {
@@ -2075,13 +5637,29 @@ public:
         for( int i = 0; !errPending() && i < (int)cols.size(); i++ )
         {
             mxArray* column = NULL;
+            bool isStacked = false;
             int j;
 
+            // Typed BLOBs of same class and size can be stacked into a matrix
+            if( cols[i].m_isAnyType && g_stack_blobs != STACK_BLOBS_OFF && typed_blobs_mode_on() && cols[i].size() > 0 )
+            {
+                column = createStackedBlobs( cols[i] );
+                isStacked = ( NULL != column );
+                
+                if( errPending() )
+                {
+                    break;
+                }
+            }
+
             // Pure floating point can be archieved in a numeric matrix
             // mixed types must be stored in a cell matrix
-            column = cols[i].m_isAnyType ?
-                     mxCreateCellMatrix( (int)cols[0].size(), 1 ) :
-                     mxCreateDoubleMatrix( (int)cols[0].size(), 1, mxREAL );
+            if( !isStacked )
+            {
+                column = cols[i].m_isAnyType ?
+                         mxCreateCellMatrix( (int)cols[0].size(), 1 ) :
+                         mxCreateDoubleMatrix( (int)cols[0].size(), 1, mxREAL );
+            }
 
             // add a new field in the struct
             if( !result || !column || -1 == ( j = mxAddField( result, cols[i].m_name.c_str() ) ) )
@@ -2090,7 +5668,11 @@ public:
                 ::utils_destroy_array( column );
             }
 
-            if( !cols[i].m_isAnyType )
+            if( isStacked )
+            {
+                // rows already unpacked into the matrix
+            }
+            else if( !cols[i].m_isAnyType )
             {
                 // fast copy of pure floating point data, iterating rows
                 for( int row = 0; !errPending() && row < (int)cols[i].size(); row++ )
@@ -2212,6 +5794,98 @@ public:
     }
     
     
+    /**
+     * \brief Create the SQL query from a mksqlite command
+     *
+     * \param[in] command Command string
+     * \returns Query, converted to UTF-8 (if \ref g_convertUTF8 is set) with
+     *          a semicolon appended, or NULL (\p m_err is set then)
+     *
+     * The caller has to free the returned string by utils_free_ptr().
+     */
+    char* createQuery( const char* command )
+    {
+        // Do the charset conversion and append a semicolon
+        char* new_command = NULL;
+        int cmd_length = ::utils_latin2utf( (const unsigned char*)command );
+        
+        if( cmd_length < strlen( command ) )
+        {
+            cmd_length = (int)strlen( command );
+        }
+        
+        new_command = (char*)MEM_ALLOC( cmd_length + 2, 1 );
+        
+        if( !new_command )
+        {
+            m_err.set( MSG_ERRMEMORY );
+            return NULL;
+        }
+        
+        if( g_convertUTF8 )
+        {
+            ::utils_latin2utf( (const unsigned char*)command, (unsigned char*)new_command );
+            sprintf( new_command + strlen( new_command ), ";" );
+        }
+        else
+        {
+            sprintf( new_command, "%s;", command );
+        }
+
+        return new_command;
+    }
+    
+    
+    /**
+     * \brief Keep SQL fetch in native memory and return a handle
+     *
+     * @param[in] cols SQLite fetched table
+     * @returns a MATLAB double scalar holding the result handle. Columns
+     *  are converted later on request (see cmdTryHandleResultCols()).
+     *
+     * @see g_result_type
+     */
+    mxArray* createResultAsHandle( ValueSQLCols& cols )
+    {
+        LazyResult* result = new LazyResult;
+        
+        result->assign( cols );
+        
+        return mxCreateDoubleScalar( (double)Results.add( result ) );
+    }
+    
+    
+    /**
+     * \brief Create the query result regarding result type
+     *
+     * \param[in] cols Column vectors of the result
+     * \returns MATLAB array or NULL
+     *
+     * @see g_result_type
+     */
+    mxArray* createResult( ValueSQLCols& cols )
+    {
+        switch( g_result_type )
+        {
+            case RESULT_TYPE_ARRAYOFSTRUCTS:
+                return createResultAsArrayOfStructs( cols );
+            
+            case RESULT_TYPE_STRUCTOFARRAYS:
+                return createResultAsStructOfArrays( cols );
+            
+            case RESULT_TYPE_MATRIX:
+                return createResultAsMatrix( cols );
+            
+            case RESULT_TYPE_HANDLE:
+                return createResultAsHandle( cols );
+            
+            default:
+                assert( false );
+                return NULL;
+        }
+    }
+    
+    
     /**
      * \brief Handle common SQL statement
      *
@@ -2233,35 +5907,18 @@ public:
 
         /*** prepare query, append semicolon ***/
         
-        // m_query can be already set i.e. in case of command 'show tables'
-        if( !m_query )
+        // m_query can be already set i.e. in case of command 'show tables',
+        // statements held by a handle are prepared already
+        if( !m_query && !m_stmt_handle )
         {
-            // Do the charset conversion and append a semicolon
-            char* new_command = NULL;
-            int cmd_length = ::utils_latin2utf( (const unsigned char*)m_command );
-            
-            if( cmd_length < strlen( m_command ) )
-            {
-                cmd_length = (int)strlen( m_command );
-            }
-            
-            new_command = (char*)MEM_ALLOC( cmd_length + 2, 1 );
+            char* new_command = createQuery( m_command );
             
             if( !new_command )
             {
-                m_err.set( MSG_ERRMEMORY );
+                // createQuery() sets m_err
                 return false;
             }
             
-            if( g_convertUTF8 )
-            {
-                ::utils_latin2utf( (const unsigned char*)m_command, (unsigned char*)new_command );
-                sprintf( new_command + strlen( new_command ), ";" );
-            }
-            else
-            {
-                sprintf( new_command, "%s;", m_command );
-            }
             ::utils_free_ptr( m_command );
             m_command = new_command;
             
@@ -2270,12 +5927,19 @@ public:
         
         /*** prepare statement ***/
 
-        if( !m_interface->setQuery( m_query ) )
+        if( m_stmt_handle ? !m_interface->setPrepared( m_stmt_handle ) : !m_interface->setQuery( m_query ) )
         {
             const char* errid = NULL;
-            m_err.set( m_interface->getErr(&errid), errid );
+            const char* errmsg = m_interface->getErr( &errid );
+            m_err.set( errmsg, errid );
             return false;
         }
+        
+        // statements passed by the user (not by commands like 'show tables') are kept for the index advisor
+        if( !m_stmt_handle && m_query == m_command )
+        {
+            m_interface->recordQuery( m_query );
+        }
 
         /*** Progress parameters for subsequent queries ***/
 
@@ -2288,6 +5952,7 @@ public:
         long*            last_insert_row     = NULL;  // kv69: for storing last_insert_row_id after each statement reuse
         bool             initialize          = true;  // kv69: flag indicating initialization within first call of fetch procedure
         int              count               = 1;     // kv69: number of repeated statements calls 
+        vector<ScalarBinder> binders( argsNeeded );   // binder kernels, selected by the first value of each parameter
 
 
 
@@ -2319,6 +5984,13 @@ public:
                 haveParamCell = false;
             }
 
+            // A cell array passed to the only parameter, which is the argument of carray(),
+            // is the parameter itself (a cellstr), not a list of parameters
+            if( !g_param_wrapping && argsNeeded == 1 && m_interface->isCarrayParameter( 1 ) )
+            {
+                haveParamCell = false;
+            }
+
             if( haveParamCell )
             {
                 // redirect cell elements as bind arguments
@@ -2453,10 +6125,21 @@ public:
                     }
                 }
 
-                if( !m_interface->bindParameter( iParam + 1, ValueMex( bindParam ), can_serialize() ) )
+                // select binder kernel once (carray() arguments are bound as arrays)
+                ScalarBinder& binder = binders[iParam];
+                
+                if( !binder.isSelected() )
+                {
+                    binder.select( m_interface->isCarrayParameter( iParam + 1 ) ? NULL : bindParam );
+                }
+
+                if( binder.accepts( bindParam ) 
+                    ? !m_interface->bindScalar( iParam + 1, binder, bindParam )
+                    : !m_interface->bindParameter( iParam + 1, ValueMex( bindParam ), can_serialize() ) )
                 {
                     const char* errid = NULL;
-                    m_err.set( m_interface->getErr(&errid), errid );
+                    const char* errmsg = m_interface->getErr( &errid );
+                    m_err.set( errmsg, errid );
                     goto finalize;
                 }
             }
@@ -2467,7 +6150,8 @@ public:
             if( !errPending() && !m_interface->fetch( cols, initialize ) )
             {
                 const char* errid = NULL;
-                m_err.set( m_interface->getErr(&errid), errid );
+                const char* errmsg = m_interface->getErr( &errid );
+                m_err.set( errmsg, errid );
                 goto finalize;
             }
             initialize = false; // kv69: for next statement use do not initialize query results again but accumulated it
@@ -2508,27 +6192,7 @@ finalize:
             }
             else
             {
-                mxArray* result = NULL;
-                
-                // dispatch regarding result type
-                switch( g_result_type )
-                {
-                    case RESULT_TYPE_ARRAYOFSTRUCTS:
-                        result = createResultAsArrayOfStructs( cols );
-                        break;
-                    
-                    case RESULT_TYPE_STRUCTOFARRAYS:
-                        result = createResultAsStructOfArrays( cols );
-                        break;
-                    
-                    case RESULT_TYPE_MATRIX:
-                        result = createResultAsMatrix( cols );
-                        break;
-                    
-                    default:
-                        assert( false );
-                        break;
-                }
+                mxArray* result = createResult( cols );
 
                 if( !result )
                 {
@@ -80,6 +80,21 @@
 % ausgefhrt werden soll, so muss das so genannte Parameter Wrapping aktiviert
 % werden:
 % mksqlite('param_wrapping', 0|1)
+%
+% Ein Vektor kann mit der tabellenwertigen Funktion carray() als Liste von
+% Werten bergeben werden, z.B. fr IN Klauseln oder Joins:
+%  ids = int32( [3 17 42] );
+%  query = mksqlite( 'select * from Adressbuch where id in carray(?)', ids );
+%  query = mksqlite( 'select * from Adressbuch where ort in carray(?)', ...
+%                    {'Muenchen', 'Berlin'} );
+% Reelle numerische und logische Vektoren werden direkt gelesen, ohne sie zu
+% kopieren. Ein CellArray aus Strings als einziges Argument wird als ein
+% Wert fr carray() verwendet, sofern Parameter Wrapping nicht aktiv ist.
+% Die Suche eines einzelnen Wertes in Vektoren mit 64 oder mehr Elementen
+% erfolgt binr. uint64 Werte ber intmax('int64') werden abgelehnt
+% (SQLite Integer sind vorzeichenbehaftet).
+% (Siehe Beispiel "sqlite_test_carray.m")
+%
 % Ein Argument darf ein realer numerischer Wert (Skalar oder Array)
 % oder ein String sein. Nichtskalare Werte werden als Vektor vom SQL Datentyp
 % BLOB (uint8) verarbeitet. ( BLOB = (B)inary (L)arge (OB)ject) )
@@ -104,8 +119,9 @@
 %   mksqlite( 'typedBLOBs', 0 ); % Deaktivieren
 %
 % (Siehe auch Beispiel "sqlite_test_bind_typed.m")
-% Typisiert werden nur numerische Arrays und Vektoren. Strukturen, Cellarrays
-% und komplexe Daten mssen vorher konvertiert werden. Matlab ist in der
+% Typisiert werden numerische und logische Arrays, seit Version 2.6 auch
+% komplexe Arrays und dnnbesetzte (sparse) Matrizen. Strukturen und
+% Cellarrays mssen vorher konvertiert werden. Matlab ist in der
 % Lage diese Konvertierung durch undokumentierte Funktionen zu bernehmen:
 % getByteStreamFromArray() und getArrayFromByteStream(). Die Funktionalitt
 % wird durch folgenden Befehl aktiviert:
@@ -130,12 +146,64 @@
 %
 %   mksqlite( 'compression_check', 0 ); % Check deaktivieren (1=aktivieren)
 %
+% Vor dem Komprimieren ordnet BLOSC die Bytes der Elemente um (shuffle).
+% Die Kompressoren "lz4+bit", "lz4hc+bit" und "blosclz+bit" ordnen statt
+% dessen die Bits um (bitshuffle), was Integer-Daten oder quantisierte Werte
+% mit nur wenigen signifikanten Bits oft besser packt. Untersttzt die CPU
+% AVX2-Befehle, werden diese zum Umordnen verwendet. Der Befehlssatz kann
+% eingeschrnkt werden (z.B. fr Benchmarks):
+%
+%   mksqlite( 'compression_simd', 'sse2' ); % 'auto', 'avx2', 'sse2' oder 'generic'
+%
+% (siehe sqlite_test_bitshuffle.m)
+%
+% BLOSC komprimiert die Daten blockweise, die Blockgre wird aus den (beim
+% Start ermittelten) Cache-Gren der CPU abgeleitet. Sie kann auch fr einen
+% Kompressor und eine Elementgre (in Bytes) festgelegt werden:
+%
+%   mksqlite( 'compression_blocksize', 'lz4', 8, 256*1024 ); % 0=automatisch
+%
+% Ein Beispiel-Array kann mit verschiedenen Blockgren komprimiert werden,
+% um Kompressionsrate und Geschwindigkeit (MB/s) zu vergleichen. Mit apply=1
+% wird die ausgewhlte Blockgre (die schnellste innerhalb von 5% der besten
+% Rate) fr die Elementgre des Arrays eingestellt:
+%
+%   res = mksqlite( 'compression_tune', 'lz4', 9, sample, apply );
+%
+% (siehe sqlite_test_blocksize.m)
+%
+% Logische Arrays (Masken) knnen statt mit einem Byte je Element auch mit
+% 8 Elementen je Byte gespeichert werden. Masken mit nur wenigen Wechseln
+% zwischen true und false werden dann als Lauflngen abgelegt:
+%
+%   mksqlite( 'bitpack_logicals', 1 ); % Aktivieren (0=deaktivieren, Standard)
+%
+% Sehr groe typisierte BLOBs knnen auerhalb der Datenbank, in Segmentdateien
+% neben der Datenbankdatei ("<dbfile>-seg0000", ...) gespeichert werden. Die
+% Datenbank enthlt dann nur einen kleinen Verweis, der beim Abrufen aufgelst
+% (in den Speicher eingeblendet) wird. Damit sind BLOBs nicht mehr auf 2 GB
+% begrenzt. Die Einstellung gilt je Datenbank und wird beim Schlieen zurckgesetzt:
+%
+%   mksqlite( dbid, 'sidecar', nBytes ); % typisierte BLOBs >= nBytes (0=aus)
+%
+% Segmentdateien werden nur erweitert, gelschte oder genderte BLOBs bleiben
+% darin erhalten. Segmente, auf die keine Tabelle mehr verweist, werden mit
+%
+%   n = mksqlite( dbid, 'sidecar gc' ); % n: Anzahl gelschter Segmente
+%
+% gelscht. Die Datenbank darf whrenddessen nicht anderweitig verwendet werden.
+% Die Segmentdateien mssen zusammen mit der Datenbankdatei kopiert werden.
+% (siehe sqlite_test_sidecar.m)
+%
 % Kompatibilitt:
 % Komprimiert abgelegte BLOBs knnen Sie nicht mit einer lteren Version von
 % mksqlite abrufen, es kommt dann zu einer Fehlermeldung. Unkomprimierte BLOBs
 % hingegen knnen auch mit der Vorgngerversion abgerufen werden.
 % Mit der Vorgngerversion gespeicherte BLOBs knnen Sie natrlich auch mit dieser
-% Version abrufen.
+% Version abrufen. Gleiches gilt fr komplexe Arrays, dnnbesetzte Matrizen und
+% bitweise gepackte logische Arrays als typisierte BLOBs.
+% Typisierte BLOBs, die auf Plattformen mit anderer Byte-Reihenfolge (big endian)
+% gespeichert wurden, werden beim Lesen automatisch konvertiert.
 %
 % Anmerkungen zur Kompressionsrate:
 % Die erzielbaren Kompressionsraten hngen stark vom Inhalt der Variablen ab.
@@ -172,14 +240,219 @@
 % [result,rowcount,colnames] = mksqlite(...)
 %
 % Per Voreinstellung wird ein Strukturarray (array of structs) zurckgegeben.
-% Wahlweise sind insgesamt drei Rckgabetypen mglich:
+% Wahlweise sind insgesamt vier Rckgabetypen mglich:
 % (0) array of structs (Vorgabe)
 % (1) struct of arrays
 % (2) cell matrix
+% (3) Ergebnis Handle (siehe unten)
 % Die Voreinstellung (n=0) kann mit folgendem Befehl gendert werden:
 % mksqlite( 'result_type', n );
 % (see sqlite_test_result_types.m)
 %
+% Spalten mit typisierten BLOBs werden bei einem Struct aus Arrays (1) als Cell
+% Arrays zurckgegeben. Haben alle BLOBs einer Spalte dieselbe Klasse und
+% Elementanzahl, knnen sie stattdessen zu einer Matrix gestapelt werden,
+% eine Spalte je Zeile. Jeder BLOB wird direkt in diese Matrix entpackt:
+% mksqlite( 'stack_blobs', n );
+% (0) Cell Arrays (Standard)
+% (1) Matrix, Cell Array falls BLOBs nicht bereinstimmen
+% (2) Matrix, Fehler falls BLOBs nicht bereinstimmen
+% Komplexe, dnnbesetzte und bitweise gepackte Arrays sowie gestreamte
+% Variablen werden nicht gestapelt.
+% (siehe sqlite_test_stack_blobs.m)
+%
+% Zuletzt verwendete Statements werden je Datenbank vorbereitet (zusammen mit
+% den aus den Spaltennamen gebildeten Feldnamen) aufbewahrt, sodass wiederholte
+% Abfragen mit gleichem SQL Text nicht erneut bersetzt werden mssen.
+% Die Anzahl zwischengespeicherter Statements (Vorgabe 16, 0=aus) wird mit
+% folgendem Befehl festgelegt:
+% mksqlite( 'stmt_cache', n );
+%
+% Ein Statement kann auch ausdrcklich vorbereitet und dann ber sein Handle
+% wiederholt ausgefhrt werden. Der SQL Text wird dabei weder erneut
+% konvertiert noch bersetzt, Parameter- und Spaltennamen werden einmalig
+% ermittelt:
+% [s, info] = mksqlite( dbid, 'prepare', 'INSERT INTO t VALUES (?,?)' );
+% mksqlite( 'exec', s, 1, 'abc' );   % Ergebnisse wie bei einer Abfrage
+% mksqlite( 'finalize', s );
+% info (optional) enthlt die Parameternamen (info.params, leer fr
+% unbenannte Parameter) und die Spaltennamen (info.columns). Das Handle
+% gehrt zu der Datenbank, mit der es vorbereitet wurde; wird diese
+% geschlossen, werden alle ihre Statements freigegeben.
+% (siehe sqlite_test_prepare.m)
+%
+% Ein Skript aus mehreren SQL Anweisungen (z.B. eine Schemamigration) wird
+% mit einem Aufruf ausgefhrt. Das Skript wird als Text oder als Name einer
+% (UTF-8 kodierten) Skriptdatei bergeben:
+% [changes, times, stmts] = mksqlite( dbid, 'exec_script', script, transaction );
+% Ist transaction 1 (Vorgabe 0), luft das Skript in einer Transaktion, die
+% zurckgerollt wird, wenn eine Anweisung fehlschlgt. Ergebniszeilen werden
+% verworfen. changes enthlt die Anzahl genderter Zeilen, times die
+% Ausfhrungszeiten in Sekunden und stmts (CellArray) den Text jeder Anweisung.
+% (siehe sqlite_test_exec_script.m)
+%
+% SQLite ist mit den Erweiterungen fr Volltextsuche (FTS5) und JSON1 erstellt.
+% Ein Volltextindex auf Textspalten einer Tabelle wird erzeugt mit
+%   fts_table = mksqlite( dbid, 'fts_index', table, columns );
+% columns ist ein Cell-Array der Namen oder ein durch Kommata getrennter
+% String. Der Index (Tabelle <table>_fts) verweist auf den Text der Tabelle,
+% statt ihn zu kopieren, und wird durch Trigger aktuell gehalten. Ein
+% erneuter Aufruf ersetzt den Index.
+%   [rowids, ranks] = mksqlite( dbid, 'fts_search', table, query, limit );
+% liefert die rowids passender Zeilen, beste bm25 Bewertung zuerst (kleinere
+% Werte sind besser). query verwendet die FTS5 Syntax (z.B. 'quick AND
+% title:fox*'), limit ist optional.
+% JSON Funktionen wie json_extract() sind deterministisch und lassen sich
+% daher ber Ausdrucksindizes indizieren:
+%   CREATE INDEX meta_k ON t( json_extract(meta, '$.k') )
+% (siehe sqlite_test_fts_json.m)
+%
+% Auf mehrere Datenbankdateien (Shards, z.B. eine pro Tag) verteilte Daten
+% knnen gemeinsam abgefragt werden. Die Shards werden ber ein
+% Dateimuster schreibgeschtzt geffnet:
+%   [count, files] = mksqlite( 'shards_open', pattern, threads );
+% threads begrenzt die Anzahl der Threads (Vorgabe: Anzahl der CPUs).
+%   [result, rows] = mksqlite( 'shards_query', sql, params, merge );
+% fhrt die Abfrage parallel auf allen Shards aus und liefert die Zeilen
+% aller Shards als ein Ergebnis (in Reihenfolge der Shards). params ist ein
+% optionales CellArray mit Parameterwerten. merge ist eine optionale
+% Angabe zur Zusammenfhrung:
+%   'order by col1 desc, col2'      fgt die (gleich sortierten) Zeilen der
+%                                   Shards zu einem sortierten Ergebnis
+%   'combine key, sum, count, max'  fasst Zeilen mit gleichen key Spalten
+%                                   zusammen, ein Schlsselwort je Spalte
+%                                   (key, sum, count, min, max), ein
+%                                   berlauf einer Integer Summe ist ein
+%                                   Fehler (wie bei sum())
+% mksqlite('shards_close') schliet alle Shards. mksqlites eigene SQL
+% Funktionen (z.B. regex, bdcratio) stehen Shard-Abfragen nicht zur Verfgung.
+% (siehe sqlite_test_shards.m)
+%
+% Eine Datenbank wird seitenweise in einem Hintergrund-Thread kopiert,
+% whrend sie weiter benutzt werden kann (Online Backup):
+%   job = mksqlite( dbid, 'backup', dest, pages_per_step, sleep_ms );
+% dest ist die Zieldatei (wird berschrieben). Jeder Schritt kopiert
+% pages_per_step Seiten (Vorgabe 100, -1 kopiert alles auf einmal), gefolgt
+% von einer Pause von sleep_ms Millisekunden (Vorgabe 10). job ist ein
+% Handle, um den Fortschritt abzufragen oder das Backup abzubrechen:
+%   status = mksqlite( 'backup_status', job );
+%   status = mksqlite( 'backup_cancel', job );
+% status ist eine Struktur mit den Feldern state ('running', 'done',
+% 'failed' oder 'cancelled'), progress (0..1), remaining, pagecount und
+% message. Das Handle wird freigegeben, sobald ein Endzustand geliefert wurde.
+% Fr Datenbanken, die whrend des Backups beschrieben werden, sollte der
+% WAL Modus verwendet werden (PRAGMA journal_mode=WAL): die Kopie ist ein
+% Schnappschuss und Schreibzugriffe werden nicht blockiert. Im Rollback
+% Journal Modus startet jeder Schreibzugriff die Kopie neu.
+% In-Memory Datenbanken werden auf einmal kopiert.
+% Umgekehrt wird eine Datei in eine (z.B. In-Memory) Datenbank geladen:
+%   pages = mksqlite( dbid, 'restore', src );
+% Sidecar Segmente, auf die die Kopie verweist, werden von beiden Befehlen
+% mitkopiert (dest-seg0000, ...). Eine Datenbank mit Sidecar Verweisen kann
+% nicht in eine In-Memory Datenbank geladen werden.
+% (siehe sqlite_test_backup.m)
+%
+% Im WAL Modus fhrt SQLite einen Checkpoint bei dem Commit aus, durch den
+% das WAL 1000 Seiten berschreitet, was diesen Commit verzgert.
+% Stattdessen kann ein Checkpointer-Thread mit eigener Verbindung diese
+% Aufgabe bernehmen (je Datenbank):
+%   stats = mksqlite( dbid, 'wal_checkpointer', threshold, interval_ms );
+% Ein passiver Checkpoint luft, sobald threshold WAL Frames (Seiten) noch
+% nicht zurckgeschrieben sind. Der Thread wird alle interval_ms
+% Millisekunden aktiv (Vorgabe 100). Finden keine Commits statt, wird das
+% WAL neu gestartet und nach einer Sekunde gekrzt. Fllt der Thread hinter
+% einem stndig schreibenden Prozess zurck und berschreitet das WAL
+% 8 * threshold Frames, schreibt der Schreibende es nach seinem Commit
+% zurck (passiv, als forced gezhlt), was die Gre des WAL begrenzt. threshold 0
+% beendet den Checkpointer und stellt den zuvor gltigen automatischen
+% Checkpoint wieder her. stats ist eine Struktur mit den Feldern running,
+% threshold, interval_ms, wal_frames, backlog (von Lesern zurckgehaltene
+% Frames), checkpointed, passive, restart, truncate, forced, busy,
+% last_ms, max_ms und total_ms. Ohne Argumente wird nur stats
+% zurckgegeben.
+% Die Datenbank muss eine Datei im WAL Modus sein (PRAGMA journal_mode=WAL).
+% Ein Checkpoint wird manuell ausgefhrt mit
+%   [wal_frames, checkpointed, busy] = mksqlite( dbid, 'wal_checkpoint', mode );
+% mode ist 'passive' (Vorgabe), 'full', 'restart' oder 'truncate'.
+% (siehe sqlite_test_wal_checkpointer.m)
+%
+% Mit dem Rckgabetyp 3 liefert eine Abfrage einen Handle statt MATLAB
+% Arrays. Die Zeilen bleiben im nativen Speicher, nur die angeforderten
+% Spalten (und Zeilen) werden umgewandelt, was bei breiten Ergebnissen Zeit
+% und Speicher spart:
+%   s    = mksqlite( 'result_cols', handle, names, rows );
+%   info = mksqlite( 'result_info', handle );
+%   ok   = mksqlite( 'result_free', handle );
+% names ist ein Cell Array oder eine kommagetrennte Liste von Spaltennamen
+% (leer fr alle), rows enthlt Indizes oder eine logische Maske (leer
+% fr alle). s ist ein struct of arrays (wie bei Rckgabetyp 1). info
+% enthlt die Felder rows, columns, sqlnames und bytes. Nicht freigegebene
+% Ergebnisse berschreiten irgendwann ein Speicherbudget (1 GiB), dann
+% werden die am lngsten nicht benutzten Ergebnisse freigegeben und ihre
+% Handles ungltig:
+%   [old_budget, used, count] = mksqlite( 'result_budget', bytes );
+% Die Klasse mksqlite_result kapselt einen Handle und gibt ihn beim
+% Lschen frei:
+%   res = mksqlite_result( dbid, 'SELECT * FROM tbl' );
+%   x   = res.col( 'x', res.col( 'id' ) > 100 );
+% (siehe sqlite_test_lazy_result.m)
+%
+% nderungen an Zeilen einer Datenbankverbindung werden aufgezeichnet mit
+%   active = mksqlite( dbid, 'track_changes', tables, capacity );
+% tables ist ein Cell Array oder eine kommagetrennte Liste von Tabellennamen,
+% '*' zeichnet alle Tabellen auf, 0 beendet die Aufzeichnung. nderungen
+% werden mit dem Commit ihrer Transaktion gespeichert, bis zu capacity
+% (Vorgabe 65536) nderungen, bis sie abgeholt werden mit
+%   [changes, lost] = mksqlite( dbid, 'changes' );
+% changes ist eine Struktur mit den Spaltenvektoren table (Cell), op (Cell
+% mit 'INSERT', 'UPDATE' oder 'DELETE') und rowid, die lteste zuerst.
+% lost zhlt die inzwischen verworfenen nderungen, da der Puffer voll
+% war. Durch ROLLBACK TO einen Savepoint oder eine fehlschlagende Anweisung
+% rckgngig gemachte nderungen entfallen. Nur nderungen dieser
+% Verbindung werden erfasst. Tabellen WITHOUT ROWID und durch REPLACE
+% gelschte Zeilen werden nicht gemeldet, bei genderter rowid wird nur
+% die neue gemeldet.
+% (siehe sqlite_test_track_changes.m)
+%
+% Datenbanken werden inkrementell ber Changesets abgeglichen (SQLite
+% Session Extension). Eine Session zeichnet die nderungen an Tabellen mit
+% PRIMARY KEY auf:
+%   active = mksqlite( dbid, 'session_start', tables );
+% tables ist ein Cell Array oder eine kommagetrennte Liste, '*' (Vorgabe)
+% fr alle Tabellen, 0 beendet die Session. Das Changeset enthlt alle
+% nderungen seit dem Start der Session, sein Abholen startet sie neu:
+%   [changeset, bytes] = mksqlite( dbid, 'session_changeset', level );
+% changeset ist ein uint8 Zeilenvektor, fr level 1..9 ein mit blosc
+% (lz4) komprimierter typisierter BLOB. bytes ist die unkomprimierte
+% Gre. Es kann nicht abgeholt werden, solange eine Transaktion offen ist
+% (nicht festgeschriebene nderungen). Ein Changeset (komprimiert oder
+% nicht) wird in einer Transaktion auf eine Datenbank mit denselben
+% Tabellen angewendet:
+%   [conflicts, counts] = mksqlite( dbid2, 'changeset_apply', changeset, policy );
+% policy lst in dbid2 genderte oder fehlende Zeilen auf: 'abort'
+% (Vorgabe, keine nderung wird bernommen, Fehler), 'omit' (Konflikte
+% werden bersprungen) oder 'replace' (Zeilen werden berschrieben).
+% counts enthlt die Konflikte nach Art (data, notfound, conflict,
+% constraint, foreign_key).
+% (siehe sqlite_test_changeset.m)
+%
+% Indizes fr langsame Abfragen schlgt vor
+%   [s, statements] = mksqlite( dbid, 'index_advisor', statements, timed );
+% statements ist ein Cell Array von SQL Anweisungen oder eine einzelne,
+% bei leerer oder fehlender Angabe die letzten 32 auf dbid ausgefhrten
+% Abfragen. Spalten aus WHERE, ON, USING, ORDER BY und GROUP BY werden zu
+% Kandidaten fr Indizes kombiniert, die auf einer Kopie des Schemas im
+% Speicher mit den Kardinalitten der Daten (sqlite_stat1, gezhlt falls
+% nicht analysiert) angelegt werden. Die Abfrageplne mit und ohne
+% Kandidat werden nach den besuchten Zeilen verglichen. s ist ein Struct
+% Array, grter Nutzen zuerst, mit den Feldern create (CREATE INDEX
+% Anweisung), table, columns, statements (Indizes der beschleunigten
+% Anweisungen), speedup (geschtzt), measured und plan (Abfrageplan mit
+% Index). Mit timed = 1 werden die Anweisungen (SELECT ohne Parameter) mit
+% und ohne Index ausgefhrt, der danach zurckgerollt wird. measured ist
+% das Verhltnis der Laufzeiten (NaN ohne Zeitmessung).
+% (siehe sqlite_test_index_advisor.m)
+%
 % =======================================================================
 %
 % Builtin SQL Funktionen:
@@ -207,6 +480,13 @@
 %     repstr gebildet.
 %     (mksqlite verwendet die perl kompatible regex engine "DEELX".
 %     Weiterfhrende Informationen siehe www.regexlab.com oder wikipedia)
+%     Muster ohne Rckverweise, Lookarounds und Modifizierer werden mit
+%     gleichem Ergebnis in linearer Zeit geprft, Zeilen ohne ein Literal
+%     des Musters werden schnell bersprungen. Ein konstantes Muster wird
+%     nur einmal je Anweisung bersetzt.
+%   * str REGEXP pattern:
+%     Operator-Schreibweise, liefert 1 wenn str eine bereinstimmung mit
+%     pattern enthlt, sonst 0.
 %   * md5(x):
 %     Es wird der MD5 Hashing Wert von x berechnet und ausgegeben.
 %   * bdcpacktime(x):
@@ -217,6 +497,39 @@
 %   * bdcratio(x):
 %     Berechnet den Kompressionsfaktor, bezogen auf x und die derzeit
 %     eingestellte Kompression.
+%   * blob_nnz(x):
+%     Zhlt die von Null verschiedenen Elemente des typisierten BLOBs x.
+%     Bitweise gepackte logische Arrays werden dazu nicht entpackt.
+%   * carray(?):
+%     Tabellenwertige Funktion, liefert die Elemente des an ihren Parameter
+%     gebundenen Vektors als Spalte "value" (siehe "Parameter binding").
+%   * approx_count_distinct(x):
+%     Aggregat, schtzt COUNT(DISTINCT x) mit einem HyperLogLog Sketch
+%     (16 KiB, etwa 0,8% Fehler) in einem Durchlauf ohne Sortierung.
+%   * approx_quantile(x,p):
+%     Aggregat, schtzt das p-Quantil (0..1) von x mit einem t-Digest.
+%   * hll_sketch(x), tdigest_sketch(x):
+%     Aggregate, liefern den Sketch selbst als typisierten BLOB (uint8 Vektor).
+%   * sketch_merge(s):
+%     Aggregat, vereinigt Sketches gleicher Art (z.B. Tages-Sketches).
+%   * sketch_count(s), sketch_quantile(s,p):
+%     Werten einen Sketch aus: Anzahl verschiedener Werte (hll_sketch) bzw.
+%     Anzahl der Werte (tdigest_sketch), p-Quantil (tdigest_sketch).
+%     Beispiel, verschiedene Benutzer eines Monats aus Tages-Sketches:
+%       SELECT sketch_count(sketch_merge(users)) FROM daily WHERE month=?
+%     (siehe sqlite_test_sketches.m)
+%   * bloom_build(x,fp_rate):
+%     Aggregat, liefert einen Bloom Filter aller Werte x als typisierten
+%     BLOB (uint8 Vektor). fp_rate (0..1) ist die Rate falsch positiver
+%     Treffer.
+%   * bloom_contains(filter,x):
+%     Liefert 1 wenn x im Filter enthalten sein kann, 0 wenn es sicher
+%     nicht enthalten ist. Ein als Parameter gebundener Filter wird nur
+%     einmal je Anweisung dekodiert. So lassen sich Tabellen vor einem Join
+%     oder vor dem Kopieren in eine andere (Shard) Datenbank vorfiltern:
+%       f = mksqlite( 'SELECT bloom_build(value, 0.01) AS f FROM carray(?)', keys );
+%       mksqlite( 'SELECT * FROM big WHERE bloom_contains(?, key)', f.f );
+%     (siehe sqlite_test_bloom.m)
 %
 % Die Verwendung von regex in Kombination mit parametrischen Parametern bieten eine
 % besonders effiziente Mglichkeit komplexe Abfragen auf Textinhalte anzuwenden.
@@ -226,6 +539,19 @@
 %
 % (siehe auch test_regex.m fr weitere Beispiele...)
 %
+% Ein regex Filter muss jede Zeile prfen. Beginnt das Muster mit "^" und
+% einem festen Prfix, kann ein Index auf der Spalte die Zeilen eingrenzen:
+%   [where, lower, upper] = mksqlite( 'regexp_where', column, pattern, type );
+% liefert die WHERE Klausel "(column >= lower AND column < upper AND
+% column REGEXP pattern)" (lower und upper werden aus dem Prfix gebildet,
+% z.B. 'ABC' und 'ABD' fr '^ABC[0-9]+'). type ist der deklarierte Typ
+% der Spalte (z.B. 'TEXT' oder 'VARCHAR(20)'). Zahlen werden vor jedem
+% Text einsortiert, daher wird der Bereich nur bei TEXT Affinitt von type
+% ergnzt (enthlt 'CHAR', 'CLOB' oder 'TEXT', aber nicht 'INT'); ohne
+% type oder ein solches Prfix wird nur der REGEXP Ausdruck geliefert. Der
+% Bereich gilt fr Spalten mit BINARY (oder NOCASE) Sortierfolge.
+% (siehe sqlite_test_regexp_where.m)
+%
 % =======================================================================
 %
 % Application-defined Funktionen:
@@ -75,6 +75,20 @@
 % If it is intended, that implicit calls with the same command and the remaining
 % arguments shall be done, so called parameter wrapping must be activated:
 % mksqlite('param_wrapping', 0|1)
+%
+% A vector can be passed as a list of values with the table-valued function
+% carray(), e.g. for IN clauses or joins:
+%  ids = int32( [3 17 42] );
+%  query = mksqlite( 'select * from AddressBook where id in carray(?)', ids );
+%  query = mksqlite( 'select * from AddressBook where city in carray(?)', ...
+%                    {'Munich', 'Berlin'} );
+% Real numeric and logical vectors are read in place, without a copy.  A
+% cell array of strings passed as the only argument is taken as one value
+% for carray(), unless parameter wrapping is active.  Lookups of a single
+% value in vectors with 64 or more elements use binary search. uint64
+% values above intmax('int64') are rejected (SQLite integers are signed).
+% (see sqlite_test_carray.m)
+%
 % An argument may be a real value (scalar or array) or a string.
 % Non-scalar values are treated as a BLOB (unit8) SQL datatype.
 % ( BLOB = (B)inary (L)arge (OB)ject) )
@@ -99,8 +113,9 @@
 %   mksqlite( 'typedBLOBs', 0 ); % deactivate
 %
 % (see also the example "sqlite_test_bind_typed.m")
-% Type conversion only works with numeric arrays and vectors.  structs,
-% cell arrays and complex data must be converted beforehand.  Matlab
+% Type conversion works with numeric and logical arrays, including complex
+% arrays and sparse matrices (stored natively since version 2.6).  structs
+% and cell arrays must be converted beforehand.  Matlab
 % can do this conversion through undocumented functions:
 % getByteStreamFromArray() and getArrayFromByteStream().
 % This functionality is activated by following command:
@@ -124,12 +139,64 @@
 %
 %   mksqlite( 'compression_check', 0 ); % deactive the check (1=activate)
 %
+% Before compression, BLOSC reorders the bytes of the elements (shuffle).
+% The compressors "lz4+bit", "lz4hc+bit" and "blosclz+bit" reorder the
+% bits instead (bitshuffle), which may pack integer data or quantized
+% values with only a few significant bits better.  The shuffle uses AVX2
+% instructions, if the CPU supports them.  The instruction set may be
+% limited (e.g. for benchmarks):
+%
+%   mksqlite( 'compression_simd', 'sse2' ); % 'auto', 'avx2', 'sse2' or 'generic'
+%
+% (see sqlite_test_bitshuffle.m)
+%
+% BLOSC compresses the data in blocks, whose size is derived from the cache
+% sizes of the CPU (detected at startup).  The block size may be set for a
+% compressor and an element size (in bytes) as well:
+%
+%   mksqlite( 'compression_blocksize', 'lz4', 8, 256*1024 ); % 0=automatic
+%
+% A sample array can be compressed with several block sizes to compare
+% compression ratio and speed (MB/s).  With apply=1 the selected block size
+% (fastest one within 5% of the best ratio) is set for the sample's element
+% size:
+%
+%   res = mksqlite( 'compression_tune', 'lz4', 9, sample, apply );
+%
+% (see sqlite_test_blocksize.m)
+%
+% Logical arrays (masks) may be stored with 8 elements per byte instead of
+% one byte per element.  Masks with only a few changes between true and
+% false are stored as run lengths then:
+%
+%   mksqlite( 'bitpack_logicals', 1 ); % activate (0=deactivate, default)
+%
+% Very large typed BLOBs may be stored outside the database, in segment
+% files next to the database file ("<dbfile>-seg0000", ...).  The database
+% only holds a small reference then, which is resolved (memory mapped) when
+% fetched.  Thus BLOBs aren't limited to 2 GB anymore.  The setting applies
+% to one database and is reset when it's closed:
+%
+%   mksqlite( dbid, 'sidecar', nBytes ); % store typed BLOBs >= nBytes (0=off)
+%
+% Segment files are append only, so deleted or updated BLOBs remain.
+% Segments no more referenced by any table are deleted with
+%
+%   n = mksqlite( dbid, 'sidecar gc' ); % n: number of deleted segments
+%
+% Don't use the database from elsewhere meanwhile.  The segment files have
+% to be copied along with the database file.
+% (see sqlite_test_sidecar.m)
+%
 %
 % Compatibility:
 %  Stored compressed blobs cannot be retrieved with older versions of mqslite,
 %  this will trigger an error report.  In contrast, uncompressed BLOBS can be
 %  retrieved with older versions.  Of course BLOBs stored with older versions
-%  can be retrieved with this version.
+%  can be retrieved with this version.  This also applies to complex arrays,
+%  sparse matrices and bit packed logical arrays stored as typed BLOBs.
+%  Typed BLOBs stored on big endian platforms are converted when read on
+%  little endian platforms and vice versa.
 %
 % Remarks on compression rate:
 %   The achievable compression rates depend strongly on the contents of the
@@ -164,14 +231,200 @@
 % [result,rowcount,colnames] = mksqlite(...)
 %
 % Per default an array of structs will be returned for table queries.
-% You can decide between three differet kinds of result types:
+% You can decide between four differet kinds of result types:
 % (0) array of structs (default)
 % (1) struct of arrays
 % (2) cell matrix
+% (3) result handle (see below)
 % You can change the default setting (n=0) with following call:
 % mksqlite( 'result_type', n );
 % (see sqlite_test_result_types.m)
 %
+% Columns holding typed BLOBs are returned as cell arrays in a struct of
+% arrays (1).  If all BLOBs of a column share class and number of elements,
+% they may be stacked into one matrix instead, one column per row.  Each
+% BLOB is unpacked directly into this matrix:
+% mksqlite( 'stack_blobs', n );
+% (0) cell arrays (default)
+% (1) matrix, cell array if BLOBs don't match
+% (2) matrix, error if BLOBs don't match
+% Complex, sparse and bit packed arrays as well as streamed variables are
+% not stacked.
+% (see sqlite_test_stack_blobs.m)
+%
+% Recently used statements are kept prepared (together with the field
+% names derived from their column names) for each database, so repeated
+% queries with the same SQL text don't need to be parsed again.
+% The number of cached statements (default 16, 0=off) can be set with:
+% mksqlite( 'stmt_cache', n );
+%
+% A statement can also be prepared explicitly and then be executed
+% repeatedly by its handle.  The SQL text is neither converted nor parsed
+% again, parameter and column names are resolved once:
+% [s, info] = mksqlite( dbid, 'prepare', 'INSERT INTO t VALUES (?,?)' );
+% mksqlite( 'exec', s, 1, 'abc' );   % same results as a query
+% mksqlite( 'finalize', s );
+% info (optional) holds the parameter names (info.params, empty for
+% unnamed parameters) and the column names (info.columns).  The handle
+% refers to the database it was prepared with; closing the database
+% finalizes all its statements.
+% (see sqlite_test_prepare.m)
+%
+% A script of several SQL statements (e.g. a schema migration) is run by
+% one call.  The script is given as text, or as name of a (UTF-8 encoded)
+% script file:
+% [changes, times, stmts] = mksqlite( dbid, 'exec_script', script, transaction );
+% If transaction is 1 (default 0), the script runs inside one transaction,
+% which is rolled back if any statement fails.  Result rows are discarded.
+% changes holds the number of changed rows, times the execution times in
+% seconds and stmts (cell array) the text of each statement.
+% (see sqlite_test_exec_script.m)
+%
+% SQLite is built with the full text search (FTS5) and JSON1 extensions.
+% A full text index on text columns of a table is created by
+%   fts_table = mksqlite( dbid, 'fts_index', table, columns );
+% columns is a cell array of names or a comma separated string. The index
+% (table <table>_fts) refers to the table's text instead of storing a copy
+% and is kept up to date by triggers. Calling it again replaces the index.
+%   [rowids, ranks] = mksqlite( dbid, 'fts_search', table, query, limit );
+% returns the rowids of matching rows, best bm25 rank first (lower rank
+% is better). query uses the FTS5 syntax (e.g. 'quick AND title:fox*'),
+% limit is optional.
+% JSON functions like json_extract() are deterministic, so expression
+% indexes make them indexable:
+%   CREATE INDEX meta_k ON t( json_extract(meta, '$.k') )
+% (see sqlite_test_fts_json.m)
+%
+% Data split into several database files (shards, e.g. one per day) can be
+% queried at once. The shards are opened read-only by a file pattern:
+%   [count, files] = mksqlite( 'shards_open', pattern, threads );
+% threads limits the number of worker threads (default: number of CPUs).
+%   [result, rows] = mksqlite( 'shards_query', sql, params, merge );
+% runs the query on all shards in parallel and returns the rows of all
+% shards as one result (in shard order). params is an optional cell array
+% of parameter values. merge is an optional merge specification:
+%   'order by col1 desc, col2'      merges the (equally ordered) rows of
+%                                   each shard into one ordered result
+%   'combine key, sum, count, max'  combines the rows with equal key
+%                                   columns, one keyword per column (key,
+%                                   sum, count, min, max), an integer sum
+%                                   overflow is an error (as sum())
+% mksqlite('shards_close') closes all shards. mksqlite's own SQL functions
+% (e.g. regex, bdcratio) are not available to shard queries.
+% (see sqlite_test_shards.m)
+%
+% A database is copied page by page in a background thread, while it
+% remains in use (online backup):
+%   job = mksqlite( dbid, 'backup', dest, pages_per_step, sleep_ms );
+% dest is the destination file (overwritten). Each step copies
+% pages_per_step pages (default 100, -1 copies all at once), followed by a
+% pause of sleep_ms milliseconds (default 10). job is a handle to poll the
+% progress or to cancel the backup:
+%   status = mksqlite( 'backup_status', job );
+%   status = mksqlite( 'backup_cancel', job );
+% status is a struct with the fields state ('running', 'done', 'failed' or
+% 'cancelled'), progress (0..1), remaining, pagecount and message. The
+% handle is released when a final state has been returned.
+% Use WAL mode (PRAGMA journal_mode=WAL) for databases written during the
+% backup: the copy is a snapshot and writers aren't blocked. In rollback
+% journal mode each write restarts the copy. In-memory databases are
+% copied at once.
+% The other way round, a file is restored into an (e.g. in-memory) database:
+%   pages = mksqlite( dbid, 'restore', src );
+% Sidecar segments referenced by the copy are copied along by both commands
+% (dest-seg0000, ...). A database holding sidecar references can't be
+% restored into an in-memory database.
+% (see sqlite_test_backup.m)
+%
+% In WAL mode SQLite checkpoints on the commit that lets the WAL exceed
+% 1000 pages, which delays this commit. A checkpointer thread with its own
+% connection takes over instead (per database):
+%   stats = mksqlite( dbid, 'wal_checkpointer', threshold, interval_ms );
+% A passive checkpoint runs, when threshold WAL frames (pages) are not yet
+% checkpointed. The thread wakes every interval_ms milliseconds (default
+% 100). When no commits happen, the WAL is restarted and truncated after
+% one second. If the thread falls behind a busy writer and the WAL exceeds
+% 8 * threshold frames, the writer checkpoints it after its commit
+% (passive, counted as forced), which bounds the WAL size. threshold 0 stops the
+% checkpointer and restores the automatic checkpoint in effect before.
+% stats is a struct with the fields running, threshold, interval_ms,
+% wal_frames, backlog (frames held back by readers), checkpointed,
+% passive, restart, truncate, forced, busy, last_ms, max_ms and total_ms.
+% Without arguments only stats are returned.
+% The database must be a file in WAL mode (PRAGMA journal_mode=WAL).
+% A checkpoint is run manually by
+%   [wal_frames, checkpointed, busy] = mksqlite( dbid, 'wal_checkpoint', mode );
+% mode is 'passive' (default), 'full', 'restart' or 'truncate'.
+% (see sqlite_test_wal_checkpointer.m)
+%
+% With result type 3 a query returns a handle instead of MATLAB arrays.
+% The rows are kept in native memory and only the columns (and rows)
+% requested are converted, which saves time and memory for wide results:
+%   s    = mksqlite( 'result_cols', handle, names, rows );
+%   info = mksqlite( 'result_info', handle );
+%   ok   = mksqlite( 'result_free', handle );
+% names is a cell array or a comma separated list of column names (empty
+% for all), rows holds indices or a logical mask (empty for all). s is a
+% struct of arrays (as with result type 1). info holds the fields rows,
+% columns, sqlnames and bytes. Results not released exceed a memory budget
+% (1 GiB) sooner or later, the least recently used results are released
+% then and their handles become invalid:
+%   [old_budget, used, count] = mksqlite( 'result_budget', bytes );
+% The class mksqlite_result wraps a handle and releases it when cleared:
+%   res = mksqlite_result( dbid, 'SELECT * FROM tbl' );
+%   x   = res.col( 'x', res.col( 'id' ) > 100 );
+% (see sqlite_test_lazy_result.m)
+%
+% Row changes of a database connection are tracked by
+%   active = mksqlite( dbid, 'track_changes', tables, capacity );
+% tables is a cell array or a comma separated list of table names, '*'
+% tracks all tables, 0 stops tracking. Changes are kept when their
+% transaction commits, up to capacity (default 65536) changes until taken
+% by
+%   [changes, lost] = mksqlite( dbid, 'changes' );
+% changes is a struct with the column vectors table (cell), op (cell with
+% 'INSERT', 'UPDATE' or 'DELETE') and rowid, oldest first. lost counts the
+% changes dropped meanwhile, since the buffer was full. Changes undone by
+% ROLLBACK TO a savepoint or by a failing statement aren't kept. Only
+% changes made by this connection are seen. Tables WITHOUT ROWID and rows
+% deleted by REPLACE aren't reported, changing the rowid reports the new
+% one only.
+% (see sqlite_test_track_changes.m)
+%
+% Databases are synchronized incrementally by changesets (SQLite session
+% extension). A session records the changes of tables with PRIMARY KEY:
+%   active = mksqlite( dbid, 'session_start', tables );
+% tables is a cell array or a comma separated list, '*' (default) for all
+% tables, 0 stops the session. The changeset holds all changes since the
+% session started, taking it restarts the session:
+%   [changeset, bytes] = mksqlite( dbid, 'session_changeset', level );
+% changeset is a uint8 row vector, for level 1..9 a typed BLOB compressed
+% by blosc (lz4). bytes is the uncompressed size. It can't be taken while
+% a transaction is open (uncommitted changes). A changeset (compressed
+% or not) is applied to a database with the same tables in one transaction:
+%   [conflicts, counts] = mksqlite( dbid2, 'changeset_apply', changeset, policy );
+% policy resolves rows changed or missing in dbid2: 'abort' (default, no
+% change is applied, error), 'omit' (conflicting changes are skipped) or
+% 'replace' (conflicting rows are overwritten). counts holds the conflicts
+% by kind (data, notfound, conflict, constraint, foreign_key).
+% (see sqlite_test_changeset.m)
+%
+% Indexes for slow queries are suggested by
+%   [s, statements] = mksqlite( dbid, 'index_advisor', statements, timed );
+% statements is a cell array of SQL statements or a single one, the last
+% 32 queries run on dbid if empty or omitted. Columns used in WHERE, ON,
+% USING, ORDER BY and GROUP BY are combined into candidate indexes, which
+% are created on an in-memory copy of the schema with the cardinalities
+% of the data (sqlite_stat1, counted if not analyzed). The query plans with
+% and without each candidate are compared by the rows visited. s is a
+% struct array, highest benefit first, with the fields create (CREATE INDEX
+% statement), table, columns, statements (indices of the statements sped
+% up), speedup (estimated), measured and plan (query plan with the index).
+% With timed = 1 the statements (SELECT without parameters) are run with
+% and without the index, which is rolled back afterwards. measured is the
+% ratio of the run times (NaN if not timed).
+% (see sqlite_test_index_advisor.m)
+%
 % =======================================================================
 %
 % Extra SQL functions:
@@ -197,6 +450,12 @@
 %     The return value replaces the value with repstr.
 %     (mksqlite uses the perl-compatible regex engine "DEELX".
 %     Further information can be found at www.regexlab.com or wikipedia)
+%     Patterns without backreferences, lookarounds and modifiers are
+%     matched by a linear-time engine with identical results, rows not
+%     containing a literal of the pattern are skipped quickly. A constant
+%     pattern is compiled only once per statement.
+%   * str REGEXP pattern:
+%     Operator form, returns 1 if str contains a match of pattern, else 0.
 %   * md5(x):
 %     Computes and returns the MD5 hash
 %   * bdcpacktime(x):
@@ -206,6 +465,38 @@
 %   * bdcratio(x):
 %     Computes the compression factor for x, using the currently set
 %     compression method.
+%   * blob_nnz(x):
+%     Counts the nonzero elements of the typed BLOB x. Bit packed logical
+%     arrays are counted without unpacking them.
+%   * carray(?):
+%     Table-valued function, returns the elements of the vector bound to
+%     its parameter as column "value" (see "Parameter binding").
+%   * approx_count_distinct(x):
+%     Aggregate, estimates COUNT(DISTINCT x) by a HyperLogLog sketch
+%     (16 KiB, about 0.8% error), in one pass without sorting.
+%   * approx_quantile(x,p):
+%     Aggregate, estimates the p-quantile (0..1) of x by a t-digest.
+%   * hll_sketch(x), tdigest_sketch(x):
+%     Aggregates, return the sketch itself as typed BLOB (uint8 vector).
+%   * sketch_merge(s):
+%     Aggregate, merges sketches of the same kind (e.g. daily sketches).
+%   * sketch_count(s), sketch_quantile(s,p):
+%     Evaluate a sketch: distinct count (hll_sketch) or number of values
+%     (tdigest_sketch), p-quantile (tdigest_sketch).
+%     Example, distinct users of a month from daily sketches:
+%       SELECT sketch_count(sketch_merge(users)) FROM daily WHERE month=?
+%     (see sqlite_test_sketches.m)
+%   * bloom_build(x,fp_rate):
+%     Aggregate, returns a Bloom filter of all values x as typed BLOB
+%     (uint8 vector). fp_rate (0..1) is the rate of false positives.
+%   * bloom_contains(filter,x):
+%     Returns 1 if x may be in the filter, 0 if it isn't for sure. A filter
+%     bound as parameter is decoded once per statement. Scans can be
+%     reduced this way before a join or before copying rows to another
+%     (shard) database:
+%       f = mksqlite( 'SELECT bloom_build(value, 0.01) AS f FROM carray(?)', keys );
+%       mksqlite( 'SELECT * FROM big WHERE bloom_contains(?, key)', f.f );
+%     (see sqlite_test_bloom.m)
 %
 % The use of regex in combination with parameters offers an
 % especially efficient possibility for complex queries on text contents.
@@ -216,6 +507,19 @@
 %
 % (also see test_regex.m for further examples...)
 %
+% A regex filter has to visit each row. If the pattern begins with "^" and
+% a literal prefix, an index on the column can narrow the rows down:
+%   [where, lower, upper] = mksqlite( 'regexp_where', column, pattern, type );
+% returns the WHERE clause "(column >= lower AND column < upper AND
+% column REGEXP pattern)" (lower and upper are derived from the prefix,
+% e.g. 'ABC' and 'ABD' for '^ABC[0-9]+'). type is the declared type of the
+% column (e.g. 'TEXT' or 'VARCHAR(20)'). Numbers sort before any text, so
+% the range is added only if type gives TEXT affinity (contains 'CHAR',
+% 'CLOB' or 'TEXT', but not 'INT'); without type or such a prefix, only
+% the REGEXP term is returned. The range is valid for columns with BINARY
+% (or NOCASE) collation.
+% (see sqlite_test_regexp_where.m)
+%
 % =======================================================================
 %
 % Application-defined functions:
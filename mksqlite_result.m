@@ -0,0 +1,90 @@
+classdef mksqlite_result < handle
+% mksqlite_result holds a query result in native memory and converts
+% columns to MATLAB arrays on request only (result type 3).
+% Example:
+%   res = mksqlite_result( 'SELECT * FROM wide_table' );
+%   x   = res.col( 'x' );                    % one column
+%   s   = res.cols( {'id', 'name'}, 1:10 );  % some columns of some rows
+%   res.rows                                 % row count
+%   clear res                                % releases the native memory
+
+  properties (SetAccess = private)
+      handle = 0;   % result handle (see mksqlite('result_info', handle))
+  end
+
+  properties (Dependent)
+      rows;         % number of rows
+      columns;      % column names (cell array)
+  end
+
+  methods
+      function obj = mksqlite_result( varargin )
+      % mksqlite_result( [dbid,] sql, [params...] ) runs the query
+      % mksqlite_result( handle ) wraps a handle returned with result type 3
+          if nargin == 1 && isnumeric( varargin{1} )
+              obj.handle = varargin{1};
+              return
+          end
+
+          old_type = mksqlite( 'result_type', 3 );
+          try
+              obj.handle = mksqlite( varargin{:} );
+          catch err
+              mksqlite( 'result_type', old_type );
+              rethrow( err );
+          end
+          mksqlite( 'result_type', old_type );
+      end
+
+      function delete( obj )
+          try
+              mksqlite( 'result_free', obj.handle );
+          catch
+              % module cleared, results already released
+          end
+      end
+
+      function values = col( obj, name, rows )
+      % col( name [, rows] ) returns one column (rows: indices or logical mask)
+          if nargin < 3
+              rows = [];
+          end
+          s = obj.cols( name, rows );
+          values = s.(obj.fieldname( name ));
+      end
+
+      function s = cols( obj, names, rows )
+      % cols( [names [, rows]] ) returns columns as struct of arrays
+          if nargin < 2
+              names = {};
+          end
+          if nargin < 3 || isempty( rows )
+              rows = [];
+          elseif ~islogical( rows )
+              rows = double( rows );
+          end
+          s = mksqlite( 'result_cols', obj.handle, names, rows );
+      end
+
+      function n = get.rows( obj )
+          info = mksqlite( 'result_info', obj.handle );
+          n = info.rows;
+      end
+
+      function c = get.columns( obj )
+          info = mksqlite( 'result_info', obj.handle );
+          c = info.columns;
+      end
+  end
+
+  methods (Access = private)
+      function name = fieldname( obj, name )
+      % MATLAB field name of a column given by its MATLAB or SQL name
+          info = mksqlite( 'result_info', obj.handle );
+          k = find( strcmp( info.sqlnames, name ), 1 );
+          if ~isempty( k ) && ~any( strcmp( info.columns, name ) )
+              name = info.columns{k};
+          end
+      end
+  end
+end
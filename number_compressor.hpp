@@ -30,9 +30,11 @@
 extern "C"
 {
   #include "blosc/blosc.h"
+  #include "blosc/shuffle.h"
 }
 //#include "global.hpp"
 #include "locale.hpp"
+#include "utils.hpp"
 
 /**
  * \name blosc IDs
@@ -42,6 +44,9 @@ extern "C"
 #define BLOSC_LZ4_ID            BLOSC_LZ4_COMPNAME
 #define BLOSC_LZ4HC_ID          BLOSC_LZ4HC_COMPNAME
 #define BLOSC_DEFAULT_ID        BLOSC_BLOSCLZ_COMPNAME
+#define BLOSC_LZ4_BIT_ID        BLOSC_LZ4_COMPNAME     "+bit"
+#define BLOSC_LZ4HC_BIT_ID      BLOSC_LZ4HC_COMPNAME   "+bit"
+#define BLOSC_DEFAULT_BIT_ID    BLOSC_BLOSCLZ_COMPNAME "+bit"
 #define QLIN16_ID               "QLIN16"
 #define QLOG16_ID               "QLOG16"
 /** @} */
@@ -72,7 +77,10 @@ private:
     
     const char*             m_strCompressorType;      ///< name of compressor to use
     compressor_type_e       m_eCompressorType;        ///< enum type of compressor to use
+    const char*             m_strBloscCompressor;     ///< blosc compressor name (without filter suffix)
+    int                     m_iBloscShuffle;          ///< blosc filter (BLOSC_SHUFFLE or BLOSC_BITSHUFFLE)
     int                     m_iCompressionLevel;      ///< compression level (0 to 9)
+    int                     m_iBlocksize;             ///< blosc block size (-1: from table)
 public:
     void*                   m_rdata;                  ///< uncompressed data
     size_t                  m_rdata_size;             ///< size of uncompressed data in bytes
@@ -99,6 +107,7 @@ public:
     {
         m_Allocator   = malloc;  // using C memory allocators
         m_DeAllocator = free;
+        m_iBlocksize  = -1;
 
         // no compression is the default
         setCompressor( COMPRESSOR_DEFAULT_ID, 0 );
@@ -183,6 +192,8 @@ public:
     bool setCompressor( const char *strCompressorType, int iCompressionLevel = -1 )
     {
         compressor_type_e eCompressorType = CT_NONE;
+        const char* strBloscCompressor = NULL;
+        int iBloscShuffle = BLOSC_SHUFFLE;
         
         m_err.clear();
         
@@ -198,14 +209,35 @@ public:
         if( 0 == _strcmpi( strCompressorType, BLOSC_LZ4_ID ) )
         {
             eCompressorType = CT_BLOSC;
+            strBloscCompressor = BLOSC_LZ4_ID;
         }
         else if( 0 == _strcmpi( strCompressorType, BLOSC_LZ4HC_ID ) )
         {
             eCompressorType = CT_BLOSC;
+            strBloscCompressor = BLOSC_LZ4HC_ID;
         }
         else if( 0 == _strcmpi( strCompressorType, BLOSC_DEFAULT_ID ) )
         {
             eCompressorType = CT_BLOSC;
+            strBloscCompressor = BLOSC_DEFAULT_ID;
+        }
+        else if( 0 == _strcmpi( strCompressorType, BLOSC_LZ4_BIT_ID ) )
+        {
+            eCompressorType = CT_BLOSC;
+            strBloscCompressor = BLOSC_LZ4_ID;
+            iBloscShuffle = BLOSC_BITSHUFFLE;
+        }
+        else if( 0 == _strcmpi( strCompressorType, BLOSC_LZ4HC_BIT_ID ) )
+        {
+            eCompressorType = CT_BLOSC;
+            strBloscCompressor = BLOSC_LZ4HC_ID;
+            iBloscShuffle = BLOSC_BITSHUFFLE;
+        }
+        else if( 0 == _strcmpi( strCompressorType, BLOSC_DEFAULT_BIT_ID ) )
+        {
+            eCompressorType = CT_BLOSC;
+            strBloscCompressor = BLOSC_DEFAULT_ID;
+            iBloscShuffle = BLOSC_BITSHUFFLE;
         }
         else if( 0 == _strcmpi( strCompressorType, QLIN16_ID ) )
         {
@@ -219,8 +251,10 @@ public:
         // check and acquire valid settings
         if( CT_NONE != eCompressorType )
         {
-            m_strCompressorType = strCompressorType;
-            m_eCompressorType   = eCompressorType;
+            m_strCompressorType  = strCompressorType;
+            m_eCompressorType    = eCompressorType;
+            m_strBloscCompressor = strBloscCompressor;
+            m_iBloscShuffle      = iBloscShuffle;
 
             if( iCompressionLevel >= 0 )
             {
@@ -229,7 +263,7 @@ public:
 
             if( m_eCompressorType == CT_BLOSC )
             {
-                blosc_set_compressor( m_strCompressorType );
+                blosc_set_compressor( m_strBloscCompressor );
             }
 
             return true;
@@ -245,6 +279,64 @@ public:
     }
 
     
+    /// Get blosc compressor name (without filter suffix), NULL if no blosc compressor is used
+    const char* getBloscCompressorName()
+    {
+        return m_eCompressorType == CT_BLOSC ? m_strBloscCompressor : NULL;
+    }
+    
+    
+    /**
+     * \brief Block size used by blosc for a compressor and element size
+     *
+     * \param[in] strBloscCompressor blosc compressor name
+     * \param[in] element_size Size of one element in bytes
+     * \returns Reference to the table entry (0: automatic block size)
+     *
+     * Element sizes other than 1, 2, 4 or 8 bytes share one entry.
+     */
+    static int& bloscBlocksize( const char* strBloscCompressor, size_t element_size )
+    {
+        static int table[4][5] = {{0}};
+        int compressor = 3;     // other compressors share the last row
+        int size_class = 4;
+        
+        if( strBloscCompressor && 0 == _strcmpi( strBloscCompressor, BLOSC_DEFAULT_ID ) )
+        {
+            compressor = 0;
+        }
+        else if( strBloscCompressor && 0 == _strcmpi( strBloscCompressor, BLOSC_LZ4_ID ) )
+        {
+            compressor = 1;
+        }
+        else if( strBloscCompressor && 0 == _strcmpi( strBloscCompressor, BLOSC_LZ4HC_ID ) )
+        {
+            compressor = 2;
+        }
+
+        switch( element_size )
+        {
+            case 1: size_class = 0; break;
+            case 2: size_class = 1; break;
+            case 4: size_class = 2; break;
+            case 8: size_class = 3; break;
+        }
+
+        return table[compressor][size_class];
+    }
+    
+    
+    /**
+     * \brief Overrides the blosc block size for this compressor
+     *
+     * \param[in] iBlocksize Block size in bytes, 0 for automatic, -1 to use bloscBlocksize()
+     */
+    void setBlocksize( int iBlocksize )
+    {
+        m_iBlocksize = iBlocksize;
+    }
+
+    
     /// Returns true, if current compressor modifies value data
     bool isLossy()
     {
@@ -252,6 +344,34 @@ public:
     }
     
     
+    /**
+     * \brief Convert compressed data from foreign byte order (inplace, before unpack())
+     *
+     * \param[in,out] cdata pointer to compressed data
+     * \param[in] cdata_size length of compressed data in bytes
+     * \returns true, if unpack() delivers data in native byte order then.
+     *          Otherwise the uncompressed data has to be swapped.
+     */
+    bool byteswapCompressed( void* cdata, size_t cdata_size )
+    {
+        // blosc streams are platform independent and keep the byte order of the original data
+        if( !isLossy() )
+        {
+            return false;
+        }
+        
+        // quantizers store offset and scale as float, followed by uint16_t values
+        if( cdata_size >= 2 * sizeof( float ) )
+        {
+            ::utils_byteswap( cdata, 2, sizeof( float ) );
+            ::utils_byteswap( (char*)cdata + 2 * sizeof( float ), 
+                              ( cdata_size - 2 * sizeof( float ) ) / sizeof( uint16_t ), sizeof( uint16_t ) );
+        }
+        
+        return true;
+    }
+    
+    
     /**
      * \brief Calls the qualified compressor (deflate) which always allocates sufficient memory (m_cdata)
      *
@@ -368,6 +488,13 @@ private:
     {
         assert( m_rdata && !m_cdata );
         
+        // blosc is limited to 2GB buffers, larger data remains uncompressed
+        if( m_rdata_size > BLOSC_MAX_BUFFERSIZE )
+        {
+            m_cdata_size = 0;
+            return false;
+        }
+        
         // BLOSC grants for that compressed data never 
         // exceeds original size + BLOSC_MAX_OVERHEAD
         m_cdata_size  = m_rdata_size + BLOSC_MAX_OVERHEAD; 
@@ -379,16 +506,22 @@ private:
             return false;
         }
 
+        blosc_set_blocksize( m_iBlocksize >= 0 ? m_iBlocksize 
+                             : bloscBlocksize( m_strBloscCompressor, m_rdata_element_size ) );
+
         /* compress raw data (rdata) and store it in cdata */
-        m_cdata_size = blosc_compress( 
+        int csize = blosc_compress( 
           /*clevel*/     m_iCompressionLevel, 
-          /*doshuffle*/  BLOSC_DOSHUFFLE, 
+          /*doshuffle*/  m_iBloscShuffle, 
           /*typesize*/   m_rdata_element_size, 
           /*nbytes*/     m_rdata_size, 
           /*src*/        m_rdata, 
           /*dest*/       m_cdata, 
           /*destsize*/   m_cdata_size );
         
+        // negative result on error
+        m_cdata_size = csize > 0 ? (size_t)csize : 0;
+        
         return NULL != m_cdata;
     }
     
@@ -0,0 +1,1074 @@
+/**
+ *  <!-- mksqlite: A MATLAB Interface to SQLite -->
+ *
+ *  @file      regex_nfa.hpp
+ *  @brief     Literal prefilter and linear-time matcher for regex()
+ *  @details   Patterns are analysed for literals every match must contain,
+ *             so most non-matching strings are rejected by a plain memory
+ *             scan. Patterns of the supported subset (no backreferences,
+ *             lookarounds or modifiers) are compiled to a Thompson NFA and
+ *             run by a Pike VM, which gives the same (leftmost-first)
+ *             matches as the backtracking DEELX engine in linear time.
+ *             Other patterns are left to DEELX.
+ *  @authors   Martin Kortmann <mail@kortmann.de>,
+ *             Andreas Martin  <andimartin@users.sourceforge.net>
+ *  @version   2.5
+ *  @date      2008-2017
+ *  @copyright Distributed under LGPL
+ *  @pre
+ *  @warning
+ *  @bug
+ */
+
+#pragma once
+
+//#include "config.h"
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cctype>
+
+/// Maximum number of NFA instructions (counted repetitions are expanded)
+#define REGEX_NFA_MAX_PROGRAM 4096
+/// Maximum nesting depth of groups
+#define REGEX_NFA_MAX_DEPTH   64
+
+
+/**
+ * \brief Pattern analysis and Pike VM matcher
+ *
+ * Supported syntax (same meaning as in DEELX without flags):
+ * literals, escaped punctuation, \\a \\e \\f \\n \\r \\t \\v, \\d \\D \\w \\W \\s \\S,
+ * ".", character classes "[...]" and "[^...]" (ASCII only), groups "(...)"
+ * and "(?:...)", alternation "|", greedy and lazy quantifiers "*", "+", "?",
+ * "{n}", "{n,}", "{n,m}", anchors "^", "$" and word boundaries \\b \\B.
+ */
+class RegexNfa
+{
+    /// AST node types
+    enum node_e { N_EMPTY, N_CHAR, N_SET, N_BOL, N_EOL, N_WORDB, N_NWORDB, N_CAT, N_ALT, N_REPEAT };
+
+    /// AST node
+    struct Node
+    {
+        node_e              type;       ///< node type
+        unsigned char       ch;         ///< character (N_CHAR)
+        int                 set;        ///< index into m_sets (N_SET)
+        int                 min, max;   ///< repetition bounds, max < 0: unbounded (N_REPEAT)
+        bool                greedy;     ///< greedy repetition (N_REPEAT)
+        std::vector<int>    kids;       ///< children (N_CAT, N_ALT, N_REPEAT)
+    };
+
+    /// NFA instruction codes
+    enum op_e { OP_CHAR, OP_SET, OP_SPLIT, OP_JMP, OP_BOL, OP_EOL, OP_WORDB, OP_NWORDB, OP_MATCH };
+
+    /// NFA instruction
+    struct Inst
+    {
+        op_e                op;         ///< instruction code
+        unsigned char       ch;         ///< character (OP_CHAR)
+        int                 x, y;       ///< targets (OP_SPLIT: x preferred, OP_JMP: x), set index (OP_SET: x)
+    };
+
+    /// Set of 256 byte values
+    struct CharSet
+    {
+        unsigned char       bits[32];   ///< one bit per byte value
+
+        CharSet()                       { memset( bits, 0, sizeof( bits ) ); }
+        void add( int c )               { bits[c >> 3] |= (unsigned char)( 1 << ( c & 7 ) ); }
+        void add( int lo, int hi )      { for( int c = lo; c <= hi; c++ ) add( c ); }
+        void add( const CharSet& s )    { for( int i = 0; i < 32; i++ ) bits[i] |= s.bits[i]; }
+        void invert()                   { for( int i = 0; i < 32; i++ ) bits[i] = (unsigned char)~bits[i]; }
+        bool has( unsigned char c ) const { return 0 != ( bits[c >> 3] & ( 1 << ( c & 7 ) ) ); }
+    };
+
+    /// Thread of the Pike VM
+    struct Thread
+    {
+        int pc;         ///< instruction
+        int start;      ///< start position of the match
+    };
+
+    bool                    m_valid;            ///< pattern is supported
+    bool                    m_literal;          ///< pattern is a plain literal
+    bool                    m_anchored;         ///< pattern begins with "^"
+    bool                    m_leading;          ///< required literal is the pattern's head
+    std::string             m_required;         ///< literal every match contains (may be empty)
+    std::string             m_prefix;           ///< literal every match begins with, if anchored
+    const char*             m_pos;              ///< parser position
+    const char*             m_end;              ///< end of pattern
+    int                     m_depth;            ///< group nesting depth
+    std::vector<Node>       m_nodes;            ///< AST
+    std::vector<CharSet>    m_sets;             ///< character sets
+    std::vector<Inst>       m_prog;             ///< NFA program
+
+    /// inhibit copy constructor and assignment operator
+    /// @{
+    RegexNfa( const RegexNfa& );
+    RegexNfa& operator=( const RegexNfa& );
+    /// @}
+
+public:
+    /**
+     * \brief Analyse and compile a pattern
+     *
+     * \param[in] pattern Regular expression
+     */
+    explicit
+    RegexNfa( const char* pattern )
+    : m_valid( false ), m_literal( false ), m_anchored( false ), m_leading( false ), m_depth( 0 )
+    {
+        if( !pattern )
+        {
+            return;
+        }
+
+        m_pos = pattern;
+        m_end = pattern + strlen( pattern );
+
+        int root = parseAlt();
+
+        if( root < 0 || m_pos != m_end )
+        {
+            return;
+        }
+
+        analyse( root );
+
+        if( compile( root ) && emit( OP_MATCH ) >= 0 )
+        {
+            m_valid = true;
+        }
+
+        m_nodes.clear();
+    }
+
+
+    /// Returns true, if the pattern can be run by match()
+    bool isValid() const
+    {
+        return m_valid;
+    }
+
+
+    /// Returns the literal every match contains (empty if none)
+    const std::string& requiredLiteral() const
+    {
+        return m_required;
+    }
+
+
+    /// Returns the literal every matching string begins with (empty if none)
+    const std::string& anchoredPrefix() const
+    {
+        return m_prefix;
+    }
+
+
+    /**
+     * \brief Prefilter: false, if \p str can't match
+     *
+     * Applicable to all patterns the constructor could parse, even if
+     * they are not supported by match().
+     */
+    bool mayMatch( const char* str, size_t len ) const
+    {
+        if( m_required.empty() )
+        {
+            return true;
+        }
+
+        if( m_anchored && m_leading )
+        {
+            return len >= m_required.size() && 0 == memcmp( str, m_required.data(), m_required.size() );
+        }
+
+        return NULL != find( str, len, 0 );
+    }
+
+
+    /**
+     * \brief Find the leftmost match
+     *
+     * \param[in] str String to search in
+     * \param[in] len Length of \p str in bytes
+     * \param[out] start Position of the match
+     * \param[out] end Position after the match
+     * \returns true if matched
+     */
+    bool match( const char* str, size_t len, int& start, int& end ) const
+    {
+        size_t from = 0;
+
+        if( !m_valid )
+        {
+            return false;
+        }
+
+        if( !m_required.empty() )
+        {
+            const char* hit = find( str, len, 0 );
+
+            if( !hit || ( m_anchored && m_leading && hit != str ) )
+            {
+                return false;
+            }
+
+            if( m_literal )
+            {
+                start = (int)( hit - str );
+                end   = start + (int)m_required.size();
+                return true;
+            }
+
+            // leftmost match can't start before the first occurrence of its head
+            if( m_leading )
+            {
+                from = (size_t)( hit - str );
+            }
+        }
+
+        return pike( (const unsigned char*)str, len, from, start, end );
+    }
+
+
+private:
+    /// Find the required literal in \p str, beginning at \p from
+    const char* find( const char* str, size_t len, size_t from ) const
+    {
+        const char*  needle = m_required.data();
+        size_t       n      = m_required.size();
+        const char*  p      = str + from;
+        const char*  last   = str + len;
+
+        while( (size_t)( last - p ) >= n )
+        {
+            // memchr() is vectorized by the C runtime
+            p = (const char*)memchr( p, needle[0], (size_t)( last - p ) - n + 1 );
+
+            if( !p )
+            {
+                return NULL;
+            }
+
+            if( 0 == memcmp( p + 1, needle + 1, n - 1 ) )
+            {
+                return p;
+            }
+
+            p++;
+        }
+
+        return NULL;
+    }
+
+
+    /// Append an AST node, returns its index
+    int node( node_e type )
+    {
+        Node n;
+
+        n.type   = type;
+        n.ch     = 0;
+        n.set    = -1;
+        n.min    = n.max = 0;
+        n.greedy = true;
+        m_nodes.push_back( n );
+
+        return (int)m_nodes.size() - 1;
+    }
+
+
+    /// Append a character set node
+    int setNode( const CharSet& set )
+    {
+        int i = node( N_SET );
+
+        m_sets.push_back( set );
+        m_nodes[i].set = (int)m_sets.size() - 1;
+
+        return i;
+    }
+
+
+    /// Stock set for \\d \\w \\s (lower case) and their complements (upper case)
+    static bool stockSet( char c, CharSet& set )
+    {
+        switch( c )
+        {
+            case 'd': case 'D': set.add( '0', '9' ); break;
+            case 'w': case 'W': set.add( 'A', 'Z' ); set.add( 'a', 'z' ); set.add( '0', '9' ); set.add( '_' ); break;
+            case 's': case 'S': set.add( ' ' ); set.add( '\t' ); set.add( '\r' ); set.add( '\n' ); break;
+            default:  return false;
+        }
+
+        if( c >= 'A' && c <= 'Z' )
+        {
+            set.invert();
+        }
+
+        return true;
+    }
+
+
+    /// Character of a single character escape, -1 if none
+    static int escapedChar( char c )
+    {
+        switch( c )
+        {
+            case 'a': return '\a';
+            case 'e': return 27;
+            case 'f': return '\f';
+            case 'n': return '\n';
+            case 'r': return '\r';
+            case 't': return '\t';
+            case 'v': return '\v';
+        }
+
+        // escaped punctuation stands for itself
+        if( (unsigned char)c < 128 && !isalnum( (unsigned char)c ) && c != ' ' && c >= 32 )
+        {
+            return (unsigned char)c;
+        }
+
+        return -1;
+    }
+
+
+    /// alt := cat ( '|' cat )*
+    int parseAlt()
+    {
+        int first = parseCat();
+
+        if( first < 0 || m_pos == m_end || *m_pos != '|' )
+        {
+            return first;
+        }
+
+        int alt = node( N_ALT );
+        m_nodes[alt].kids.push_back( first );
+
+        while( m_pos < m_end && *m_pos == '|' )
+        {
+            m_pos++;
+
+            int next = parseCat();
+
+            if( next < 0 )
+            {
+                return -1;
+            }
+
+            m_nodes[alt].kids.push_back( next );
+        }
+
+        return alt;
+    }
+
+
+    /// cat := repeat*
+    int parseCat()
+    {
+        int cat = node( N_CAT );
+
+        while( m_pos < m_end && *m_pos != '|' && *m_pos != ')' )
+        {
+            int item = parseRepeat();
+
+            if( item < 0 )
+            {
+                return -1;
+            }
+
+            // flatten nested concatenations (groups don't capture here)
+            if( m_nodes[item].type == N_CAT )
+            {
+                std::vector<int> kids = m_nodes[item].kids;
+                m_nodes[cat].kids.insert( m_nodes[cat].kids.end(), kids.begin(), kids.end() );
+            }
+            else
+            {
+                m_nodes[cat].kids.push_back( item );
+            }
+        }
+
+        return cat;
+    }
+
+
+    /// Parse quantifier bounds at m_pos, false if there is none
+    bool parseBounds( int& min, int& max )
+    {
+        const char* p = m_pos;
+
+        switch( *p )
+        {
+            case '*': min = 0; max = -1; m_pos++; return true;
+            case '+': min = 1; max = -1; m_pos++; return true;
+            case '?': min = 0; max = 1;  m_pos++; return true;
+            case '{': break;
+            default:  return false;
+        }
+
+        // {n}, {n,} or {n,m}
+        p++;
+        if( p == m_end || !isdigit( (unsigned char)*p ) )
+        {
+            return false;
+        }
+
+        for( min = 0; p < m_end && isdigit( (unsigned char)*p ) && min < 10000; p++ )
+        {
+            min = min * 10 + ( *p - '0' );
+        }
+
+        max = min;
+
+        if( p < m_end && *p == ',' )
+        {
+            p++;
+            max = -1;
+
+            if( p < m_end && isdigit( (unsigned char)*p ) )
+            {
+                for( max = 0; p < m_end && isdigit( (unsigned char)*p ) && max < 10000; p++ )
+                {
+                    max = max * 10 + ( *p - '0' );
+                }
+            }
+        }
+
+        if( p == m_end || *p != '}' || ( max >= 0 && max < min ) )
+        {
+            return false;
+        }
+
+        m_pos = p + 1;
+
+        return true;
+    }
+
+
+    /// repeat := atom quantifier?
+    int parseRepeat()
+    {
+        int atom = parseAtom();
+        int min, max;
+
+        if( atom < 0 || m_pos == m_end )
+        {
+            return atom;
+        }
+
+        if( !parseBounds( min, max ) )
+        {
+            // unparsable '{' is left to DEELX
+            return *m_pos == '{' ? -1 : atom;
+        }
+
+        // quantified anchors and subexpressions matching the empty string
+        // are left to DEELX, as it doesn't backtrack into them
+        if( nullable( atom ) )
+        {
+            return -1;
+        }
+
+        int rep = node( N_REPEAT );
+        m_nodes[rep].min = min;
+        m_nodes[rep].max = max;
+        m_nodes[rep].kids.push_back( atom );
+
+        if( m_pos < m_end && *m_pos == '?' )
+        {
+            m_nodes[rep].greedy = false;
+            m_pos++;
+        }
+
+        // stacked or possessive quantifiers are left to DEELX
+        if( m_pos < m_end && ( *m_pos == '*' || *m_pos == '+' || *m_pos == '?' || *m_pos == '{' ) )
+        {
+            return -1;
+        }
+
+        return rep;
+    }
+
+
+    /// Returns true, if the subexpression can match the empty string
+    bool nullable( int i ) const
+    {
+        const Node& n = m_nodes[i];
+
+        switch( n.type )
+        {
+            case N_CHAR:
+            case N_SET:
+                return false;
+
+            case N_CAT:
+                for( size_t k = 0; k < n.kids.size(); k++ )
+                {
+                    if( !nullable( n.kids[k] ) ) return false;
+                }
+                return true;
+
+            case N_ALT:
+                for( size_t k = 0; k < n.kids.size(); k++ )
+                {
+                    if( nullable( n.kids[k] ) ) return true;
+                }
+                return false;
+
+            case N_REPEAT:
+                return n.min == 0 || nullable( n.kids[0] );
+
+            default:
+                return true;
+        }
+    }
+
+
+    /// atom := group | class | '.' | anchor | escape | character
+    int parseAtom()
+    {
+        char c = *m_pos++;
+
+        switch( c )
+        {
+            case '(':
+            {
+                // only plain and non-capturing groups
+                if( m_pos < m_end && *m_pos == '?' )
+                {
+                    if( m_end - m_pos < 2 || m_pos[1] != ':' )
+                    {
+                        return -1;
+                    }
+                    m_pos += 2;
+                }
+
+                if( ++m_depth > REGEX_NFA_MAX_DEPTH )
+                {
+                    return -1;
+                }
+
+                int inner = parseAlt();
+                m_depth--;
+
+                if( inner < 0 || m_pos == m_end || *m_pos != ')' )
+                {
+                    return -1;
+                }
+
+                m_pos++;
+
+                return inner;
+            }
+
+            case '[':
+                return parseClass();
+
+            case '.':
+            {
+                CharSet set;
+                set.add( '\n' );
+                set.invert();
+                return setNode( set );
+            }
+
+            case '^':
+                return node( N_BOL );
+
+            case '$':
+                return node( N_EOL );
+
+            case '\\':
+            {
+                if( m_pos == m_end )
+                {
+                    return -1;
+                }
+
+                c = *m_pos++;
+
+                CharSet set;
+                if( stockSet( c, set ) )
+                {
+                    return setNode( set );
+                }
+
+                if( c == 'b' ) return node( N_WORDB );
+                if( c == 'B' ) return node( N_NWORDB );
+
+                int ch = escapedChar( c );
+
+                if( ch < 0 )
+                {
+                    return -1;
+                }
+
+                int n = node( N_CHAR );
+                m_nodes[n].ch = (unsigned char)ch;
+                return n;
+            }
+
+            case ')': case ']': case '}': case '*': case '+': case '?': case '{':
+                return -1;
+
+            default:
+            {
+                int n = node( N_CHAR );
+                m_nodes[n].ch = (unsigned char)c;
+                return n;
+            }
+        }
+    }
+
+
+    /// class := '[' '^'? item+ ']'  (the '[' is consumed already)
+    int parseClass()
+    {
+        CharSet set;
+        bool negate = false;
+        bool first = true;
+
+        if( m_pos < m_end && *m_pos == '^' )
+        {
+            negate = true;
+            m_pos++;
+        }
+
+        // "[]...]" is left to DEELX
+        if( m_pos < m_end && *m_pos == ']' )
+        {
+            return -1;
+        }
+
+        while( m_pos < m_end && *m_pos != ']' )
+        {
+            int lo = (unsigned char)*m_pos++;
+
+            if( lo == '[' && m_pos < m_end && ( *m_pos == ':' || *m_pos == '=' || *m_pos == '.' ) )
+            {
+                return -1;  // POSIX classes
+            }
+
+            if( lo == '\\' )
+            {
+                if( m_pos == m_end )
+                {
+                    return -1;
+                }
+
+                char c = *m_pos++;
+                CharSet stock;
+
+                if( stockSet( c, stock ) )
+                {
+                    set.add( stock );
+                    first = false;
+                    continue;
+                }
+
+                lo = escapedChar( c );
+
+                if( lo < 0 )
+                {
+                    return -1;
+                }
+            }
+
+            // non ASCII bytes compare as signed chars in DEELX
+            if( lo >= 128 )
+            {
+                return -1;
+            }
+
+            if( m_end - m_pos >= 2 && *m_pos == '-' && m_pos[1] != ']' )
+            {
+                int hi = (unsigned char)m_pos[1];
+                m_pos += 2;
+
+                if( hi == '\\' || hi >= 128 || hi < lo )
+                {
+                    return -1;
+                }
+
+                set.add( lo, hi );
+            }
+            else
+            {
+                set.add( lo );
+            }
+
+            first = false;
+        }
+
+        if( m_pos == m_end || first )
+        {
+            return -1;
+        }
+
+        m_pos++;  // skip ']'
+
+        if( negate )
+        {
+            set.invert();
+        }
+
+        return setNode( set );
+    }
+
+
+    /**
+     * \brief Extract the longest literal every match contains
+     *
+     * Looks for runs of characters in the top level concatenation. Since
+     * nested concatenations are flattened, this includes plain groups.
+     */
+    void analyse( int root )
+    {
+        const Node& r = m_nodes[root];
+        std::string run;
+        bool head = true;       // current run begins at the pattern's head
+        bool runIsHead = true;
+        bool plain = ( r.type == N_CAT );
+
+        if( r.type != N_CAT )
+        {
+            return;
+        }
+
+        m_anchored = !r.kids.empty() && m_nodes[r.kids[0]].type == N_BOL;
+
+        for( size_t i = 1; m_anchored && i < r.kids.size() && m_nodes[r.kids[i]].type == N_CHAR; i++ )
+        {
+            m_prefix += (char)m_nodes[r.kids[i]].ch;
+        }
+
+        for( size_t i = 0; i <= r.kids.size(); i++ )
+        {
+            const Node* n = i < r.kids.size() ? &m_nodes[r.kids[i]] : NULL;
+
+            if( n && n->type == N_CHAR )
+            {
+                if( run.empty() )
+                {
+                    runIsHead = head;
+                }
+                run += (char)n->ch;
+                continue;
+            }
+
+            // leading "^" doesn't break the head
+            if( n && i == 0 && n->type == N_BOL )
+            {
+                continue;
+            }
+
+            if( run.size() > m_required.size() )
+            {
+                m_required = run;
+                m_leading  = runIsHead;
+            }
+
+            run.clear();
+            head = false;
+
+            if( n )
+            {
+                plain = false;
+
+                // "x+" and "x{n,}" contain at least one x
+                if( n->type == N_REPEAT && n->min > 0 && m_nodes[n->kids[0]].type == N_CHAR )
+                {
+                    run = (char)m_nodes[n->kids[0]].ch;
+                    runIsHead = false;
+
+                    if( run.size() > m_required.size() )
+                    {
+                        m_required = run;
+                        m_leading  = false;
+                    }
+
+                    run.clear();
+                }
+            }
+        }
+
+        m_literal = plain && !m_required.empty();
+    }
+
+
+    /// Append an instruction, returns its index or -1 if the program is too large
+    int emit( op_e op, int x = 0, int y = 0, unsigned char ch = 0 )
+    {
+        if( m_prog.size() >= REGEX_NFA_MAX_PROGRAM )
+        {
+            return -1;
+        }
+
+        Inst inst;
+        inst.op = op;
+        inst.x  = x;
+        inst.y  = y;
+        inst.ch = ch;
+        m_prog.push_back( inst );
+
+        return (int)m_prog.size() - 1;
+    }
+
+
+    /// Compile an AST node into NFA instructions
+    bool compile( int i )
+    {
+        const Node& n = m_nodes[i];
+
+        switch( n.type )
+        {
+            case N_EMPTY:   return true;
+            case N_CHAR:    return emit( OP_CHAR, 0, 0, n.ch ) >= 0;
+            case N_SET:     return emit( OP_SET, n.set ) >= 0;
+            case N_BOL:     return emit( OP_BOL ) >= 0;
+            case N_EOL:     return emit( OP_EOL ) >= 0;
+            case N_WORDB:   return emit( OP_WORDB ) >= 0;
+            case N_NWORDB:  return emit( OP_NWORDB ) >= 0;
+
+            case N_CAT:
+                for( size_t k = 0; k < n.kids.size(); k++ )
+                {
+                    if( !compile( n.kids[k] ) ) return false;
+                }
+                return true;
+
+            case N_ALT:
+            {
+                // split L1, L2; L1: a; jmp end; L2: split ...
+                std::vector<int> jumps;
+
+                for( size_t k = 0; k < n.kids.size(); k++ )
+                {
+                    int split = -1;
+
+                    if( k + 1 < n.kids.size() )
+                    {
+                        if( ( split = emit( OP_SPLIT ) ) < 0 ) return false;
+                        m_prog[split].x = split + 1;
+                    }
+
+                    if( !compile( n.kids[k] ) ) return false;
+
+                    if( split >= 0 )
+                    {
+                        int jmp = emit( OP_JMP );
+                        if( jmp < 0 ) return false;
+                        jumps.push_back( jmp );
+                        m_prog[split].y = jmp + 1;
+                    }
+                }
+
+                for( size_t k = 0; k < jumps.size(); k++ )
+                {
+                    m_prog[jumps[k]].x = (int)m_prog.size();
+                }
+
+                return true;
+            }
+
+            case N_REPEAT:
+            {
+                // mandatory copies
+                for( int k = 0; k < n.min; k++ )
+                {
+                    if( !compile( n.kids[0] ) ) return false;
+                }
+
+                if( n.max < 0 )
+                {
+                    // L: split body, end; body: e; jmp L
+                    int split = emit( OP_SPLIT );
+                    if( split < 0 || !compile( n.kids[0] ) ) return false;
+                    int jmp = emit( OP_JMP, split );
+                    if( jmp < 0 ) return false;
+                    setSplit( split, split + 1, jmp + 1, n.greedy );
+                    return true;
+                }
+
+                // optional copies: (e(e(e)?)?)?
+                std::vector<int> splits;
+
+                for( int k = n.min; k < n.max; k++ )
+                {
+                    int split = emit( OP_SPLIT );
+                    if( split < 0 || !compile( n.kids[0] ) ) return false;
+                    splits.push_back( split );
+                }
+
+                for( size_t k = 0; k < splits.size(); k++ )
+                {
+                    setSplit( splits[k], splits[k] + 1, (int)m_prog.size(), n.greedy );
+                }
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+
+    /// Set targets of a split instruction by priority
+    void setSplit( int split, int body, int skip, bool greedy )
+    {
+        m_prog[split].x = greedy ? body : skip;
+        m_prog[split].y = greedy ? skip : body;
+    }
+
+
+    /// Word character as defined by DEELX
+    static bool isWordChar( int c )
+    {
+        return ( c >= 'A' && c <= 'Z' ) || ( c >= 'a' && c <= 'z' ) || ( c >= '0' && c <= '9' ) || c == '_';
+    }
+
+
+    /**
+     * \brief Add a thread and follow its epsilon transitions (in priority order)
+     *
+     * \param[in,out] list Thread list for position \p pos
+     * \param[in,out] mark Position (+1) a instruction was added for last
+     * \param[in,out] stack Work space
+     */
+    void addThread( std::vector<Thread>& list, std::vector<size_t>& mark, std::vector<int>& stack,
+                    int pc, int start, const unsigned char* str, size_t len, size_t pos ) const
+    {
+        stack.clear();
+        stack.push_back( pc );
+
+        while( !stack.empty() )
+        {
+            pc = stack.back();
+            stack.pop_back();
+
+            if( mark[pc] == pos + 1 )
+            {
+                continue;
+            }
+
+            mark[pc] = pos + 1;
+
+            const Inst& inst = m_prog[pc];
+            bool wordL = pos > 0 && isWordChar( str[pos-1] );
+            bool wordR = pos < len && isWordChar( str[pos] );
+
+            switch( inst.op )
+            {
+                case OP_JMP:
+                    stack.push_back( inst.x );
+                    break;
+
+                case OP_SPLIT:
+                    // preferred branch is processed first
+                    stack.push_back( inst.y );
+                    stack.push_back( inst.x );
+                    break;
+
+                case OP_BOL:
+                    if( pos == 0 ) stack.push_back( pc + 1 );
+                    break;
+
+                case OP_EOL:
+                    if( pos == len ) stack.push_back( pc + 1 );
+                    break;
+
+                case OP_WORDB:
+                    if( wordL != wordR ) stack.push_back( pc + 1 );
+                    break;
+
+                case OP_NWORDB:
+                    if( wordL == wordR ) stack.push_back( pc + 1 );
+                    break;
+
+                default:
+                {
+                    Thread t;
+                    t.pc    = pc;
+                    t.start = start;
+                    list.push_back( t );
+                    break;
+                }
+            }
+        }
+    }
+
+
+    /// Run the Pike VM, starting at \p from
+    bool pike( const unsigned char* str, size_t len, size_t from, int& start, int& end ) const
+    {
+        std::vector<Thread> clist, nlist;
+        std::vector<size_t> mark( m_prog.size(), 0 );
+        std::vector<int>    stack;
+        bool matched = false;
+
+        clist.reserve( m_prog.size() );
+        nlist.reserve( m_prog.size() );
+
+        for( size_t pos = from; ; pos++ )
+        {
+            // new lowest priority thread for a match starting here
+            if( !matched && ( !m_anchored || pos == 0 ) )
+            {
+                addThread( clist, mark, stack, 0, (int)pos, str, len, pos );
+            }
+
+            // no threads left and no new ones to come
+            if( clist.empty() && ( matched || m_anchored ) )
+            {
+                break;
+            }
+
+            for( size_t k = 0; k < clist.size(); k++ )
+            {
+                const Inst& inst = m_prog[clist[k].pc];
+                bool step = false;
+
+                switch( inst.op )
+                {
+                    case OP_CHAR:
+                        step = pos < len && str[pos] == inst.ch;
+                        break;
+
+                    case OP_SET:
+                        step = pos < len && m_sets[inst.x].has( str[pos] );
+                        break;
+
+                    case OP_MATCH:
+                        matched = true;
+                        start   = clist[k].start;
+                        end     = (int)pos;
+                        k = clist.size();   // cut off threads of lower priority
+                        continue;
+
+                    default:
+                        break;
+                }
+
+                if( step )
+                {
+                    addThread( nlist, mark, stack, clist[k].pc + 1, clist[k].start, str, len, pos + 1 );
+                }
+            }
+
+            clist.swap( nlist );
+            nlist.clear();
+
+            if( pos >= len )
+            {
+                break;
+            }
+        }
+
+        return matched;
+    }
+};
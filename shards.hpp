@@ -0,0 +1,829 @@
+/**
+ *  <!-- mksqlite: A MATLAB Interface to SQLite -->
+ *
+ *  @file      shards.hpp
+ *  @brief     Scatter-gather queries across a set of database files
+ *  @details   A shard set is a number of database files (e.g. one per day),
+ *             opened read-only beside the database slots. A query runs on
+ *             each shard in worker threads, rows are collected in native
+ *             buffers (no MATLAB memory is touched by the workers) and
+ *             merged: concatenated, merged by sort keys, or partial
+ *             aggregates combined.
+ *  @authors   Martin Kortmann <mail@kortmann.de>,
+ *             Andreas Martin  <andimartin@users.sourceforge.net>
+ *  @version   2.5
+ *  @date      2008-2017
+ *  @copyright Distributed under LGPL
+ *  @pre
+ *  @warning   Functions of mksqlite (regex, md5, application-defined ...)
+ *             allocate MATLAB memory and are not available on shards.
+ *  @bug
+ */
+
+#pragma once
+
+//#include "config.h"
+//#include "sqlite/sqlite3.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <queue>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+  #include "blosc/win32/pthread.h"
+#else
+  #include <pthread.h>
+#endif
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <glob.h>
+  #include <unistd.h>
+#endif
+
+
+/**
+ * \brief Set of read-only database files, queried in parallel
+ */
+class ShardSet
+{
+public:
+    /// Field value in native memory
+    struct Cell
+    {
+        int             type;       ///< SQLITE_NULL, SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT or SQLITE_BLOB
+        sqlite3_int64   i;          ///< SQLITE_INTEGER value
+        double          d;          ///< SQLITE_FLOAT value
+        std::string     bytes;      ///< SQLITE_TEXT (UTF-8) or SQLITE_BLOB content
+
+        Cell() : type( SQLITE_NULL ), i( 0 ), d( 0.0 ) {}
+    };
+
+    typedef std::vector<Cell> Row;  ///< One result row
+
+    /// Query result (of one shard, or merged)
+    struct Result
+    {
+        std::vector<std::string>  names;    ///< Column names (UTF-8)
+        std::vector<Row>          rows;     ///< Result rows
+        int                       rc;       ///< SQLite result code
+        std::string               errmsg;   ///< SQLite error message, if rc indicates an error
+
+        Result() : rc( SQLITE_OK ) {}
+    };
+
+private:
+    std::vector<std::string>  m_files;      ///< File names, sorted
+    std::vector<sqlite3*>     m_dbs;        ///< Database handles, same order
+    int                       m_threads;    ///< Maximum number of worker threads
+
+    /// Shared state of the worker threads
+    struct Job
+    {
+        ShardSet*                   self;       ///< Shard set
+        const char*                 sql;        ///< SQL statement (UTF-8)
+        const std::vector<Cell>*    params;     ///< Parameters to bind
+        std::vector<Result>*        results;    ///< Result of each shard
+        size_t                      next;       ///< Next shard to query
+        pthread_mutex_t             mutex;      ///< Protects next
+    };
+
+    /// Combine operations of partial aggregates (see merge())
+    enum combine_e { COMBINE_KEY, COMBINE_SUM, COMBINE_MIN, COMBINE_MAX };
+
+    /// Order of rows by sort keys (column, descending), ties by shard
+    struct RowLess
+    {
+        const std::vector< std::pair<int,bool> >* keys;   ///< Sort keys
+
+        bool operator()( const Row& a, const Row& b ) const
+        {
+            for( size_t k = 0; k < keys->size(); k++ )
+            {
+                int c = compare( a[(*keys)[k].first], b[(*keys)[k].first] );
+
+                if( c )
+                {
+                    return (*keys)[k].second ? c > 0 : c < 0;
+                }
+            }
+
+            return false;
+        }
+    };
+
+    /// inhibit copy constructor and assignment operator
+    /// @{
+    ShardSet( const ShardSet& );
+    ShardSet& operator=( const ShardSet& );
+    /// @}
+
+public:
+    /// Standard ctor
+    ShardSet() : m_threads( 0 )
+    {}
+
+
+    /// Dtor closes all shards
+    ~ShardSet()
+    {
+        (void)close();
+    }
+
+
+    /// Returns the number of open shards
+    size_t count() const
+    {
+        return m_dbs.size();
+    }
+
+
+    /// Returns the file name of shard \p i
+    const std::string& filename( size_t i ) const
+    {
+        return m_files[i];
+    }
+
+
+    /**
+     * \brief Open all files matching a wildcard pattern read-only
+     *
+     * Shards opened before are closed.
+     *
+     * \param[in] pattern File name pattern (UTF-8), e.g. "data/2017-*.db"
+     * \param[in] threads Maximum number of worker threads (0: number of CPUs)
+     * \param[out] err Error information
+     * \returns true if at least one file was opened
+     */
+    bool open( const char* pattern, int threads, SQLerror& err )
+    {
+        (void)close();
+
+        findFiles( pattern, m_files );
+
+        for( size_t i = 0; i < m_files.size(); i++ )
+        {
+            sqlite3* db = NULL;
+            int rc = sqlite3_open_v2( m_files[i].c_str(), &db, SQLITE_OPEN_READONLY, NULL );
+
+            if( SQLITE_OK != rc )
+            {
+                err.setSqlError( db, rc );
+                sqlite3_close( db );
+                (void)close();
+                return false;
+            }
+
+            sqlite3_extended_result_codes( db, true );
+            sqlite3_busy_timeout( db, CONFIG_BUSYTIMEOUT );
+            m_dbs.push_back( db );
+        }
+
+        if( m_dbs.empty() )
+        {
+            err.set( MSG_SHARDSNOTOPEN );
+            return false;
+        }
+
+        m_threads = threads > 0 ? threads : cpuCount();
+
+        return true;
+    }
+
+
+    /// Close all shards, returns the number of closed shards
+    int close()
+    {
+        int nClosed = 0;
+
+        for( size_t i = 0; i < m_dbs.size(); i++ )
+        {
+            if( m_dbs[i] )
+            {
+                sqlite3_close( m_dbs[i] );
+                nClosed++;
+            }
+        }
+
+        m_dbs.clear();
+        m_files.clear();
+
+        return nClosed;
+    }
+
+
+    /**
+     * \brief Run a query on all shards
+     *
+     * \param[in] sql SQL statement (UTF-8)
+     * \param[in] params Values bound to the parameters of \p sql
+     * \param[out] results Result of each shard (check rc)
+     */
+    void query( const char* sql, const std::vector<Cell>& params, std::vector<Result>& results )
+    {
+        Job job;
+        std::vector<pthread_t> threads;
+        int nThreads = std::min( m_threads, (int)m_dbs.size() );
+
+        results.assign( m_dbs.size(), Result() );
+
+        job.self    = this;
+        job.sql     = sql;
+        job.params  = &params;
+        job.results = &results;
+        job.next    = 0;
+        pthread_mutex_init( &job.mutex, NULL );
+
+        // the calling thread is one of the workers
+        for( int i = 1; i < nThreads; i++ )
+        {
+            pthread_t thread;
+
+            if( 0 != pthread_create( &thread, NULL, &ShardSet::worker, &job ) )
+            {
+                break;
+            }
+
+            threads.push_back( thread );
+        }
+
+        (void)worker( &job );
+
+        for( size_t i = 0; i < threads.size(); i++ )
+        {
+            pthread_join( threads[i], NULL );
+        }
+
+        pthread_mutex_destroy( &job.mutex );
+    }
+
+
+    /**
+     * \brief Merge the results of all shards
+     *
+     * \p spec is one of:
+     * - "" (empty): rows are concatenated in shard order
+     * - "order by <col> [asc|desc], ...": each shard result is sorted by
+     *   the given columns already (ORDER BY in the query), the sorted
+     *   results are merged
+     * - "combine <op>, ...": one operation per column, where "key" marks
+     *   grouping columns and "sum", "count", "min" and "max" combine the
+     *   partial aggregates of rows with equal keys
+     *
+     * Columns are given by name or by number (1 based).
+     *
+     * \param[in] spec Merge specification
+     * \param[in,out] results Shard results (rows are moved)
+     * \param[out] merged Merged result
+     * \param[out] errmsg Reason, if \p spec is invalid or an integer sum overflows
+     * \returns true on success
+     */
+    static bool merge( const std::string& spec, std::vector<Result>& results, Result& merged, std::string& errmsg )
+    {
+        std::vector<std::string> words = split( spec );
+        std::vector< std::pair<int,bool> > keys;
+        std::vector<combine_e> ops;
+
+        merged = Result();
+
+        // column names of the first shard, all shards run the same query
+        if( !results.empty() )
+        {
+            merged.names = results[0].names;
+        }
+
+        if( words.empty() )
+        {
+            for( size_t i = 0; i < results.size(); i++ )
+            {
+                appendRows( merged.rows, results[i].rows );
+            }
+            return true;
+        }
+
+        if( words.size() >= 2 && lower( words[0] ) == "order" && lower( words[1] ) == "by" )
+        {
+            for( size_t i = 2; i < words.size(); i++ )
+            {
+                std::pair<int,bool> key( columnIndex( words[i], merged.names ), false );
+
+                if( key.first < 0 )
+                {
+                    errmsg = "unknown column '" + words[i] + "'";
+                    return false;
+                }
+
+                if( i + 1 < words.size() && ( lower( words[i+1] ) == "asc" || lower( words[i+1] ) == "desc" ) )
+                {
+                    key.second = lower( words[++i] ) == "desc";
+                }
+
+                keys.push_back( key );
+            }
+
+            if( keys.empty() )
+            {
+                errmsg = "no sort column";
+                return false;
+            }
+
+            mergeOrdered( keys, results, merged );
+            return true;
+        }
+
+        if( lower( words[0] ) == "combine" )
+        {
+            for( size_t i = 1; i < words.size(); i++ )
+            {
+                std::string op = lower( words[i] );
+
+                if( op == "key" )                           ops.push_back( COMBINE_KEY );
+                else if( op == "sum" || op == "count" )     ops.push_back( COMBINE_SUM );
+                else if( op == "min" )                      ops.push_back( COMBINE_MIN );
+                else if( op == "max" )                      ops.push_back( COMBINE_MAX );
+                else
+                {
+                    errmsg = "unknown operation '" + words[i] + "'";
+                    return false;
+                }
+
+                if( ops.back() == COMBINE_KEY )
+                {
+                    keys.push_back( std::pair<int,bool>( (int)i - 1, false ) );
+                }
+            }
+
+            if( ops.size() != merged.names.size() )
+            {
+                errmsg = "one operation per column expected";
+                return false;
+            }
+
+            if( !combine( keys, ops, results, merged ) )
+            {
+                // as SQLite's sum()
+                errmsg = "integer overflow";
+                return false;
+            }
+            return true;
+        }
+
+        errmsg = "'order by' or 'combine' expected";
+        return false;
+    }
+
+
+    /// Compare two values in SQLite's order (NULL < numbers < text < BLOB), text and BLOBs binary
+    static int compare( const Cell& a, const Cell& b )
+    {
+        int ra = rank( a.type ), rb = rank( b.type );
+
+        if( ra != rb )
+        {
+            return ra < rb ? -1 : 1;
+        }
+
+        switch( ra )
+        {
+            case 1:
+                if( a.type == SQLITE_INTEGER && b.type == SQLITE_INTEGER )
+                {
+                    return a.i < b.i ? -1 : ( a.i > b.i ? 1 : 0 );
+                }
+                else
+                {
+                    double da = a.type == SQLITE_INTEGER ? (double)a.i : a.d;
+                    double db = b.type == SQLITE_INTEGER ? (double)b.i : b.d;
+
+                    return da < db ? -1 : ( da > db ? 1 : 0 );
+                }
+
+            case 2:
+            case 3:
+            {
+                size_t n = std::min( a.bytes.size(), b.bytes.size() );
+                int c = n ? memcmp( a.bytes.data(), b.bytes.data(), n ) : 0;
+
+                if( c )
+                {
+                    return c;
+                }
+
+                return a.bytes.size() < b.bytes.size() ? -1 : ( a.bytes.size() > b.bytes.size() ? 1 : 0 );
+            }
+        }
+
+        return 0;
+    }
+
+
+private:
+    /// Thread function: query shards until none is left
+    static void* worker( void* arg )
+    {
+        Job* job = (Job*)arg;
+
+        for( ;; )
+        {
+            pthread_mutex_lock( &job->mutex );
+            size_t i = job->next++;
+            pthread_mutex_unlock( &job->mutex );
+
+            if( i >= job->self->m_dbs.size() )
+            {
+                break;
+            }
+
+            job->self->queryShard( job->self->m_dbs[i], job->sql, *job->params, (*job->results)[i] );
+        }
+
+        return NULL;
+    }
+
+
+    /// Run a query on one shard (called by worker threads)
+    static void queryShard( sqlite3* db, const char* sql, const std::vector<Cell>& params, Result& result )
+    {
+        sqlite3_stmt* stmt = NULL;
+        int rc = sqlite3_prepare_v2( db, sql, -1, &stmt, NULL );
+
+        for( int i = 0; SQLITE_OK == rc && stmt && i < (int)params.size() && i < sqlite3_bind_parameter_count( stmt ); i++ )
+        {
+            const Cell& p = params[i];
+
+            switch( p.type )
+            {
+                case SQLITE_INTEGER: rc = sqlite3_bind_int64( stmt, i + 1, p.i ); break;
+                case SQLITE_FLOAT:   rc = sqlite3_bind_double( stmt, i + 1, p.d ); break;
+                case SQLITE_TEXT:    rc = sqlite3_bind_text( stmt, i + 1, p.bytes.data(), (int)p.bytes.size(), SQLITE_STATIC ); break;
+                case SQLITE_BLOB:    rc = sqlite3_bind_blob( stmt, i + 1, p.bytes.data(), (int)p.bytes.size(), SQLITE_STATIC ); break;
+                default:             rc = sqlite3_bind_null( stmt, i + 1 ); break;
+            }
+        }
+
+        if( SQLITE_OK == rc && stmt )
+        {
+            int nCols = sqlite3_column_count( stmt );
+
+            for( int j = 0; j < nCols; j++ )
+            {
+                const char* name = sqlite3_column_name( stmt, j );
+                result.names.push_back( name ? name : "" );
+            }
+
+            while( SQLITE_ROW == ( rc = sqlite3_step( stmt ) ) )
+            {
+                result.rows.push_back( Row( nCols ) );
+                Row& row = result.rows.back();
+
+                for( int j = 0; j < nCols; j++ )
+                {
+                    Cell& cell = row[j];
+
+                    cell.type = sqlite3_column_type( stmt, j );
+
+                    switch( cell.type )
+                    {
+                        case SQLITE_INTEGER: cell.i = sqlite3_column_int64( stmt, j ); break;
+                        case SQLITE_FLOAT:   cell.d = sqlite3_column_double( stmt, j ); break;
+                        case SQLITE_TEXT:
+                        case SQLITE_BLOB:
+                        {
+                            const void* data = cell.type == SQLITE_TEXT ? (const void*)sqlite3_column_text( stmt, j )
+                                                                        : sqlite3_column_blob( stmt, j );
+                            int bytes = sqlite3_column_bytes( stmt, j );
+
+                            if( data && bytes )
+                            {
+                                cell.bytes.assign( (const char*)data, (size_t)bytes );
+                            }
+                            break;
+                        }
+                    }
+                }
+            }
+
+            if( SQLITE_DONE == rc )
+            {
+                rc = SQLITE_OK;
+            }
+        }
+
+        if( SQLITE_OK != rc )
+        {
+            result.rc     = sqlite3_extended_errcode( db );
+            result.errmsg = sqlite3_errmsg( db );
+            result.rows.clear();
+        }
+
+        sqlite3_finalize( stmt );
+    }
+
+
+    /// k-way merge of sorted shard results
+    static void mergeOrdered( const std::vector< std::pair<int,bool> >& keys, std::vector<Result>& results, Result& merged )
+    {
+        typedef std::pair<size_t,size_t> Pos;   // (shard, row)
+
+        // priority queue yields the greatest element, so the order is inverted
+        struct Later
+        {
+            RowLess less;                           ///< Row order
+            const std::vector<Result>* results;     ///< Shard results
+
+            bool operator()( const Pos& a, const Pos& b ) const
+            {
+                const Row& ra = (*results)[a.first].rows[a.second];
+                const Row& rb = (*results)[b.first].rows[b.second];
+
+                if( less( rb, ra ) ) return true;
+                if( less( ra, rb ) ) return false;
+                return a.first > b.first;
+            }
+        } later;
+
+        later.less.keys = &keys;
+        later.results   = &results;
+
+        std::priority_queue< Pos, std::vector<Pos>, Later > heads( later );
+        size_t total = 0;
+
+        for( size_t i = 0; i < results.size(); i++ )
+        {
+            total += results[i].rows.size();
+
+            if( !results[i].rows.empty() )
+            {
+                heads.push( Pos( i, 0 ) );
+            }
+        }
+
+        merged.rows.reserve( total );
+
+        while( !heads.empty() )
+        {
+            Pos pos = heads.top();
+            heads.pop();
+
+            merged.rows.push_back( Row() );
+            merged.rows.back().swap( results[pos.first].rows[pos.second] );
+
+            if( ++pos.second < results[pos.first].rows.size() )
+            {
+                heads.push( pos );
+            }
+        }
+    }
+
+
+    /// Combine partial aggregates of rows with equal keys (output ordered by keys), false on integer overflow
+    static bool combine( const std::vector< std::pair<int,bool> >& keys, const std::vector<combine_e>& ops,
+                         std::vector<Result>& results, Result& merged )
+    {
+        RowLess less;
+        less.keys = &keys;
+
+        std::map<Row, size_t, RowLess> groups( less );  // row index in merged.rows
+
+        for( size_t i = 0; i < results.size(); i++ )
+        {
+            for( size_t r = 0; r < results[i].rows.size(); r++ )
+            {
+                Row& row = results[i].rows[r];
+                std::map<Row, size_t, RowLess>::iterator it = groups.find( row );
+
+                if( it == groups.end() )
+                {
+                    groups.insert( std::make_pair( row, merged.rows.size() ) );
+                    merged.rows.push_back( Row() );
+                    merged.rows.back().swap( row );
+                    continue;
+                }
+
+                Row& acc = merged.rows[it->second];
+
+                for( size_t j = 0; j < ops.size(); j++ )
+                {
+                    switch( ops[j] )
+                    {
+                        case COMBINE_SUM: if( !add( acc[j], row[j] ) ) return false; break;
+                        case COMBINE_MIN: if( row[j].type != SQLITE_NULL && ( acc[j].type == SQLITE_NULL || compare( row[j], acc[j] ) < 0 ) ) acc[j] = row[j]; break;
+                        case COMBINE_MAX: if( row[j].type != SQLITE_NULL && ( acc[j].type == SQLITE_NULL || compare( row[j], acc[j] ) > 0 ) ) acc[j] = row[j]; break;
+                        default: break;
+                    }
+                }
+            }
+        }
+
+        // order groups by key
+        std::vector<Row> rows;
+        rows.reserve( merged.rows.size() );
+
+        for( std::map<Row, size_t, RowLess>::iterator it = groups.begin(); it != groups.end(); ++it )
+        {
+            rows.push_back( Row() );
+            rows.back().swap( merged.rows[it->second] );
+        }
+
+        merged.rows.swap( rows );
+        return true;
+    }
+
+
+    /// SUM of two partial sums (NULLs ignored, integer until a float is involved), false on integer overflow
+    static bool add( Cell& acc, const Cell& value )
+    {
+        if( value.type != SQLITE_INTEGER && value.type != SQLITE_FLOAT )
+        {
+            return true;
+        }
+
+        if( acc.type == SQLITE_INTEGER && value.type == SQLITE_INTEGER )
+        {
+            sqlite3_int64 sum = (sqlite3_int64)( (sqlite3_uint64)acc.i + (sqlite3_uint64)value.i );
+
+            // operands of equal sign, sum of the other sign
+            if( ( acc.i < 0 ) == ( value.i < 0 ) && ( sum < 0 ) != ( acc.i < 0 ) )
+            {
+                return false;
+            }
+
+            acc.i = sum;
+        }
+        else if( acc.type == SQLITE_INTEGER || acc.type == SQLITE_FLOAT )
+        {
+            acc.d    = ( acc.type == SQLITE_INTEGER ? (double)acc.i : acc.d )
+                     + ( value.type == SQLITE_INTEGER ? (double)value.i : value.d );
+            acc.type = SQLITE_FLOAT;
+        }
+        else
+        {
+            acc = value;
+        }
+
+        return true;
+    }
+
+
+    /// Type rank in SQLite's sort order
+    static int rank( int type )
+    {
+        switch( type )
+        {
+            case SQLITE_NULL:       return 0;
+            case SQLITE_INTEGER:
+            case SQLITE_FLOAT:      return 1;
+            case SQLITE_TEXT:       return 2;
+            default:                return 3;
+        }
+    }
+
+
+    /// Move rows of \p src behind \p dst
+    static void appendRows( std::vector<Row>& dst, std::vector<Row>& src )
+    {
+        size_t n = dst.size();
+
+        dst.resize( n + src.size() );
+
+        for( size_t i = 0; i < src.size(); i++ )
+        {
+            dst[n + i].swap( src[i] );
+        }
+    }
+
+
+    /// Split at white spaces and commas
+    static std::vector<std::string> split( const std::string& text )
+    {
+        std::vector<std::string> words;
+        std::string word;
+
+        for( size_t i = 0; i <= text.size(); i++ )
+        {
+            char c = i < text.size() ? text[i] : ' ';
+
+            if( isspace( (unsigned char)c ) || c == ',' )
+            {
+                if( !word.empty() )
+                {
+                    words.push_back( word );
+                    word.clear();
+                }
+            }
+            else
+            {
+                word += c;
+            }
+        }
+
+        return words;
+    }
+
+
+    /// Lower case copy of \p text
+    static std::string lower( std::string text )
+    {
+        for( size_t i = 0; i < text.size(); i++ )
+        {
+            text[i] = (char)tolower( (unsigned char)text[i] );
+        }
+
+        return text;
+    }
+
+
+    /// Column index (base 0) by name or number (base 1), -1 if not found
+    static int columnIndex( const std::string& word, const std::vector<std::string>& names )
+    {
+        char* end = NULL;
+        long number = strtol( word.c_str(), &end, 10 );
+
+        if( end && !*end )
+        {
+            return number >= 1 && number <= (long)names.size() ? (int)number - 1 : -1;
+        }
+
+        for( size_t i = 0; i < names.size(); i++ )
+        {
+            if( lower( names[i] ) == lower( word ) )
+            {
+                return (int)i;
+            }
+        }
+
+        return -1;
+    }
+
+
+    /// Number of processors
+    static int cpuCount()
+    {
+#ifdef _WIN32
+        SYSTEM_INFO si;
+        GetSystemInfo( &si );
+        return (int)si.dwNumberOfProcessors;
+#else
+        long n = sysconf( _SC_NPROCESSORS_ONLN );
+        return n > 0 ? (int)n : 1;
+#endif
+    }
+
+
+    /// Sorted list of files matching \p pattern
+    static void findFiles( const char* pattern, std::vector<std::string>& files )
+    {
+        files.clear();
+
+#ifdef _WIN32
+        // UTF-8 names, as sqlite3_open_v2() expects
+        WIN32_FIND_DATAW data;
+        std::string dir( pattern );
+        size_t sep = dir.find_last_of( "\\/:" );
+        std::vector<wchar_t> wpattern( strlen( pattern ) + 1 );
+        char name[3 * MAX_PATH];
+
+        dir = ( sep == std::string::npos ) ? "" : dir.substr( 0, sep + 1 );
+
+        if( !MultiByteToWideChar( CP_UTF8, 0, pattern, -1, &wpattern[0], (int)wpattern.size() ) )
+        {
+            return;
+        }
+
+        HANDLE hFind = FindFirstFileW( &wpattern[0], &data );
+
+        if( INVALID_HANDLE_VALUE != hFind )
+        {
+            do
+            {
+                if( !( data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) 
+                    && WideCharToMultiByte( CP_UTF8, 0, data.cFileName, -1, name, sizeof( name ), NULL, NULL ) )
+                {
+                    files.push_back( dir + name );
+                }
+            }
+            while( FindNextFileW( hFind, &data ) );
+
+            FindClose( hFind );
+        }
+#else
+        glob_t g;
+
+        if( 0 == glob( pattern, 0, NULL, &g ) )
+        {
+            for( size_t i = 0; i < g.gl_pathc; i++ )
+            {
+                files.push_back( g.gl_pathv[i] );
+            }
+        }
+
+        globfree( &g );
+#endif
+
+        std::sort( files.begin(), files.end() );
+    }
+};
@@ -0,0 +1,865 @@
+/**
+ *  <!-- mksqlite: A MATLAB Interface to SQLite -->
+ *
+ *  @file      sidecar.hpp
+ *  @brief     External storage of large typed BLOBs in sidecar segment files
+ *  @details   Typed BLOBs exceeding a size threshold are appended to segment
+ *             files next to the database. The database row keeps a small
+ *             reference only, which is resolved by memory mapping when fetched.
+ *  @authors   Martin Kortmann <mail@kortmann.de>,
+ *             Andreas Martin  <andimartin@users.sourceforge.net>
+ *  @version   2.5
+ *  @date      2008-2017
+ *  @copyright Distributed under LGPL
+ *  @pre
+ *  @warning
+ *  @bug
+ */
+
+#pragma once
+
+//#include "config.h"
+//#include "global.hpp"
+//#include "sqlite/sqlite3.h"
+#include "sql_builtin_functions.hpp"
+//#include "typed_blobs.hpp"
+//#include "utils.hpp"
+//#include "locale.hpp"
+#include <string>
+#include <set>
+#include <cstdio>
+
+#ifdef _WIN32
+  #include <io.h>
+#else
+  #include <dirent.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+/**
+ * \file
+ * Segment files are named after the database file with suffix "-seg" and
+ * a running number (e.g. "data.db-seg0000"). They are append-only: a BLOB once
+ * written is never modified, so rolled back transactions or deleted rows
+ * leave unreferenced data behind. Segments which aren't referenced by any
+ * row anymore are deleted by SidecarStore::collect() ("sidecar gc" command).
+ *
+ * Since the database holds only the reference, the BLOB size is no more
+ * limited by SQLite (\ref CONFIG_MKSQLITE_MAX_BLOB_SIZE).
+ *
+ * A copy of the database (backup, restore) refers to segments named after
+ * the copy, so the segments referenced are copied along with it
+ * (SidecarStore::copySegments()).
+ */
+
+#define SIDECAR_MAGIC_MAXLEN  14                  ///< length of SidecarRef::m_magic
+#define SIDECAR_MAGIC         "mkSQLite.ref\0"     ///< identifying string of references (14 bytes)
+#define SIDECAR_SEG_SUFFIX    "-seg"              ///< segment file name suffix, followed by the segment number
+
+/**
+ * \brief Reference to a BLOB stored in a sidecar segment
+ *
+ * This struct is stored as (small) BLOB in the database instead of the
+ * typed BLOB itself.
+ */
+struct GCC_PACKED_STRUCT SidecarRef
+{
+  char     m_magic[SIDECAR_MAGIC_MAXLEN];   ///< + 14 identifying string
+  int16_t  m_ver;                           ///< +  2 struct size as version number
+  char     m_endian;                        ///< +  1 byte order of numeric fields: 'L'ittle or 'B'ig endian
+  char     m_reserved[3];                   ///< +  3 (zero)
+  uint32_t m_segment;                       ///< +  4 segment number
+  uint64_t m_offset;                        ///< +  8 offset of the typed BLOB in the segment file
+  uint64_t m_length;                        ///< +  8 length of the typed BLOB in bytes
+  uint64_t m_checksum;                      ///< +  8 checksum of the typed BLOB (see SidecarStore::checksum())
+                                            ///< = 48 Bytes
+
+  /// Initialize reference
+  void init( uint32_t segment, uint64_t offset, uint64_t length, uint64_t checksum )
+  {
+    memset( this, 0, sizeof( *this ) );
+    memcpy( m_magic, SIDECAR_MAGIC, SIDECAR_MAGIC_MAXLEN );
+
+    m_ver       = (int16_t)sizeof( *this );
+    m_endian    = TBH_endian[0];
+    m_segment   = segment;
+    m_offset    = offset;
+    m_length    = length;
+    m_checksum  = checksum;
+  }
+
+  /// Check if a BLOB is a sidecar reference
+  static
+  bool isRef( const void* pBlob, size_t blob_size )
+  {
+    return    pBlob && blob_size == sizeof( SidecarRef )
+           && 0 == memcmp( pBlob, SIDECAR_MAGIC, SIDECAR_MAGIC_MAXLEN );
+  }
+
+  /// Read a reference from a BLOB, converting foreign byte order
+  static
+  SidecarRef fromBlob( const void* pBlob )
+  {
+    SidecarRef ref;
+
+    memcpy( &ref, pBlob, sizeof( ref ) );
+
+    if( ( ref.m_endian == 'L' || ref.m_endian == 'B' ) && ref.m_endian != TBH_endian[0] )
+    {
+      ref.m_ver       = TypedBLOBHeaderBase::swapped( ref.m_ver );
+      ref.m_segment   = TypedBLOBHeaderBase::swapped( ref.m_segment );
+      ref.m_offset    = TypedBLOBHeaderBase::swapped( ref.m_offset );
+      ref.m_length    = TypedBLOBHeaderBase::swapped( ref.m_length );
+      ref.m_checksum  = TypedBLOBHeaderBase::swapped( ref.m_checksum );
+      ref.m_endian    = TBH_endian[0];
+    }
+
+    return ref;
+  }
+};
+
+
+/**
+ * \brief Read-only (copy on write) memory mapping of a file section
+ *
+ * Pages are mapped privately, so the unpacking functions may modify
+ * the header of the typed BLOB without touching the file.
+ */
+class SidecarMapping
+{
+    void*   m_base;     ///< start of mapping (aligned)
+    size_t  m_span;     ///< length of mapping in bytes
+    char*   m_data;     ///< start of requested section
+
+    // Non-copyable
+    SidecarMapping( const SidecarMapping& );
+    SidecarMapping& operator=( const SidecarMapping& );
+
+public:
+    /// Ctor
+    SidecarMapping() : m_base( NULL ), m_span( 0 ), m_data( NULL )
+    {}
+
+    /// Dtor
+    ~SidecarMapping()
+    {
+        unmap();
+    }
+
+    /// Returns the mapped section
+    void* data()
+    {
+        return m_data;
+    }
+
+    /**
+     * \brief Map a section of a file into memory
+     *
+     * \param[in] filename Name of the file
+     * \param[in] offset Start of the section in bytes
+     * \param[in] length Length of the section in bytes
+     * \returns true on success (false, if the file is too short)
+     */
+    bool map( const char* filename, uint64_t offset, uint64_t length )
+    {
+        unmap();
+
+        if( !length || length != (size_t)length )
+        {
+            return false;
+        }
+
+#ifdef _WIN32
+        HANDLE        hFile = CreateFileA( filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                           NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+        HANDLE        hMap  = NULL;
+        LARGE_INTEGER file_size;
+        SYSTEM_INFO   si;
+
+        if( INVALID_HANDLE_VALUE == hFile )
+        {
+            return false;
+        }
+
+        GetSystemInfo( &si );
+        uint64_t base = offset - offset % si.dwAllocationGranularity;
+
+        if( GetFileSizeEx( hFile, &file_size ) && (uint64_t)file_size.QuadPart >= offset + length )
+        {
+            hMap = CreateFileMappingA( hFile, NULL, PAGE_WRITECOPY, 0, 0, NULL );
+        }
+
+        if( hMap )
+        {
+            m_span = (size_t)( offset - base + length );
+            m_base = MapViewOfFile( hMap, FILE_MAP_COPY, (DWORD)( base >> 32 ), (DWORD)base, m_span );
+            CloseHandle( hMap );
+        }
+
+        CloseHandle( hFile );
+#else
+        int         fd = open( filename, O_RDONLY );
+        struct stat st;
+
+        if( fd < 0 )
+        {
+            return false;
+        }
+
+        uint64_t page = (uint64_t)sysconf( _SC_PAGESIZE );
+        uint64_t base = offset - offset % page;
+
+        // mapping beyond the end of file would raise SIGBUS on access
+        if( 0 == fstat( fd, &st ) && (uint64_t)st.st_size >= offset + length )
+        {
+            m_span = (size_t)( offset - base + length );
+            m_base = mmap( NULL, m_span, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, (off_t)base );
+
+            if( MAP_FAILED == m_base )
+            {
+                m_base = NULL;
+            }
+        }
+
+        close( fd );
+#endif
+
+        if( !m_base )
+        {
+            m_span = 0;
+            return false;
+        }
+
+        m_data = (char*)m_base + ( offset - base );
+        return true;
+    }
+
+    /// Release the mapping
+    void unmap()
+    {
+        if( m_base )
+        {
+#ifdef _WIN32
+            UnmapViewOfFile( m_base );
+#else
+            munmap( m_base, m_span );
+#endif
+        }
+
+        m_base = NULL;
+        m_data = NULL;
+        m_span = 0;
+    }
+};
+
+
+/**
+ * \brief Sidecar storage of one database
+ *
+ * References are resolved always, but new BLOBs are stored only
+ * as long as a threshold is set. The segment currently written
+ * is kept open for appending.
+ */
+class SidecarStore
+{
+    std::string m_dbfile;       ///< database file name (base of segment names)
+    size_t      m_threshold;    ///< minimum size of typed BLOBs stored in sidecar (0=off)
+    uint32_t    m_segment;      ///< number of the segment currently written
+    FILE*       m_file;         ///< segment file currently written (append mode)
+    uint64_t    m_offset;       ///< current size of the segment file written
+
+    // Non-copyable
+    SidecarStore( const SidecarStore& );
+    SidecarStore& operator=( const SidecarStore& );
+
+public:
+    /// Ctor
+    SidecarStore() : m_threshold( 0 ), m_segment( 0 ), m_file( NULL ), m_offset( 0 )
+    {}
+
+    /// Dtor
+    ~SidecarStore()
+    {
+        close();
+    }
+
+
+    /**
+     * \brief Assign the database file segment names are derived from
+     *
+     * \param[in] db_filename Database file name (UTF-8), empty or NULL for memory based databases
+     */
+    void open( const char* db_filename )
+    {
+        close();
+        m_dbfile = db_filename ? db_filename : "";
+    }
+
+
+    /// Deactivate sidecar storage and forget the database file
+    void close()
+    {
+        detach();
+        m_dbfile.clear();
+    }
+
+
+    /// Returns true, if sidecar storage is active
+    bool isOn() const
+    {
+        return m_threshold > 0;
+    }
+
+
+    /// Returns the threshold in bytes (0 if inactive)
+    size_t threshold() const
+    {
+        return m_threshold;
+    }
+
+
+    /// Returns true, if a typed BLOB of \p blob_size bytes is to be stored in the sidecar
+    bool accepts( size_t blob_size ) const
+    {
+        return m_threshold > 0 && blob_size >= m_threshold;
+    }
+
+
+    /**
+     * \brief Activate sidecar storage
+     *
+     * \param[in] threshold Minimum size in bytes for typed BLOBs to store, 0 deactivates
+     * \returns Error ID (see \ref MSG_IDS)
+     */
+    int attach( size_t threshold )
+    {
+        detach();
+
+        if( !threshold )
+        {
+            return MSG_NOERROR;
+        }
+
+        if( m_dbfile.empty() )
+        {
+            return MSG_SIDECARNOFILE;
+        }
+
+        std::set<uint32_t> segments;
+
+        m_threshold = threshold;
+
+        // continue writing the last segment
+        listSegments( segments );
+        m_segment = segments.empty() ? 0 : *segments.rbegin();
+
+        return MSG_NOERROR;
+    }
+
+
+    /// Deactivate sidecar storage and close the segment file currently written
+    void detach()
+    {
+        closeSegment();
+        m_threshold = 0;
+    }
+
+
+    /// Returns the file name of segment number \p segment
+    std::string segmentName( uint32_t segment ) const
+    {
+        return segmentName( m_dbfile, segment );
+    }
+
+
+    /// Returns the file name of segment number \p segment of database file \p dbfile
+    static
+    std::string segmentName( const std::string& dbfile, uint32_t segment )
+    {
+        char suffix[32];
+
+        _snprintf( suffix, sizeof( suffix ), SIDECAR_SEG_SUFFIX "%04u", (unsigned)segment );
+        return dbfile + suffix;
+    }
+
+
+    /**
+     * \brief Fast checksum over a memory block
+     *
+     * FNV-1a, processing 64 bit words, which is fast enough
+     * to check each BLOB on every fetch.
+     */
+    static
+    uint64_t checksum( const void* data, size_t size )
+    {
+        const uint64_t  prime   = 0x100000001b3ULL;
+        uint64_t        hash    = 0xcbf29ce484222325ULL ^ size;
+        const char*     p       = (const char*)data;
+        size_t          i;
+
+        for( i = 0; i + 8 <= size; i += 8 )
+        {
+            uint64_t word;
+
+            memcpy( &word, p + i, 8 );
+            hash = ( hash ^ word ) * prime;
+        }
+
+        for( ; i < size; i++ )
+        {
+            hash = ( hash ^ (unsigned char)p[i] ) * prime;
+        }
+
+        return hash ^ ( hash >> 32 );
+    }
+
+
+    /**
+     * \brief Append a typed BLOB to the current segment
+     *
+     * \param[in] pBlob Typed BLOB
+     * \param[in] blob_size Size of \p pBlob in bytes
+     * \param[out] ppRef Reference to store in the database instead, allocated by sqlite3_malloc
+     * \param[out] pRef_size Size of \p ppRef in bytes
+     * \returns Error ID (see \ref MSG_IDS)
+     */
+    int store( const void* pBlob, size_t blob_size, void** ppRef, size_t* pRef_size )
+    {
+        assert( isOn() && ppRef && pRef_size );
+
+        *ppRef      = NULL;
+        *pRef_size  = 0;
+
+        // start a new segment, if the current one would exceed its size
+        if( m_offset > 0 && m_offset + blob_size > CONFIG_SIDECAR_SEGMENT_SIZE )
+        {
+            closeSegment();
+            m_segment++;
+        }
+
+        if( !openSegment() )
+        {
+            return MSG_ERRSIDECAR;
+        }
+
+        // data must be on disk before the reference may be committed
+        if(    fwrite( pBlob, 1, blob_size, m_file ) != blob_size
+            || 0 != fflush( m_file )
+#ifdef _WIN32
+            || 0 != _commit( _fileno( m_file ) ) )
+#else
+            || 0 != fsync( fileno( m_file ) ) )
+#endif
+        {
+            // position is unknown now, reopen before next use
+            closeSegment();
+            return MSG_ERRSIDECAR;
+        }
+
+        SidecarRef* pRef = (SidecarRef*)sqlite3_malloc( (int)sizeof( SidecarRef ) );
+
+        if( !pRef )
+        {
+            return MSG_ERRMEMORY;
+        }
+
+        pRef->init( m_segment, m_offset, blob_size, checksum( pBlob, blob_size ) );
+        m_offset += blob_size;
+
+        *ppRef      = pRef;
+        *pRef_size  = sizeof( SidecarRef );
+
+        return MSG_NOERROR;
+    }
+
+
+    /**
+     * \brief Map the typed BLOB referenced by \p pRefBlob into memory
+     *
+     * \param[in] pRefBlob Reference (SidecarRef) read from the database
+     * \param[out] mapping Mapping holding the typed BLOB
+     * \param[out] pBlob_size Size of the typed BLOB in bytes
+     * \returns Pointer to the typed BLOB, NULL if missing or damaged
+     */
+    const void* resolve( const void* pRefBlob, SidecarMapping& mapping, size_t* pBlob_size ) const
+    {
+        SidecarRef ref = SidecarRef::fromBlob( pRefBlob );
+
+        *pBlob_size = 0;
+
+        if(    m_dbfile.empty()
+            || !mapping.map( segmentName( ref.m_segment ).c_str(), ref.m_offset, ref.m_length )
+            || checksum( mapping.data(), (size_t)ref.m_length ) != ref.m_checksum )
+        {
+            return NULL;
+        }
+
+        *pBlob_size = (size_t)ref.m_length;
+        return mapping.data();
+    }
+
+
+    /**
+     * \brief Unpack a typed BLOB referenced by \p pRefBlob into a MATLAB array
+     *
+     * The BLOB is memory mapped and unpacked from there, without
+     * copying it as a whole.
+     *
+     * \param[in] pRefBlob Reference (SidecarRef) read from the database
+     * \param[in] bStreamable true, if serialization is possible
+     * \param[out] ppItem Created MATLAB array
+     * \returns Error ID (see \ref MSG_IDS)
+     */
+    int unpack( const void* pRefBlob, bool bStreamable, mxArray** ppItem ) const
+    {
+        SidecarMapping  mapping;
+        size_t          blob_size    = 0;
+        const void*     pBlob        = resolve( pRefBlob, mapping, &blob_size );
+        double          process_time = 0.0;
+        double          ratio        = 0.0;
+
+        *ppItem = NULL;
+
+        if( !pBlob )
+        {
+            return MSG_ERRSIDECAR;
+        }
+
+        return blob_unpack( pBlob, blob_size, bStreamable, ppItem, &process_time, &ratio );
+    }
+
+
+    /**
+     * \brief Delete segments, which are not referenced in the database anymore
+     *
+     * All BLOB columns of all tables in the main database are scanned for references.
+     * The database may not be used by others meanwhile.
+     *
+     * \param[in] db SQLite database handle
+     * \param[out] pRemoved Number of segment files deleted
+     * \returns Error ID (see \ref MSG_IDS)
+     */
+    int collect( sqlite3* db, int* pRemoved )
+    {
+        std::set<uint32_t>      referenced;
+        std::set<uint32_t>      segments;
+        int                     err_id;
+
+        assert( pRemoved );
+        *pRemoved = 0;
+
+        if( m_dbfile.empty() )
+        {
+            return MSG_SIDECARNOFILE;
+        }
+
+        err_id = referencedSegments( db, referenced );
+
+        if( MSG_NOERROR != err_id )
+        {
+            return err_id;
+        }
+
+        // the segment currently written must not be open when deleted
+        closeSegment();
+        listSegments( segments );
+
+        for( std::set<uint32_t>::iterator it = segments.begin(); it != segments.end(); it++ )
+        {
+            if( !referenced.count( *it ) && 0 == remove( segmentName( *it ).c_str() ) )
+            {
+                (*pRemoved)++;
+            }
+        }
+
+        return MSG_NOERROR;
+    }
+
+
+    /**
+     * \brief Collect the numbers of all segments referenced in the database
+     *
+     * All BLOB columns of all tables in the main database are scanned for references.
+     *
+     * \param[in] db SQLite database handle
+     * \param[out] referenced Segment numbers
+     * \returns Error ID (see \ref MSG_IDS)
+     */
+    static
+    int referencedSegments( sqlite3* db, std::set<uint32_t>& referenced )
+    {
+        std::vector<std::string> tables;
+        sqlite3_stmt*           stmt = NULL;
+
+        if( SQLITE_OK != sqlite3_prepare_v2( db, "SELECT name FROM main.sqlite_master "
+                                                 "WHERE type='table' AND name NOT LIKE 'sqlite_%'", -1, &stmt, NULL ) )
+        {
+            return MSG_ERRSIDECAR;
+        }
+
+        while( SQLITE_ROW == sqlite3_step( stmt ) )
+        {
+            tables.push_back( (const char*)sqlite3_column_text( stmt, 0 ) );
+        }
+        sqlite3_finalize( stmt );
+
+        for( size_t i = 0; i < tables.size(); i++ )
+        {
+            std::vector<std::string> columns;
+            char* query = sqlite3_mprintf( "PRAGMA main.table_info(\"%w\")", tables[i].c_str() );
+
+            if( query && SQLITE_OK == sqlite3_prepare_v2( db, query, -1, &stmt, NULL ) )
+            {
+                while( SQLITE_ROW == sqlite3_step( stmt ) )
+                {
+                    columns.push_back( (const char*)sqlite3_column_text( stmt, 1 ) );
+                }
+                sqlite3_finalize( stmt );
+            }
+            sqlite3_free( query );
+
+            for( size_t j = 0; j < columns.size(); j++ )
+            {
+                // length() of a BLOB is taken from the record header, without loading the content
+                query = sqlite3_mprintf( "SELECT \"%w\" FROM main.\"%w\" WHERE typeof(\"%w\")='blob' AND length(\"%w\")=%d",
+                                         columns[j].c_str(), tables[i].c_str(), columns[j].c_str(), columns[j].c_str(),
+                                         (int)sizeof( SidecarRef ) );
+
+                if( !query || SQLITE_OK != sqlite3_prepare_v2( db, query, -1, &stmt, NULL ) )
+                {
+                    sqlite3_free( query );
+                    return MSG_ERRSIDECAR;
+                }
+
+                while( SQLITE_ROW == sqlite3_step( stmt ) )
+                {
+                    const void* pBlob = sqlite3_column_blob( stmt, 0 );
+
+                    if( SidecarRef::isRef( pBlob, sqlite3_column_bytes( stmt, 0 ) ) )
+                    {
+                        referenced.insert( SidecarRef::fromBlob( pBlob ).m_segment );
+                    }
+                }
+                sqlite3_finalize( stmt );
+                sqlite3_free( query );
+            }
+        }
+
+        return MSG_NOERROR;
+    }
+
+
+    /**
+     * \brief Copy the segments referenced in a copy of a database
+     *
+     * References in a database copy resolve against segments named after
+     * the copy, so the segments of the original are copied to these names.
+     * Existing segments of the copy with the same numbers are overwritten.
+     *
+     * \param[in] db SQLite database handle of the copy
+     * \param[in] src_dbfile File name of the original database
+     * \param[in] dest_dbfile File name of the copy
+     * \returns Error ID (see \ref MSG_IDS)
+     */
+    static
+    int copySegments( sqlite3* db, const std::string& src_dbfile, const std::string& dest_dbfile )
+    {
+        std::set<uint32_t>  referenced;
+        int                 err_id = referencedSegments( db, referenced );
+
+        if( MSG_NOERROR != err_id || referenced.empty() )
+        {
+            return err_id;
+        }
+
+        if( src_dbfile.empty() || dest_dbfile.empty() )
+        {
+            return MSG_SIDECARNOFILE;
+        }
+
+        if( src_dbfile == dest_dbfile )
+        {
+            return MSG_NOERROR;
+        }
+
+        for( std::set<uint32_t>::iterator it = referenced.begin(); it != referenced.end(); it++ )
+        {
+            if( !copyFile( segmentName( src_dbfile, *it ), segmentName( dest_dbfile, *it ) ) )
+            {
+                return MSG_ERRSIDECAR;
+            }
+        }
+
+        return MSG_NOERROR;
+    }
+
+
+private:
+    /// Open current segment for appending
+    bool openSegment()
+    {
+        if( m_file )
+        {
+            return true;
+        }
+
+        m_file = fopen( segmentName( m_segment ).c_str(), "ab" );
+
+        if( m_file )
+        {
+#ifdef _WIN32
+            if( 0 == _fseeki64( m_file, 0, SEEK_END ) )
+            {
+                m_offset = (uint64_t)_ftelli64( m_file );
+                return true;
+            }
+#else
+            if( 0 == fseeko( m_file, 0, SEEK_END ) )
+            {
+                m_offset = (uint64_t)ftello( m_file );
+                return true;
+            }
+#endif
+            closeSegment();
+        }
+
+        return false;
+    }
+
+
+    /// Close segment currently written
+    void closeSegment()
+    {
+        if( m_file )
+        {
+            fclose( m_file );
+        }
+
+        m_file   = NULL;
+        m_offset = 0;
+    }
+
+
+    /// Copy file \p from to \p to (overwritten), returns false on failure
+    static
+    bool copyFile( const std::string& from, const std::string& to )
+    {
+        FILE*   src     = fopen( from.c_str(), "rb" );
+        FILE*   dest    = src ? fopen( to.c_str(), "wb" ) : NULL;
+        bool    ok      = ( NULL != dest );
+        std::vector<char> buffer( 1 << 20 );
+
+        while( ok )
+        {
+            size_t n = fread( &buffer[0], 1, buffer.size(), src );
+
+            if( n && fwrite( &buffer[0], 1, n, dest ) != n )
+            {
+                ok = false;
+            }
+
+            if( n < buffer.size() )
+            {
+                ok = ok && !ferror( src );
+                break;
+            }
+        }
+
+        // data must be on disk before the copy of the database is used
+        if(    ok
+            && (    0 != fflush( dest )
+#ifdef _WIN32
+                 || 0 != _commit( _fileno( dest ) ) ) )
+#else
+                 || 0 != fsync( fileno( dest ) ) ) )
+#endif
+        {
+            ok = false;
+        }
+
+        if( src )
+        {
+            fclose( src );
+        }
+
+        if( dest )
+        {
+            fclose( dest );
+        }
+
+        return ok;
+    }
+
+
+    /// Collect the numbers of all existing segment files
+    void listSegments( std::set<uint32_t>& segments ) const
+    {
+        // split database file name into directory and name
+        size_t      sep    = m_dbfile.find_last_of(
+#ifdef _WIN32
+                                 "/\\:"
+#else
+                                 "/"
+#endif
+                             );
+        std::string prefix = ( sep == std::string::npos ) ? m_dbfile : m_dbfile.substr( sep + 1 );
+
+        prefix += SIDECAR_SEG_SUFFIX;
+
+#ifdef _WIN32
+        WIN32_FIND_DATAA    fd;
+        HANDLE              hFind = FindFirstFileA( ( m_dbfile + SIDECAR_SEG_SUFFIX "*" ).c_str(), &fd );
+
+        if( INVALID_HANDLE_VALUE != hFind )
+        {
+            do
+            {
+                addSegment( fd.cFileName, prefix, segments );
+            } while( FindNextFileA( hFind, &fd ) );
+
+            FindClose( hFind );
+        }
+#else
+        std::string dir  = ( sep == std::string::npos ) ? std::string( "." ) : m_dbfile.substr( 0, sep + 1 );
+        DIR*        pDir = opendir( dir.c_str() );
+
+        if( pDir )
+        {
+            struct dirent* pEntry;
+
+            while( NULL != ( pEntry = readdir( pDir ) ) )
+            {
+                addSegment( pEntry->d_name, prefix, segments );
+            }
+
+            closedir( pDir );
+        }
+#endif
+    }
+
+
+    /// Add the segment number, if \p name is "<prefix><digits>"
+    static
+    void addSegment( const char* name, const std::string& prefix, std::set<uint32_t>& segments )
+    {
+        const char* digits = name + prefix.size();
+
+        if( 0 != strncmp( name, prefix.c_str(), prefix.size() ) || !*digits )
+        {
+            return;
+        }
+
+        for( const char* p = digits; *p; p++ )
+        {
+            if( *p < '0' || *p > '9' )
+            {
+                return;
+            }
+        }
+
+        segments.insert( (uint32_t)strtoul( digits, NULL, 10 ) );
+    }
+};
@@ -0,0 +1,1014 @@
+/**
+ *  <!-- mksqlite: A MATLAB Interface to SQLite -->
+ *
+ *  @file      sketches.hpp
+ *  @brief     Mergeable approximate statistics (distinct count, quantiles)
+ *  @details   SQL aggregates approx_count_distinct() (HyperLogLog) and
+ *             approx_quantile() (t-digest) evaluate in one pass with constant
+ *             memory. hll_sketch() and tdigest_sketch() return the sketch
+ *             itself as typed BLOB (uint8 row vector), so partial sketches
+ *             (e.g. per day) can be stored and combined later by the
+ *             aggregate sketch_merge(). sketch_count() and sketch_quantile()
+ *             evaluate a stored sketch.
+ *  @see       P. Flajolet et al., "HyperLogLog: the analysis of a near-optimal
+ *             cardinality estimation algorithm", 2007
+ *  @see       O. Ertl, "New cardinality estimation algorithms for HyperLogLog
+ *             sketches", 2017 (estimator without bias correction tables)
+ *  @see       T. Dunning, O. Ertl, "Computing extremely accurate quantiles
+ *             using t-digests", 2019
+ *  @authors   Martin Kortmann <mail@kortmann.de>,
+ *             Andreas Martin  <andimartin@users.sourceforge.net>
+ *  @version   2.5
+ *  @date      2008-2017
+ *  @copyright Distributed under LGPL
+ *  @pre
+ *  @warning   Sketches are stored in little endian byte order and can be
+ *             merged across platforms. HyperLogLog sketches of different
+ *             precision can't be merged.
+ *  @bug
+ */
+
+#pragma once
+
+//#include "config.h"
+//#include "sqlite/sqlite3.h"
+//#include "typed_blobs.hpp"
+//#include "sql_builtin_functions.hpp"
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+#define SKETCH_MAGIC_HLL        "HLL1"      ///< Identifies a serialized HyperLogLog sketch
+#define SKETCH_MAGIC_TDIGEST    "TDG1"      ///< Identifies a serialized t-digest
+#define SKETCH_MAGIC_LEN        4           ///< Length of the identifiers above
+
+
+/**
+ * \brief Little endian (de)serialization of sketches
+ */
+class SketchCodec
+{
+public:
+    /// Append \p bytes bytes of \p value (little endian)
+    static void putUint( std::string& out, uint64_t value, int bytes )
+    {
+        for( int i = 0; i < bytes; i++ )
+        {
+            out += (char)( ( value >> ( 8 * i ) ) & 0xff );
+        }
+    }
+
+
+    /// Append a double (little endian)
+    static void putDouble( std::string& out, double value )
+    {
+        uint64_t bits;
+
+        memcpy( &bits, &value, sizeof( bits ) );
+        putUint( out, bits, 8 );
+    }
+
+
+    /// Read \p bytes bytes (little endian) at \p pos, advances \p pos
+    static bool getUint( const std::string& in, size_t& pos, int bytes, uint64_t& value )
+    {
+        if( pos + bytes > in.size() )
+        {
+            return false;
+        }
+
+        value = 0;
+
+        for( int i = 0; i < bytes; i++ )
+        {
+            value |= (uint64_t)(unsigned char)in[pos++] << ( 8 * i );
+        }
+
+        return true;
+    }
+
+
+    /// Read a double (little endian) at \p pos, advances \p pos
+    static bool getDouble( const std::string& in, size_t& pos, double& value )
+    {
+        uint64_t bits;
+
+        if( !getUint( in, pos, 8, bits ) )
+        {
+            return false;
+        }
+
+        memcpy( &value, &bits, sizeof( value ) );
+        return true;
+    }
+
+
+    /// 64 bit hash (MurmurHash64A, independent of the byte order)
+    static uint64_t hash( const unsigned char* data, size_t len, uint64_t seed )
+    {
+        const uint64_t m = 0xc6a4a7935bd1e995ULL;
+        const int      r = 47;
+        uint64_t       h = seed ^ ( len * m );
+        size_t         i = 0;
+
+        for( ; i + 8 <= len; i += 8 )
+        {
+            uint64_t k = 0;
+
+            for( int j = 0; j < 8; j++ )
+            {
+                k |= (uint64_t)data[i + j] << ( 8 * j );
+            }
+
+            k *= m;
+            k ^= k >> r;
+            k *= m;
+
+            h ^= k;
+            h *= m;
+        }
+
+        if( i < len )
+        {
+            for( int j = (int)( len - i ) - 1; j >= 0; j-- )
+            {
+                h ^= (uint64_t)data[i + j] << ( 8 * j );
+            }
+
+            h *= m;
+        }
+
+        h ^= h >> r;
+        h *= m;
+        h ^= h >> r;
+
+        return h;
+    }
+
+
+    /**
+     * \brief Hash of a SQL value, equal values (as by DISTINCT) give equal hashes
+     *
+     * \param[in] value SQL value (not NULL)
+     * \returns 64 bit hash
+     *
+     * Integral floats are hashed as integers, so 1 and 1.0 count once.
+     */
+    static uint64_t hashValue( sqlite3_value* value )
+    {
+        unsigned char   buffer[8];
+        sqlite3_int64   i;
+        double          d;
+
+        switch( sqlite3_value_type( value ) )
+        {
+            case SQLITE_FLOAT:
+                d = sqlite3_value_double( value );
+
+                if( d != floor( d ) || fabs( d ) >= 9.2e18 )
+                {
+                    uint64_t bits;
+
+                    memcpy( &bits, &d, sizeof( bits ) );
+                    toBytes( bits, buffer );
+                    return hash( buffer, 8, 2 );
+                }
+
+                i = (sqlite3_int64)d;
+                break;
+
+            case SQLITE_TEXT:
+                return hash( sqlite3_value_text( value ), (size_t)sqlite3_value_bytes( value ), 3 );
+
+            case SQLITE_BLOB:
+                return hash( (const unsigned char*)sqlite3_value_blob( value ), (size_t)sqlite3_value_bytes( value ), 4 );
+
+            default:
+                i = sqlite3_value_int64( value );
+                break;
+        }
+
+        toBytes( (uint64_t)i, buffer );
+        return hash( buffer, 8, 1 );
+    }
+
+
+    /// Return a serialized sketch or filter as typed BLOB (uint8 row vector)
+    static void resultBlob( sqlite3_context* ctx, const std::string& payload )
+    {
+        size_t              offset = TypedBLOBHeaderV1::dataOffset( 2 );
+        mwSize              dims[] = { 1, (mwSize)payload.size() };
+        TypedBLOBHeaderV1*  tbh    = (TypedBLOBHeaderV1*)sqlite3_malloc64( offset + payload.size() );
+
+        if( !tbh )
+        {
+            sqlite3_result_error_nomem( ctx );
+            return;
+        }
+
+        tbh->init( mxUINT8_CLASS, 2, dims );
+        memcpy( tbh->getData(), payload.data(), payload.size() );
+
+        sqlite3_result_blob64( ctx, tbh, offset + payload.size(), sqlite3_free );
+    }
+
+
+    /**
+     * \brief Get the serialized sketch or filter of a BLOB argument
+     *
+     * \param[in] value Typed BLOB (uint8, compressed or not) or plain BLOB
+     * \param[out] payload Serialized sketch
+     * \returns false if the value is no BLOB or an invalid typed BLOB
+     */
+    static bool fromBlob( sqlite3_value* value, std::string& payload )
+    {
+        const void* blob      = sqlite3_value_blob( value );
+        size_t      blob_size = (size_t)sqlite3_value_bytes( value );
+        mxClassID   clsid     = mxUNKNOWN_CLASS;
+        size_t      numel     = 0;
+
+        if( SQLITE_BLOB != sqlite3_value_type( value ) )
+        {
+            return false;
+        }
+
+        if( blob_size < sizeof( TypedBLOBHeaderBase ) || !((TypedBLOBHeaderBase*)blob)->validMagic() )
+        {
+            payload.assign( (const char*)blob, blob_size );
+            return true;
+        }
+
+        if(    MSG_NOERROR != blob_unpack_into( blob, blob_size, &clsid, &numel, NULL )
+            || mxUINT8_CLASS != clsid )
+        {
+            return false;
+        }
+
+        payload.resize( numel );
+
+        return MSG_NOERROR == blob_unpack_into( blob, blob_size, &clsid, &numel, &payload[0] );
+    }
+
+
+private:
+    /// Little endian bytes of \p value
+    static void toBytes( uint64_t value, unsigned char* bytes )
+    {
+        for( int j = 0; j < 8; j++ )
+        {
+            bytes[j] = (unsigned char)( value >> ( 8 * j ) );
+        }
+    }
+};
+
+
+/**
+ * \brief HyperLogLog sketch for distinct counts
+ *
+ * 2^p registers of one byte hold the maximum rank of the hashes mapped to
+ * them. The relative standard error is about 1.04/sqrt(2^p), 0.8% with
+ * the default precision of 14 (16 KiB).
+ */
+class HllSketch
+{
+    int                         m_p;        ///< Precision (number of index bits)
+    std::vector<unsigned char>  m_reg;      ///< Registers
+
+public:
+    /// Ctor
+    explicit HllSketch( int p = CONFIG_SKETCH_HLL_PRECISION )
+    : m_p( p ), m_reg( (size_t)1 << p, 0 )
+    {
+    }
+
+
+    /// Add a hashed value
+    void add( uint64_t h )
+    {
+        size_t   index = (size_t)( h >> ( 64 - m_p ) );
+        uint64_t w     = h << m_p;
+        int      rank  = 64 - m_p + 1;
+
+        if( w )
+        {
+            for( rank = 1; !( w & 0x8000000000000000ULL ); rank++ )
+            {
+                w <<= 1;
+            }
+        }
+
+        if( m_reg[index] < rank )
+        {
+            m_reg[index] = (unsigned char)rank;
+        }
+    }
+
+
+    /// Merge another sketch (union of both sets), false if precisions differ
+    bool merge( const HllSketch& other )
+    {
+        if( other.m_p != m_p )
+        {
+            return false;
+        }
+
+        for( size_t i = 0; i < m_reg.size(); i++ )
+        {
+            m_reg[i] = std::max( m_reg[i], other.m_reg[i] );
+        }
+
+        return true;
+    }
+
+
+    /// Estimated number of distinct values (Ertl's improved estimator)
+    double estimate() const
+    {
+        int                 q = 64 - m_p;
+        double              m = (double)m_reg.size();
+        std::vector<double> count( q + 2, 0.0 );
+        double              z;
+
+        for( size_t i = 0; i < m_reg.size(); i++ )
+        {
+            count[m_reg[i]]++;
+        }
+
+        z = m * tau( ( m - count[q + 1] ) / m );
+
+        for( int k = q; k >= 1; k-- )
+        {
+            z = 0.5 * ( z + count[k] );
+        }
+
+        z += m * sigma( count[0] / m );
+
+        return m * m / ( 2.0 * log( 2.0 ) ) / z;
+    }
+
+
+    /// Serialize: magic, precision, registers
+    void serialize( std::string& out ) const
+    {
+        out.assign( SKETCH_MAGIC_HLL, SKETCH_MAGIC_LEN );
+        SketchCodec::putUint( out, (uint64_t)m_p, 1 );
+        out.append( (const char*)&m_reg[0], m_reg.size() );
+    }
+
+
+    /// Deserialize, returns false if \p in is no valid HyperLogLog sketch
+    bool deserialize( const std::string& in )
+    {
+        size_t   pos = SKETCH_MAGIC_LEN;
+        uint64_t p;
+
+        if(    0 != in.compare( 0, SKETCH_MAGIC_LEN, SKETCH_MAGIC_HLL )
+            || !SketchCodec::getUint( in, pos, 1, p ) || p < 4 || p > 18
+            || in.size() != pos + ( (size_t)1 << p ) )
+        {
+            return false;
+        }
+
+        // ranks are 0..64-p+1 (estimate() counts them by rank)
+        for( size_t i = pos; i < in.size(); i++ )
+        {
+            if( (unsigned char)in[i] > 64 - p + 1 )
+            {
+                return false;
+            }
+        }
+
+        m_p = (int)p;
+        m_reg.assign( in.begin() + pos, in.end() );
+
+        return true;
+    }
+
+
+private:
+    /// Helper function sigma of Ertl's estimator
+    static double sigma( double x )
+    {
+        double y = 1.0, z = x, zPrev;
+
+        if( x == 1.0 )
+        {
+            return HUGE_VAL;
+        }
+
+        do
+        {
+            x *= x;
+            zPrev = z;
+            z += x * y;
+            y += y;
+        } while( z != zPrev );
+
+        return z;
+    }
+
+
+    /// Helper function tau of Ertl's estimator
+    static double tau( double x )
+    {
+        double y = 1.0, z = 1.0 - x, zPrev;
+
+        if( x == 0.0 || x == 1.0 )
+        {
+            return 0.0;
+        }
+
+        do
+        {
+            x = sqrt( x );
+            zPrev = z;
+            y *= 0.5;
+            z -= ( 1.0 - x ) * ( 1.0 - x ) * y;
+        } while( z != zPrev );
+
+        return z / 3.0;
+    }
+};
+
+
+/**
+ * \brief Merging t-digest for quantiles
+ *
+ * Values are buffered and merged into at most about delta centroids,
+ * which are small at the tails (accurate extreme quantiles) and large
+ * in the middle of the distribution.
+ */
+class TDigest
+{
+    /// Cluster of values
+    struct Centroid
+    {
+        double mean;        ///< Mean of the values
+        double weight;      ///< Number of values
+
+        /// Sort order
+        bool operator<( const Centroid& other ) const
+        {
+            return mean < other.mean;
+        }
+    };
+
+    double                  m_delta;        ///< Compression
+    double                  m_count;        ///< Number of values
+    double                  m_min;          ///< Minimum value
+    double                  m_max;          ///< Maximum value
+    std::vector<Centroid>   m_centroids;    ///< Merged centroids (sorted)
+    std::vector<Centroid>   m_buffer;       ///< Values not yet merged
+
+public:
+    /// Ctor
+    explicit TDigest( double delta = CONFIG_SKETCH_TDIGEST_COMPRESSION )
+    : m_delta( delta ), m_count( 0.0 ), m_min( HUGE_VAL ), m_max( -HUGE_VAL )
+    {
+    }
+
+
+    /// Add a value (NaN is ignored)
+    void add( double x, double weight = 1.0 )
+    {
+        Centroid c = { x, weight };
+
+        if( x != x )
+        {
+            return;
+        }
+
+        m_buffer.push_back( c );
+        m_count += weight;
+        m_min    = std::min( m_min, x );
+        m_max    = std::max( m_max, x );
+
+        if( m_buffer.size() >= (size_t)( 10 * m_delta ) )
+        {
+            compress();
+        }
+    }
+
+
+    /// Merge another digest
+    void merge( const TDigest& other )
+    {
+        m_buffer.insert( m_buffer.end(), other.m_centroids.begin(), other.m_centroids.end() );
+        m_buffer.insert( m_buffer.end(), other.m_buffer.begin(), other.m_buffer.end() );
+        m_count += other.m_count;
+        m_min    = std::min( m_min, other.m_min );
+        m_max    = std::max( m_max, other.m_max );
+
+        compress();
+    }
+
+
+    /// Number of values
+    double count() const
+    {
+        return m_count;
+    }
+
+
+    /**
+     * \brief Estimated quantile
+     *
+     * \param[in] q Probability (0..1)
+     * \returns Quantile, interpolated between centroids, NaN if empty
+     */
+    double quantile( double q )
+    {
+        size_t n;
+        double index, cum = 0.0;
+
+        compress();
+        n = m_centroids.size();
+
+        if( !n )
+        {
+            return DBL_NAN;
+        }
+
+        if( n == 1 )
+        {
+            return m_centroids[0].mean;
+        }
+
+        index = q * m_count;
+
+        // below the first centroid: interpolate from the minimum
+        if( index < m_centroids[0].weight / 2 )
+        {
+            return m_min + index / ( m_centroids[0].weight / 2 ) * ( m_centroids[0].mean - m_min );
+        }
+
+        for( size_t i = 0; i + 1 < n; i++ )
+        {
+            double left  = cum + m_centroids[i].weight / 2;
+            double right = cum + m_centroids[i].weight + m_centroids[i + 1].weight / 2;
+
+            if( index < right )
+            {
+                return m_centroids[i].mean + ( index - left ) / ( right - left )
+                                             * ( m_centroids[i + 1].mean - m_centroids[i].mean );
+            }
+
+            cum += m_centroids[i].weight;
+        }
+
+        // above the last centroid: interpolate to the maximum
+        {
+            double left = m_count - m_centroids[n - 1].weight / 2;
+
+            return m_centroids[n - 1].mean + std::min( 1.0, ( index - left ) / ( m_count - left ) )
+                                             * ( m_max - m_centroids[n - 1].mean );
+        }
+    }
+
+
+    /// Serialize: magic, delta, count, min, max, number of centroids, centroids
+    void serialize( std::string& out )
+    {
+        compress();
+
+        out.assign( SKETCH_MAGIC_TDIGEST, SKETCH_MAGIC_LEN );
+        SketchCodec::putDouble( out, m_delta );
+        SketchCodec::putDouble( out, m_count );
+        SketchCodec::putDouble( out, m_min );
+        SketchCodec::putDouble( out, m_max );
+        SketchCodec::putUint( out, (uint64_t)m_centroids.size(), 4 );
+
+        for( size_t i = 0; i < m_centroids.size(); i++ )
+        {
+            SketchCodec::putDouble( out, m_centroids[i].mean );
+            SketchCodec::putDouble( out, m_centroids[i].weight );
+        }
+    }
+
+
+    /// Deserialize, returns false if \p in is no valid t-digest
+    bool deserialize( const std::string& in )
+    {
+        size_t   pos = SKETCH_MAGIC_LEN;
+        uint64_t n;
+
+        if(    0 != in.compare( 0, SKETCH_MAGIC_LEN, SKETCH_MAGIC_TDIGEST )
+            || !SketchCodec::getDouble( in, pos, m_delta ) || !( m_delta >= 10 )
+            || !SketchCodec::getDouble( in, pos, m_count )
+            || !SketchCodec::getDouble( in, pos, m_min )
+            || !SketchCodec::getDouble( in, pos, m_max )
+            || !SketchCodec::getUint( in, pos, 4, n )
+            || in.size() != pos + n * 16 )
+        {
+            return false;
+        }
+
+        m_buffer.clear();
+        m_centroids.resize( (size_t)n );
+
+        for( size_t i = 0; i < m_centroids.size(); i++ )
+        {
+            SketchCodec::getDouble( in, pos, m_centroids[i].mean );
+            SketchCodec::getDouble( in, pos, m_centroids[i].weight );
+        }
+
+        return true;
+    }
+
+
+private:
+    /// Merge buffered values into the centroids
+    void compress()
+    {
+        std::vector<Centroid> merged;
+        double                sofar = 0.0, limit;
+
+        if( m_buffer.empty() )
+        {
+            return;
+        }
+
+        m_buffer.insert( m_buffer.end(), m_centroids.begin(), m_centroids.end() );
+        std::sort( m_buffer.begin(), m_buffer.end() );
+
+        Centroid current = m_buffer[0];
+        limit = m_count * qLimit( 0.0 );
+
+        for( size_t i = 1; i < m_buffer.size(); i++ )
+        {
+            const Centroid& c = m_buffer[i];
+
+            if( sofar + current.weight + c.weight <= limit )
+            {
+                current.weight += c.weight;
+                current.mean   += ( c.mean - current.mean ) * c.weight / current.weight;
+            }
+            else
+            {
+                merged.push_back( current );
+                sofar  += current.weight;
+                limit   = m_count * qLimit( sofar / m_count );
+                current = c;
+            }
+        }
+
+        merged.push_back( current );
+        m_centroids.swap( merged );
+        m_buffer.clear();
+    }
+
+
+    /// Upper quantile of a centroid starting at \p q0 (scale function k1)
+    double qLimit( double q0 ) const
+    {
+        const double pi = 3.14159265358979323846;
+        double k = m_delta / ( 2 * pi ) * asin( 2 * q0 - 1 ) + 1;
+
+        if( k >= m_delta / 4 )
+        {
+            return 1.0;
+        }
+
+        return ( sin( k * 2 * pi / m_delta ) + 1 ) / 2;
+    }
+};
+
+
+/**
+ * \brief SQL functions on sketches
+ */
+class SketchFunctions
+{
+    /// State of sketch_merge()
+    struct MergeState
+    {
+        HllSketch*  hll;        ///< Merged HyperLogLog sketches
+        TDigest*    tdigest;    ///< Merged t-digests
+    };
+
+    /// State of approx_quantile()
+    struct QuantileState
+    {
+        TDigest*    tdigest;    ///< Values
+        double      q;          ///< Probability (from first row)
+    };
+
+public:
+    /// Register all functions at \p db
+    static void attach( sqlite3* db )
+    {
+        sqlite3_create_function( db, "approx_count_distinct", 1, SQLITE_UTF8, NULL, NULL, hllStep, countDistinctFinal );
+        sqlite3_create_function( db, "hll_sketch", 1, SQLITE_UTF8, NULL, NULL, hllStep, hllSketchFinal );
+        sqlite3_create_function( db, "approx_quantile", 2, SQLITE_UTF8, NULL, NULL, quantileStep, quantileFinal );
+        sqlite3_create_function( db, "tdigest_sketch", 1, SQLITE_UTF8, NULL, NULL, tdigestStep, tdigestSketchFinal );
+        sqlite3_create_function( db, "sketch_merge", 1, SQLITE_UTF8, NULL, NULL, mergeStep, mergeFinal );
+        sqlite3_create_function( db, "sketch_count", 1, SQLITE_UTF8, NULL, sketchCount, NULL, NULL );
+        sqlite3_create_function( db, "sketch_quantile", 2, SQLITE_UTF8, NULL, sketchQuantile, NULL, NULL );
+    }
+
+
+private:
+    /// Get the aggregate state (a pointer to T), created on first use if \p bCreate is set
+    template< typename T >
+    static T* state( sqlite3_context* ctx, bool bCreate )
+    {
+        T** pp = (T**)sqlite3_aggregate_context( ctx, bCreate ? (int)sizeof( T* ) : 0 );
+
+        if( !pp )
+        {
+            return NULL;
+        }
+
+        if( !*pp && bCreate )
+        {
+            *pp = new T();
+        }
+
+        return *pp;
+    }
+
+
+    /// Release the aggregate state
+    template< typename T >
+    static void release( sqlite3_context* ctx )
+    {
+        T** pp = (T**)sqlite3_aggregate_context( ctx, 0 );
+
+        if( pp && *pp )
+        {
+            delete *pp;
+            *pp = NULL;
+        }
+    }
+
+
+    /// Step of approx_count_distinct() and hll_sketch()
+    static void hllStep( sqlite3_context* ctx, int argc, sqlite3_value** argv )
+    {
+        HllSketch* hll = state<HllSketch>( ctx, true );
+
+        if( !hll )
+        {
+            sqlite3_result_error_nomem( ctx );
+            return;
+        }
+
+        if( SQLITE_NULL != sqlite3_value_type( argv[0] ) )
+        {
+            hll->add( SketchCodec::hashValue( argv[0] ) );
+        }
+    }
+
+
+    /// Final of approx_count_distinct()
+    static void countDistinctFinal( sqlite3_context* ctx )
+    {
+        HllSketch* hll = state<HllSketch>( ctx, false );
+
+        sqlite3_result_int64( ctx, hll ? (sqlite3_int64)floor( hll->estimate() + 0.5 ) : 0 );
+        release<HllSketch>( ctx );
+    }
+
+
+    /// Final of hll_sketch()
+    static void hllSketchFinal( sqlite3_context* ctx )
+    {
+        HllSketch   empty;
+        HllSketch*  hll = state<HllSketch>( ctx, false );
+        std::string out;
+
+        ( hll ? hll : &empty )->serialize( out );
+        SketchCodec::resultBlob( ctx, out );
+        release<HllSketch>( ctx );
+    }
+
+
+    /// Step of approx_quantile()
+    static void quantileStep( sqlite3_context* ctx, int argc, sqlite3_value** argv )
+    {
+        QuantileState* s = state<QuantileState>( ctx, true );
+
+        if( !s )
+        {
+            sqlite3_result_error_nomem( ctx );
+            return;
+        }
+
+        if( !s->tdigest )
+        {
+            s->q = sqlite3_value_double( argv[1] );
+
+            if( SQLITE_NULL == sqlite3_value_type( argv[1] ) || !( s->q >= 0.0 && s->q <= 1.0 ) )
+            {
+                sqlite3_result_error( ctx, "approx_quantile(): probability must be in the range 0..1!", -1 );
+                return;
+            }
+
+            s->tdigest = new TDigest();
+        }
+
+        if( SQLITE_NULL != sqlite3_value_type( argv[0] ) )
+        {
+            s->tdigest->add( sqlite3_value_double( argv[0] ) );
+        }
+    }
+
+
+    /// Final of approx_quantile()
+    static void quantileFinal( sqlite3_context* ctx )
+    {
+        QuantileState* s = state<QuantileState>( ctx, false );
+
+        if( s && s->tdigest && s->tdigest->count() > 0 )
+        {
+            sqlite3_result_double( ctx, s->tdigest->quantile( s->q ) );
+        }
+        else
+        {
+            sqlite3_result_null( ctx );
+        }
+
+        if( s )
+        {
+            delete s->tdigest;
+        }
+
+        release<QuantileState>( ctx );
+    }
+
+
+    /// Step of tdigest_sketch()
+    static void tdigestStep( sqlite3_context* ctx, int argc, sqlite3_value** argv )
+    {
+        TDigest* tdigest = state<TDigest>( ctx, true );
+
+        if( !tdigest )
+        {
+            sqlite3_result_error_nomem( ctx );
+            return;
+        }
+
+        if( SQLITE_NULL != sqlite3_value_type( argv[0] ) )
+        {
+            tdigest->add( sqlite3_value_double( argv[0] ) );
+        }
+    }
+
+
+    /// Final of tdigest_sketch()
+    static void tdigestSketchFinal( sqlite3_context* ctx )
+    {
+        TDigest     empty;
+        TDigest*    tdigest = state<TDigest>( ctx, false );
+        std::string out;
+
+        ( tdigest ? tdigest : &empty )->serialize( out );
+        SketchCodec::resultBlob( ctx, out );
+        release<TDigest>( ctx );
+    }
+
+
+    /// Step of sketch_merge()
+    static void mergeStep( sqlite3_context* ctx, int argc, sqlite3_value** argv )
+    {
+        MergeState* s = state<MergeState>( ctx, true );
+        std::string in;
+        HllSketch   hll;
+        TDigest     tdigest;
+
+        if( !s )
+        {
+            sqlite3_result_error_nomem( ctx );
+            return;
+        }
+
+        if( SQLITE_NULL == sqlite3_value_type( argv[0] ) )
+        {
+            return;
+        }
+
+        if( !SketchCodec::fromBlob( argv[0], in ) )
+        {
+            sqlite3_result_error( ctx, "sketch_merge(): argument is no sketch!", -1 );
+        }
+        else if( hll.deserialize( in ) )
+        {
+            if( s->tdigest || ( s->hll && !s->hll->merge( hll ) ) )
+            {
+                sqlite3_result_error( ctx, "sketch_merge(): sketches of different kind or precision!", -1 );
+            }
+            else if( !s->hll )
+            {
+                s->hll = new HllSketch( hll );
+            }
+        }
+        else if( tdigest.deserialize( in ) )
+        {
+            if( s->hll )
+            {
+                sqlite3_result_error( ctx, "sketch_merge(): sketches of different kind or precision!", -1 );
+            }
+            else if( !s->tdigest )
+            {
+                s->tdigest = new TDigest( tdigest );
+            }
+            else
+            {
+                s->tdigest->merge( tdigest );
+            }
+        }
+        else
+        {
+            sqlite3_result_error( ctx, "sketch_merge(): argument is no sketch!", -1 );
+        }
+    }
+
+
+    /// Final of sketch_merge()
+    static void mergeFinal( sqlite3_context* ctx )
+    {
+        MergeState* s = state<MergeState>( ctx, false );
+        std::string out;
+
+        if( s && s->hll )
+        {
+            s->hll->serialize( out );
+            SketchCodec::resultBlob( ctx, out );
+        }
+        else if( s && s->tdigest )
+        {
+            s->tdigest->serialize( out );
+            SketchCodec::resultBlob( ctx, out );
+        }
+        else
+        {
+            sqlite3_result_null( ctx );
+        }
+
+        if( s )
+        {
+            delete s->hll;
+            delete s->tdigest;
+        }
+
+        release<MergeState>( ctx );
+    }
+
+
+    /// sketch_count(sketch): distinct count (HyperLogLog) or number of values (t-digest)
+    static void sketchCount( sqlite3_context* ctx, int argc, sqlite3_value** argv )
+    {
+        std::string in;
+        HllSketch   hll;
+        TDigest     tdigest;
+
+        if( SQLITE_NULL == sqlite3_value_type( argv[0] ) )
+        {
+            sqlite3_result_null( ctx );
+        }
+        else if( SketchCodec::fromBlob( argv[0], in ) && hll.deserialize( in ) )
+        {
+            sqlite3_result_int64( ctx, (sqlite3_int64)floor( hll.estimate() + 0.5 ) );
+        }
+        else if( tdigest.deserialize( in ) )
+        {
+            sqlite3_result_int64( ctx, (sqlite3_int64)tdigest.count() );
+        }
+        else
+        {
+            sqlite3_result_error( ctx, "sketch_count(): argument is no sketch!", -1 );
+        }
+    }
+
+
+    /// sketch_quantile(sketch, q): quantile of a t-digest
+    static void sketchQuantile( sqlite3_context* ctx, int argc, sqlite3_value** argv )
+    {
+        std::string in;
+        TDigest     tdigest;
+        double      q = sqlite3_value_double( argv[1] );
+
+        if( SQLITE_NULL == sqlite3_value_type( argv[0] ) )
+        {
+            sqlite3_result_null( ctx );
+        }
+        else if( !SketchCodec::fromBlob( argv[0], in ) || !tdigest.deserialize( in ) )
+        {
+            sqlite3_result_error( ctx, "sketch_quantile(): argument is no t-digest!", -1 );
+        }
+        else if( SQLITE_NULL == sqlite3_value_type( argv[1] ) || !( q >= 0.0 && q <= 1.0 ) )
+        {
+            sqlite3_result_error( ctx, "sketch_quantile(): probability must be in the range 0..1!", -1 );
+        }
+        else if( tdigest.count() > 0 )
+        {
+            sqlite3_result_double( ctx, tdigest.quantile( q ) );
+        }
+        else
+        {
+            sqlite3_result_null( ctx );
+        }
+    }
+};
@@ -26,6 +26,7 @@
 #include "number_compressor.hpp"
 #include "serialize.hpp"
 #include "deelx/deelx.h"
+#include "regex_nfa.hpp"
 //#include "utils.hpp"
 
 extern "C"
@@ -39,10 +40,12 @@ void lg_func( sqlite3_context *ctx, int argc, sqlite3_value **argv );
 void ln_func( sqlite3_context *ctx, int argc, sqlite3_value **argv );
 void exp_func( sqlite3_context *ctx, int argc, sqlite3_value **argv );
 void regex_func( sqlite3_context *ctx, int argc, sqlite3_value **argv );
+void regexp_func( sqlite3_context *ctx, int argc, sqlite3_value **argv );
 void BDC_ratio_func( sqlite3_context *ctx, int argc, sqlite3_value **argv );
 void BDC_pack_time_func( sqlite3_context *ctx, int argc, sqlite3_value **argv );
 void BDC_unpack_time_func( sqlite3_context *ctx, int argc, sqlite3_value **argv );
 void MD5_func( sqlite3_context *ctx, int argc, sqlite3_value **argv );
+void BLOB_nnz_func( sqlite3_context *ctx, int argc, sqlite3_value **argv );
 
 
 // Forward declarations
@@ -50,11 +53,15 @@ int  blob_pack    ( const mxArray* pcItem, bool bStreamable,
                     void** ppBlob, size_t* pBlob_size, 
                     double *pdProcess_time, double* pdRatio,
                     const char* compressor = g_compression_type, 
-                    int level = g_compression_level );
+                    int level = g_compression_level,
+                    size_t max_size = CONFIG_MKSQLITE_MAX_BLOB_SIZE );
 int  blob_unpack  ( const void* pBlob, size_t blob_size, 
                     bool bStreamable, mxArray** ppItem, 
                     double* pProcess_time, double* pdRatio );
+int  blob_unpack_into( const void* pBlob, size_t blob_size,
+                       mxClassID* pClsid, size_t* pNumel, void* pData );
 void blob_free    ( void** pBlob );
+int  blob_nnz     ( const void* pBlob, size_t blob_size, size_t* pNnz );
 
 
 #ifdef MAIN_MODULE
@@ -225,6 +232,100 @@ void exp_func( sqlite3_context *ctx, int argc, sqlite3_value **argv ){
 }
 
 
+/// Compiled pattern, cached as auxiliary data by regex_func()
+struct RegexCache
+{
+    int                 convertUTF8;    ///< g_convertUTF8 when compiled
+    RegexNfa            nfa;            ///< prefilter and linear-time matcher
+    CRegexpT <char>     deelx;          ///< backtracking matcher (fallback and replace)
+
+    /// Compile \p pattern for both engines
+    RegexCache( const char* pattern, int convert )
+    : convertUTF8( convert ), nfa( pattern ), deelx( pattern )
+    {}
+
+    /// Destructor for sqlite3_set_auxdata()
+    static void destroy( void* p )
+    {
+        delete (RegexCache*)p;
+    }
+};
+
+
+/**
+ * \brief Get the compiled pattern of argument \p iArg
+ *
+ * The compiled pattern is kept as auxiliary data of the argument, so a
+ * constant pattern is compiled once per statement. If SQLite doesn't keep
+ * it, a temporary copy is returned in \p owned, which the caller must delete.
+ *
+ * \param[in] ctx SQL context parameter
+ * \param[in] argv SQL argument values
+ * \param[in] iArg Index of the pattern argument
+ * \param[out] owned Temporary copy or NULL
+ * \returns Compiled pattern
+ */
+RegexCache* regex_compile( sqlite3_context *ctx, sqlite3_value **argv, int iArg, RegexCache*& owned )
+{
+    RegexCache* cache = (RegexCache*)sqlite3_get_auxdata( ctx, iArg );
+
+    owned = NULL;
+
+    // Compile the pattern, if not cached (or conversion mode changed)
+    if( !cache || cache->convertUTF8 != g_convertUTF8 )
+    {
+        char* pattern = utils_strnewdup( (const char*)sqlite3_value_text( argv[iArg] ), g_convertUTF8 );
+        HC_NOTES( pattern, "regex_compile" );
+
+        // SQLite owns the cache now and may drop it at once (out of memory)
+        sqlite3_set_auxdata( ctx, iArg, new RegexCache( pattern, g_convertUTF8 ), RegexCache::destroy );
+        cache = (RegexCache*)sqlite3_get_auxdata( ctx, iArg );
+
+        if( !cache )
+        {
+            cache = owned = new RegexCache( pattern, g_convertUTF8 );
+        }
+
+        if( pattern )
+        {
+            ::utils_free_ptr( pattern );
+        }
+    }
+
+    return cache;
+}
+
+
+/**
+ * \brief Find the leftmost match of a compiled pattern
+ *
+ * \param[in] cache Compiled pattern
+ * \param[in] str String to search in
+ * \param[out] start First match position (0 based)
+ * \param[out] end Position afterwards matching substring (0 based)
+ * \returns true if matched
+ */
+bool regex_match( RegexCache* cache, const char* str, int& start, int& end )
+{
+    if( !str || !cache->nfa.mayMatch( str, strlen( str ) ) )
+    {
+        return false;
+    }
+
+    if( cache->nfa.isValid() )
+    {
+        return cache->nfa.match( str, strlen( str ), start, end );
+    }
+
+    MatchResult result = cache->deelx.Match( str );
+
+    start = result.GetStart();
+    end   = result.GetEnd();
+
+    return 0 != result.IsMatched();
+}
+
+
 /**
  * \brief Regular expression function implementation
  *
@@ -235,22 +336,26 @@ void exp_func( sqlite3_context *ctx, int argc, sqlite3_value **argv ){
  * If 3 arguments passed regex(str,pattern,replacement) the substring
  * will be modified regarding replacement parameter before returned.
  *
+ * Strings not containing the pattern's required literal are rejected
+ * without running a matcher, supported patterns are matched in linear time
+ * by RegexNfa, all others by DEELX (see regex_compile() and regex_match()).
+ *
  * \param[in] ctx SQL context parameter
  * \param[in] argc Argument count
  * \param[in] argv SQL argument values
  */
 void regex_func( sqlite3_context *ctx, int argc, sqlite3_value **argv ){
     assert( argc >= 2 ); // at least 2 arguments needed
-    char *str = NULL, *pattern = NULL, *replace = NULL;
+    char *str = NULL, *replace = NULL;
+    RegexCache* owned = NULL;
+    RegexCache* cache = regex_compile( ctx, argv, 1, owned );
+    int start = 0, end = 0;
     
     sqlite3_result_null( ctx );
     
     // Get input arguments
     str = utils_strnewdup( (const char*)sqlite3_value_text( argv[0] ), g_convertUTF8 );
-    pattern = utils_strnewdup( (const char*)sqlite3_value_text( argv[1] ), g_convertUTF8 );
-    
     HC_NOTES( str, "regex_func" );
-    HC_NOTES( pattern, "regex_func" );
     
     // Optional 3rd parameter is the replacement pattern
     if( argc > 2 )
@@ -259,27 +364,20 @@ void regex_func( sqlite3_context *ctx, int argc, sqlite3_value **argv ){
         HC_NOTES( replace, "regex_func" );
     }
     
-    CRegexpT <char> regexp( pattern );
-
     // find and match
-    MatchResult result = regexp.Match( str );
-
-    // result
-    if( result.IsMatched() )
+    if( regex_match( cache, str, start, end ) )
     {
         char *str_value = NULL;
         
         if( argc == 2 )
         {
             // Match mode
-            int start = result.GetStart();  // first match position (0 based)
-            int end   = result.GetEnd();    // position afterwards matching substring (0 based)
             int len   = end - start;
 
             str_value = (char*)MEM_ALLOC( len + 1, sizeof(char) );
             
-            // make a substring copy
-            if( str_value && len > 0 )
+            // make a substring copy (empty matches give an empty string)
+            if( str_value )
             {
                 memset( str_value, 0, len + 1 );
                 strncpy( str_value, &str[start], len );
@@ -288,7 +386,7 @@ void regex_func( sqlite3_context *ctx, int argc, sqlite3_value **argv ){
         else
         {
             // Replace mode (allocates space)
-            char* result = regexp.Replace( str, replace );
+            char* result = cache->deelx.Replace( str, replace );
             
             // make a copy with own memory management
             if( result )
@@ -296,9 +394,11 @@ void regex_func( sqlite3_context *ctx, int argc, sqlite3_value **argv ){
                 int len = (int)strlen( result );
                 str_value = (char*)MEM_ALLOC( len + 1, sizeof(char) );
                 
-                if( str_value && len )
+                // terminate always (empty results give an empty string)
+                if( str_value )
                 {
-                    strcpy( str_value, result );
+                    memcpy( str_value, result, len );
+                    str_value[len] = 0;
                 }
                 
                 CRegexpT<char>::ReleaseString( result );
@@ -333,15 +433,51 @@ void regex_func( sqlite3_context *ctx, int argc, sqlite3_value **argv ){
         ::utils_free_ptr( str );
     }
     
-    if( pattern )
-    {
-        ::utils_free_ptr( pattern );
-    }
-    
     if( replace )
     {
         ::utils_free_ptr( replace );
     }
+
+    delete owned;
+}
+
+
+/**
+ * \brief REGEXP operator implementation
+ *
+ * SQLite rewrites "str REGEXP pattern" as regexp(pattern,str), so
+ * argv[0] is the pattern and argv[1] the string. Returns 1 if str contains
+ * a match, 0 if not and NULL if one of the arguments is NULL.
+ *
+ * \param[in] ctx SQL context parameter
+ * \param[in] argc Argument count
+ * \param[in] argv SQL argument values
+ */
+void regexp_func( sqlite3_context *ctx, int argc, sqlite3_value **argv ){
+    assert( argc == 2 );
+    RegexCache* owned = NULL;
+    RegexCache* cache = NULL;
+    char* str = NULL;
+    int start, end;
+
+    if( sqlite3_value_type( argv[0] ) == SQLITE_NULL || sqlite3_value_type( argv[1] ) == SQLITE_NULL )
+    {
+        sqlite3_result_null( ctx );
+        return;
+    }
+
+    cache = regex_compile( ctx, argv, 0, owned );
+    str   = utils_strnewdup( (const char*)sqlite3_value_text( argv[1] ), g_convertUTF8 );
+    HC_NOTES( str, "regexp_func" );
+
+    sqlite3_result_int( ctx, regex_match( cache, str, start, end ) ? 1 : 0 );
+
+    if( str )
+    {
+        ::utils_free_ptr( str );
+    }
+
+    delete owned;
 }
 
 
@@ -662,6 +798,50 @@ void BDC_unpack_time_func( sqlite3_context *ctx, int argc, sqlite3_value **argv
 }
 
 
+/**
+ * \brief BLOB_nnz function implementation
+ *
+ * BLOB_nnz(value) counts the nonzero elements of a typed blob,
+ * where value is argv[0]. Returns NULL for untyped blobs.
+ *
+ * \param[in] ctx SQL context parameter
+ * \param[in] argc Argument count
+ * \param[in] argv SQL argument values
+ */
+void BLOB_nnz_func( sqlite3_context *ctx, int argc, sqlite3_value **argv ){
+    assert( argc == 1 );
+    
+    sqlite3_result_null( ctx );
+
+    // get and handle "value" argument
+    if( SQLITE_BLOB == sqlite3_value_type( argv[0] ) )
+    {
+        const void* pBlob     = sqlite3_value_blob( argv[0] );
+        size_t      blob_size = (size_t)sqlite3_value_bytes( argv[0] );
+        size_t      nnz       = 0;
+        
+        // serialized arrays (unknown class) have no countable elements
+        if(    pBlob && blob_size >= sizeof( TypedBLOBHeaderBase ) 
+            && ((TypedBLOBHeaderBase*)pBlob)->validMagic()
+            && ((TypedBLOBHeaderBase*)pBlob)->m_clsid != mxUNKNOWN_CLASS )
+        {
+            if( MSG_NOERROR != blob_nnz( pBlob, blob_size, &nnz ) )
+            {
+                sqlite3_result_error( ctx, "BLOB_nnz(): an error while unpacking occured!", -1 );
+            }
+            else
+            {
+                sqlite3_result_int64( ctx, (sqlite3_int64)nnz );
+            }
+        }
+    } 
+    else 
+    {
+        sqlite3_result_error( ctx, "BLOB_nnz(): only BLOB type supported!", -1 );
+    }
+}
+
+
 
 
 
@@ -682,6 +862,207 @@ void blob_free( void** ppBlob )
 }
 
 
+/**
+ * \brief Create a typed blob from a complex, sparse or bit packed MATLAB array (deep copy)
+ *
+ * The array data is split into lanes (see TypedBLOBLanes), each lane is 
+ * shuffled and compressed separately. Index lanes of sparse matrices are
+ * always compressed lossless (by blosc, if a lossy compressor is chosen).
+ * Parameters see blob_pack().
+ */
+int blob_pack_lanes( const mxArray* pcItem, 
+                     void** ppBlob, size_t* pBlob_size, 
+                     double *pdProcess_time, double* pdRatio,
+                     const char* compressor, int level, size_t max_size )
+{
+    Err               err;
+    TypedBLOBLanes    lanes;
+    NumberCompressor  numericSequence[TypedBLOBLanes::MAX_LANES];   // one compressor for each lane
+    size_t            stored[TypedBLOBLanes::MAX_LANES];            // stored size of each lane
+    mwSize            nDims         = mxGetNumberOfDimensions( pcItem );
+    bool              isCompressed  = false;
+    bool              isLossy       = false;
+    size_t            raw_size;
+    size_t            data_size;
+    char*             pData         = NULL;
+
+    *ppBlob         = NULL;
+    *pBlob_size     = 0;
+    *pdProcess_time = 0.0;
+    *pdRatio        = 1.0;
+    
+    lanes.fromItem( pcItem, g_bitpack_logicals != 0 );
+    raw_size  = TypedBLOBLanes::tableSize( lanes.m_nLanes ) + lanes.rawSize();
+    data_size = raw_size;
+    
+    for( int i = 0; i < lanes.m_nLanes; i++ )
+    {
+        stored[i] = lanes.m_lane[i].m_bytes;
+    }
+    
+    // only if compression is desired
+    if( level )
+    {
+        double start_time = utils_get_wall_time();
+        
+        for( int i = 0; i < lanes.m_nLanes; i++ )
+        {
+            TypedBLOBLanes::Lane& lane = lanes.m_lane[i];
+            
+            // setCompressor() always returns true, since parameters had been checked already
+            (void)numericSequence[i].setCompressor( compressor, level );
+            isLossy = isLossy || ( !lane.m_isIndex && numericSequence[i].isLossy() );
+            
+            // indices must not be modified
+            if( lane.m_isIndex && numericSequence[i].isLossy() )
+            {
+                (void)numericSequence[i].setCompressor( COMPRESSOR_DEFAULT_ID, level );
+            }
+            
+            if( lane.m_bytes )
+            {
+                numericSequence[i].pack( lane.m_data, lane.m_bytes, lane.m_elbytes, 
+                                         !lane.m_isIndex && mxIsDouble( pcItem ) );  // allocates m_rdata
+                
+                // lane is stored compressed, only if it's worth the effort
+                if( numericSequence[i].m_result_size > 0 && numericSequence[i].m_result_size < lane.m_bytes )
+                {
+                    stored[i]    = numericSequence[i].m_result_size;
+                    isCompressed = true;
+                }
+            }
+        }
+        
+        *pdProcess_time = utils_get_wall_time() - start_time;
+    }
+    
+    if( isCompressed )
+    {
+        data_size = TypedBLOBLanes::tableSize( lanes.m_nLanes );
+        
+        for( int i = 0; i < lanes.m_nLanes; i++ )
+        {
+            data_size += stored[i];
+        }
+        
+        // Switch to uncompressed blob, if it's not worth the effort.
+        if( TypedBLOBHeaderV2::dataOffset( nDims ) + data_size >= TypedBLOBHeaderV1::dataOffset( nDims ) + raw_size )
+        {
+            isCompressed = false;
+            data_size    = raw_size;
+            
+            for( int i = 0; i < lanes.m_nLanes; i++ )
+            {
+                stored[i] = lanes.m_lane[i].m_bytes;
+            }
+        }
+    }
+    
+    *pBlob_size = ( isCompressed ? TypedBLOBHeaderV2::dataOffset( nDims ) : TypedBLOBHeaderV1::dataOffset( nDims ) ) + data_size;
+    
+    // discard data if it exeeds max allowd size by sqlite (or the lane table)
+    if( *pBlob_size > max_size )
+    {
+        err.set( MSG_BLOBTOOBIG );
+        goto finalize;
+    }
+    
+    // raw and stored lane sizes are kept as 32 bit integers in the lane table
+    for( int i = 0; i < lanes.m_nLanes; i++ )
+    {
+        if( lanes.m_lane[i].m_bytes > (size_t)INT32_MAX || stored[i] > (size_t)INT32_MAX )
+        {
+            err.set( MSG_BLOBTOOBIG );
+            goto finalize;
+        }
+    }
+    
+    *ppBlob = sqlite3_malloc64( *pBlob_size );
+    if( NULL == *ppBlob )
+    {
+        err.set( MSG_ERRMEMORY );
+        goto finalize;
+    }
+    
+    // blob typing...
+    if( isCompressed )
+    {
+        TypedBLOBHeaderV2* tbh2 = (TypedBLOBHeaderV2*)*ppBlob;
+        
+        tbh2->init( pcItem, lanes.m_layout );
+        tbh2->setCompressor( numericSequence[lanes.m_nLanes-1].getCompressorName() );  // compressor of value lanes
+        pData = (char*)tbh2->getData();
+    }
+    else
+    {
+        TypedBLOBHeaderV1* tbh1 = (TypedBLOBHeaderV1*)*ppBlob;
+        
+        tbh1->init( pcItem, lanes.m_layout );
+        pData = (char*)tbh1->getData();
+    }
+    
+    // ...lane table and lanes
+    if( !lanes.writeTable( pData, stored ) )
+    {
+        err.set( MSG_BLOBTOOBIG );
+        goto finalize;
+    }
+    pData += TypedBLOBLanes::tableSize( lanes.m_nLanes );
+    
+    for( int i = 0; i < lanes.m_nLanes; i++ )
+    {
+        if( stored[i] )
+        {
+            memcpy( pData, stored[i] < lanes.m_lane[i].m_bytes ? numericSequence[i].m_result : lanes.m_lane[i].m_data, stored[i] );
+            pData += stored[i];
+        }
+    }
+    
+    *pdRatio = (double)*pBlob_size / ( TypedBLOBHeaderV1::dataOffset( nDims ) + raw_size );
+    
+    // optionally check if compressed data equals to original?
+    if( isCompressed && g_compression_check && !isLossy )
+    {
+        mxArray*        unpacked = NULL;
+        TypedBLOBLanes  unpacked_lanes;
+        bool            is_equal = false;
+        double          dummy;
+        
+        // inflate compressed data again
+        if( MSG_NOERROR == blob_unpack( *ppBlob, *pBlob_size, false, &unpacked, &dummy, &dummy ) && unpacked )
+        {
+            unpacked_lanes.fromItem( unpacked, g_bitpack_logicals != 0 );
+            is_equal = ( unpacked_lanes.m_nLanes == lanes.m_nLanes );
+            
+            for( int i = 0; is_equal && i < lanes.m_nLanes; i++ )
+            {
+                is_equal =    unpacked_lanes.m_lane[i].m_bytes == lanes.m_lane[i].m_bytes
+                           && 0 == memcmp( unpacked_lanes.m_lane[i].m_data, lanes.m_lane[i].m_data, lanes.m_lane[i].m_bytes );
+            }
+        }
+        
+        ::utils_destroy_array( unpacked );
+        
+        // check if uncompressed data equals original
+        if( !is_equal )
+        {
+            err.set( MSG_ERRCOMPRESSION );
+            goto finalize;
+        }
+    }
+    
+finalize:
+    
+    if( err.isPending() )
+    {
+        blob_free( ppBlob );
+        *pBlob_size = 0;
+    }
+    
+    return err.getMsgId();
+}
+
+
 /**
  * \brief create a compressed typed blob from a Matlab item (deep copy)
  *
@@ -695,11 +1076,13 @@ void blob_free( void** ppBlob )
  *            Default is global setting g_compression_type
  * \param[in] level compression level (optional). 
  *            Default is global setting g_compression_level
+ * \param[in] max_size maximum BLOB size in bytes (optional). 
+ *            Default is \ref CONFIG_MKSQLITE_MAX_BLOB_SIZE, the limit of SQLite
  */
 int blob_pack( const mxArray* pcItem, bool bStreamable, 
                void** ppBlob, size_t* pBlob_size, 
                double *pdProcess_time, double* pdRatio,
-               const char* compressor, int level )
+               const char* compressor, int level, size_t max_size )
 {
     Err err;
     
@@ -709,6 +1092,13 @@ int blob_pack( const mxArray* pcItem, bool bStreamable,
     mxArray*          byteStream        = NULL;  // for stream preprocessing
     NumberCompressor  numericSequence;           // compressor
     
+    // complex and sparse arrays are stored in separate lanes, logical arrays optionally bit packed
+    if(    TypedBLOBHeaderBase::getLayout( pcItem ) != TBH_LAYOUT_PLAIN 
+        || ( g_bitpack_logicals && mxIsLogical( pcItem ) ) )
+    {
+        return blob_pack_lanes( pcItem, ppBlob, pBlob_size, pdProcess_time, pdRatio, compressor, level, max_size );
+    }
+    
     // BLOB packaging in 3 steps:
     // 1. Serialize
     // 2. Compress
@@ -740,7 +1130,7 @@ int blob_pack( const mxArray* pcItem, bool bStreamable,
     (void)numericSequence.setCompressor( compressor, level );
     
     // only if compression is desired
-    if( g_compression_level )
+    if( level )
     {
         double start_time = utils_get_wall_time();
         
@@ -780,14 +1170,14 @@ int blob_pack( const mxArray* pcItem, bool bStreamable,
             TypedBLOBHeaderV2* tbh2 = NULL;
             
             // discard data if it exeeds max allowd size by sqlite
-            if( *pBlob_size > CONFIG_MKSQLITE_MAX_BLOB_SIZE )
+            if( *pBlob_size > max_size )
             {
                 err.set( MSG_BLOBTOOBIG );
                 goto finalize;
             }
 
             // allocate space for a typed blob containing compressed data
-            tbh2 = (TypedBLOBHeaderV2*)sqlite3_malloc( (int)*pBlob_size );
+            tbh2 = (TypedBLOBHeaderV2*)sqlite3_malloc64( *pBlob_size );
             if( NULL == tbh2 )
             {
                 err.set( MSG_ERRMEMORY );
@@ -798,9 +1188,7 @@ int blob_pack( const mxArray* pcItem, bool bStreamable,
             tbh2->init( value.Item() );
             tbh2->setCompressor( numericSequence.getCompressorName() );
 
-            // ...and copy compressed data
-            /// \todo Do byteswapping here if big endian? 
-            // (Most platforms use little endian)
+            // ...and copy compressed data (native byte order, readers convert if needed)
             memcpy( (char*)tbh2->getData(), numericSequence.m_result, numericSequence.m_result_size );
             
             // optionally check if compressed data equals to original?
@@ -811,7 +1199,7 @@ int blob_pack( const mxArray* pcItem, bool bStreamable,
                 double dummy;
 
                 // inflate compressed data again
-                if( !blob_unpack( (void*)tbh2, (int)*pBlob_size, bStreamable, &unpacked, &dummy, &dummy ) )
+                if( !blob_unpack( (void*)tbh2, *pBlob_size, bStreamable, &unpacked, &dummy, &dummy ) )
                 {
                     sqlite3_free( tbh2 );
                     
@@ -846,13 +1234,13 @@ int blob_pack( const mxArray* pcItem, bool bStreamable,
         /* Without compression, raw data is copied into blob structure as is */
         *pBlob_size = TypedBLOBHeaderV1::dataOffset( value.NumDims() ) + value.ByData();
 
-        if( *pBlob_size > CONFIG_MKSQLITE_MAX_BLOB_SIZE )
+        if( *pBlob_size > max_size )
         {
             err.set( MSG_BLOBTOOBIG );
             goto finalize;
         }
 
-        tbh1 = (TypedBLOBHeaderV1*)sqlite3_malloc( (int)*pBlob_size );
+        tbh1 = (TypedBLOBHeaderV1*)sqlite3_malloc64( *pBlob_size );
         if( NULL == tbh1 )
         {
             err.set( MSG_ERRMEMORY );
@@ -862,9 +1250,7 @@ int blob_pack( const mxArray* pcItem, bool bStreamable,
         // blob typing...
         tbh1->init( value.Item() );
 
-        // and copy uncompressed data
-        /// \todo Do byteswapping here if big endian? 
-        // (Most platforms use little endian)
+        // and copy uncompressed data (native byte order, readers convert if needed)
         memcpy( tbh1->getData(), value.Data(), value.ByData() );
 
         *ppBlob = (void*)tbh1;
@@ -887,74 +1273,307 @@ finalize:
 
 
 /**
- * \brief uncompress a typed blob and return as MATLAB array
+ * \brief Convert the header of a typed blob written with foreign byte order (inplace)
  *
- * \param[out] pBlob BLOB to decompress
- * \param[out] blob_size Size of BLOB in bytes
- * \param[in] bStreamable if true, streaming preprocess is intended
- * \param[in] ppItem MATLAB array to compress
- * \param[out] pdProcess_time Processing time in seconds
- * \param[out] pdRatio Realized compression ratio
+ * Converts the header fields and the lane table (if any), but not the data.
+ *
+ * \param[in,out] pBlob BLOB (copy)
+ * \param[in] blob_size Size of BLOB in bytes
+ * \returns false if BLOB is malformed
  */
-int blob_unpack( const void* pBlob, size_t blob_size, bool bStreamable, 
-                 mxArray** ppItem, 
-                 double* pdProcess_time, double* pdRatio )
+bool blob_header_to_native( void* pBlob, size_t blob_size )
 {
-    Err err;
-    bool bIsByteStream = false;
-    
     typedef TypedBLOBHeaderV1 tbhv1_t;
     typedef TypedBLOBHeaderV2 tbhv2_t;
     
-    mxArray* pItem = NULL;
-    NumberCompressor numericSequence;
-
-    assert( NULL != ppItem && NULL != pdProcess_time && NULL != pdRatio );
-    
-    *ppItem         = NULL;
-    *pdProcess_time = 0.0;
-    *pdRatio        = 1.0;
-    
     tbhv1_t* tbh1 = (tbhv1_t*)pBlob;
     tbhv2_t* tbh2 = (tbhv2_t*)pBlob;
     
-    /* test valid platform */
-    if( !tbh1->validPlatform() )
-    {
-        mexWarnMsgIdAndTxt( "MATLAB:MKSQLITE:BlobDiffArch", ::getLocaleMsg( MSG_WARNDIFFARCH ) );
-        /// \todo warning, error or automatic conversion..?
-        // since mostly platforms (except SunOS) use LE encoding
-        // and unicode is not supported here, there is IMHO no need 
-        // for conversions...
-        
-        // Warning can switched off via:
-        // warning( 'off', 'MATLAB:MKSQLITE:BlobDiffArch' );
-    }
-
-    /* check for valid header */
-    if( !tbh1->validMagic() )
-    {
-        err.set( MSG_UNSUPPTBH );
-        goto finalize;
-    }
-
-    // serialized array marked as "unknown class" is a byte stream
-    if( tbh1->m_clsid == mxUNKNOWN_CLASS )
-    {
-        bIsByteStream = true;
-        tbh1->m_clsid = mxUINT8_CLASS;
-    }
-
+    tbh1->m_ver   = TypedBLOBHeaderBase::swapped( tbh1->m_ver );
+    tbh1->m_clsid = TypedBLOBHeaderBase::swapped( tbh1->m_clsid );
+    
     switch( tbh1->m_ver )
     {
-      // typed blob with uncompressed data
       case sizeof( tbhv1_t ):
-      {
-          // get data from header "type 1" is easy
-          pItem = tbh1->createNumericArray( /* doCopyData */ true );
-          break;
-      }
-
+          if( !tbh1->dimsToNative( blob_size ) )
+          {
+              return false;
+          }
+          
+          if( tbh1->getLayout() != TBH_LAYOUT_PLAIN )
+          {
+              return TypedBLOBLanes::tableToNative( tbh1->getData(), blob_size - tbh1->dataOffset() );
+          }
+          break;
+          
+      case sizeof( tbhv2_t ):
+          if( !tbh2->dimsToNative( blob_size ) )
+          {
+              return false;
+          }
+          
+          if( tbh2->getLayout() != TBH_LAYOUT_PLAIN )
+          {
+              return TypedBLOBLanes::tableToNative( tbh2->getData(), blob_size - tbh2->dataOffset() );
+          }
+          break;
+          
+      default:
+          return false;
+    }
+    
+    return true;
+}
+
+
+/**
+ * \brief Uncompress a typed blob holding a complex, sparse or bit packed array
+ *
+ * Counterpart to blob_pack_lanes(). Value lanes are unpacked directly 
+ * into the data space of the created MATLAB array.
+ * If \p bSwap is set, the lanes are converted from foreign byte order
+ * (the header must be converted by blob_header_to_native() already).
+ * Other parameters see blob_unpack().
+ */
+int blob_unpack_lanes( const void* pBlob, size_t blob_size, bool bSwap,
+                       mxArray** ppItem, 
+                       double* pdProcess_time, double* pdRatio )
+{
+    Err err;
+    
+    typedef TypedBLOBHeaderV1 tbhv1_t;
+    typedef TypedBLOBHeaderV2 tbhv2_t;
+    
+    tbhv1_t*            tbh1            = (tbhv1_t*)pBlob;
+    tbhv2_t*            tbh2            = (tbhv2_t*)pBlob;
+    TypedBLOBLanes      lanes;
+    NumberCompressor    valueCompressor;
+    NumberCompressor    indexCompressor;
+    mxArray*            pItem           = NULL;
+    mwSize*             dimensions      = NULL;
+    int                 nDims           = 0;
+    const char*         pData           = NULL;
+    size_t              avail           = 0;
+    bool                isCompressed    = false;
+    int                 nLanes          = 0;
+    size_t              bytes[TypedBLOBLanes::MAX_LANES];
+    size_t              stored[TypedBLOBLanes::MAX_LANES];
+    double              start_time      = utils_get_wall_time();
+
+    switch( tbh1->m_ver )
+    {
+      // typed blob with uncompressed lanes
+      case sizeof( tbhv1_t ):
+          nDims = tbh1->getNumDims();
+          if( nDims >= 0 && blob_size >= tbh1->dataOffset() )
+          {
+              pData = (const char*)tbh1->getData();
+              avail = blob_size - tbh1->dataOffset();
+          }
+          break;
+
+      // typed blob with compressed lanes
+      case sizeof( tbhv2_t ):
+          if( !tbh2->validCompression() )
+          {
+              err.set( MSG_UNKCOMPRESSOR );
+              goto finalize;
+          }
+          
+          nDims = tbh2->getNumDims();
+          if( nDims >= 0 && blob_size >= tbh2->dataOffset() )
+          {
+              pData = (const char*)tbh2->getData();
+              avail = blob_size - tbh2->dataOffset();
+          }
+          
+          isCompressed = true;
+          valueCompressor.setCompressor( tbh2->m_compression );
+          indexCompressor.setCompressor( valueCompressor.isLossy() ? COMPRESSOR_DEFAULT_ID : tbh2->m_compression );
+          break;
+          
+      default:
+          break;
+    }
+    
+    if( !pData || !TypedBLOBLanes::readTable( pData, avail, nLanes, bytes, stored ) )
+    {
+        err.set( MSG_UNSUPPTBH );
+        goto finalize;
+    }
+    
+    // create an empty MATLAB array
+    dimensions = new mwSize[nDims+1];
+    
+    for( int i = 0; i < nDims; i++ )
+    {
+        dimensions[i] = isCompressed ? tbh2->getDim( i ) : tbh1->getDim( i );
+    }
+    
+    pItem = lanes.createItem( tbh1->getClsid(), tbh1->getLayout(), (mwSize)nDims, dimensions, nLanes, bytes );
+    
+    if( !pItem )
+    {
+        err.set( MSG_UNSUPPTBH );
+        goto finalize;
+    }
+    
+    pData += TypedBLOBLanes::tableSize( nLanes );
+    
+    // lanes will be unpacked directly into MATLAB variable data space
+    for( int i = 0; i < nLanes; i++ )
+    {
+        TypedBLOBLanes::Lane& lane = lanes.m_lane[i];
+        bool isNative = !bSwap;
+        
+        if( stored[i] < bytes[i] )
+        {
+            NumberCompressor& numericSequence = lane.m_isIndex ? indexCompressor : valueCompressor;
+            
+            if( !isNative && isCompressed )
+            {
+                isNative = numericSequence.byteswapCompressed( (void*)pData, stored[i] );
+            }
+            
+            if( !isCompressed || !numericSequence.unpack( (void*)pData, stored[i], lane.m_data, lane.m_bytes, lane.m_elbytes ) )
+            {
+                err.set( MSG_ERRCOMPRESSION );
+                goto finalize;
+            }
+        }
+        else if( bytes[i] )
+        {
+            memcpy( lane.m_data, pData, bytes[i] );
+        }
+        
+        // convert in place
+        if( !isNative )
+        {
+            ::utils_byteswap( lane.m_data, lane.m_bytes / lane.m_elbytes, lane.m_elbytes );
+        }
+        
+        pData += stored[i];
+    }
+    
+    // rebuild sparse indices
+    if( !lanes.finish( pItem ) )
+    {
+        err.set( MSG_UNSUPPTBH );
+        goto finalize;
+    }
+    
+    *pdProcess_time = utils_get_wall_time() - start_time;
+    *pdRatio        = (double)( pData - (const char*)pBlob ) / ( tbhv1_t::dataOffset( nDims ) + TypedBLOBLanes::tableSize( nLanes ) + lanes.rawSize() );
+    
+    *ppItem = pItem;
+    pItem = NULL;
+    
+finalize:
+    
+    delete[] dimensions;
+    ::utils_destroy_array( pItem );
+    
+    return err.getMsgId();
+}
+
+
+/**
+ * \brief uncompress a typed blob and return as MATLAB array
+ *
+ * \param[out] pBlob BLOB to decompress
+ * \param[out] blob_size Size of BLOB in bytes
+ * \param[in] bStreamable if true, streaming preprocess is intended
+ * \param[in] ppItem MATLAB array to compress
+ * \param[out] pdProcess_time Processing time in seconds
+ * \param[out] pdRatio Realized compression ratio
+ */
+int blob_unpack( const void* pBlob, size_t blob_size, bool bStreamable, 
+                 mxArray** ppItem, 
+                 double* pdProcess_time, double* pdRatio )
+{
+    Err err;
+    bool bIsByteStream = false;
+    
+    typedef TypedBLOBHeaderV1 tbhv1_t;
+    typedef TypedBLOBHeaderV2 tbhv2_t;
+    
+    mxArray* pItem = NULL;
+    NumberCompressor numericSequence;
+    void* pNative = NULL;   // copy of a BLOB written with foreign byte order
+    bool bSwap = false;
+
+    assert( NULL != ppItem && NULL != pdProcess_time && NULL != pdRatio );
+    
+    *ppItem         = NULL;
+    *pdProcess_time = 0.0;
+    *pdRatio        = 1.0;
+    
+    tbhv1_t* tbh1 = (tbhv1_t*)pBlob;
+    tbhv2_t* tbh2 = (tbhv2_t*)pBlob;
+    
+    /* check for valid header */
+    if( blob_size < sizeof( TypedBLOBHeaderBase ) || !tbh1->validMagic() )
+    {
+        err.set( MSG_UNSUPPTBH );
+        goto finalize;
+    }
+
+    /* BLOBs from platforms with another byte order are converted on a copy */
+    if( tbh1->isForeignEndian() )
+    {
+        pNative = sqlite3_malloc64( blob_size );
+        if( NULL == pNative )
+        {
+            err.set( MSG_ERRMEMORY );
+            goto finalize;
+        }
+        
+        memcpy( pNative, pBlob, blob_size );
+        
+        if( !blob_header_to_native( pNative, blob_size ) )
+        {
+            err.set( MSG_UNSUPPTBH );
+            goto finalize;
+        }
+        
+        pBlob = pNative;
+        tbh1  = (tbhv1_t*)pNative;
+        tbh2  = (tbhv2_t*)pNative;
+        bSwap = true;
+    }
+
+    // complex, sparse and bit packed arrays are stored in separate lanes
+    if( tbh1->getLayout() != TBH_LAYOUT_PLAIN )
+    {
+        int err_id = blob_unpack_lanes( pBlob, blob_size, bSwap, ppItem, pdProcess_time, pdRatio );
+        
+        sqlite3_free( pNative );
+        return err_id;
+    }
+
+    // serialized array marked as "unknown class" is a byte stream
+    if( tbh1->m_clsid == mxUNKNOWN_CLASS )
+    {
+        bIsByteStream = true;
+        tbh1->m_clsid = mxUINT8_CLASS;
+    }
+
+    switch( tbh1->m_ver )
+    {
+      // typed blob with uncompressed data
+      case sizeof( tbhv1_t ):
+      {
+          // get data from header "type 1" is easy
+          pItem = tbh1->createNumericArray( /* doCopyData */ true );
+          
+          // convert in place
+          if( pItem && bSwap )
+          {
+              ::utils_byteswap( ValueMex(pItem).Data(), ValueMex(pItem).NumElements(), ValueMex(pItem).ByElement() );
+          }
+          break;
+      }
+
       // typed blob with compressed data
       case sizeof( tbhv2_t ):
       {
@@ -976,6 +1595,12 @@ int blob_unpack( const void* pBlob, size_t blob_size, bool bStreamable,
               void*  cdata      = tbh2->getData();  // get compressed data
               size_t cdata_size = blob_size - tbh2->dataOffset(); // and its size
               
+              // quantized data is converted before, blosc data after decompression
+              if( bSwap && numericSequence.byteswapCompressed( cdata, cdata_size ) )
+              {
+                  bSwap = false;
+              }
+              
               // data will be unpacked directly into MATLAB variable data space
               if( !numericSequence.unpack( cdata, cdata_size, ValueMex(pItem).Data(), ValueMex(pItem).ByData(), ValueMex(pItem).ByElement() ) )
               {
@@ -983,6 +1608,12 @@ int blob_unpack( const void* pBlob, size_t blob_size, bool bStreamable,
                   goto finalize;
               } 
               
+              // convert in place
+              if( bSwap )
+              {
+                  ::utils_byteswap( ValueMex(pItem).Data(), ValueMex(pItem).NumElements(), ValueMex(pItem).ByElement() );
+              }
+              
               *pdProcess_time = utils_get_wall_time() - start_time;
 
               // any data omitted?
@@ -994,8 +1625,6 @@ int blob_unpack( const void* pBlob, size_t blob_size, bool bStreamable,
               {
                   *pdRatio = 0.0;
               }
-
-              /// \todo Do byteswapping here if needed, depend on endian?
           }
           break;
       }
@@ -1031,7 +1660,313 @@ finalize:
     // cdata is owned by the blob (const parameter pBlob)
     // so inhibit from freeing through destructor:
     ::utils_destroy_array( pItem );
+    sqlite3_free( pNative );
+
+    return err.getMsgId();
+}
+
+
+/**
+ * \brief Unpack the data of a typed blob into preallocated memory
+ *
+ * Only arrays stored in plain layout (real, full, not bit packed and 
+ * not serialized) can be unpacked this way. The array dimensions are
+ * reduced to the number of elements.
+ *
+ * \param[in] pBlob Typed BLOB
+ * \param[in] blob_size Size of BLOB in bytes
+ * \param[in,out] pClsid Class ID of the array elements
+ * \param[in,out] pNumel Number of array elements
+ * \param[out] pData Memory for \p pNumel elements of class \p pClsid.
+ *             If NULL, class ID and number of elements are returned only.
+ * \returns Error ID (see \ref MSG_IDS), MSG_UNSUPPTBH if the BLOB can't be
+ *          unpacked this way or doesn't match \p pClsid and \p pNumel.
+ */
+int blob_unpack_into( const void* pBlob, size_t blob_size,
+                      mxClassID* pClsid, size_t* pNumel, void* pData )
+{
+    Err err;
+    
+    typedef TypedBLOBHeaderV1 tbhv1_t;
+    typedef TypedBLOBHeaderV2 tbhv2_t;
+    
+    NumberCompressor numericSequence;
+    void*     pNative = NULL;   // copy of a BLOB written with foreign byte order
+    bool      bSwap   = false;
+    tbhv1_t*  tbh1    = (tbhv1_t*)pBlob;
+    tbhv2_t*  tbh2    = (tbhv2_t*)pBlob;
+    bool      isCompressed;
+    int       nDims;
+    size_t    numel   = 1;
+    size_t    elbytes;
+    
+    assert( pClsid && pNumel );
+    
+    /* check for valid header */
+    if( blob_size < sizeof( TypedBLOBHeaderBase ) || !tbh1->validMagic() )
+    {
+        err.set( MSG_UNSUPPTBH );
+        goto finalize;
+    }
 
+    /* BLOBs from platforms with another byte order are converted on a copy */
+    if( tbh1->isForeignEndian() )
+    {
+        pNative = sqlite3_malloc64( blob_size );
+        if( NULL == pNative )
+        {
+            err.set( MSG_ERRMEMORY );
+            goto finalize;
+        }
+        
+        memcpy( pNative, pBlob, blob_size );
+        
+        if( !blob_header_to_native( pNative, blob_size ) )
+        {
+            err.set( MSG_UNSUPPTBH );
+            goto finalize;
+        }
+        
+        tbh1  = (tbhv1_t*)pNative;
+        tbh2  = (tbhv2_t*)pNative;
+        bSwap = true;
+    }
+    
+    // lanes and byte streams would need a MATLAB array of their own
+    if(    tbh1->getLayout() != TBH_LAYOUT_PLAIN || !tbh1->validClsid()
+        || ( tbh1->m_ver != sizeof( tbhv1_t ) && tbh1->m_ver != sizeof( tbhv2_t ) ) )
+    {
+        err.set( MSG_UNSUPPTBH );
+        goto finalize;
+    }
+    
+    isCompressed = ( tbh1->m_ver == sizeof( tbhv2_t ) );
+    
+    // dimensions must not exceed the BLOB
+    if( blob_size < ( isCompressed ? tbhv2_t::dataOffset( 0 ) : tbhv1_t::dataOffset( 0 ) ) )
+    {
+        err.set( MSG_UNSUPPTBH );
+        goto finalize;
+    }
+    
+    nDims = isCompressed ? tbh2->getNumDims() : tbh1->getNumDims();
+    
+    if( nDims < 0 || blob_size < ( isCompressed ? tbhv2_t::dataOffset( nDims ) : tbhv1_t::dataOffset( nDims ) ) )
+    {
+        err.set( MSG_UNSUPPTBH );
+        goto finalize;
+    }
+    
+    for( int i = 0; i < nDims; i++ )
+    {
+        numel *= isCompressed ? tbh2->getDim( i ) : tbh1->getDim( i );
+    }
+    
+    if( !pData )
+    {
+        *pClsid = tbh1->getClsid();
+        *pNumel = numel;
+        goto finalize;
+    }
+    
+    if( *pClsid != tbh1->getClsid() || *pNumel != numel )
+    {
+        err.set( MSG_UNSUPPTBH );
+        goto finalize;
+    }
+    
+    elbytes = utils_elbytes( *pClsid );
+    
+    if( !isCompressed )
+    {
+        // uncompressed data is copied as is
+        if( blob_size - tbh1->dataOffset() < numel * elbytes )
+        {
+            err.set( MSG_UNSUPPTBH );
+            goto finalize;
+        }
+        
+        memcpy( pData, tbh1->getData(), numel * elbytes );
+    }
+    else if( numel )
+    {
+        void*  cdata      = tbh2->getData();            // get compressed data
+        size_t cdata_size = blob_size - tbh2->dataOffset(); // and its size
+        
+        numericSequence.setCompressor( tbh2->m_compression );
+        
+        // quantized data is converted before, blosc data after decompression
+        if( bSwap && numericSequence.byteswapCompressed( cdata, cdata_size ) )
+        {
+            bSwap = false;
+        }
+        
+        if( !numericSequence.unpack( cdata, cdata_size, pData, numel * elbytes, elbytes ) )
+        {
+            err.set( MSG_ERRCOMPRESSION );
+            goto finalize;
+        }
+    }
+    
+    // convert in place
+    if( bSwap )
+    {
+        ::utils_byteswap( pData, numel, elbytes );
+    }
+    
+finalize:
+    
+    sqlite3_free( pNative );
+
+    return err.getMsgId();
+}
+
+
+/// Count nonzero elements of type T (imaginary part \p pImag is optional)
+template< typename T >
+size_t blob_count_nonzeros( const void* pReal, const void* pImag, size_t count )
+{
+    const T* re  = (const T*)pReal;
+    const T* im  = (const T*)pImag;
+    size_t   nnz = 0;
+    
+    for( size_t i = 0; i < count; i++ )
+    {
+        nnz += ( re[i] != 0 || ( im && im[i] != 0 ) );
+    }
+    
+    return nnz;
+}
+
+
+/**
+ * \brief Count nonzero elements of a typed blob
+ *
+ * Bit packed and run-length coded logical arrays are counted without 
+ * expanding them into a MATLAB array. Other typed blobs are unpacked first.
+ *
+ * \param[in] pBlob Typed BLOB
+ * \param[in] blob_size Size of BLOB in bytes
+ * \param[out] pNnz Number of nonzero elements
+ */
+int blob_nnz( const void* pBlob, size_t blob_size, size_t* pNnz )
+{
+    Err err;
+    
+    typedef TypedBLOBHeaderV1 tbhv1_t;
+    typedef TypedBLOBHeaderV2 tbhv2_t;
+    
+    tbhv1_t*    tbh1    = (tbhv1_t*)pBlob;
+    tbhv2_t*    tbh2    = (tbhv2_t*)pBlob;
+    int         layout  = tbh1->isForeignEndian() ? TBH_LAYOUT_PLAIN : tbh1->getLayout();  // foreign BLOBs are unpacked
+    mxArray*    pItem   = NULL;
+    
+    assert( pNnz );
+    *pNnz = 0;
+    
+    if( layout == TBH_LAYOUT_BITPACK || layout == TBH_LAYOUT_RLE )
+    {
+        const char*             pData   = NULL;
+        size_t                  avail   = 0;
+        int                     nLanes  = 0;
+        size_t                  bytes[TypedBLOBLanes::MAX_LANES];
+        size_t                  stored[TypedBLOBLanes::MAX_LANES];
+        std::vector<uint8_t>    buffer;
+        NumberCompressor        numericSequence;
+        
+        if( tbh1->m_ver == sizeof( tbhv1_t ) && tbh1->getNumDims() >= 0 && blob_size >= tbh1->dataOffset() )
+        {
+            pData = (const char*)tbh1->getData();
+            avail = blob_size - tbh1->dataOffset();
+        }
+        else if( tbh1->m_ver == sizeof( tbhv2_t ) && tbh2->getNumDims() >= 0 && blob_size >= tbh2->dataOffset() )
+        {
+            pData = (const char*)tbh2->getData();
+            avail = blob_size - tbh2->dataOffset();
+            numericSequence.setCompressor( tbh2->m_compression );
+        }
+        
+        if( !pData || !TypedBLOBLanes::readTable( pData, avail, nLanes, bytes, stored ) || nLanes != 1 )
+        {
+            err.set( MSG_UNSUPPTBH );
+            goto finalize;
+        }
+        
+        pData += TypedBLOBLanes::tableSize( nLanes );
+        
+        // compressed lane is inflated, but not expanded
+        if( stored[0] < bytes[0] )
+        {
+            buffer.resize( bytes[0] );
+            
+            if(    tbh1->m_ver != sizeof( tbhv2_t ) 
+                || !numericSequence.unpack( (void*)pData, stored[0], &buffer[0], bytes[0], 
+                                            layout == TBH_LAYOUT_RLE ? sizeof( uint32_t ) : 1 ) )
+            {
+                err.set( MSG_ERRCOMPRESSION );
+                goto finalize;
+            }
+            
+            pData = (const char*)&buffer[0];
+        }
+        
+        if( layout == TBH_LAYOUT_BITPACK )
+        {
+            *pNnz = utils_count_bits( (const unsigned char*)pData, bytes[0] );
+        }
+        else
+        {
+            // sum up the runs of true values (odd runs)
+            for( size_t i = 1; i < bytes[0] / sizeof( uint32_t ); i += 2 )
+            {
+                uint32_t run;
+                
+                memcpy( &run, pData + i * sizeof( uint32_t ), sizeof( run ) );
+                *pNnz += run;
+            }
+        }
+    }
+    else
+    {
+        double  dummy;
+        size_t  count;
+        int     rc = blob_unpack( pBlob, blob_size, false, &pItem, &dummy, &dummy );
+        
+        if( MSG_NOERROR != rc )
+        {
+            return rc;
+        }
+        
+        const void* re = mxGetData( pItem );
+        const void* im = mxIsComplex( pItem ) ? mxGetImagData( pItem ) : NULL;
+        
+        // sparse matrices: stored elements only
+        count = mxIsSparse( pItem ) ? mxGetJc( pItem )[ mxGetN( pItem ) ] : mxGetNumberOfElements( pItem );
+        
+        switch( mxGetClassID( pItem ) )
+        {
+            case mxDOUBLE_CLASS:  *pNnz = blob_count_nonzeros<double>( re, im, count );     break;
+            case mxSINGLE_CLASS:  *pNnz = blob_count_nonzeros<float>( re, im, count );      break;
+            case mxLOGICAL_CLASS: *pNnz = blob_count_nonzeros<mxLogical>( re, im, count );  break;
+            case mxCHAR_CLASS:    *pNnz = blob_count_nonzeros<mxChar>( re, im, count );     break;
+            case mxINT8_CLASS:
+            case mxUINT8_CLASS:   *pNnz = blob_count_nonzeros<uint8_t>( re, im, count );    break;
+            case mxINT16_CLASS:
+            case mxUINT16_CLASS:  *pNnz = blob_count_nonzeros<uint16_t>( re, im, count );   break;
+            case mxINT32_CLASS:
+            case mxUINT32_CLASS:  *pNnz = blob_count_nonzeros<uint32_t>( re, im, count );   break;
+            case mxINT64_CLASS:
+            case mxUINT64_CLASS:  *pNnz = blob_count_nonzeros<uint64_t>( re, im, count );   break;
+            default:
+                err.set( MSG_UNSUPPTBH );
+                goto finalize;
+        }
+    }
+    
+finalize:
+    
+    ::utils_destroy_array( pItem );
+    
     return err.getMsgId();
 }
 
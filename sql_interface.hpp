@@ -21,10 +21,21 @@
 //#include "global.hpp"
 //#include "sqlite/sqlite3.h"
 #include "sql_builtin_functions.hpp"
+#include "sidecar.hpp"
+#include "carray.hpp"
+#include "sketches.hpp"
+#include "bloom.hpp"
+#include "checkpoint.hpp"
+#include "changefeed.hpp"
+#include "changeset.hpp"
+#include "index_advisor.hpp"
 //#include "utils.hpp"
 //#include "value.hpp"
 //#include "locale.hpp"
 #include <map>
+#include <list>
+#include <unordered_set>
+#include <unordered_map>
 
 // Handling Ctrl+C functions, see also http://undocumentedmatlab.com/blog/mex-ctrl-c-interrupt
 extern "C" bool utIsInterruptPending();
@@ -34,8 +45,8 @@ extern "C" bool utSetInterruptHandled( bool );
 /// type for column container
 typedef vector<ValueSQLCol> ValueSQLCols;
 
-extern ValueMex createItemFromValueSQL( const ValueSQL& value, int& err_id );  /* mksqlite.cpp */
-extern ValueSQL createValueSQLFromItem( const ValueMex& item, bool bStreamable, int& iTypeComplexity, int& err_id );  /* mksqlite.cpp */
+extern ValueMex createItemFromValueSQL( const ValueSQL& value, int& err_id, const SidecarStore* sidecar = NULL );  /* mksqlite.cpp */
+extern ValueSQL createValueSQLFromItem( const ValueMex& item, bool bStreamable, int& iTypeComplexity, int& err_id, SidecarStore* sidecar = NULL );  /* mksqlite.cpp */
 
 class SQLstack;
 class SQLiface;
@@ -352,16 +363,45 @@ public:
 /// Class holding an exception array, the function map and the handle for one database
 class SQLstackitem
 {
+public:
+    /// Prepared statement held in the statement cache, with its field name mapping
+    struct StmtCacheItem
+    {
+        string                          m_query;        ///< SQL query the statement was prepared from (cache key)
+        sqlite3_stmt*                   m_stmt;         ///< prepared statement (NULL while checked out)
+        ValueSQLCol::StringPairList     m_names;        ///< column names and their MATLAB field names
+        int                             m_names_stamp;  ///< name settings \p m_names was built with (-1 if not built yet)
+        int                             m_reprepared;   ///< SQLITE_STMTSTATUS_REPREPARE counter when \p m_names was built
+        int                             m_schema;       ///< schema version the statement was prepared with (see SQLstackitem::schemaVersion())
+        vector<int>                     m_carray_params;///< parameter numbers (1 based) passed to carray()
+        vector<string>                  m_param_names;  ///< parameter names (empty for unnamed parameters), one per parameter
+
+        /// Ctor
+        StmtCacheItem() : m_stmt( NULL ), m_names_stamp( -1 ), m_reprepared( 0 ), m_schema( -1 )
+        {}
+    };
+
+private:
     typedef map<string, MexFunctors*> MexFunctorsMap;   ///< Dictionary: function name => function handles
+    typedef list<StmtCacheItem>       StmtCache;        ///< Statement cache, most recently used first
+    typedef map<int, StmtCacheItem>   PreparedStmts;    ///< Dictionary: statement handle => prepared statement
 
     sqlite3*        m_db;           ///< SQLite db object
     MexFunctorsMap  m_fcnmap;       ///< MEX function map with MATLAB functions for application-defined SQL functions
     ValueMex        m_exception;    ///< MATALAB exception array, may be thrown when mksqlite function leaves
+    StmtCache       m_stmtcache;    ///< Prepared statements recently used
+    PreparedStmts   m_prepared;     ///< Prepared statements held by MATLAB handles (see 'prepare')
+    SidecarStore    m_sidecar;      ///< External storage for large typed BLOBs
+    WalCheckpointer m_checkpointer; ///< Background WAL checkpoints
+    ChangeFeed      m_changes;      ///< Row changes tracked (see 'track_changes')
+    ChangesetSession m_session;     ///< Changes recorded for incremental sync (see 'session_start')
+    IndexAdvisor    m_advisor;      ///< Statements recently run, index suggestions (see 'index_advisor')
+    sqlite3_stmt*   m_schemastmt;   ///< "PRAGMA schema_version", kept prepared for schemaVersion()
 
 public:
 
     /// Ctor
-    SQLstackitem() : m_db( NULL )
+    SQLstackitem() : m_db( NULL ), m_schemastmt( NULL )
     {}
 
 
@@ -400,6 +440,41 @@ public:
     }
 
 
+    /// Returns the sidecar storage of this database
+    SidecarStore& sidecar()
+    {
+        return m_sidecar;
+    }
+
+
+    /// Returns the WAL checkpointer of this database
+    WalCheckpointer& checkpointer()
+    {
+        return m_checkpointer;
+    }
+
+
+    /// Returns the change tracker of this database
+    ChangeFeed& changes()
+    {
+        return m_changes;
+    }
+
+
+    /// Returns the changeset session of this database
+    ChangesetSession& session()
+    {
+        return m_session;
+    }
+
+
+    /// Returns the index advisor of this database
+    IndexAdvisor& advisor()
+    {
+        return m_advisor;
+    }
+
+
     /// Progress handler (watchdog)
     static
     int progressHandler( void* data )
@@ -467,6 +542,7 @@ public:
             }
 
             sqlite3_extended_result_codes( m_db, true );
+            m_sidecar.open( sqlite3_db_filename( m_db, "MAIN" ) );
             attachBuiltinFunctions();
             utSetInterruptEnabled( true );
             setProgressHandler( true );
@@ -478,9 +554,225 @@ public:
     }
 
 
+    /**
+     * \brief Current schema version of the main database
+     *
+     * Any change to the schema (CREATE, ALTER, DROP...) increments this number.
+     * Cached statements prepared with another version may have stale column
+     * names, since SQLite re-prepares them not before sqlite3_step().
+     *
+     * \returns schema version, or -1 if it could not be read
+     */
+    int schemaVersion()
+    {
+        int version = -1;
+
+        if( !m_schemastmt && SQLITE_OK != sqlite3_prepare_v2( m_db, "PRAGMA schema_version", -1, &m_schemastmt, 0 ) )
+        {
+            sqlite3_finalize( m_schemastmt );
+            m_schemastmt = NULL;
+            return -1;
+        }
+
+        if( SQLITE_ROW == sqlite3_step( m_schemastmt ) )
+        {
+            version = sqlite3_column_int( m_schemastmt, 0 );
+        }
+        sqlite3_reset( m_schemastmt );
+
+        return version;
+    }
+
+
+    /**
+     * \brief Take a prepared statement from the statement cache
+     *
+     * \param[in] query SQL query the statement was prepared from
+     * \param[out] item Cache entry, containing the statement and its field names
+     * \returns true if a statement for \p query was cached
+     *
+     * The statement is removed from the cache until it is returned by stmtCacheCheckin().
+     */
+    bool stmtCacheCheckout( const char* query, StmtCacheItem& item )
+    {
+        for( StmtCache::iterator it = m_stmtcache.begin(); it != m_stmtcache.end(); it++ )
+        {
+            if( it->m_query == query )
+            {
+                item = *it;
+                m_stmtcache.erase( it );
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+
+    /**
+     * \brief Return a prepared statement to the statement cache
+     *
+     * \param[in,out] item Cache entry, \p item.m_stmt must be reset already
+     *
+     * Least recently used statements exceeding the cache size (\ref g_stmt_cache_size)
+     * will be finalized.
+     */
+    void stmtCacheCheckin( StmtCacheItem& item )
+    {
+        if( item.m_stmt )
+        {
+            m_stmtcache.push_front( item );
+            item.m_stmt = NULL;
+        }
+
+        stmtCacheTrim();
+    }
+
+
+    /// Finalize least recently used statements exceeding the cache size
+    void stmtCacheTrim()
+    {
+        while( (int)m_stmtcache.size() > std::max( g_stmt_cache_size, 0 ) )
+        {
+            sqlite3_finalize( m_stmtcache.back().m_stmt );
+            m_stmtcache.pop_back();
+        }
+    }
+
+
+    /// Finalize all cached statements
+    void stmtCacheClear()
+    {
+        for( StmtCache::iterator it = m_stmtcache.begin(); it != m_stmtcache.end(); it++ )
+        {
+            sqlite3_finalize( it->m_stmt );
+        }
+        m_stmtcache.clear();
+    }
+
+
+    /**
+     * \brief Keep a prepared statement for a MATLAB handle
+     *
+     * \param[in] handle Statement handle
+     * \param[in,out] item Statement and its meta data, \p item.m_stmt is taken over
+     */
+    void preparedAdd( int handle, StmtCacheItem& item )
+    {
+        assert( item.m_stmt && !m_prepared.count( handle ) );
+        m_prepared[handle] = item;
+        item.m_stmt = NULL;
+    }
+
+
+    /**
+     * \brief Take the prepared statement of a MATLAB handle
+     *
+     * \param[in] handle Statement handle
+     * \param[out] item Statement and its meta data
+     * \returns false if \p handle is unknown (or the statement is in use)
+     *
+     * The statement remains with the handle, but is marked as in use until
+     * it is returned by preparedCheckin().
+     */
+    bool preparedCheckout( int handle, StmtCacheItem& item )
+    {
+        PreparedStmts::iterator it = m_prepared.find( handle );
+
+        if( it == m_prepared.end() || !it->second.m_stmt )
+        {
+            return false;
+        }
+
+        item = it->second;
+        it->second.m_stmt = NULL;
+
+        return true;
+    }
+
+
+    /**
+     * \brief Return the prepared statement of a MATLAB handle
+     *
+     * \param[in] handle Statement handle
+     * \param[in,out] item Statement and its meta data, \p item.m_stmt must be reset already
+     */
+    void preparedCheckin( int handle, StmtCacheItem& item )
+    {
+        PreparedStmts::iterator it = m_prepared.find( handle );
+
+        assert( it != m_prepared.end() && !it->second.m_stmt );
+
+        if( it != m_prepared.end() )
+        {
+            it->second = item;
+        }
+        else
+        {
+            sqlite3_finalize( item.m_stmt );
+        }
+
+        item.m_stmt = NULL;
+    }
+
+
+    /**
+     * \brief Finalize the prepared statement of a MATLAB handle
+     *
+     * \param[in] handle Statement handle
+     * \returns false if \p handle is unknown
+     */
+    bool preparedFinalize( int handle )
+    {
+        PreparedStmts::iterator it = m_prepared.find( handle );
+
+        if( it == m_prepared.end() || !it->second.m_stmt )
+        {
+            return false;
+        }
+
+        sqlite3_finalize( it->second.m_stmt );
+        m_prepared.erase( it );
+
+        return true;
+    }
+
+
+    /// Finalize all statements held by MATLAB handles
+    void preparedClear()
+    {
+        for( PreparedStmts::iterator it = m_prepared.begin(); it != m_prepared.end(); it++ )
+        {
+            sqlite3_finalize( it->second.m_stmt );
+        }
+        m_prepared.clear();
+    }
+
+
     /// Close database
     bool closeDb( SQLerror& err )
     {
+        // Cached statements would keep the database from closing
+        stmtCacheClear();
+        preparedClear();
+        sqlite3_finalize( m_schemastmt );
+        m_schemastmt = NULL;
+        
+        // Sidecar storage has to be activated for each database opened
+        m_sidecar.close();
+        
+        // Checkpointer holds its own connection to the database file
+        m_checkpointer.stop();
+        
+        // Change tracking has to be activated for each database opened
+        m_changes.stop();
+        
+        // Sessions must be deleted before the database is closed
+        m_session.stop();
+        
+        // Statements recorded refer to this database
+        m_advisor.clear();
+
         // Deallocate functors
         for( MexFunctorsMap::iterator it = m_fcnmap.begin(); it != m_fcnmap.end(); it++ )
         {
@@ -521,6 +813,8 @@ public:
      * - bdcpacktime
      * - bdcunpacktime
      * - md5
+     * - approx_count_distinct, approx_quantile (and their sketches)
+     * - bloom_build, bloom_contains
      */
     void attachBuiltinFunctions()
     {
@@ -537,10 +831,15 @@ public:
             sqlite3_create_function( m_db, "exp", 1, SQLITE_UTF8, NULL, exp_func, NULL, NULL );                       // power function (math)
             sqlite3_create_function( m_db, "regex", 2, SQLITE_UTF8, NULL, regex_func, NULL, NULL );                   // regular expressions (MATCH mode)
             sqlite3_create_function( m_db, "regex", 3, SQLITE_UTF8, NULL, regex_func, NULL, NULL );                   // regular expressions (REPLACE mode)
+            sqlite3_create_function( m_db, "regexp", 2, SQLITE_UTF8, NULL, regexp_func, NULL, NULL );                 // REGEXP operator
             sqlite3_create_function( m_db, "bdcratio", 1, SQLITE_UTF8, NULL, BDC_ratio_func, NULL, NULL );            // compression ratio (blob data compression)
             sqlite3_create_function( m_db, "bdcpacktime", 1, SQLITE_UTF8, NULL, BDC_pack_time_func, NULL, NULL );     // compression time (blob data compression)
             sqlite3_create_function( m_db, "bdcunpacktime", 1, SQLITE_UTF8, NULL, BDC_unpack_time_func, NULL, NULL ); // decompression time (blob data compression)
             sqlite3_create_function( m_db, "md5", 1, SQLITE_UTF8, NULL, MD5_func, NULL, NULL );                       // Message-Digest (RSA)
+            sqlite3_create_function( m_db, "blob_nnz", 1, SQLITE_UTF8, NULL, BLOB_nnz_func, NULL, NULL );             // nonzero elements of a typed blob
+            CarrayModule::attach( m_db );                                                                             // table-valued function carray()
+            SketchFunctions::attach( m_db );                                                                          // approximate distinct counts and quantiles
+            BloomFunctions::attach( m_db );                                                                           // Bloom filters (semi-join prefiltering)
         }
     }
 };
@@ -550,6 +849,110 @@ public:
 
 
 
+/**
+ * \brief Fast binding of real numeric scalars
+ *
+ * Parameters are usually converted by createValueSQLFromItem(), which
+ * dispatches on type complexity and class for each value. For a batch of
+ * parameters (parameter wrapping) the binder kernel for a parameter is 
+ * selected once by the class of its first value, following values of
+ * the same class are bound directly from their data.
+ */
+class ScalarBinder
+{
+public:
+    /// Binder kernel
+    typedef int (*BindFcn)( sqlite3_stmt* stmt, int index, const void* pData );
+
+private:
+    mxClassID   m_clsid;    ///< MATLAB class the kernel is made for
+    BindFcn     m_fcn;      ///< kernel, NULL if values need the common conversion
+    bool        m_selected; ///< true, if the kernel has been selected
+
+    /// Kernel for integer classes
+    template< typename T >
+    static
+    int bindInteger( sqlite3_stmt* stmt, int index, const void* pData )
+    {
+        return sqlite3_bind_int64( stmt, index, (sqlite3_int64)*(const T*)pData );
+    }
+
+    /// Kernel for floating point classes (NaN is bound as NULL by SQLite)
+    template< typename T >
+    static
+    int bindFloat( sqlite3_stmt* stmt, int index, const void* pData )
+    {
+        return sqlite3_bind_double( stmt, index, (double)*(const T*)pData );
+    }
+
+    /// Returns true, if \p item is a real, non-sparse scalar
+    static
+    bool isRealScalar( const mxArray* item )
+    {
+        return mxGetNumberOfElements( item ) == 1 && !mxIsComplex( item ) && !mxIsSparse( item );
+    }
+
+public:
+    /// Ctor
+    ScalarBinder() : m_clsid( mxUNKNOWN_CLASS ), m_fcn( NULL ), m_selected( false )
+    {}
+
+
+    /// Returns true, if the kernel has been selected
+    bool isSelected() const
+    {
+        return m_selected;
+    }
+
+
+    /// Select the kernel by the first value \p item of a parameter
+    void select( const mxArray* item )
+    {
+        m_selected = true;
+        m_clsid    = item ? mxGetClassID( item ) : mxUNKNOWN_CLASS;
+        m_fcn      = NULL;
+
+        if( !item || !isRealScalar( item ) )
+        {
+            return;
+        }
+
+        switch( m_clsid )
+        {
+            case mxLOGICAL_CLASS: m_fcn = &bindInteger<mxLogical>; break;
+            case mxINT8_CLASS:    m_fcn = &bindInteger<int8_t>;    break;
+            case mxUINT8_CLASS:   m_fcn = &bindInteger<uint8_t>;   break;
+            case mxINT16_CLASS:   m_fcn = &bindInteger<int16_t>;   break;
+            case mxUINT16_CLASS:  m_fcn = &bindInteger<uint16_t>;  break;
+            case mxINT32_CLASS:   m_fcn = &bindInteger<int32_t>;   break;
+            case mxUINT32_CLASS:  m_fcn = &bindInteger<uint32_t>;  break;
+            case mxINT64_CLASS:   m_fcn = &bindInteger<int64_t>;   break;
+            case mxSINGLE_CLASS:  m_fcn = &bindFloat<float>;       break;
+            case mxDOUBLE_CLASS:  m_fcn = &bindFloat<double>;      break;
+            default:
+                // uint64, strings, cells, ... need the common conversion
+                break;
+        }
+    }
+
+
+    /// Returns true, if \p item can be bound by the selected kernel
+    bool accepts( const mxArray* item ) const
+    {
+        return m_fcn && item && mxGetClassID( item ) == m_clsid && isRealScalar( item );
+    }
+
+
+    /// Bind \p item to parameter \p index (1 based), \p item must be accepted
+    int bind( sqlite3_stmt* stmt, int index, const mxArray* item ) const
+    {
+        assert( accepts( item ) );
+        return m_fcn( stmt, index, mxGetData( item ) );
+    }
+};
+
+
+
 /**
  * \brief SQLite interface
  *
@@ -557,10 +960,14 @@ public:
  */
 class SQLiface
 {
+    typedef SQLstackitem::StmtCacheItem StmtCacheItem;
+
     SQLstackitem*   m_pstackitem;   ///< pointer to current database
     sqlite3*        m_db;           ///< SQLite db handle
     const char*     m_command;      ///< SQL query (no ownership, read-only!)
     sqlite3_stmt*   m_stmt;         ///< SQL statement (sqlite bridge)
+    StmtCacheItem   m_stmtinfo;     ///< Cache information (query and field names) for \p m_stmt
+    int             m_handle;       ///< MATLAB handle \p m_stmt belongs to (0: statement cache)
     SQLerror        m_lasterr;      ///< recent error message
           
 public:
@@ -571,7 +978,8 @@ public:
     m_pstackitem( &stackitem ),
     m_db( stackitem.dbid() ),
     m_command( NULL ),
-    m_stmt( NULL )
+    m_stmt( NULL ),
+    m_handle( 0 )
   {
       // Multiple calls of sqlite3_initialize() are harmless no-ops
       sqlite3_initialize();
@@ -636,47 +1044,535 @@ public:
           return NULL;
       }
 
-      return sqlite3_db_filename( m_db, database ? database : "MAIN" );
-  }
+      return sqlite3_db_filename( m_db, database ? database : "MAIN" );
+  }
+
+
+  /// Sets the busy timemout in milliseconds
+  bool setBusyTimeout( int iTimeoutValue )
+  {
+      if( !isOpen() )
+      {
+          assert( false );
+          return false;
+      }
+      
+      int rc = sqlite3_busy_timeout( m_db, iTimeoutValue );
+      if( SQLITE_OK != rc )
+      {
+          setSqlError( rc );
+          return false;
+      }
+      return true;
+  }
+  
+  
+  /// Returns the busy timeout in milliseconds
+  bool getBusyTimeout( int& iTimeoutValue )
+  {
+      if( !isOpen() )
+      {
+          assert( false );
+          return false;
+      }
+      
+      int rc = sqlite3_busy_timeout( m_db, iTimeoutValue );
+      if( SQLITE_OK != rc )
+      {
+          setSqlError( rc );
+          return false;
+      }
+      return true;
+  }
+  
+
+  /// Returns the sidecar storage of current database
+  SidecarStore* getSidecar()
+  {
+      return m_pstackitem ? &m_pstackitem->sidecar() : NULL;
+  }
+
+
+  /**
+   * \brief Activates sidecar storage for typed BLOBs of the main database
+   *
+   * \param[in] threshold Minimum size in bytes of typed BLOBs to store in the sidecar, 0 deactivates
+   * \returns true on success
+   */
+  bool setSidecar( size_t threshold )
+  {
+      if( !isOpen() )
+      {
+          assert( false );
+          return false;
+      }
+
+      int err_id = m_pstackitem->sidecar().attach( threshold );
+      if( MSG_NOERROR != err_id )
+      {
+          setErr( err_id );
+          return false;
+      }
+      return true;
+  }
+
+
+  /**
+   * \brief Deletes sidecar segments, which are not referenced anymore
+   *
+   * \param[out] removed Number of segment files deleted
+   * \returns true on success
+   */
+  bool collectSidecar( int& removed )
+  {
+      removed = 0;
+
+      if( !isOpen() )
+      {
+          assert( false );
+          return false;
+      }
+
+      int err_id = m_pstackitem->sidecar().collect( m_db, &removed );
+      if( MSG_NOERROR != err_id )
+      {
+          setErr( err_id );
+          return false;
+      }
+      return true;
+  }
+  
+
+  /**
+   * \brief Starts or stops background WAL checkpoints of the main database
+   *
+   * \param[in] threshold WAL frames triggering a passive checkpoint, 0 stops
+   * \param[in] interval_ms Wake-up interval of the checkpointer thread
+   * \returns true on success
+   */
+  bool setCheckpointer( int threshold, int interval_ms )
+  {
+      if( !isOpen() )
+      {
+          assert( false );
+          return false;
+      }
+
+      if( threshold <= 0 )
+      {
+          m_pstackitem->checkpointer().stop();
+          return true;
+      }
+
+      int err_id = m_pstackitem->checkpointer().start( m_db, threshold, interval_ms );
+      if( MSG_NOERROR != err_id )
+      {
+          setErr( err_id );
+          return false;
+      }
+      return true;
+  }
+
+
+  /// Returns the statistics of the WAL checkpointer
+  WalCheckpointer::Stats getCheckpointerStats()
+  {
+      return m_pstackitem ? m_pstackitem->checkpointer().stats() : WalCheckpointer::Stats();
+  }
+
+
+  /**
+   * \brief Starts or stops tracking of row changes
+   *
+   * \param[in] bEnable Start (restart) or stop tracking
+   * \param[in] tables Names of the tables to track, all tables if empty
+   * \param[in] capacity Number of committed changes kept until taken
+   * \returns true on success
+   */
+  bool setChangeTracking( bool bEnable, const vector<string>& tables, size_t capacity )
+  {
+      if( !isOpen() )
+      {
+          assert( false );
+          return false;
+      }
+
+      if( bEnable )
+      {
+          m_pstackitem->changes().start( m_db, tables, capacity );
+      }
+      else
+      {
+          m_pstackitem->changes().stop();
+      }
+      return true;
+  }
+
+
+  /// Returns the change tracker of the database
+  ChangeFeed& getChangeFeed()
+  {
+      assert( m_pstackitem );
+      return m_pstackitem->changes();
+  }
+
+
+  /**
+   * \brief Starts or stops recording changes for changesets
+   *
+   * \param[in] bEnable Start (restart) or stop the session
+   * \param[in] tables Names of the tables to record, all tables if empty
+   * \returns true on success
+   */
+  bool setSession( bool bEnable, const vector<string>& tables )
+  {
+      if( !isOpen() )
+      {
+          assert( false );
+          return false;
+      }
+
+      if( !bEnable )
+      {
+          m_pstackitem->session().stop();
+          return true;
+      }
+
+      int rc = m_pstackitem->session().start( m_db, tables );
+      if( SQLITE_OK != rc )
+      {
+          setResultCodeError( rc );
+          return false;
+      }
+      return true;
+  }
+
+
+  /// Returns true if a session records changes
+  bool isSessionRunning()
+  {
+      return m_pstackitem && m_pstackitem->session().running();
+  }
+
+
+  /**
+   * \brief Takes the changeset of the session, which is restarted
+   *
+   * Refused while a transaction is open, its changes could be rolled back.
+   *
+   * \param[out] changeset Changes since the session (re-)started
+   * \returns true on success
+   */
+  bool takeChangeset( string& changeset )
+  {
+      if( !isSessionRunning() )
+      {
+          setErr( MSG_NOSESSION );
+          return false;
+      }
+
+      // the session records uncommitted changes as well
+      if( !sqlite3_get_autocommit( m_db ) )
+      {
+          setErr( MSG_SESSIONINTRANSACTION );
+          return false;
+      }
+
+      int rc = m_pstackitem->session().take( changeset );
+      if( SQLITE_OK != rc )
+      {
+          setResultCodeError( rc );
+          return false;
+      }
+      return true;
+  }
+
+
+  /**
+   * \brief Applies a changeset to the main database
+   *
+   * \param[in] changeset Changeset (see takeChangeset())
+   * \param[in] policy Conflict resolution
+   * \param[out] conflicts Conflicts occurred
+   * \returns true on success
+   */
+  bool applyChangeset( const string& changeset, ChangesetSession::policy_e policy, ChangesetSession::Conflicts& conflicts )
+  {
+      if( !isOpen() )
+      {
+          assert( false );
+          return false;
+      }
+
+      int rc = ChangesetSession::apply( m_db, changeset, policy, conflicts );
+      if( SQLITE_ABORT == rc && ChangesetSession::POLICY_ABORT == policy && conflicts.total() )
+      {
+          setErr( MSG_CHANGESETABORT );
+          return false;
+      }
+      if( SQLITE_CORRUPT == rc )
+      {
+          setErr( MSG_INVALIDCHANGESET );
+          return false;
+      }
+      if( SQLITE_OK != rc )
+      {
+          setResultCodeError( rc );
+          return false;
+      }
+      return true;
+  }
+
+
+  /// Records a statement run for the index advisor
+  void recordQuery( const char* query )
+  {
+      if( m_pstackitem )
+      {
+          m_pstackitem->advisor().record( query );
+      }
+  }
+
+
+  /**
+   * \brief Suggests indexes for statements
+   *
+   * \param[in,out] statements SQL statements, the statements recently run if empty
+   * \param[in] bTimed Time the statements with and without each index suggested
+   * \param[out] suggestions Indexes suggested, highest estimated benefit first
+   * \returns true on success
+   */
+  bool adviseIndexes( vector<string>& statements, bool bTimed, vector<IndexAdvisor::Suggestion>& suggestions )
+  {
+      if( !isOpen() )
+      {
+          assert( false );
+          return false;
+      }
+
+      if( statements.empty() )
+      {
+          statements = m_pstackitem->advisor().history();
+      }
+
+      int rc = m_pstackitem->advisor().advise( m_db, statements, bTimed, suggestions );
+      if( SQLITE_OK != rc )
+      {
+          setResultCodeError( rc );
+          return false;
+      }
+      return true;
+  }
+
+
+  /// Sets an error by its result code (no message set at the database, i.e. session extension)
+  void setResultCodeError( int rc )
+  {
+      m_lasterr.set_printf( sqlite3_errstr( rc ), m_lasterr.trans_err_to_ident( rc ) );
+  }
+
+
+  /**
+   * \brief Runs a checkpoint of the main database synchronously
+   *
+   * \param[in] mode SQLITE_CHECKPOINT_PASSIVE, _FULL, _RESTART or _TRUNCATE
+   * \param[out] nLog Frames in the WAL
+   * \param[out] nCkpt Frames checkpointed
+   * \param[out] bBusy true if the checkpoint was blocked by other connections
+   * \returns true on success
+   */
+  bool walCheckpoint( int mode, int& nLog, int& nCkpt, bool& bBusy )
+  {
+      if( !isOpen() )
+      {
+          assert( false );
+          return false;
+      }
+
+      int rc = sqlite3_wal_checkpoint_v2( m_db, "main", mode, &nLog, &nCkpt );
+
+      bBusy = ( SQLITE_BUSY == rc );
+      if( SQLITE_OK != rc && !bBusy )
+      {
+          setSqlError( rc );
+          return false;
+      }
+      return true;
+  }
+
+
+  /// Returns the text from \p begin to \p end without leading white spaces and comments
+  static
+  string stripLeadingComments( const char* begin, const char* end )
+  {
+      for(;;)
+      {
+          while( begin < end && isspace( (unsigned char)*begin ) ) begin++;
+
+          if( end - begin >= 2 && begin[0] == '-' && begin[1] == '-' )
+          {
+              while( begin < end && *begin != '\n' ) begin++;
+          }
+          else if( end - begin >= 2 && begin[0] == '/' && begin[1] == '*' )
+          {
+              const char* stop = strstr( begin + 2, "*/" );
+              begin = ( stop && stop + 2 <= end ) ? stop + 2 : end;
+          }
+          else
+          {
+              return string( begin, end - begin );
+          }
+      }
+  }
+
+
+  /**
+   * \brief Executes all statements of a SQL script
+   *
+   * Statements are prepared one after another from the tail of the
+   * previous one. Result rows are discarded. If \p bTransaction is set,
+   * the script runs inside one transaction, which is rolled back on
+   * failure.
+   *
+   * \param[in] script SQL statements (UTF-8)
+   * \param[in] bTransaction true to run the script inside one transaction
+   * \param[out] changes Number of rows changed, for each statement
+   * \param[out] times Execution time in seconds, for each statement
+   * \param[out] texts SQL text, for each statement
+   * \returns true on success
+   */
+  bool execScript( const char* script, bool bTransaction, vector<int>& changes, 
+                   vector<double>& times, vector<string>& texts )
+  {
+      const char* tail = script;
+      int rc = SQLITE_OK;
+
+      if( !isOpen() )
+      {
+          assert( false );
+          return false;
+      }
+
+      // statement cache is not involved
+      closeStmt();
+
+      if( bTransaction )
+      {
+          rc = sqlite3_exec( m_db, "BEGIN;", NULL, NULL, NULL );
+          if( SQLITE_OK != rc )
+          {
+              setSqlError( rc );
+              return false;
+          }
+      }
+
+      while( SQLITE_OK == rc && tail && *tail )
+      {
+          sqlite3_stmt* stmt  = NULL;
+          const char*   sql   = tail;
+          double        start = utils_get_wall_time();
+          int           total = sqlite3_total_changes( m_db );
+
+          rc = sqlite3_prepare_v2( m_db, sql, -1, &stmt, &tail );
+
+          if( SQLITE_OK != rc || !stmt )
+          {
+              // error, or white spaces and comments only
+              continue;
+          }
+
+          do
+          {
+              rc = sqlite3_step( stmt );
+          }
+          while( SQLITE_ROW == rc );
 
+          sqlite3_finalize( stmt );
 
-  /// Sets the busy timemout in milliseconds
-  bool setBusyTimeout( int iTimeoutValue )
-  {
-      if( !isOpen() )
-      {
-          assert( false );
-          return false;
+          if( SQLITE_DONE == rc )
+          {
+              rc = SQLITE_OK;
+              changes.push_back( sqlite3_total_changes( m_db ) - total );
+              times.push_back( utils_get_wall_time() - start );
+              texts.push_back( stripLeadingComments( sql, tail ) );
+          }
       }
-      
-      int rc = sqlite3_busy_timeout( m_db, iTimeoutValue );
+
       if( SQLITE_OK != rc )
       {
-          setSqlError( rc );
+          // report failing statement by its number
+          int errcode = sqlite3_extended_errcode( m_db );
+          m_lasterr.set_printf( ::getLocaleMsg( MSG_SCRIPTSTMT ), m_lasterr.trans_err_to_ident( errcode ),
+                                (int)texts.size() + 1, sqlite3_errmsg( m_db ) );
+
+          if( bTransaction && !sqlite3_get_autocommit( m_db ) )
+          {
+              sqlite3_exec( m_db, "ROLLBACK;", NULL, NULL, NULL );
+          }
           return false;
       }
+
+      if( bTransaction )
+      {
+          rc = sqlite3_exec( m_db, "COMMIT;", NULL, NULL, NULL );
+          if( SQLITE_OK != rc )
+          {
+              setSqlError( rc );
+              sqlite3_exec( m_db, "ROLLBACK;", NULL, NULL, NULL );
+              return false;
+          }
+      }
+
       return true;
   }
-  
-  
-  /// Returns the busy timeout in milliseconds
-  bool getBusyTimeout( int& iTimeoutValue )
+
+
+  /**
+   * \brief Fetch (rowid, rank) pairs of a query
+   *
+   * Used for full text searches, the query must return the rowid in its
+   * first and a numeric rank in its second column.
+   *
+   * \param[in] query SQL statement (UTF-8)
+   * \param[out] rowids Values of the first column
+   * \param[out] ranks Values of the second column
+   * \returns true on success
+   */
+  bool queryRankedRowids( const char* query, vector<sqlite3_int64>& rowids, vector<double>& ranks )
   {
+      sqlite3_stmt* stmt = NULL;
+      int rc;
+
       if( !isOpen() )
       {
           assert( false );
           return false;
       }
-      
-      int rc = sqlite3_busy_timeout( m_db, iTimeoutValue );
-      if( SQLITE_OK != rc )
+
+      // statement cache is not involved
+      closeStmt();
+
+      rc = sqlite3_prepare_v2( m_db, query, -1, &stmt, NULL );
+
+      if( SQLITE_OK == rc && stmt )
+      {
+          while( SQLITE_ROW == ( rc = sqlite3_step( stmt ) ) )
+          {
+              rowids.push_back( sqlite3_column_int64( stmt, 0 ) );
+              ranks.push_back( sqlite3_column_double( stmt, 1 ) );
+          }
+      }
+
+      if( SQLITE_DONE != rc && SQLITE_OK != rc )
       {
           setSqlError( rc );
-          return false;
       }
-      return true;
+
+      sqlite3_finalize( stmt );
+
+      return SQLITE_DONE == rc || SQLITE_OK == rc;
   }
-  
+
 
   /// Enable or disable load extensions
   bool setEnableLoadExtension( int flagOnOff )
@@ -697,7 +1593,7 @@ public:
   }
   
   
-  /// Closing current statement
+  /// Closing current statement (statement returns to the statement cache)
   void closeStmt()
   {
       if( m_stmt )
@@ -705,8 +1601,19 @@ public:
           // sqlite3_reset() does not reset the bindings on a prepared statement!
           sqlite3_clear_bindings( m_stmt );
           sqlite3_reset( m_stmt );
-          sqlite3_finalize( m_stmt );
+          m_stmtinfo.m_stmt = m_stmt;
+
+          if( m_handle )
+          {
+              m_pstackitem->preparedCheckin( m_handle, m_stmtinfo );
+          }
+          else
+          {
+              m_pstackitem->stmtCacheCheckin( m_stmtinfo );
+          }
+
           m_stmt = NULL;
+          m_handle = 0;
           m_command = NULL;
       }
   }
@@ -909,16 +1816,8 @@ public:
                                   break;
 
                               case SQLITE_INTEGER:
-                                  if( (int)item.ClassID() == (int)ValueMex::INT64_CLASS )
-                                  {
-                                      // scalar integer value
-                                      sqlite3_result_int64( ctx, item.GetInt64() );
-                                  }
-                                  else
-                                  {
-                                      // scalar integer value
-                                      sqlite3_result_int( ctx, item.GetInt() );
-                                  }
+                                  // scalar integer value
+                                  sqlite3_result_int64( ctx, value.m_integer );
                                   break;
 
                               case SQLITE_TEXT:
@@ -1067,6 +1966,143 @@ public:
           return false;
       }
 
+      // Close previous statement, if any
+      closeStmt();
+      
+      // Recently used statements need not to be prepared again
+      if( m_pstackitem->stmtCacheCheckout( query, m_stmtinfo ) )
+      {
+          if( m_stmtinfo.m_schema == m_pstackitem->schemaVersion() )
+          {
+              m_stmt = m_stmtinfo.m_stmt;
+              m_stmtinfo.m_stmt = NULL;
+              m_command = query;
+              return true;
+          }
+
+          // Schema changed, columns (e.g. of "SELECT *") may differ now
+          sqlite3_finalize( m_stmtinfo.m_stmt );
+          m_stmtinfo = StmtCacheItem();
+      }
+
+      return prepareStmt( query );
+  }
+
+
+  /**
+   * \brief Prepare a SQL query to be held by a MATLAB handle
+   *
+   * Parameter and column names are resolved here once, not on each
+   * execution.
+   *
+   * \param[in] query String containing SQL statement
+   * \param[in] handle Statement handle (see SQLstackitem::preparedAdd())
+   * \param[out] names Column names and their MATLAB field names
+   */
+  bool prepareHandle( const char* query, int handle, ValueSQLCol::StringPairList& names )
+  {
+      if( !isOpen() )
+      {
+          assert( false );
+          return false;
+      }
+
+      closeStmt();
+
+      if( !prepareStmt( query ) )
+      {
+          return false;
+      }
+
+      if( !m_stmt )
+      {
+          // no statement (only white spaces or comments)
+          setErr( MSG_INVQUERY );
+          return false;
+      }
+
+      getColNames( names );
+
+      if( errPending() )
+      {
+          closeStmt();
+          return false;
+      }
+
+      m_stmtinfo.m_stmt = m_stmt;
+      m_pstackitem->preparedAdd( handle, m_stmtinfo );
+      m_stmt = NULL;
+      m_command = NULL;
+
+      return true;
+  }
+
+
+  /**
+   * \brief Dispatch the SQL query held by a MATLAB handle
+   *
+   * \param[in] handle Statement handle
+   */
+  bool setPrepared( int handle )
+  {
+      if( !isOpen() )
+      {
+          assert( false );
+          return false;
+      }
+
+      closeStmt();
+
+      if( !m_pstackitem->preparedCheckout( handle, m_stmtinfo ) )
+      {
+          setErr( MSG_INVALIDSTMTHANDLE );
+          return false;
+      }
+
+      m_stmt = m_stmtinfo.m_stmt;
+      m_stmtinfo.m_stmt = NULL;
+      m_handle = handle;
+      m_command = m_stmtinfo.m_query.c_str();
+
+      if( m_stmtinfo.m_schema != m_pstackitem->schemaVersion() )
+      {
+          // Schema changed, prepare the query again (columns may differ now)
+          sqlite3_stmt* stale = m_stmt;
+          StmtCacheItem info = m_stmtinfo;
+
+          m_stmt = NULL;
+          if( !prepareStmt( info.m_query.c_str() ) )
+          {
+              // Keep the statement with its handle, so it can still be finalized
+              m_stmt = stale;
+              m_stmtinfo = info;
+              m_command = m_stmtinfo.m_query.c_str();
+              return false;
+          }
+
+          sqlite3_finalize( stale );
+          m_command = m_stmtinfo.m_query.c_str();
+      }
+
+      return true;
+  }
+
+
+  /// Returns the parameter names of the current statement (empty for unnamed parameters)
+  const vector<string>& getParameterNames()
+  {
+      return m_stmtinfo.m_param_names;
+  }
+
+
+private:
+  /**
+   * \brief Prepare a SQL query and resolve its parameters
+   *
+   * \param[in] query String containing SQL statement
+   */
+  bool prepareStmt( const char* query )
+  {
       /*
        * complete the query
        */
@@ -1077,9 +2113,6 @@ public:
           return false;
       }
 
-      // Close previous statement, if any
-      closeStmt();
-      
       /*
        * and prepare it
        * if anything is wrong with the query, than complain about it.
@@ -1091,21 +2124,47 @@ public:
           return false;
       }
       
+      m_stmtinfo = StmtCacheItem();
+      m_stmtinfo.m_query = query;
+      m_stmtinfo.m_schema = m_pstackitem->schemaVersion();
+      carray_find_params( m_stmt, query, m_stmtinfo.m_carray_params );
+
+      // parameter names are kept, so binding by name needs no further lookup
+      m_stmtinfo.m_param_names.resize( sqlite3_bind_parameter_count( m_stmt ) );
+      for( int i = 0; i < (int)m_stmtinfo.m_param_names.size(); i++ )
+      {
+          const char* name = sqlite3_bind_parameter_name( m_stmt, i + 1 );
+          m_stmtinfo.m_param_names[i] = name ? name : "";
+      }
+
       m_command = query;
       return true;
   }
+
+public:
   
   
   /// Returns the count of parameters the current statement expects
   int getParameterCount()
   {
-      return m_stmt ? sqlite3_bind_parameter_count( m_stmt ) : 0;
+      return m_stmt ? (int)m_stmtinfo.m_param_names.size() : 0;
   }
   
-  /// Returns the name for nth parameter
+  /// Returns the name for nth parameter (1 based), NULL for unnamed parameters
   const char* getParameterName( int n )
   {
-      return m_stmt ? sqlite3_bind_parameter_name( m_stmt, n ) : NULL;
+      if( !m_stmt || n < 1 || n > (int)m_stmtinfo.m_param_names.size() || m_stmtinfo.m_param_names[n-1].empty() )
+      {
+          return NULL;
+      }
+      return m_stmtinfo.m_param_names[n-1].c_str();
+  }
+  
+  /// Returns true, if parameter \p index (1 based) is the argument of carray()
+  bool isCarrayParameter( int index )
+  {
+      const vector<int>& params = m_stmtinfo.m_carray_params;
+      return find( params.begin(), params.end(), index ) != params.end();
   }
   
   /// kv69: Returns the number of last row id; usefull for inserts in tables with autoincrement primary keys
@@ -1125,6 +2184,59 @@ public:
   }
   
   
+  /**
+   * \brief Binds a real numeric scalar by a binder kernel
+   *
+   * \param[in] index Parameter number (1 based)
+   * \param[in] binder Binder kernel selected for this parameter
+   * \param[in] item MATLAB array, accepted by \p binder
+   */
+  bool bindScalar( int index, const ScalarBinder& binder, const mxArray* item )
+  {
+      int rc = binder.bind( m_stmt, index, item );
+      if( SQLITE_OK != rc )
+      {
+          setSqlError( rc );
+          return false;
+      }
+
+      return true;
+  }
+
+
+  /**
+   * \brief Binds a MATLAB array to a parameter passed to carray()
+   *
+   * The array is referenced, not copied. The binding is released when the
+   * statement is reset (see closeStmt()).
+   *
+   * \param[in] index Parameter number (1 based)
+   * \param[in] item MATLAB array
+   */
+  bool bindCarray( int index, const ValueMex& item )
+  {
+      CarrayBinding* binding = new CarrayBinding;
+      int err_id = binding->assign( item.Item() );
+
+      if( MSG_NOERROR != err_id )
+      {
+          delete binding;
+          setErr( err_id );
+          return false;
+      }
+
+      // binding is destroyed by SQLite, even on failure
+      int rc = sqlite3_bind_pointer( m_stmt, index, binding, CARRAY_POINTER_TYPE, CarrayBinding::destroy );
+      if( SQLITE_OK != rc )
+      {
+          setSqlError( rc );
+          return false;
+      }
+
+      return true;
+  }
+
+
   /**
    * \brief Binds one parameter from current statement to a MATLAB array
    *
@@ -1140,7 +2252,12 @@ public:
 
       assert( isOpen() );
 
-      ValueSQL value = createValueSQLFromItem( item, bStreamable, iTypeComplexity, err_id );
+      if( isCarrayParameter( index ) )
+      {
+          return bindCarray( index, item );
+      }
+
+      ValueSQL value = createValueSQLFromItem( item, bStreamable, iTypeComplexity, err_id, getSidecar() );
 
       if( MSG_NOERROR != err_id )
       {
@@ -1168,23 +2285,11 @@ public:
               break;
 
           case SQLITE_INTEGER:
-              if( (int)item.ClassID() == (int)ValueMex::INT64_CLASS )
-              {
-                  // scalar integer value
-                  rc = sqlite3_bind_int64( m_stmt, index, item.GetInt64() );
-                  if( SQLITE_OK != rc )
-                  {
-                      setSqlError( rc );
-                  }
-              }
-              else
+              // scalar integer value (64 bit, uint32 exceeds int)
+              rc = sqlite3_bind_int64( m_stmt, index, value.m_integer );
+              if( SQLITE_OK != rc )
               {
-                  // scalar integer value
-                  rc = sqlite3_bind_int( m_stmt, index, item.GetInt() );
-                  if( SQLITE_OK != rc )
-                  {
-                      setSqlError( rc );
-                  }
+                  setSqlError( rc );
               }
               break;
 
@@ -1323,18 +2428,66 @@ public:
    * fieldnames must be unambiguous. So there is a second name which
    * is used to be that fieldname. Column name and field name are 
    * represented by string pairs.
+   * The name mapping is kept with the (cached) statement, so it is
+   * built only once, as long as the statement isn't re-prepared and
+   * the name settings (\ref g_namelengthmax, \ref g_check4uniquefields)
+   * don't change.
    *
    * \param[out] names String pair list for column names
    * \returns Column count
    */
   int getColNames( ValueSQLCol::StringPairList& names )
   {
+      const int names_stamp = 2 * g_namelengthmax + ( g_check4uniquefields ? 1 : 0 );
+      const int reprepared  = m_stmt ? sqlite3_stmt_status( m_stmt, SQLITE_STMTSTATUS_REPREPARE, 0 ) : 0;
+
+      // Name mapping already done?
+      if( m_stmtinfo.m_names_stamp == names_stamp && m_stmtinfo.m_reprepared == reprepared )
+      {
+          names = m_stmtinfo.m_names;
+          return (int)names.size();
+      }
+
+      vector<string> col_names;
+
+      for( int i = 0; i < colCount(); i++ )
+      {
+          col_names.push_back( colName(i) );
+      }
+
+      if( !makeFieldNames( col_names, names ) )
+      {
+          setErr( MSG_ERRVARNAME );
+          return 0;
+      }
+      
+      m_stmtinfo.m_names       = names;
+      m_stmtinfo.m_names_stamp = names_stamp;
+      m_stmtinfo.m_reprepared  = reprepared;
+
+      return (int)names.size();
+  }
+  
+  
+  /**
+   * \brief Map SQL column names to valid MATLAB field names
+   *
+   * \param[in] col_names SQL column names
+   * \param[out] names Pairs of SQL and MATLAB names
+   * \returns false if names couldn't be made unique
+   */
+  static bool makeFieldNames( const vector<string>& col_names, ValueSQLCol::StringPairList& names )
+  {
+      unordered_set<string>     used_names;     // field names assigned so far
+      unordered_map<string,int> last_number;    // last suffix number used for a field name
+
       names.clear();
+      used_names.reserve( 2 * col_names.size() );
       
       // iterate columns
-      for( int i = 0; i < colCount(); i++ )
+      for( size_t i = 0; i < col_names.size(); i++ )
       {
-          pair<string,string> item( colName(i), colName(i) );
+          pair<string,string> item( col_names[i], col_names[i] );
           
           // truncate column name if necessary
           item.second = item.second.substr( 0, g_namelengthmax );
@@ -1349,52 +2502,37 @@ public:
           }
           
           // Optionally ensure fieldnames are unambiguous
-          if( g_check4uniquefields )
+          if( g_check4uniquefields && !used_names.insert( item.second ).second )
           {
-              int loop = 0;
-              int number = 1;
-              string new_name(item.second);
-              
-              // break if more than 100 equal column names  \literal
-              while( loop < i && number < 100 )
+              // if name exists already, then append consecutive numbers to differ
+              int&   number = last_number[item.second];
+              string new_name;
+
+              do
               {
-                  // if name exists already, then append consecutive numbers to differ
-                  if( new_name == names[loop].second )
+                  char str_number[16];
+                  int  str_number_len;
+
+                  // break if more than 100 equal column names
+                  if( ++number >= 100 )
                   {
-                      char* str_number      = new char[g_namelengthmax+1];
-                      char* buffer          = new char[g_namelengthmax+1];
-                      int   str_number_len;
-
-                      // measure suffix length 
-                      str_number_len = _snprintf( str_number, g_namelengthmax+1, "_%d", number );
-                      // truncate name if necessary and append suffix
-                      _snprintf( buffer, g_namelengthmax+1, "%.*s%s", g_namelengthmax - str_number_len, item.second.c_str(), str_number );
-                      new_name = buffer;
-
-                      delete[] str_number;
-                      delete[] buffer;
-                      
-                      loop = 0; // name is new, check again precedent
-                      number++;
-
-                  } else loop++;
-              }
-              
-              // number may not exceed limit
-              if( loop < i )
-              {
-                  names.clear();
-                  setErr( MSG_ERRVARNAME );
-                  break;
-              }
+                      names.clear();
+                      return false;
+                  }
+
+                  // measure suffix length, truncate name if necessary and append suffix
+                  str_number_len = _snprintf( str_number, sizeof(str_number), "_%d", number );
+                  new_name = item.second.substr( 0, std::max( g_namelengthmax - str_number_len, 0 ) ) + str_number;
+              } 
+              while( !used_names.insert( new_name ).second );
               
               item.second = new_name;
           }
           
           names.push_back( item );
       }
-      
-      return (int)names.size();
+
+      return true;
   }
   
   
@@ -1408,15 +2546,10 @@ public:
   }
   
   
-  /// Clear parameter bindings and finalize current statement
+  /// Clear parameter bindings and release current statement to the statement cache
   void finalize()
   {
-      if( m_stmt )
-      {
-          sqlite3_clear_bindings( m_stmt );
-          sqlite3_finalize( m_stmt );
-          m_stmt = NULL;
-      }
+      closeStmt();
   }
 
     
@@ -0,0 +1,77 @@
+function sqlite_test_backup
+
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+
+    %% Create a file database in WAL mode
+    src  = fullfile( tempdir, 'mksqlite_backup_src.db' );
+    dest = fullfile( tempdir, 'mksqlite_backup_dest.db' );
+    if exist( src, 'file' ), delete( src ); end
+    if exist( dest, 'file' ), delete( dest ); end
+
+    db = mksqlite( 0, 'open', src );
+    mksqlite( db, 'PRAGMA journal_mode=WAL' );
+    mksqlite( db, 'CREATE TABLE meas (t REAL, v REAL)' );
+    mksqlite( db, 'BEGIN' );
+    for i = 1:100000
+        mksqlite( db, 'INSERT INTO meas VALUES (?,?)', i, rand );
+    end
+    mksqlite( db, 'COMMIT' );
+
+    %% Backup in the background, while data is still acquired
+    job = mksqlite( db, 'backup', dest, 20, 5 );
+    writes = 0;
+    tic;
+    status = mksqlite( 'backup_status', job );
+    while strcmp( status.state, 'running' )
+        mksqlite( db, 'INSERT INTO meas VALUES (?,?)', -1, rand );
+        writes = writes + 1;
+        status = mksqlite( 'backup_status', job );
+    end
+    fprintf( 'Backup %s after %.3f s (%d pages), %d writes meanwhile\n', ...
+             status.state, toc, status.pagecount, writes );
+    assert( strcmp( status.state, 'done' ) && status.progress == 1 );
+
+    %% Restore the snapshot into an in-memory database
+    mem = mksqlite( 0, 'open', ':memory:' );
+    pages = mksqlite( mem, 'restore', dest );
+    n = mksqlite( mem, 'SELECT count(*) AS n FROM meas' );
+    assert( pages == status.pagecount && n.n == 100000 );
+
+    %% Cancel a slow backup
+    job = mksqlite( db, 'backup', dest, 1, 100 );
+    status = mksqlite( 'backup_cancel', job );
+    assert( strcmp( status.state, 'cancelled' ) );
+
+    %% Sidecar segments are copied along
+    mksqlite( 'typedBLOBs', 1 );
+    mksqlite( db, 'sidecar', 1000 );
+    mksqlite( db, 'CREATE TABLE signals (v)' );
+    mksqlite( db, 'INSERT INTO signals VALUES (?)', (1:5000)' );
+    job = mksqlite( db, 'backup', dest, -1, 0 );
+    status = mksqlite( 'backup_status', job );
+    while strcmp( status.state, 'running' )
+        status = mksqlite( 'backup_status', job );
+    end
+    assert( strcmp( status.state, 'done' ) && exist( [dest '-seg0000'], 'file' ) == 2 );
+    copy = mksqlite( 0, 'open', dest );
+    r = mksqlite( copy, 'SELECT v FROM signals' );
+    assert( isequal( r.v, (1:5000)' ) );
+    mksqlite( copy, 'close' );
+
+    %% Sidecar references can't be restored into memory
+    try
+        mksqlite( mem, 'restore', src );
+        error( 'restore should fail' );
+    catch err
+        fprintf( 'Expected error: %s\n', err.message );
+    end
+
+    mksqlite( 0, 'close' );
+    delete( src );
+    delete( dest );
+    delete( [src '-seg*'] );
+    delete( [dest '-seg*'] );
@@ -0,0 +1,51 @@
+function sqlite_test_bind_typed_complex_sparse
+  
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+    
+
+    %% Create an in-memory database
+    mksqlite( 'open', ':memory:' );
+    mksqlite( 'param_wrapping', 0 );
+
+    % With typed BLOBs (mode 1) complex arrays and sparse matrices are 
+    % stored natively, no streaming (mode 2) is needed. Real and imaginary 
+    % parts, as well as the indices of sparse matrices, are stored (and 
+    % compressed) separately.
+    mksqlite( 'typedBLOBs', 1 ); 
+    mksqlite( 'compression', 'lz4', 9 );
+
+    data = { complex( rand(20,30), rand(20,30) ), ...
+             sprand( 1000, 1000, 0.001 ), ...
+             sprand( 200, 100, 0.01 ) + 1i * sprand( 200, 100, 0.01 ), ...
+             sparse( rand(50) > 0.9 ), ...
+             sparse( 10, 10 ) };
+
+    mksqlite( 'CREATE TABLE demo (Data)' );
+
+    for i = 1:numel( data )
+        mksqlite( 'INSERT INTO demo VALUES (?)', data{i} );
+    end
+
+    %% Now read back values
+    query = mksqlite( 'SELECT * FROM demo' );
+
+    for i = 1:numel( data )
+        assert( isequal( query(i).Data, data{i} ) );
+        assert( issparse( query(i).Data ) == issparse( data{i} ) );
+        fprintf( '%s %s %s: ok\n', mat2str( size( data{i} ) ), ...
+                 class( data{i} ), iff( issparse( data{i} ), 'sparse', 'full' ) );
+    end
+
+    mksqlite( 'close' );
+    
+    
+function result = iff( cond, a, b )
+    if cond
+        result = a;
+    else
+        result = b;
+    end
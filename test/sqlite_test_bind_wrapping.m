@@ -75,5 +75,43 @@ function sqlite_test_bind_wrapping
     fprintf( '---> Text: ' ), ...
              query(3).Data
 
+    
+    % ------------------------------------------------------------------
+
+    
+    %% Wrapped scalars are bound by a kernel selected once per parameter
+    fprintf( '\nInserting 100000 records of scalars... ' );
+    mksqlite( 'CREATE TABLE samples (t, channel, valid)' );
+    
+    n = 100000;
+    t = num2cell( (1:n) / 1000 );
+    channel = num2cell( int32( mod( 1:n, 8 ) ) );
+    valid = num2cell( rand( 1, n ) > 0.1 );
+    
+    tic
+    mksqlite( 'BEGIN' );
+    mksqlite( 'INSERT INTO samples VALUES (?,?,?)', [t; channel; valid] );
+    mksqlite( 'COMMIT' );
+    fprintf( '%.3f s\n', toc );
+    
+    query = mksqlite( 'SELECT count(*) AS n, typeof(channel) AS type FROM samples' );
+    assert( query.n == n && strcmp( query.type, 'integer' ) );
+    
+    % other classes within the same parameter are converted as usual
+    mksqlite( 'INSERT INTO samples VALUES (?,?,?)', { 0, int32(1), true; 'text', 2.5, [] }' );
+    query = mksqlite( 'SELECT typeof(t) AS type FROM samples WHERE rowid > ?', n + 1 );
+    assert( strcmp( query.type, 'text' ) );
+
+    %% uint32 values above intmax('int32') are bound as 64 bit integers
+    big = uint32( 3000000000 );
+    mksqlite( 'DELETE FROM samples' );
+    mksqlite( 'param_wrapping', 0 );
+    mksqlite( 'INSERT INTO samples VALUES (?,1,1)', big );              % common conversion
+    mksqlite( 'param_wrapping', 1 );
+    mksqlite( 'INSERT INTO samples VALUES (?,2,2)', { big, big } );     % kernel
+    mksqlite( 'INSERT INTO samples VALUES (?,3,3)', { 1, big } );       % common conversion
+    query = mksqlite( 'SELECT count(*) AS n FROM samples WHERE t = 3000000000' );
+    assert( query.n == 4 );
+
 
     mksqlite( 'close' );
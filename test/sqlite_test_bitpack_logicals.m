@@ -0,0 +1,45 @@
+function sqlite_test_bitpack_logicals
+  
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+    
+
+    %% Create an in-memory database
+    mksqlite( 'open', ':memory:' );
+    mksqlite( 'param_wrapping', 0 );
+    mksqlite( 'typedBLOBs', 1 ); 
+
+    % Logical arrays (masks) are stored with one byte per element by default.
+    % With 'bitpack_logicals' 8 elements are packed into one byte. Masks with 
+    % only a few runs of equal values are stored as run lengths.
+    masks = { rand( 1000, 1000 ) > 0.5, ...                 % random mask (bit packed)
+              [false(1,1e6), true(1,500), false(1,1e6)], ... % few runs (run-length coded)
+              false( 0, 3 ) };
+
+    mksqlite( 'CREATE TABLE demo (Mode, Data)' );
+
+    for packed = [0, 1]
+        mksqlite( 'bitpack_logicals', packed );
+        
+        for i = 1:numel( masks )
+            mksqlite( 'INSERT INTO demo VALUES (?,?)', packed, masks{i} );
+        end
+    end
+
+    %% Now read back values
+    % blob_nnz() counts the set elements without unpacking packed masks
+    query = mksqlite( 'SELECT Mode, Data, length(Data) AS Bytes, blob_nnz(Data) AS nnz FROM demo' );
+
+    for i = 1:numel( query )
+        mask = masks{ mod( i-1, numel( masks ) ) + 1 };
+        
+        assert( isequal( query(i).Data, mask ) );
+        assert( query(i).nnz == nnz( mask ) );
+        fprintf( 'bitpack_logicals=%d: %d elements, %d set, stored in %d bytes\n', ...
+                 query(i).Mode, numel( mask ), query(i).nnz, query(i).Bytes );
+    end
+
+    mksqlite( 'close' );
@@ -0,0 +1,55 @@
+function sqlite_test_bitshuffle
+  
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+    
+    
+    %% Create an in-memory database
+    db = mksqlite( 0, 'open', ':memory:' );
+    mksqlite( db, 'CREATE TABLE data (compressor, class, value)' );
+    
+    mksqlite( 'typedBLOBs', 2 );
+    mksqlite( 'compression_check', 1 );
+    
+    %% Byte shuffle vs. bit shuffle
+    % Integer data with only a few significant bits and quantized doubles
+    values = { int32( randi( 16, 1e5, 1 ) ), ...
+               uint16( mod( 1:1e5, 100 ) ), ...
+               round( cumsum( randn( 1e5, 1 ) ) ) };
+    compressors = { 'lz4', 'lz4+bit', 'lz4hc', 'lz4hc+bit', 'blosclz', 'blosclz+bit' };
+    
+    for i = 1:numel( compressors )
+        mksqlite( 'compression', compressors{i}, 9 );
+        for k = 1:numel( values )
+            mksqlite( db, 'INSERT INTO data VALUES (?,?,?)', ...
+                      compressors{i}, class( values{k} ), values{k} );
+        end
+    end
+    
+    query = mksqlite( db, 'SELECT compressor, class, value, length(value) AS bytes FROM data' );
+    for i = 1:numel( query )
+        k = mod( i-1, numel( values ) ) + 1;
+        assert( isequal( query(i).value, values{k} ) );
+        fprintf( '%-12s %-7s %8d bytes\n', query(i).compressor, query(i).class, query(i).bytes );
+    end
+    
+    %% Benchmark of the shuffle instruction sets
+    % BDCPackTime() and BDCUnpackTime() use the current compression settings
+    fprintf( '\nCPU supports %s\n', mksqlite( 'compression_simd' ) );
+    mksqlite( 'compression', 'lz4', 1 );
+    mksqlite( db, 'DELETE FROM data' );
+    mksqlite( db, 'INSERT INTO data VALUES (?,?,?)', 'lz4', 'double', (1:4e6)' );
+    
+    simd = { 'generic', 'sse2', 'avx2' };
+    for i = 1:numel( simd )
+        mksqlite( 'compression_simd', simd{i} );
+        query = mksqlite( db, [ 'SELECT BDCPackTime(value) AS pack, ', ...
+                                '       BDCUnpackTime(value) AS unpack FROM data' ] );
+        fprintf( '%-8s: pack %.4f s, unpack %.4f s\n', simd{i}, query.pack, query.unpack );
+    end
+    mksqlite( 'compression_simd', 'auto' );
+    
+    mksqlite( db, 'close' );
@@ -0,0 +1,40 @@
+function sqlite_test_blocksize
+  
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');  % shows the detected cache sizes
+    fprintf( '\n\n' );
+    
+    
+    %% Sweep block sizes on a sample array
+    sample = round( cumsum( randn( 2e6, 1 ) ) );
+    
+    for compressor = { 'lz4', 'lz4hc', 'blosclz' }
+        fprintf( 'Block sizes for %s:\n', compressor{1} );
+        res = mksqlite( 'compression_tune', compressor{1}, 9, sample );
+        for i = 1:numel( res )
+            marks = ' *';
+            fprintf( '%9d bytes: ratio %6.2f, pack %7.1f MB/s, unpack %7.1f MB/s %c\n', ...
+                     res(i).blocksize, res(i).ratio, res(i).pack_MBps, res(i).unpack_MBps, ...
+                     marks( 1 + res(i).selected ) );
+        end
+        fprintf( '\n' );
+    end
+    
+    %% Apply the selected block size and use it
+    res = mksqlite( 'compression_tune', 'lz4', 9, sample, 1 );
+    blocksize = mksqlite( 'compression_blocksize', 'lz4', 8 );
+    assert( blocksize == res([res.selected]).blocksize || blocksize == 0 );
+    
+    db = mksqlite( 0, 'open', ':memory:' );
+    mksqlite( 'typedBLOBs', 2 );
+    mksqlite( 'compression', 'lz4', 9 );
+    mksqlite( db, 'CREATE TABLE data (value)' );
+    mksqlite( db, 'INSERT INTO data VALUES (?)', sample );
+    query = mksqlite( db, 'SELECT value FROM data' );
+    assert( isequal( query.value, sample ) );
+    mksqlite( db, 'close' );
+    
+    %% Back to automatic block size
+    mksqlite( 'compression_blocksize', 'lz4', 8, 0 );
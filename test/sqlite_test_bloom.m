@@ -0,0 +1,50 @@
+function sqlite_test_bloom
+
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+
+    %% Large local table and a set of keys from MATLAB
+    n = 2e6;
+    db = mksqlite( 0, 'open', ':memory:' );
+    mksqlite( db, 'CREATE TABLE big (key INTEGER, value REAL)' );
+    mksqlite( db, sprintf( ['WITH RECURSIVE r(i) AS (SELECT 0 UNION ALL SELECT i+1 FROM r WHERE i < %d) ' ...
+                            'INSERT INTO big SELECT i, random() FROM r'], n - 1 ) );
+
+    keys = unique( randi( n, 1, 20000 ) ) - 1;
+
+    %% Build the filter from the MATLAB keys
+    tic;
+    f = mksqlite( db, 'SELECT bloom_build(value, 0.01) AS filter FROM carray(?)', keys );
+    fprintf( 'filter: %d bytes for %d keys, built in %.3f s\n', numel( f.filter ), numel( keys ), toc );
+
+    %% Probe: no false negatives, about 1% false positives
+    tic;
+    hits = mksqlite( db, 'SELECT count(*) AS n FROM big WHERE bloom_contains(?, key)', f.filter );
+    t_probe = toc;
+    fpr = ( hits.n - numel( keys ) ) / ( n - numel( keys ) );
+    fprintf( '%d candidates of %d rows (false positive rate %.4f) in %.3f s\n', hits.n, n, fpr, t_probe );
+    assert( hits.n >= numel( keys ) && fpr < 0.02 );
+
+    %% Prefilter rows before shipping them to another (shard) database
+    shard = mksqlite( 0, 'open', ':memory:' );
+    mksqlite( shard, 'CREATE TABLE remote_keys (key INTEGER PRIMARY KEY)' );
+    mksqlite( shard, 'INSERT INTO remote_keys SELECT value FROM carray(?)', keys );
+
+    tic;
+    candidates = mksqlite( db, 'SELECT key, value FROM big WHERE bloom_contains(?, key)', f.filter );
+    exact = mksqlite( shard, 'SELECT count(*) AS n FROM remote_keys WHERE key IN carray(?)', [candidates.key] );
+    fprintf( 'shipped %d of %d rows, %d matches in %.3f s\n', numel( candidates ), n, exact.n, toc );
+    assert( exact.n == numel( keys ) );
+
+    %% Filters are typed BLOBs and can be stored
+    mksqlite( db, 'CREATE TABLE filters (name TEXT, filter BLOB)' );
+    mksqlite( db, 'INSERT INTO filters SELECT ''keys'', bloom_build(value, 0.01) FROM carray(?)', keys );
+    r = mksqlite( db, ['SELECT count(*) AS n FROM big WHERE ' ...
+                       'bloom_contains((SELECT filter FROM filters WHERE name = ''keys''), key)'] );
+    assert( r.n == hits.n );
+
+    mksqlite( shard, 'close' );
+    mksqlite( db, 'close' );
@@ -0,0 +1,69 @@
+function sqlite_test_carray
+  
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+    
+
+    %% Create an in-memory database
+    mksqlite( 'open', ':memory:' );
+    mksqlite( 'param_wrapping', 0 );
+    mksqlite( 'result_type', 1 );   % struct of arrays
+
+    mksqlite( 'CREATE TABLE items (id INTEGER PRIMARY KEY, name TEXT, price REAL)' );
+    mksqlite( 'BEGIN' );
+
+    for i = 1:10000
+        mksqlite( 'INSERT INTO items VALUES (?,?,?)', i, sprintf( 'item%05d', i ), i / 10 );
+    end
+
+    mksqlite( 'COMMIT' );
+
+    %% Select rows by a list of ids
+    ids = int32( randperm( 10000, 500 ) );
+    
+    tic
+    query = mksqlite( 'SELECT id FROM items WHERE id IN carray(?) ORDER BY id', ids );
+    fprintf( 'IN carray(?): %.3f s\n', toc );
+    assert( isequal( query.id, double( sort( ids(:) ) ) ) );
+    
+    % the same by a statement with 500 placeholders
+    sql = [ 'SELECT id FROM items WHERE id IN (', repmat( '?,', 1, numel(ids)-1 ), '?) ORDER BY id' ];
+    args = num2cell( ids );
+    tic
+    query = mksqlite( sql, args{:} );
+    fprintf( 'IN (?,?,...): %.3f s\n', toc );
+    assert( isequal( query.id, double( sort( ids(:) ) ) ) );
+
+    %% Strings, a cellstr as only argument is one value for carray()
+    names = { 'item00003', 'item00042', 'none' };
+    query = mksqlite( 'SELECT id FROM items WHERE name IN carray(?) ORDER BY id', names );
+    assert( isequal( query.id, [3; 42] ) );
+    
+    %% Join and named parameters, NaN is NULL
+    prices = [ 0.1, 2.5, NaN, 1000 ];
+    query = mksqlite( ['SELECT count(*) AS n FROM items i JOIN carray(:p) c ON c.value = i.price ', ...
+                       'WHERE i.id < :maxid'], prices, 1000 );
+    assert( query.n == 2 );
+    
+    %% Unsupported arrays
+    try
+        mksqlite( 'SELECT * FROM carray(?)', { 'a', 1 } );
+        error( 'carray() should fail' );
+    catch err
+        fprintf( 'Expected error: %s\n', err.message );
+    end
+    
+    % uint64 beyond intmax('int64') would wrap negative
+    query = mksqlite( 'SELECT value FROM carray(?)', uint64( [1, intmax('int64')] ) );
+    assert( query(2).value > 0 );
+    try
+        mksqlite( 'SELECT * FROM carray(?)', uint64( [1, 2^63] ) );
+        error( 'carray() should fail' );
+    catch err
+        fprintf( 'Expected error: %s\n', err.message );
+    end
+    
+    mksqlite( 'close' );
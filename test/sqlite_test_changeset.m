@@ -0,0 +1,80 @@
+function sqlite_test_changeset
+
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+
+    %% Instrument database and central store with the same schema
+    schema = 'CREATE TABLE samples (id INTEGER PRIMARY KEY, t REAL, channel TEXT, value REAL)';
+    instrument = mksqlite( 0, 'open', ':memory:' );
+    central    = mksqlite( 0, 'open', ':memory:' );
+    mksqlite( instrument, schema );
+    mksqlite( central, schema );
+
+    mksqlite( instrument, 'session_start', 'samples' );
+
+    %% Acquisition, then ship the delta
+    n = 100000;
+    mksqlite( instrument, sprintf( ['WITH RECURSIVE r(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM r WHERE i < %d) ' ...
+                                    'INSERT INTO samples (t, channel, value) SELECT i * 0.001, ''ch1'', 0 FROM r'], n ) );
+
+    tic;
+    [changeset, bytes] = mksqlite( instrument, 'session_changeset', 9 );
+    conflicts = mksqlite( central, 'changeset_apply', changeset );
+    fprintf( '%d rows: changeset of %d bytes (%d compressed) shipped in %.3f s\n', ...
+             n, bytes, numel( changeset ), toc );
+    assert( conflicts == 0 );
+
+    r = mksqlite( central, 'SELECT count(*) AS n FROM samples' );
+    assert( r.n == n );
+
+    %% Next delta holds the new changes only
+    mksqlite( instrument, 'UPDATE samples SET value = 1 WHERE id <= 10' );
+    mksqlite( instrument, 'DELETE FROM samples WHERE id > 99990' );
+    changeset = mksqlite( instrument, 'session_changeset' );
+    fprintf( 'delta: %d bytes\n', numel( changeset ) );
+    mksqlite( central, 'changeset_apply', changeset );
+
+    r = mksqlite( central, 'SELECT count(*) AS n, sum(value) AS s FROM samples' );
+    assert( r.n == n - 10 && r.s == 10 );
+
+    %% No changeset within a transaction (changes could be rolled back)
+    mksqlite( instrument, 'BEGIN' );
+    mksqlite( instrument, 'UPDATE samples SET value = 3 WHERE id = 10' );
+    try
+        mksqlite( instrument, 'session_changeset' );
+        error( 'changeset taken within a transaction' );
+    catch err
+        disp( err.message );
+        assert( ~isempty( strfind( err.message, 'transaction' ) ) );
+    end
+    mksqlite( instrument, 'ROLLBACK' );
+    changeset = mksqlite( instrument, 'session_changeset' );
+    assert( isempty( changeset ) );
+
+    %% Conflicts: rows changed at the central store too
+    mksqlite( central, 'UPDATE samples SET value = -1 WHERE id = 1' );
+    mksqlite( instrument, 'UPDATE samples SET value = 2 WHERE id IN (1, 2)' );
+    changeset = mksqlite( instrument, 'session_changeset' );
+
+    try
+        mksqlite( central, 'changeset_apply', changeset );
+        error( 'conflict not reported' );
+    catch err
+        disp( err.message );
+    end
+
+    [conflicts, counts] = mksqlite( central, 'changeset_apply', changeset, 'omit' );
+    disp( counts );
+    assert( conflicts == 1 && counts.data == 1 );
+    r = mksqlite( central, 'SELECT value FROM samples WHERE id IN (1, 2) ORDER BY id' );
+    assert( isequal( [r.value], [-1, 2] ) );
+
+    conflicts = mksqlite( central, 'changeset_apply', changeset, 'replace' );
+    r = mksqlite( central, 'SELECT value FROM samples WHERE id IN (1, 2) ORDER BY id' );
+    assert( isequal( [r.value], [2, 2] ) );
+
+    mksqlite( instrument, 'session_start', 0 );
+    mksqlite( 0, 'close' );
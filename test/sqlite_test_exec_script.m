@@ -0,0 +1,49 @@
+function sqlite_test_exec_script
+  
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+    
+
+    %% Create an in-memory database
+    db = mksqlite( 0, 'open', ':memory:' );
+
+    %% Schema migration as one script
+    script = [ 'CREATE TABLE person (id INTEGER PRIMARY KEY, name TEXT); ', ...
+               'CREATE INDEX person_name ON person(name); ', ...
+               '-- some data', char(10), ...
+               'INSERT INTO person (name) VALUES (''Alice''), (''Bob''), (''Carol''); ', ...
+               'UPDATE person SET name = upper(name) WHERE id > 1;' ];
+
+    [changes, times, stmts] = mksqlite( db, 'exec_script', script, 1 );
+    
+    for i = 1:numel( stmts )
+        fprintf( '%3d rows, %.6f s: %s\n', changes(i), times(i), stmts{i} );
+    end
+    assert( isequal( changes, [0; 0; 3; 2] ) );
+
+    %% Failing script is rolled back as a whole
+    try
+        mksqlite( db, 'exec_script', [ 'INSERT INTO person (name) VALUES (''Dave''); ', ...
+                                       'INSERT INTO nonexisting VALUES (1);' ], 1 );
+        error( 'script should fail' );
+    catch err
+        fprintf( 'Expected error: %s\n', err.message );
+    end
+    
+    query = mksqlite( db, 'SELECT count(*) AS n FROM person' );
+    assert( query.n == 3 );
+
+    %% Script file
+    filename = [ tempname, '.sql' ];
+    fid = fopen( filename, 'w' );
+    fprintf( fid, 'DELETE FROM person WHERE id = 1;\nVACUUM;\n' );
+    fclose( fid );
+    
+    changes = mksqlite( db, 'exec_script', filename );
+    assert( isequal( changes, [1; 0] ) );
+    delete( filename );
+    
+    mksqlite( db, 'close' );
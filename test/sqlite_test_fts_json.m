@@ -0,0 +1,76 @@
+function sqlite_test_fts_json
+
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+
+    %% Create an in-memory database with text and JSON metadata
+    db = mksqlite( 0, 'open', ':memory:' );
+    mksqlite( db, 'CREATE TABLE doc (id INTEGER PRIMARY KEY, title TEXT, body TEXT, meta TEXT)' );
+
+    words = { 'sensor', 'drift', 'calibration', 'offset', 'noise', 'spectrum', ...
+              'filter', 'sample', 'voltage', 'current', 'thermal', 'pressure' };
+    n = 100000;
+    rand( 'seed', 1 );
+
+    mksqlite( db, 'BEGIN' );
+    for i = 1:n
+        body = sprintf( '%s ', words{ randi( numel( words ), 1, 12 ) } );
+        meta = sprintf( '{"run":%d,"channel":"ch%d"}', mod( i, 500 ), mod( i, 16 ) );
+        mksqlite( db, 'INSERT INTO doc (title, body, meta) VALUES (?,?,?)', ...
+                  sprintf( 'doc %d', i ), body, meta );
+    end
+    mksqlite( db, 'COMMIT' );
+
+    %% Full text index vs. LIKE scan
+    tic;
+    fts = mksqlite( db, 'fts_index', 'doc', { 'title', 'body' } );
+    fprintf( 'Created %s in %.3f s\n', fts, toc );
+
+    tic;
+    like = mksqlite( db, [ 'SELECT id FROM doc WHERE body LIKE ''%calibration%'' ', ...
+                           'AND body LIKE ''%thermal%''' ] );
+    t_like = toc;
+
+    tic;
+    [rowids, ranks] = mksqlite( db, 'fts_search', 'doc', 'calibration AND thermal' );
+    t_fts = toc;
+
+    fprintf( 'LIKE scan: %d rows, %.3f s; FTS5: %d rows, %.3f s\n', ...
+             numel( like ), t_like, numel( rowids ), t_fts );
+    assert( isequal( sort( [like.id]' ), sort( rowids ) ) );
+    assert( issorted( ranks ) );
+
+    % Top 10 only
+    rowids = mksqlite( db, 'fts_search', 'doc', 'noise NEAR(spectrum filter)', 10 );
+    assert( numel( rowids ) <= 10 );
+
+    %% Triggers keep the index up to date
+    mksqlite( db, 'INSERT INTO doc (title, body) VALUES (''new'', ''unobtainium'')' );
+    rowids = mksqlite( db, 'fts_search', 'doc', 'unobtainium' );
+    assert( numel( rowids ) == 1 );
+
+    mksqlite( db, 'DELETE FROM doc WHERE id = ?', rowids );
+    assert( isempty( mksqlite( db, 'fts_search', 'doc', 'unobtainium' ) ) );
+
+    %% JSON extraction, without and with expression index
+    query = 'SELECT count(*) AS n FROM doc WHERE json_extract(meta, ''$.run'') = 42';
+
+    tic;
+    scan = mksqlite( db, query );
+    t_scan = toc;
+
+    mksqlite( db, 'CREATE INDEX doc_run ON doc( json_extract(meta, ''$.run'') )' );
+
+    tic;
+    indexed = mksqlite( db, query );
+    t_index = toc;
+
+    plan = mksqlite( db, [ 'EXPLAIN QUERY PLAN ', query ] );
+    fprintf( 'Plan: %s\n', plan(1).detail );
+    fprintf( 'json_extract scan: %.3f s; expression index: %.3f s\n', t_scan, t_index );
+    assert( scan.n == indexed.n );
+
+    mksqlite( db, 'close' );
@@ -0,0 +1,55 @@
+function sqlite_test_index_advisor
+
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+
+    %% Customers and orders without indexes
+    db = mksqlite( 0, 'open', ':memory:' );
+    mksqlite( db, 'CREATE TABLE customers (id INTEGER PRIMARY KEY, name TEXT, region INTEGER)' );
+    mksqlite( db, 'CREATE TABLE orders (id INTEGER PRIMARY KEY, customer INTEGER, status INTEGER, day INTEGER, amount REAL)' );
+    mksqlite( db, ['WITH RECURSIVE r(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM r WHERE i < 2000) ' ...
+                   'INSERT INTO customers SELECT i, ''name'' || i, i % 10 FROM r'] );
+    mksqlite( db, ['WITH RECURSIVE r(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM r WHERE i < 200000) ' ...
+                   'INSERT INTO orders SELECT i, i % 2000 + 1, i % 5, i % 365, i * 0.5 FROM r'] );
+
+    %% Ad-hoc queries, kept as history
+    for id = 1:20
+        mksqlite( db, 'SELECT count(*) AS n FROM orders WHERE customer = ?', id );
+    end
+    mksqlite( db, 'SELECT sum(amount) AS s FROM orders WHERE status = 1 AND day BETWEEN 10 AND 20' );
+    mksqlite( db, 'SELECT * FROM customers ORDER BY name LIMIT 5' );
+
+    %% Suggestions for the history
+    [s, statements] = mksqlite( db, 'index_advisor' );
+    fprintf( '%d statements analyzed\n', numel( statements ) );
+    for i = 1:numel( s )
+        fprintf( '%-60s estimated speedup %8.1f\n', s(i).create, s(i).speedup );
+    end
+    assert( numel( s ) >= 3 );
+    assert( all( [s.speedup] > 1 ) );
+    assert( any( strcmp( {s.table}, 'customers' ) ) );
+
+    %% Statements given, timed runs (index is rolled back)
+    queries = { 'SELECT count(*) AS n, max(amount) AS m FROM orders WHERE customer = 42 AND status = 2', ...
+                'SELECT id FROM orders WHERE day = 3 ORDER BY amount' };
+    s = mksqlite( db, 'index_advisor', queries, 1 );
+    for i = 1:numel( s )
+        fprintf( '%-60s estimated speedup %8.1f, measured %6.1f\n', s(i).create, s(i).speedup, s(i).measured );
+        fprintf( '%s', s(i).plan );
+    end
+    assert( ~isempty( s ) && s(1).measured > 1 );
+
+    r = mksqlite( db, 'SELECT count(*) AS n FROM sqlite_master WHERE type = ''index''' );
+    assert( r.n == 0 );
+
+    %% Take the suggestions, nothing left to suggest
+    for i = 1:numel( s )
+        mksqlite( db, s(i).create );
+    end
+    s = mksqlite( db, 'index_advisor', queries );
+    assert( isempty( s ) );
+
+    mksqlite( 0, 'close' );
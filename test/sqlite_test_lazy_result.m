@@ -0,0 +1,86 @@
+function sqlite_test_lazy_result
+
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+
+    %% Wide table: 40 columns, 50000 rows
+    ncols = 40;
+    nrows = 50000;
+    db = mksqlite( 0, 'open', ':memory:' );
+
+    names = arrayfun( @(k) sprintf( 'c%d', k ), 1:ncols, 'UniformOutput', false );
+    mksqlite( db, sprintf( 'CREATE TABLE wide (id INTEGER, name TEXT, %s)', ...
+                           strjoin( strcat( names, ' REAL' ), ', ' ) ) );
+    mksqlite( db, sprintf( ['WITH RECURSIVE r(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM r WHERE i < %d) ' ...
+                            'INSERT INTO wide SELECT i, ''row '' || i, %s FROM r'], ...
+                           nrows, strjoin( repmat( {'random() / 1e18'}, 1, ncols ), ', ' ) ) );
+
+    %% Full conversion (struct of arrays)
+    old_type = mksqlite( 'result_type', 1 );
+    tic;
+    full = mksqlite( db, 'SELECT * FROM wide' );
+    t_full = toc;
+    mksqlite( 'result_type', old_type );
+
+    %% Lazy: handle, 2 columns converted on request
+    tic;
+    res = mksqlite_result( db, 'SELECT * FROM wide' );
+    id = res.col( 'id' );
+    x  = res.col( 'c7' );
+    t_lazy = toc;
+
+    assert( res.rows == nrows );
+    assert( numel( res.columns ) == ncols + 2 );
+    assert( isequal( id, full.id ) );
+    assert( isequal( x, full.c7 ) );
+
+    fprintf( 'Full conversion (%d columns): %.3f s\n', ncols + 2, t_full );
+    fprintf( 'Handle, 2 columns converted : %.3f s\n', t_lazy );
+
+    %% Rows: indices and logical masks
+    s = res.cols( {'id', 'name'}, [3 1] );
+    assert( isequal( s.id, [3; 1] ) );
+    assert( strcmp( s.name{1}, 'row 3' ) );
+
+    x = res.col( 'c1', id > nrows - 10 );
+    assert( numel( x ) == 10 );
+
+    %% Raw handles
+    mksqlite( 'result_type', 3 );
+    h = mksqlite( db, 'SELECT id, name FROM wide WHERE id <= 5' );
+    mksqlite( 'result_type', old_type );
+
+    info = mksqlite( 'result_info', h );
+    fprintf( 'Handle %d: %d rows, %d bytes\n', h, info.rows, info.bytes );
+    s = mksqlite( 'result_cols', h, 'name' );
+    assert( numel( s.name ) == 5 );
+    assert( mksqlite( 'result_free', h ) == 1 );
+    assert( mksqlite( 'result_free', h ) == 0 );
+
+    try
+        mksqlite( 'result_cols', res.handle, 'no_such_column' );
+        error( 'unknown column not detected' );
+    catch err
+        fprintf( 'Expected error: %s\n', err.message );
+    end
+
+    %% Memory budget: least recently used results are released
+    [old_budget, used, count] = mksqlite( 'result_budget' );
+    fprintf( 'Budget %.0f MB, used %.1f MB by %d result(s)\n', old_budget / 2^20, used / 2^20, count );
+    r2 = mksqlite_result( db, 'SELECT * FROM wide' );
+    r2.rows;   % r2 is used more recently than res
+    mksqlite( 'result_budget', used * 1.5 );
+    assert( r2.rows == nrows );
+    try
+        res.rows;
+        error( 'released result not detected' );
+    catch err
+        fprintf( 'Expected error: %s\n', err.message );
+    end
+    mksqlite( 'result_budget', old_budget );
+
+    clear res r2
+    mksqlite( db, 'close' );
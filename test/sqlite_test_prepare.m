@@ -0,0 +1,84 @@
+function sqlite_test_prepare
+  
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+    
+
+    %% Create an in-memory database
+    db = mksqlite( 0, 'open', ':memory:' );
+    mksqlite( db, 'CREATE TABLE samples (id INTEGER PRIMARY KEY, channel TEXT, value REAL)' );
+    
+    n = 20000;
+    values = rand( n, 1 );
+
+    %% Insert by SQL text
+    mksqlite( db, 'BEGIN' );
+    tic
+    for i = 1:n
+        mksqlite( db, 'INSERT INTO samples (channel, value) VALUES (?,?)', 'ch1', values(i) );
+    end
+    fprintf( 'SQL text:  %.3f s\n', toc );
+    mksqlite( db, 'COMMIT' );
+
+    %% Insert by statement handle
+    [s, info] = mksqlite( db, 'prepare', 'INSERT INTO samples (channel, value) VALUES (:channel, ?)' );
+    assert( isequal( info.params, {':channel'; ''} ) );
+    
+    mksqlite( db, 'BEGIN' );
+    tic
+    for i = 1:n
+        mksqlite( 'exec', s, 'ch2', values(i) );
+    end
+    fprintf( 'handle:    %.3f s\n', toc );
+    mksqlite( db, 'COMMIT' );
+    mksqlite( 'finalize', s );
+
+    %% Query by statement handle
+    [q, info] = mksqlite( db, 'prepare', 'SELECT channel, sum(value) AS total FROM samples WHERE channel = ?' );
+    assert( isequal( info.columns, {'channel'; 'total'} ) );
+    
+    r1 = mksqlite( 'exec', q, 'ch1' );
+    r2 = mksqlite( 'exec', q, 'ch2' );
+    assert( abs( r1.total - r2.total ) < 1e-6 );
+    mksqlite( 'finalize', q );
+    
+    %% Finalized handles are invalid
+    try
+        mksqlite( 'exec', q, 'ch1' );
+        error( 'exec should fail' );
+    catch err
+        fprintf( 'Expected error: %s\n', err.message );
+    end
+    
+    %% Cached statements follow schema changes
+    mksqlite( db, 'CREATE TABLE t (a)' );
+    mksqlite( db, 'INSERT INTO t VALUES (1)' );
+    r = mksqlite( db, 'SELECT * FROM t' );
+    assert( isequal( fieldnames( r ), {'a'} ) );
+    
+    mksqlite( db, 'ALTER TABLE t ADD COLUMN b' );
+    r = mksqlite( db, 'SELECT * FROM t' );
+    assert( isequal( fieldnames( r ), {'a'; 'b'} ) );
+    
+    mksqlite( db, 'CREATE TABLE u (x)' );
+    mksqlite( db, 'INSERT INTO u VALUES (1)' );
+    r = mksqlite( db, 'SELECT * FROM u' );
+    assert( isequal( fieldnames( r ), {'x'} ) );
+    
+    mksqlite( db, 'DROP TABLE u' );
+    mksqlite( db, 'CREATE TABLE u (p, q, r)' );
+    mksqlite( db, 'INSERT INTO u VALUES (1, 2, 3)' );
+    r = mksqlite( db, 'SELECT * FROM u' );
+    assert( isequal( fieldnames( r ), {'p'; 'q'; 'r'} ) );
+    
+    %% Statement handles follow schema changes
+    q = mksqlite( db, 'prepare', 'SELECT * FROM t' );
+    mksqlite( db, 'ALTER TABLE t ADD COLUMN c' );
+    r = mksqlite( 'exec', q );
+    assert( isequal( fieldnames( r ), {'a'; 'b'; 'c'} ) );
+    mksqlite( 'finalize', q );
+    
+    mksqlite( db, 'close' );
@@ -0,0 +1,47 @@
+function sqlite_test_regex_nfa
+
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+
+    %% Create an in-memory database with some text rows
+    db = mksqlite( 0, 'open', ':memory:' );
+    mksqlite( db, 'CREATE TABLE log (line TEXT)' );
+
+    n = 50000;
+    mksqlite( db, 'BEGIN' );
+    for i = 1:n
+        if mod( i, 100 ) == 0
+            state = sprintf( 'ERROR code %d', mod( i, 7 ) );
+        else
+            state = 'ok';
+        end
+        mksqlite( db, 'INSERT INTO log VALUES (?)', sprintf( 'row %d value=%d %s', i, 7*i, state ) );
+    end
+    mksqlite( db, 'COMMIT' );
+
+    %% Same results as the backtracking engine (backreference forces DEELX)
+    query = mksqlite( db, 'SELECT regex(line, "ERROR code (\d)") AS m FROM log WHERE rowid = 700' );
+    assert( strcmp( query.m, 'ERROR code 0' ) );
+
+    query = mksqlite( db, 'SELECT regex(line, "(\d)\1") AS m FROM log WHERE rowid = 11' );
+    assert( strcmp( query.m, '11' ) );
+
+    query = mksqlite( db, 'SELECT regex(line, "value=(\d+) (\w+)$", "$2:$1") AS m FROM log WHERE rowid = 3' );
+    assert( strcmp( query.m, 'row 3 ok:21' ) );
+
+    query = mksqlite( db, 'SELECT regex(line, "^.*$", "") AS m FROM log WHERE rowid = 3' );
+    assert( ischar( query.m ) && isempty( query.m ) );
+
+    %% Timings: literal prefilter, linear-time matcher and pathological pattern
+    patterns = { 'ERROR code \d+', '^row \d+ value', '\w+=\d+ ok$', '(x+x+)+y' };
+
+    for i = 1:numel( patterns )
+        tic;
+        query = mksqlite( db, 'SELECT count(*) AS n FROM log WHERE regex(line, ?) NOT NULL', patterns{i} );
+        fprintf( '%-20s %6d matches, %.3f s\n', patterns{i}, query.n, toc );
+    end
+
+    mksqlite( db, 'close' );
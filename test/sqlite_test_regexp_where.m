@@ -0,0 +1,63 @@
+function sqlite_test_regexp_where
+
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+
+    %% Create an in-memory database with an indexed name column
+    db = mksqlite( 0, 'open', ':memory:' );
+    mksqlite( db, 'CREATE TABLE part (name TEXT)' );
+    mksqlite( db, 'CREATE INDEX part_name ON part (name)' );
+
+    n = 200000;
+    prefixes = { 'ABC', 'ABD', 'XYZ', 'ABCX' };
+    mksqlite( db, 'BEGIN' );
+    for i = 1:n
+        mksqlite( db, 'INSERT INTO part VALUES (?)', sprintf( '%s%d', prefixes{ mod(i,4)+1 }, i ) );
+    end
+    mksqlite( db, 'COMMIT' );
+
+    %% REGEXP operator
+    query = mksqlite( db, 'SELECT ''ABC123'' REGEXP ''^ABC\d+$'' AS a, ''ABX'' REGEXP ''^ABC'' AS b' );
+    assert( query.a == 1 && query.b == 0 );
+
+    %% Anchored prefix gives an indexable range
+    pattern = '^ABC[0-9]+$';
+    [where, lower, upper] = mksqlite( 'regexp_where', 'name', pattern, 'TEXT' );
+    fprintf( 'WHERE %s\n', where );
+    assert( strcmp( lower, 'ABC' ) && strcmp( upper, 'ABD' ) );
+
+    plan = mksqlite( db, [ 'EXPLAIN QUERY PLAN SELECT count(*) FROM part WHERE ', where ] );
+    fprintf( 'Plan: %s\n', plan(1).detail );
+
+    tic;
+    full = mksqlite( db, 'SELECT count(*) AS n FROM part WHERE name REGEXP ?', pattern );
+    t_scan = toc;
+
+    tic;
+    ranged = mksqlite( db, [ 'SELECT count(*) AS n FROM part WHERE ', where ] );
+    t_index = toc;
+
+    fprintf( 'Full scan: %d rows, %.3f s; index range: %d rows, %.3f s\n', ...
+             full.n, t_scan, ranged.n, t_index );
+    assert( full.n == ranged.n );
+
+    %% No prefix, no range
+    where = mksqlite( 'regexp_where', 'name', '[0-9]{6}$', 'TEXT' );
+    assert( strcmp( where, '(name REGEXP ''[0-9]{6}$'')' ) );
+
+    %% No TEXT affinity, no range (numbers sort before any text)
+    mksqlite( db, 'CREATE TABLE serial (code NUMERIC)' );
+    mksqlite( db, 'INSERT INTO serial VALUES (12), (123), (''12a''), (21)' );
+    full = mksqlite( db, 'SELECT count(*) AS n FROM serial WHERE code REGEXP ''^12''' );
+    assert( full.n == 3 );
+    where = mksqlite( 'regexp_where', 'code', '^12', 'NUMERIC' );
+    assert( strcmp( where, '(code REGEXP ''^12'')' ) );
+    where = mksqlite( 'regexp_where', 'code', '^12' );
+    assert( strcmp( where, '(code REGEXP ''^12'')' ) );
+    ranged = mksqlite( db, [ 'SELECT count(*) AS n FROM serial WHERE ', where ] );
+    assert( ranged.n == full.n );
+
+    mksqlite( db, 'close' );
@@ -0,0 +1,46 @@
+function sqlite_test_result_speed
+
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+
+    %% Table with 1M rows and 20 columns (10 REAL, 10 INTEGER)
+    nrows = 1e6;
+    ncols = 20;
+    db = mksqlite( 0, 'open', ':memory:' );
+
+    names = arrayfun( @(k) sprintf( 'c%d', k ), 1:ncols, 'UniformOutput', false );
+    vals  = [ repmat( {'i * 0.5'}, 1, ncols/2 ), repmat( {'i'}, 1, ncols/2 ) ];
+    mksqlite( db, sprintf( 'CREATE TABLE wide (%s)', strjoin( names, ', ' ) ) );
+    mksqlite( db, sprintf( ['WITH RECURSIVE r(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM r WHERE i < %d) ' ...
+                            'INSERT INTO wide SELECT %s FROM r'], nrows, strjoin( vals, ', ' ) ) );
+
+    %% Result types
+    old_type = mksqlite( 'result_type' );
+    labels   = { 'array of structs', 'struct of arrays', 'cell matrix' };
+    times    = zeros( 1, 3 );
+
+    for type = 0:2
+        mksqlite( 'result_type', type );
+        tic;
+        result = mksqlite( db, 'SELECT * FROM wide' );
+        times(type+1) = toc;
+        clear result
+    end
+
+    mksqlite( 'result_type', old_type );
+
+    for type = 0:2
+        fprintf( '%-18s %dx%d: %.2f s\n', labels{type+1}, nrows, ncols, times(type+1) );
+    end
+
+    %% Check contents of the array of structs
+    mksqlite( 'result_type', 0 );
+    result = mksqlite( db, 'SELECT * FROM wide WHERE rowid IN (1, 1000000)' );
+    mksqlite( 'result_type', old_type );
+    assert( numel( result ) == 2 );
+    assert( result(1).c1 == 0.5 && result(2).c20 == nrows );
+
+    mksqlite( db, 'close' );
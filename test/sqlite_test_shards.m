@@ -0,0 +1,75 @@
+function sqlite_test_shards
+
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+
+    %% Create one database file per day
+    folder = fullfile( tempdir, 'mksqlite_shards' );
+    if ~exist( folder, 'dir' )
+        mkdir( folder );
+    end
+    delete( fullfile( folder, 'day*.db' ) );
+
+    days = 8;
+    n = 50000;
+    rand( 'seed', 1 );
+
+    for d = 1:days
+        db = mksqlite( 0, 'open', fullfile( folder, sprintf( 'day%02d.db', d ) ) );
+        mksqlite( db, 'CREATE TABLE meas (ch INTEGER, t REAL, v REAL)' );
+        mksqlite( db, 'BEGIN' );
+        for i = 1:n
+            mksqlite( db, 'INSERT INTO meas VALUES (?,?,?)', mod( i, 16 ), d + i / n, rand );
+        end
+        mksqlite( db, 'COMMIT' );
+        mksqlite( db, 'close' );
+    end
+
+    [count, files] = mksqlite( 'shards_open', fullfile( folder, 'day*.db' ) );
+    assert( count == days && numel( files ) == days );
+
+    query = [ 'SELECT ch, count(*) AS n, sum(v) AS s, min(v) AS lo, max(v) AS hi ', ...
+              'FROM meas WHERE v > ? GROUP BY ch' ];
+
+    %% Serial loop over all files, combined in MATLAB
+    tic;
+    serial = [];
+    for d = 1:days
+        db = mksqlite( 0, 'open', files{d}, 'ro' );
+        serial = [ serial; mksqlite( db, query, 0.5 ) ];
+        mksqlite( db, 'close' );
+    end
+    ch = [serial.ch];
+    n_serial = accumarray( ch(:) + 1, [serial.n] );
+    t_serial = toc;
+
+    %% Scatter-gather query
+    tic;
+    combined = mksqlite( 'shards_query', query, { 0.5 }, 'combine key, sum, sum, min, max' );
+    t_shards = toc;
+
+    fprintf( 'Serial loop: %.3f s; shards_query: %.3f s\n', t_serial, t_shards );
+    assert( numel( combined ) == 16 );
+    assert( isequal( [combined.n]', n_serial ) );
+    assert( abs( sum( [combined.s] ) - sum( [serial.s] ) ) < 1e-6 );
+
+    %% Integer sums overflow as with SQLite's sum()
+    try
+        mksqlite( 'shards_query', 'SELECT 9223372036854775807 AS s', {}, 'combine sum' );
+        error( 'overflow not detected' );
+    catch err
+        fprintf( 'Expected error: %s\n', err.message );
+        assert( ~isempty( strfind( err.message, 'integer overflow' ) ) );
+    end
+
+    %% Ordered merge of the first rows of each shard
+    [top, rows] = mksqlite( 'shards_query', 'SELECT t, v FROM meas ORDER BY v DESC LIMIT 5', ...
+                            {}, 'order by v desc' );
+    assert( rows == 5 * days );
+    assert( issorted( -[top.v] ) );
+
+    mksqlite( 'shards_close' );
+    delete( fullfile( folder, 'day*.db' ) );
@@ -0,0 +1,48 @@
+function sqlite_test_sidecar
+  
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+    
+
+    %% Create a file based database
+    % Sidecar segments are stored next to the database file
+    dbfile = fullfile( tempdir, 'sqlite_test_sidecar.db' );
+    delete( [dbfile, '*'] );
+    
+    db = mksqlite( 0, 'open', dbfile );
+    mksqlite( 'param_wrapping', 0 );
+    mksqlite( 'typedBLOBs', 1 ); 
+
+    % Typed BLOBs of 1 MB or more are stored in sidecar segments
+    mksqlite( db, 'sidecar', 2^20 );
+
+    data = { rand( 10 ), rand( 1000 ), complex( rand( 500 ), rand( 500 ) ) };
+
+    mksqlite( db, 'CREATE TABLE demo (ID, Data)' );
+
+    for i = 1:numel( data )
+        mksqlite( db, 'INSERT INTO demo VALUES (?,?)', i, data{i} );
+    end
+
+    %% Now read back values
+    % Rows only hold a reference of 48 bytes for large BLOBs
+    query = mksqlite( db, 'SELECT ID, Data, length(Data) AS Bytes FROM demo' );
+
+    for i = 1:numel( query )
+        assert( isequal( query(i).Data, data{i} ) );
+        fprintf( 'Item %d: %d bytes, stored in %d bytes\n', ...
+                 i, numel( data{i} ) * 8 * ( 1 + ~isreal( data{i} ) ), query(i).Bytes );
+    end
+    
+    dir( [dbfile, '-seg*'] )
+
+    %% Remove all large BLOBs, their segments are deleted by garbage collection
+    mksqlite( db, 'DELETE FROM demo WHERE ID > 1' );
+    n = mksqlite( db, 'sidecar gc' );
+    fprintf( '%d segment(s) deleted\n', n );
+    
+    mksqlite( db, 'close' );
+    delete( dbfile );
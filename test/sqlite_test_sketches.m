@@ -0,0 +1,64 @@
+function sqlite_test_sketches
+
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+
+    %% Event table: 30 days, 100000 events per day, 1M users
+    ndays  = 30;
+    nday   = 1e5;
+    db = mksqlite( 0, 'open', ':memory:' );
+    mksqlite( db, 'CREATE TABLE events (day INTEGER, user INTEGER, latency REAL)' );
+    mksqlite( db, sprintf( ['WITH RECURSIVE r(i) AS (SELECT 0 UNION ALL SELECT i+1 FROM r WHERE i < %d) ' ...
+                            'INSERT INTO events SELECT i / %d, abs(random()) %% 1000000, abs(random()) / 9.2e18 FROM r'], ...
+                           ndays * nday - 1, nday ) );
+
+    %% Exact vs. approximate distinct count
+    tic; exact  = mksqlite( db, 'SELECT count(DISTINCT user) AS n FROM events' ); t_exact  = toc;
+    tic; approx = mksqlite( db, 'SELECT approx_count_distinct(user) AS n FROM events' ); t_approx = toc;
+    fprintf( 'COUNT(DISTINCT): %d in %.3f s\n', exact.n, t_exact );
+    fprintf( 'approx_count_distinct: %d in %.3f s (%.2f%% error)\n', approx.n, t_approx, ...
+             100 * ( double( approx.n ) - double( exact.n ) ) / double( exact.n ) );
+    assert( abs( double( approx.n ) - double( exact.n ) ) / double( exact.n ) < 0.03 );
+
+    %% Quantiles
+    q = mksqlite( db, 'SELECT approx_quantile(latency, 0.5) AS p50, approx_quantile(latency, 0.99) AS p99 FROM events' );
+    fprintf( 'latency p50 %.4f, p99 %.4f\n', q.p50, q.p99 );
+    assert( abs( q.p50 - 0.5 ) < 0.01 && abs( q.p99 - 0.99 ) < 0.005 );
+
+    %% Daily sketches, merged to a month
+    mksqlite( db, 'CREATE TABLE daily (day INTEGER, users BLOB, latency BLOB)' );
+    mksqlite( db, ['INSERT INTO daily SELECT day, hll_sketch(user), tdigest_sketch(latency) ' ...
+                   'FROM events GROUP BY day'] );
+
+    tic;
+    month = mksqlite( db, ['SELECT sketch_count(sketch_merge(users)) AS users, ' ...
+                           'sketch_quantile(sketch_merge(latency), 0.99) AS p99 FROM daily'] );
+    t_merge = toc;
+    fprintf( 'month from daily sketches: %d users, p99 %.4f in %.4f s\n', month.users, month.p99, t_merge );
+    assert( month.users == approx.n );
+
+    %% Sketches are typed BLOBs (uint8 vectors) and can be stored again
+    old_mode = mksqlite( 'typedBLOBs', 1 );
+    s = mksqlite( db, 'SELECT users FROM daily WHERE day = 0' );
+    assert( isa( s.users, 'uint8' ) );
+    mksqlite( db, 'CREATE TABLE stored (users BLOB)' );
+    mksqlite( db, 'INSERT INTO stored VALUES (?)', s.users );
+    n = mksqlite( db, 'SELECT sketch_count(users) AS n FROM stored' );
+    d = mksqlite( db, 'SELECT sketch_count(users) AS n FROM daily WHERE day = 0' );
+    assert( n.n == d.n );
+    mksqlite( 'typedBLOBs', old_mode );
+
+    %% Corrupt sketches are rejected (register out of range)
+    corrupt = ['X''484C4C3104' 'FF' repmat( '00', 1, 15 ) ''''];
+    try
+        mksqlite( db, ['SELECT sketch_count(' corrupt ') AS n'] );
+        error( 'corrupt sketch accepted' );
+    catch err
+        assert( isempty( strfind( err.message, 'corrupt sketch accepted' ) ) );
+        disp( err.message );
+    end
+
+    mksqlite( db, 'close' );
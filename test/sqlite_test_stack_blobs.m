@@ -0,0 +1,57 @@
+function sqlite_test_stack_blobs
+  
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+    
+
+    %% Create an in-memory database
+    mksqlite( 'open', ':memory:' );
+    mksqlite( 'param_wrapping', 0 );
+    mksqlite( 'typedBLOBs', 1 ); 
+    mksqlite( 'result_type', 1 );   % struct of arrays
+
+    % 1000 waveforms of same length
+    waveforms = rand( 2048, 1000 );
+
+    mksqlite( 'CREATE TABLE shots (Run, Waveform)' );
+    mksqlite( 'BEGIN' );
+
+    for i = 1:size( waveforms, 2 )
+        mksqlite( 'INSERT INTO shots VALUES (?,?)', 1, waveforms(:,i) );
+    end
+
+    mksqlite( 'COMMIT' );
+
+    %% Read back as cell array and as matrix
+    mksqlite( 'stack_blobs', 0 );
+    tic
+    query = mksqlite( 'SELECT Waveform FROM shots WHERE Run=?', 1 );
+    data = cell2mat( query.Waveform' );
+    fprintf( 'cell array and cell2mat: %.3f s\n', toc );
+    assert( isequal( data, waveforms ) );
+    
+    mksqlite( 'stack_blobs', 1 );
+    tic
+    query = mksqlite( 'SELECT Waveform FROM shots WHERE Run=?', 1 );
+    fprintf( 'stacked: %.3f s\n', toc );
+    assert( isequal( query.Waveform, waveforms ) );
+
+    %% Waveforms of different length can't be stacked
+    mksqlite( 'INSERT INTO shots VALUES (?,?)', 1, rand( 100, 1 ) );
+    
+    query = mksqlite( 'SELECT Waveform FROM shots WHERE Run=?', 1 );
+    assert( iscell( query.Waveform ) );
+    
+    mksqlite( 'stack_blobs', 2 );
+    try
+        query = mksqlite( 'SELECT Waveform FROM shots WHERE Run=?', 1 );
+        error( 'stacking should fail' );
+    catch err
+        fprintf( 'Expected error: %s\n', err.message );
+    end
+    
+    mksqlite( 'stack_blobs', 0 );
+    mksqlite( 'close' );
@@ -0,0 +1,83 @@
+function sqlite_test_track_changes
+
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+
+    %% Track two of three tables
+    db = mksqlite( 0, 'open', ':memory:' );
+    mksqlite( db, 'CREATE TABLE orders (id INTEGER PRIMARY KEY, qty REAL)' );
+    mksqlite( db, 'CREATE TABLE items (id INTEGER PRIMARY KEY, name TEXT)' );
+    mksqlite( db, 'CREATE TABLE log (msg TEXT)' );
+
+    active = mksqlite( db, 'track_changes', {'orders', 'items'} );
+    assert( active == 1 );
+
+    mksqlite( db, 'INSERT INTO orders (qty) VALUES (1), (2), (3)' );
+    mksqlite( db, 'INSERT INTO items (name) VALUES (''a'')' );
+    mksqlite( db, 'INSERT INTO log VALUES (''not tracked'')' );
+    mksqlite( db, 'UPDATE orders SET qty = 20 WHERE id = 2' );
+    mksqlite( db, 'DELETE FROM orders WHERE id = 1' );
+
+    [c, lost] = mksqlite( db, 'changes' );
+    disp( [c.table, c.op, num2cell( c.rowid )] );
+    assert( numel( c.rowid ) == 6 && lost == 0 );
+    assert( isequal( c.op(end-1:end), {'UPDATE'; 'DELETE'} ) && isequal( c.rowid(end-1:end), [2; 1] ) );
+
+    % taken changes are cleared
+    c = mksqlite( db, 'changes' );
+    assert( isempty( c.rowid ) );
+
+    %% DELETE without WHERE reports each row
+    mksqlite( db, 'DELETE FROM orders' );
+    c = mksqlite( db, 'changes' );
+    assert( numel( c.rowid ) == 2 && all( strcmp( c.op, 'DELETE' ) ) );
+
+    %% Changes are kept on commit only
+    mksqlite( db, 'BEGIN' );
+    mksqlite( db, 'INSERT INTO items (name) VALUES (''b'')' );
+    mksqlite( db, 'ROLLBACK' );
+    c = mksqlite( db, 'changes' );
+    assert( isempty( c.rowid ) );
+
+    %% Changes undone by ROLLBACK TO a savepoint are dropped
+    mksqlite( db, 'SAVEPOINT s' );
+    mksqlite( db, 'INSERT INTO items (name) VALUES (''b'')' );
+    mksqlite( db, 'ROLLBACK TO s' );
+    mksqlite( db, 'RELEASE s' );
+    c = mksqlite( db, 'changes' );
+    assert( isempty( c.rowid ) );
+
+    %% Changes of a failing statement are dropped, the transaction's others kept
+    mksqlite( db, 'BEGIN' );
+    mksqlite( db, 'INSERT INTO items (name) VALUES (''c'')' );
+    try
+        mksqlite( db, 'INSERT INTO orders (id) VALUES (10), (11), (1), (10)' );
+        error( 'UNIQUE constraint expected' );
+    catch err
+        assert( ~isempty( strfind( err.message, 'UNIQUE' ) ) );
+    end
+    mksqlite( db, 'COMMIT' );
+    c = mksqlite( db, 'changes' );
+    assert( numel( c.rowid ) == 1 && strcmp( c.table{1}, 'items' ) );
+
+    %% Bulk changes: a small buffer keeps the newest ones
+    mksqlite( db, 'track_changes', '*', 1000 );
+    tic;
+    mksqlite( db, ['WITH RECURSIVE r(i) AS (SELECT 1 UNION ALL SELECT i+1 FROM r WHERE i < 100000) ' ...
+                   'INSERT INTO orders (qty) SELECT i FROM r'] );
+    t = toc;
+    [c, lost] = mksqlite( db, 'changes' );
+    fprintf( '100000 inserts tracked in %.3f s, %d kept, %d lost\n', t, numel( c.rowid ), lost );
+    assert( numel( c.rowid ) + lost == 100000 );
+
+    %% Stop tracking
+    active = mksqlite( db, 'track_changes', 0 );
+    assert( active == 0 );
+    mksqlite( db, 'INSERT INTO items (name) VALUES (''c'')' );
+    c = mksqlite( db, 'changes' );
+    assert( isempty( c.rowid ) );
+
+    mksqlite( db, 'close' );
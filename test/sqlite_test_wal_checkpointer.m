@@ -0,0 +1,80 @@
+function sqlite_test_wal_checkpointer
+
+    clear all
+    close all
+    clc
+    dummy = mksqlite('version mex');
+    fprintf( '\n\n' );
+
+    %% Create a file database in WAL mode
+    dbfile = fullfile( tempdir, 'mksqlite_wal.db' );
+    if exist( dbfile, 'file' ), delete( dbfile ); end
+
+    db = mksqlite( 0, 'open', dbfile );
+    mksqlite( db, 'PRAGMA journal_mode=WAL' );
+    mksqlite( db, 'PRAGMA synchronous=NORMAL' );
+    mksqlite( db, 'CREATE TABLE meas (t REAL, data BLOB)' );
+
+    n = 20000;
+    sample = rand( 1, 256 );
+
+    %% Inline automatic checkpoints
+    t_inline = zeros( n, 1 );
+    for i = 1:n
+        tic;
+        mksqlite( db, 'INSERT INTO meas VALUES (?,?)', i, sample );
+        t_inline(i) = toc;
+    end
+
+    %% Background checkpoints
+    stats = mksqlite( db, 'wal_checkpointer', 1000, 50 );
+    assert( stats.running == 1 );
+
+    t_bg = zeros( n, 1 );
+    for i = 1:n
+        tic;
+        mksqlite( db, 'INSERT INTO meas VALUES (?,?)', i, sample );
+        t_bg(i) = toc;
+    end
+
+    stats = mksqlite( db, 'wal_checkpointer' );
+    fprintf( 'Insert latency max (99.9%%): inline %.2f ms (%.2f ms), checkpointer %.2f ms (%.2f ms)\n', ...
+             1000 * max( t_inline ), 1000 * p999( t_inline ), ...
+             1000 * max( t_bg ), 1000 * p999( t_bg ) );
+    fprintf( 'Checkpoints: %d passive, %d restart, %d busy, %d frames, max %.2f ms\n', ...
+             stats.passive, stats.restart, stats.busy, stats.checkpointed, stats.max_ms );
+    assert( stats.passive > 0 );
+
+    % the writer checkpoints a WAL exceeding 8 * threshold frames
+    pagesize = mksqlite( db, 'PRAGMA page_size' );
+    wal = dir( [ dbfile, '-wal' ] );
+    fprintf( 'WAL under load: %.1f MB, %d forced restarts\n', wal.bytes / 2^20, stats.forced );
+    assert( wal.bytes <= ( 8 * 1000 + 100 ) * ( pagesize.page_size + 24 ) + 32 );
+
+    %% WAL is truncated when idle
+    pause( 1.5 );
+    stats = mksqlite( db, 'wal_checkpointer' );
+    wal = dir( [ dbfile, '-wal' ] );
+    assert( stats.truncate > 0 && wal.bytes == 0 );
+
+    %% Manual checkpoint, stop
+    [wal_frames, checkpointed, busy] = mksqlite( db, 'wal_checkpoint', 'truncate' );
+    assert( busy == 0 );
+    stats = mksqlite( db, 'wal_checkpointer', 0 );
+    assert( stats.running == 0 );
+
+    % the automatic checkpoint in effect before is restored
+    mksqlite( db, 'PRAGMA wal_autocheckpoint=200' );
+    mksqlite( db, 'wal_checkpointer', 1000 );
+    mksqlite( db, 'wal_checkpointer', 0 );
+    query = mksqlite( db, 'PRAGMA wal_autocheckpoint' );
+    assert( query.wal_autocheckpoint == 200 );
+
+    mksqlite( db, 'close' );
+    delete( dbfile );
+
+
+function q = p999( t )
+    % 99.9% percentile
+    t = sort( t );
+    q = t( ceil( 0.999 * numel( t ) ) );
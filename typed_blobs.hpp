@@ -19,6 +19,7 @@
 //#include "config.h"
 //#include "global.hpp"
 #include "utils.hpp"
+#include <vector>
 
 #ifdef _WIN32
   #define GCC_PACKED_STRUCT
@@ -92,6 +93,24 @@
 /** @} */
 
 
+/**
+ * \name Storage layouts
+ *
+ * Layout flags are stored along with the MATLAB class ID in the upper bits
+ * of TypedBLOBHeaderBase::m_clsid. Arrays not stored as TBH_LAYOUT_PLAIN keep
+ * their data in separate lanes (see TypedBLOBLanes).
+ *
+ * @{
+ */
+#define TBH_LAYOUT_PLAIN      0x00000000    ///< real, full numeric array (data as is)
+#define TBH_LAYOUT_COMPLEX    0x00010000    ///< complex array, real and imaginary parts in separate lanes
+#define TBH_LAYOUT_SPARSE     0x00020000    ///< sparse matrix (CSC) with delta coded indices
+#define TBH_LAYOUT_BITPACK    0x00040000    ///< logical array, 8 elements per byte
+#define TBH_LAYOUT_RLE        0x00080000    ///< logical array, run-length coded
+#define TBH_LAYOUT_MASK       0x7fff0000    ///< all layout flags
+/** @} */
+
+
 /**
  * \name Text fields for integrity check (platform and magic)
  *
@@ -171,15 +190,27 @@ struct GCC_PACKED_STRUCT TypedBLOBHeaderBase
   char    m_endian;                         ///< +  1 Byte order: 'L'ittle endian or 'B'ig endian
                                             ///< = 32 Bytes (+4 bytes for int32_t m_nDims[1] later)
   
-  /// Initialize structure with class ID and platform information
-  void init( mxClassID clsid )
+  /// Initialize structure with class ID, storage layout and platform information
+  void init( mxClassID clsid, int layout = TBH_LAYOUT_PLAIN )
   {
     strcpy( m_magic,    TBH_MAGIC );
     strcpy( m_platform, TBH_platform );
     
-    m_ver       = (int16_t)sizeof( *this ); // Header size used as version number
-    m_clsid     = (int32_t)clsid;           // MATLABs class ID
-    m_endian    = TBH_endian[0];            // First letter only ('L'ittle or 'B'ig)
+    m_ver       = (int16_t)sizeof( *this );     // Header size used as version number
+    m_clsid     = (int32_t)clsid | layout;      // MATLABs class ID and storage layout
+    m_endian    = TBH_endian[0];                // First letter only ('L'ittle or 'B'ig)
+  }
+  
+  /// Get MATLAB class ID (without layout flags)
+  mxClassID getClsid()
+  {
+    return (mxClassID)( m_clsid & ~TBH_LAYOUT_MASK );
+  }
+  
+  /// Get storage layout flags (see \ref TBH_LAYOUT_MASK)
+  int getLayout()
+  {
+    return m_clsid & TBH_LAYOUT_MASK;
   }
   
   /// Check identifying string (magic)
@@ -226,7 +257,7 @@ struct GCC_PACKED_STRUCT TypedBLOBHeaderBase
   /// Check for valid self class ID
   bool validClsid()
   {
-    return validClsid( (mxClassID)m_clsid );
+    return validClsid( getClsid() );
   }
   
   
@@ -237,8 +268,25 @@ struct GCC_PACKED_STRUCT TypedBLOBHeaderBase
   }
   
   
+  /// Check if BLOB was written with another byte order than the running one
+  bool isForeignEndian()
+  {
+    return ( m_endian == 'L' || m_endian == 'B' ) && m_endian != TBH_endian[0];
+  }
+  
+  
+  /// Reverse the byte order of a value
+  template< typename T >
+  static
+  T swapped( T value )
+  {
+    ::utils_byteswap( &value, 1, sizeof( value ) );
+    return value;
+  }
+  
+  
 #if defined( MATLAB_MEX_FILE )
-  /// Get data size of an array in bytes
+  /// Get data size of an array in bytes (real part, non-zero elements only if sparse)
   static
   size_t getDataSize( const mxArray* pItem )
   {
@@ -247,13 +295,34 @@ struct GCC_PACKED_STRUCT TypedBLOBHeaderBase
     if( pItem )
     {
       size_t szElement   = mxGetElementSize( pItem );
-      size_t cntElements = mxGetNumberOfElements( pItem );
+      size_t cntElements = mxIsSparse( pItem ) ? mxGetJc( pItem )[ mxGetN( pItem ) ]
+                                               : mxGetNumberOfElements( pItem );
       
       data_size = szElement * cntElements;
     }
     
     return data_size;
   }
+  
+  
+  /// Get storage layout needed for an array
+  static
+  int getLayout( const mxArray* pItem )
+  {
+    int layout = TBH_LAYOUT_PLAIN;
+    
+    if( pItem && mxIsComplex( pItem ) )
+    {
+      layout |= TBH_LAYOUT_COMPLEX;
+    }
+    
+    if( pItem && mxIsSparse( pItem ) )
+    {
+      layout |= TBH_LAYOUT_SPARSE;
+    }
+    
+    return layout;
+  }
 #endif
 };
 
@@ -272,9 +341,9 @@ struct GCC_PACKED_STRUCT TypedBLOBHeaderCompressed : public TypedBLOBHeaderBase
   char m_compression[12];
 
   /// Initialization
-  void init( mxClassID clsid )
+  void init( mxClassID clsid, int layout = TBH_LAYOUT_PLAIN )
   {
-    TypedBLOBHeaderBase::init( clsid );
+    TypedBLOBHeaderBase::init( clsid, layout );
     setCompressor( "" );
   }
 
@@ -322,10 +391,11 @@ struct GCC_PACKED_STRUCT TBHData : public HeaderBaseType
    * \param[in] clsid MATLAB class ID of array elements
    * \param[in] nDims Amount of array dimensions
    * \param[in] pSize Pointer to vector of dimension lengths
+   * \param[in] layout Storage layout flags (\ref TBH_LAYOUT_PLAIN for plain arrays)
    */
-  void init( mxClassID clsid, mwSize nDims, const mwSize* pSize )
+  void init( mxClassID clsid, mwSize nDims, const mwSize* pSize, int layout = TBH_LAYOUT_PLAIN )
   {
-    HeaderBaseType::init( clsid );
+    HeaderBaseType::init( clsid, layout );
     HeaderBaseType::m_ver = sizeof( *this );
     
     assert( nDims >= 0 );
@@ -347,7 +417,58 @@ struct GCC_PACKED_STRUCT TBHData : public HeaderBaseType
     mwSize nDims = mxGetNumberOfDimensions( pItem );
     const mwSize* dimensions = mxGetDimensions( pItem );
     
-    init( clsid, nDims, dimensions );
+    init( clsid, nDims, dimensions, HeaderBaseType::getLayout( pItem ) );
+  }
+  
+  
+  /// Set class ID and dimension information of an array item, stored in a given layout
+  void init( const mxArray* pItem, int layout )
+  {
+    assert( pItem );
+    init( mxGetClassID( pItem ), mxGetNumberOfDimensions( pItem ), mxGetDimensions( pItem ), layout );
+  }
+  
+  
+  /// Get number of dimensions
+  int getNumDims()
+  {
+    return m_nDims[0];
+  }
+  
+  
+  /// Get length of dimension \p i (base 0)
+  mwSize getDim( int i )
+  {
+    return (mwSize)m_nDims[i+1];
+  }
+  
+  
+  /**
+   * \brief Convert dimensions written with foreign byte order (inplace)
+   *
+   * \param[in] blob_size Size of the whole BLOB in bytes
+   * \returns false if dimensions exceed the BLOB
+   */
+  bool dimsToNative( size_t blob_size )
+  {
+    if( blob_size < dataOffset( 0 ) )
+    {
+      return false;
+    }
+    
+    m_nDims[0] = HeaderBaseType::swapped( m_nDims[0] );
+    
+    if( m_nDims[0] < 0 || blob_size < dataOffset( m_nDims[0] ) )
+    {
+      return false;
+    }
+    
+    for( int i = 0; i < m_nDims[0]; i++ )
+    {
+      m_nDims[i+1] = HeaderBaseType::swapped( m_nDims[i+1] );
+    }
+    
+    return true;
   }
   
   
@@ -407,7 +528,7 @@ struct GCC_PACKED_STRUCT TBHData : public HeaderBaseType
   /// Get data size in bytes, returns 0 on error
   size_t getDataSize()
   {
-    return utils_elbytes( (mxClassID)HeaderBaseType::m_clsid );
+    return utils_elbytes( HeaderBaseType::getClsid() );
   }
   
   
@@ -423,7 +544,7 @@ struct GCC_PACKED_STRUCT TBHData : public HeaderBaseType
     mwSize nDims = m_nDims[0];
     mwSize* dimensions = new mwSize[nDims];
     mxArray* pItem = NULL;
-    mxClassID clsid = (mxClassID)HeaderBaseType::m_clsid;
+    mxClassID clsid = HeaderBaseType::getClsid();
     
     for( int i = 0; i < (int)nDims; i++ )
     {
@@ -463,6 +584,550 @@ typedef TBHData<TypedBLOBHeaderBase>       TypedBLOBHeaderV1;  ///< typed blob h
 typedef TBHData<TypedBLOBHeaderCompressed> TypedBLOBHeaderV2;  ///< typed blob header for MATLAB arrays with compression feature
 
 
+#if defined( MATLAB_MEX_FILE )
+/**
+ * \brief Data lanes of complex and sparse arrays
+ *
+ * Complex arrays hold real and imaginary parts in separate lanes.
+ * Sparse matrices (CSC) hold the element count of each column (delta coded 
+ * column starts), the row index deltas within each column (delta coded row 
+ * indices), the real values and, if complex, the imaginary values. 
+ * Indices are stored as uint32_t, since array dimensions are limited to 
+ * int32_t by the typed BLOB header anyway.
+ *
+ * Logical arrays may be stored in one lane as packed bits (TBH_LAYOUT_BITPACK)
+ * or, if there are only a few runs of equal values, as uint32_t run lengths 
+ * (TBH_LAYOUT_RLE). The runs alternate between false and true, beginning with 
+ * false (the first run may be empty).
+ *
+ * In the BLOB, the lane data is preceded by a lane table of int32_t values:
+ * the number of lanes, followed by the raw size and the stored size (in bytes) 
+ * of each lane. A lane is compressed, if its stored size is less than its raw size.
+ */
+class TypedBLOBLanes
+{
+public:
+  enum { MAX_LANES = 4 };   ///< complex sparse matrices have 4 lanes
+
+  /// One data lane
+  struct Lane
+  {
+    void*   m_data;         ///< raw lane data
+    size_t  m_bytes;        ///< size of raw lane data in bytes
+    size_t  m_elbytes;      ///< size of one lane element in bytes
+    bool    m_isIndex;      ///< true for index lanes (lossless compression only)
+  };
+
+  int       m_layout;               ///< storage layout (see \ref TBH_LAYOUT_MASK)
+  int       m_nLanes;               ///< number of lanes in use
+  Lane      m_lane[MAX_LANES];      ///< lanes
+  
+private:
+  std::vector<uint32_t> m_colCounts;  ///< element count of each column (sparse only)
+  std::vector<uint32_t> m_rowDeltas;  ///< row index deltas (sparse only)
+  std::vector<uint8_t>  m_bits;       ///< packed bits (TBH_LAYOUT_BITPACK only)
+  std::vector<uint32_t> m_runs;       ///< run lengths (TBH_LAYOUT_RLE only)
+  
+  /// Append a lane
+  void addLane( void* data, size_t bytes, size_t elbytes, bool isIndex )
+  {
+    assert( m_nLanes < MAX_LANES );
+    
+    m_lane[m_nLanes].m_data     = data;
+    m_lane[m_nLanes].m_bytes    = bytes;
+    m_lane[m_nLanes].m_elbytes  = elbytes;
+    m_lane[m_nLanes].m_isIndex  = isIndex;
+    m_nLanes++;
+  }
+  
+  /// Pointer to first element of a vector, NULL if empty
+  template< typename T >
+  static
+  T* vecData( std::vector<T>& vec )
+  {
+    return vec.empty() ? NULL : &vec[0];
+  }
+  
+  /// Run-length code a logical array, returns false if it has too many runs
+  bool encodeRuns( const mxLogical* data, size_t count, size_t maxRuns )
+  {
+    size_t   nRuns = 1;
+    
+    if( nRuns > maxRuns )
+    {
+      return false;
+    }
+    
+    // count runs first, the first run is always a false one
+    for( size_t i = 0; i < count; i++ )
+    {
+      if( ( data[i] != 0 ) != ( ( nRuns & 1 ) == 0 ) )
+      {
+        if( ++nRuns > maxRuns )
+        {
+          return false;
+        }
+      }
+    }
+    
+    m_runs.assign( nRuns, 0 );
+    nRuns = 0;
+    
+    for( size_t i = 0; i < count; i++ )
+    {
+      if( ( data[i] != 0 ) != ( ( nRuns & 1 ) != 0 ) )
+      {
+        nRuns++;
+      }
+      m_runs[nRuns]++;
+    }
+    
+    return true;
+  }
+
+  /// Inhibit copies
+  TypedBLOBLanes( const TypedBLOBLanes& );
+  TypedBLOBLanes& operator=( const TypedBLOBLanes& );
+
+public:
+  /// Ctor
+  TypedBLOBLanes() : m_layout( TBH_LAYOUT_PLAIN ), m_nLanes( 0 )
+  {}
+  
+  
+  /// Size of the lane table in bytes
+  static
+  size_t tableSize( int nLanes )
+  {
+    return ( 1 + 2 * nLanes ) * sizeof( int32_t );
+  }
+  
+  
+  /// Sum of raw lane sizes in bytes
+  size_t rawSize()
+  {
+    size_t bytes = 0;
+    
+    for( int i = 0; i < m_nLanes; i++ )
+    {
+      bytes += m_lane[i].m_bytes;
+    }
+    
+    return bytes;
+  }
+  
+  
+  /**
+   * \brief Split an array into lanes
+   *
+   * Value lanes refer to the array data (no copy), index lanes 
+   * of sparse matrices are delta coded into own memory.
+   * Full logical arrays are bit packed or run-length coded into own memory, 
+   * if \p bitpack is set.
+   *
+   * \param[in] pItem Complex, sparse or logical MATLAB array
+   * \param[in] bitpack true, if logical arrays shall be bit packed
+   */
+  void fromItem( const mxArray* pItem, bool bitpack = false )
+  {
+    size_t elbytes = mxGetElementSize( pItem );
+    size_t count   = mxGetNumberOfElements( pItem );
+    
+    m_nLanes = 0;
+    m_layout = TypedBLOBHeaderBase::getLayout( pItem );
+    
+    if( bitpack && m_layout == TBH_LAYOUT_PLAIN && mxIsLogical( pItem ) )
+    {
+      size_t packed  = ( count + 7 ) / 8;
+      size_t maxRuns = packed / ( 2 * sizeof( uint32_t ) );   // runs must save half of the space at least
+      
+      if( count <= UINT32_MAX && encodeRuns( mxGetLogicals( pItem ), count, maxRuns ) )
+      {
+        m_layout = TBH_LAYOUT_RLE;
+        addLane( vecData( m_runs ), m_runs.size() * sizeof( uint32_t ), sizeof( uint32_t ), true );
+      }
+      else
+      {
+        m_layout = TBH_LAYOUT_BITPACK;
+        m_bits.resize( packed );
+        utils_pack_bits( (const unsigned char*)mxGetLogicals( pItem ), count, vecData( m_bits ) );
+        addLane( vecData( m_bits ), packed, 1, true );
+      }
+      
+      return;
+    }
+    
+    if( mxIsSparse( pItem ) )
+    {
+      mwSize   n  = mxGetN( pItem );
+      mwIndex* jc = mxGetJc( pItem );
+      mwIndex* ir = mxGetIr( pItem );
+      
+      count = jc[n];
+      m_colCounts.resize( n );
+      m_rowDeltas.resize( count );
+      
+      for( mwSize j = 0; j < n; j++ )
+      {
+        mwIndex last_row = 0;
+        
+        m_colCounts[j] = (uint32_t)( jc[j+1] - jc[j] );
+        
+        for( mwIndex k = jc[j]; k < jc[j+1]; k++ )
+        {
+          m_rowDeltas[k] = (uint32_t)( ir[k] - last_row );
+          last_row = ir[k];
+        }
+      }
+      
+      addLane( vecData( m_colCounts ), m_colCounts.size() * sizeof( uint32_t ), sizeof( uint32_t ), true );
+      addLane( vecData( m_rowDeltas ), m_rowDeltas.size() * sizeof( uint32_t ), sizeof( uint32_t ), true );
+    }
+    
+    addLane( mxGetData( pItem ), count * elbytes, elbytes, false );
+    
+    if( mxIsComplex( pItem ) )
+    {
+      addLane( mxGetImagData( pItem ), count * elbytes, elbytes, false );
+    }
+  }
+  
+  
+  /**
+   * \brief Create an array and assign the lanes to its memory
+   *
+   * Value lanes refer directly to the data of the created array, index lanes
+   * to own memory. After filling the lanes, finish() must be called.
+   *
+   * \param[in] clsid MATLAB class ID
+   * \param[in] layout Storage layout flags
+   * \param[in] nDims Number of dimensions
+   * \param[in] pSize Dimension lengths
+   * \param[in] nLanes Number of lanes (from lane table)
+   * \param[in] pBytes Raw size of each lane in bytes (from lane table)
+   * \returns the created array or NULL if lanes don't match the layout
+   */
+  mxArray* createItem( mxClassID clsid, int layout, mwSize nDims, const mwSize* pSize, 
+                       int nLanes, const size_t* pBytes )
+  {
+    bool         isComplex  = ( layout & TBH_LAYOUT_COMPLEX ) != 0;
+    bool         isSparse   = ( layout & TBH_LAYOUT_SPARSE ) != 0;
+    size_t       elbytes    = utils_elbytes( clsid );
+    mxArray*     pItem      = NULL;
+    
+    m_nLanes = 0;
+    m_layout = layout;
+    
+    if( layout == TBH_LAYOUT_BITPACK || layout == TBH_LAYOUT_RLE )
+    {
+      size_t count = 1;
+      
+      for( int i = 0; i < (int)nDims; i++ )
+      {
+        count *= pSize[i];
+      }
+      
+      if(    clsid != mxLOGICAL_CLASS || nLanes != 1 
+          || ( layout == TBH_LAYOUT_BITPACK && pBytes[0] != ( count + 7 ) / 8 )
+          || ( layout == TBH_LAYOUT_RLE && ( !pBytes[0] || pBytes[0] % sizeof( uint32_t ) ) ) )
+      {
+        return NULL;
+      }
+      
+      pItem = mxCreateLogicalArray( nDims, pSize );
+      
+      if( pItem && layout == TBH_LAYOUT_BITPACK )
+      {
+        m_bits.resize( pBytes[0] );
+        addLane( vecData( m_bits ), pBytes[0], 1, true );
+      }
+      else if( pItem )
+      {
+        m_runs.resize( pBytes[0] / sizeof( uint32_t ) );
+        addLane( vecData( m_runs ), pBytes[0], sizeof( uint32_t ), true );
+      }
+      
+      return pItem;
+    }
+    
+    if( !elbytes || ( layout & ~( TBH_LAYOUT_COMPLEX | TBH_LAYOUT_SPARSE ) ) )
+    {
+      return NULL;
+    }
+    
+    if( !isSparse )
+    {
+      size_t count = 1;
+      
+      for( int i = 0; i < (int)nDims; i++ )
+      {
+        count *= pSize[i];
+      }
+      
+      if( !isComplex || nLanes != 2 || pBytes[0] != count * elbytes || pBytes[1] != count * elbytes )
+      {
+        return NULL;
+      }
+      
+      pItem = mxCreateNumericArray( nDims, pSize, clsid, mxCOMPLEX );
+    }
+    else
+    {
+      // MATLAB supports sparse matrices of type double and logical only
+      if( nDims != 2 || nLanes != 3 + isComplex || 
+          !( clsid == mxDOUBLE_CLASS || ( clsid == mxLOGICAL_CLASS && !isComplex ) ) )
+      {
+        return NULL;
+      }
+      
+      size_t count = pBytes[1] / sizeof( uint32_t );
+      
+      if(    pBytes[0] != pSize[1] * sizeof( uint32_t ) 
+          || pBytes[1] != count * sizeof( uint32_t ) 
+          || pBytes[2] != count * elbytes 
+          || ( isComplex && pBytes[3] != count * elbytes ) )
+      {
+        return NULL;
+      }
+      
+      if( clsid == mxLOGICAL_CLASS )
+      {
+        pItem = mxCreateSparseLogicalMatrix( pSize[0], pSize[1], count );
+      }
+      else
+      {
+        pItem = mxCreateSparse( pSize[0], pSize[1], count, isComplex ? mxCOMPLEX : mxREAL );
+      }
+      
+      if( pItem )
+      {
+        m_colCounts.resize( pSize[1] );
+        m_rowDeltas.resize( count );
+        addLane( vecData( m_colCounts ), pBytes[0], sizeof( uint32_t ), true );
+        addLane( vecData( m_rowDeltas ), pBytes[1], sizeof( uint32_t ), true );
+      }
+    }
+    
+    if( pItem )
+    {
+      size_t bytes = pBytes[m_nLanes];
+      
+      addLane( mxGetData( pItem ), bytes, elbytes, false );
+      
+      if( isComplex )
+      {
+        addLane( mxGetImagData( pItem ), bytes, elbytes, false );
+      }
+    }
+    
+    return pItem;
+  }
+  
+  
+  /**
+   * \brief Rebuild sparse indices or logical elements from filled lanes
+   *
+   * \param[in,out] pItem Array created by createItem()
+   * \returns false if indices or runs are invalid
+   */
+  bool finish( mxArray* pItem )
+  {
+    if( m_layout == TBH_LAYOUT_BITPACK )
+    {
+      utils_unpack_bits( vecData( m_bits ), mxGetNumberOfElements( pItem ), (unsigned char*)mxGetLogicals( pItem ) );
+      return true;
+    }
+    
+    if( m_layout == TBH_LAYOUT_RLE )
+    {
+      mxLogical* data  = mxGetLogicals( pItem );
+      size_t     count = mxGetNumberOfElements( pItem );
+      size_t     pos   = 0;
+      
+      // runs expand straight into the array (which is initialized to false)
+      for( size_t i = 0; i < m_runs.size(); i++ )
+      {
+        if( m_runs[i] > count - pos )
+        {
+          return false;
+        }
+        
+        if( i & 1 )
+        {
+          memset( data + pos, 1, m_runs[i] );
+        }
+        
+        pos += m_runs[i];
+      }
+      
+      return pos == count;
+    }
+    
+    if( !mxIsSparse( pItem ) )
+    {
+      return true;
+    }
+    
+    mwSize   m     = mxGetM( pItem );
+    mwSize   n     = mxGetN( pItem );
+    mwIndex* jc    = mxGetJc( pItem );
+    mwIndex* ir    = mxGetIr( pItem );
+    size_t   count = m_rowDeltas.size();
+    
+    jc[0] = 0;
+    
+    for( mwSize j = 0; j < n; j++ )
+    {
+      jc[j+1] = jc[j] + m_colCounts[j];
+      
+      if( jc[j+1] > count )
+      {
+        return false;
+      }
+    }
+    
+    if( jc[n] != count )
+    {
+      return false;
+    }
+    
+    for( mwSize j = 0; j < n; j++ )
+    {
+      mwIndex row = 0;
+      
+      for( mwIndex k = jc[j]; k < jc[j+1]; k++ )
+      {
+        // row indices must be strictly increasing within a column
+        if( k > jc[j] && !m_rowDeltas[k] )
+        {
+          return false;
+        }
+        
+        row += m_rowDeltas[k];
+        
+        if( row >= m )
+        {
+          return false;
+        }
+        
+        ir[k] = row;
+      }
+    }
+    
+    return true;
+  }
+  
+  
+  /**
+   * \brief Write lane table with raw sizes and stored sizes of each lane
+   *
+   * \param[out] pTable Lane table (see tableSize())
+   * \param[in] pStored Stored size of each lane in bytes
+   * \returns false (and nothing written) if a size exceeds the 32 bit table entries
+   */
+  bool writeTable( void* pTable, const size_t* pStored ) const
+  {
+    int32_t* table = (int32_t*)pTable;
+    
+    for( int i = 0; i < m_nLanes; i++ )
+    {
+      if( m_lane[i].m_bytes > (size_t)INT32_MAX || pStored[i] > (size_t)INT32_MAX )
+      {
+        return false;
+      }
+    }
+    
+    *table++ = m_nLanes;
+    
+    for( int i = 0; i < m_nLanes; i++ )
+    {
+      *table++ = (int32_t)m_lane[i].m_bytes;
+      *table++ = (int32_t)pStored[i];
+    }
+    
+    return true;
+  }
+  
+  
+  /**
+   * \brief Convert lane table written with foreign byte order (inplace)
+   *
+   * \param[in,out] pTable Lane table
+   * \param[in] avail Available bytes from \p pTable on
+   * \returns false if table exceeds \p avail
+   */
+  static
+  bool tableToNative( void* pTable, size_t avail )
+  {
+    int32_t nLanes;
+    
+    if( avail < tableSize( 0 ) )
+    {
+      return false;
+    }
+    
+    memcpy( &nLanes, pTable, sizeof( nLanes ) );
+    nLanes = TypedBLOBHeaderBase::swapped( nLanes );
+    
+    if( nLanes < 1 || nLanes > MAX_LANES || avail < tableSize( nLanes ) )
+    {
+      return false;
+    }
+    
+    ::utils_byteswap( pTable, 1 + 2 * nLanes, sizeof( int32_t ) );
+    
+    return true;
+  }
+  
+  
+  /**
+   * \brief Read lane table
+   *
+   * \param[in] pTable Lane table
+   * \param[in] avail Available bytes from \p pTable on
+   * \param[out] nLanes Number of lanes
+   * \param[out] pBytes Raw size of each lane in bytes (\ref MAX_LANES elements)
+   * \param[out] pStored Stored size of each lane in bytes (\ref MAX_LANES elements)
+   * \returns false if table is malformed or lanes exceed \p avail
+   */
+  static
+  bool readTable( const void* pTable, size_t avail, int& nLanes, size_t* pBytes, size_t* pStored )
+  {
+    const int32_t* table = (const int32_t*)pTable;
+    size_t total;
+    
+    if( avail < tableSize( 0 ) )
+    {
+      return false;
+    }
+    
+    nLanes = *table++;
+    
+    if( nLanes < 1 || nLanes > MAX_LANES || avail < tableSize( nLanes ) )
+    {
+      return false;
+    }
+    
+    total = tableSize( nLanes );
+    
+    for( int i = 0; i < nLanes; i++ )
+    {
+      if( table[0] < 0 || table[1] < 0 || table[1] > table[0] )
+      {
+        return false;
+      }
+      
+      pBytes[i]  = (size_t)*table++;
+      pStored[i] = (size_t)*table++;
+      total     += pStored[i];
+    }
+    
+    return total <= avail;
+  }
+};
+#endif
+
+
 ///////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////
 /// Test backward compatibility, will be removed in future releases
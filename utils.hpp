@@ -22,6 +22,19 @@
 #include "global.hpp"
 //#include "locale.hpp"
 
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+  #include <emmintrin.h>
+  #define UTILS_HAVE_SSE2
+#endif
+#if defined( __SSSE3__ )
+  #include <tmmintrin.h>
+  #define UTILS_HAVE_SSSE3
+#endif
+#if defined( __BMI2__ )
+  #include <immintrin.h>
+  #define UTILS_HAVE_BMI2
+#endif
+
 /* helper functions, formard declarations */
 #if defined( MATLAB_MEX_FILE)
                   char*   utils_getString         ( const mxArray* str );
@@ -34,7 +47,12 @@ template<class T> void    utils_free_ptr          ( T *&pmxarr );
                   char*   utils_strnewdup         ( const char* s, int flagConvertUTF8 );
                   double  utils_get_wall_time     ();
                   double  utils_get_cpu_time      ();
+                  void    utils_sleep_ms          ( int ms );
                   char*   utils_strlwr            ( char* );
+                  size_t  utils_pack_bits         ( const unsigned char* src, size_t count, unsigned char* dst );
+                  void    utils_unpack_bits       ( const unsigned char* src, size_t count, unsigned char* dst );
+                  size_t  utils_count_bits        ( const unsigned char* src, size_t bytes );
+                  void    utils_byteswap          ( void* data, size_t count, size_t elbytes );
 
 
 #ifdef MAIN_MODULE
@@ -79,6 +97,10 @@ size_t utils_elbytes( mxClassID classID )
     switch (classID)
     {
 
+    case mxLOGICAL_CLASS:
+        result = sizeof(mxLogical);
+        break;
+
     case mxCHAR_CLASS:
         result = sizeof(mxChar);
         break;
@@ -115,6 +137,14 @@ size_t utils_elbytes( mxClassID classID )
         result = sizeof(uint32_T);
         break;
 
+    case mxINT64_CLASS:
+        result = sizeof(int64_T);
+        break;
+
+    case mxUINT64_CLASS:
+        result = sizeof(uint64_T);
+        break;
+
     default:
         assert( false );
     }
@@ -263,6 +293,193 @@ char* utils_strlwr( char* str )
 }
 
 
+/**
+ * @brief      Pack bytes into bits (8 elements per byte, LSB first)
+ *
+ * @param [in] src   Bytes, each nonzero byte is a set bit
+ * @param [in] count Number of bytes in \p src
+ * @param [out] dst  Packed bits, (count+7)/8 bytes. Trailing bits are zero.
+ *
+ * @return     Number of bytes written to \p dst
+ */
+size_t utils_pack_bits( const unsigned char* src, size_t count, unsigned char* dst )
+{
+    size_t i = 0;
+    
+#ifdef UTILS_HAVE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    
+    // 16 elements at once: set bits are the inverted sign bits of (byte == 0)
+    for( ; i + 16 <= count; i += 16 )
+    {
+        int mask = ~_mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i*)( src + i ) ), zero ) );
+        
+        dst[i/8]     = (unsigned char)( mask & 0xff );
+        dst[i/8 + 1] = (unsigned char)( ( mask >> 8 ) & 0xff );
+    }
+#endif
+
+    for( ; i < count; i += 8 )
+    {
+        unsigned char bits = 0;
+        
+        for( size_t k = 0; k < 8 && i + k < count; k++ )
+        {
+            bits |= (unsigned char)( ( src[i+k] != 0 ) << k );
+        }
+        
+        dst[i/8] = bits;
+    }
+    
+    return ( count + 7 ) / 8;
+}
+
+
+/**
+ * @brief      Unpack bits into bytes of value 0 or 1 (counterpart to utils_pack_bits())
+ *
+ * @param [in] src   Packed bits, (count+7)/8 bytes
+ * @param [in] count Number of elements to unpack
+ * @param [out] dst  Bytes (count)
+ */
+void utils_unpack_bits( const unsigned char* src, size_t count, unsigned char* dst )
+{
+    size_t i = 0;
+    
+#if defined( UTILS_HAVE_BMI2 )
+    // deposit 8 bits into the lowest bit of 8 bytes
+    for( ; i + 8 <= count; i += 8 )
+    {
+        uint64_t bytes = _pdep_u64( src[i/8], 0x0101010101010101ULL );
+        memcpy( dst + i, &bytes, 8 );
+    }
+#elif defined( UTILS_HAVE_SSE2 )
+    const __m128i select = _mm_set_epi8( (char)0x80, 0x40, 0x20, 0x10, 8, 4, 2, 1, 
+                                         (char)0x80, 0x40, 0x20, 0x10, 8, 4, 2, 1 );
+    const __m128i one    = _mm_set1_epi8( 1 );
+    
+    // spread 2 bytes over 16 lanes and test one bit per lane
+    for( ; i + 16 <= count; i += 16 )
+    {
+        __m128i bits = _mm_unpacklo_epi64( _mm_set1_epi8( (char)src[i/8] ), _mm_set1_epi8( (char)src[i/8 + 1] ) );
+        
+        bits = _mm_cmpeq_epi8( _mm_and_si128( bits, select ), select );
+        _mm_storeu_si128( (__m128i*)( dst + i ), _mm_and_si128( bits, one ) );
+    }
+#endif
+
+    for( ; i < count; i++ )
+    {
+        dst[i] = ( src[i/8] >> ( i % 8 ) ) & 1;
+    }
+}
+
+
+/**
+ * @brief      Count set bits
+ *
+ * @param [in] src   Bit field
+ * @param [in] bytes Size of \p src in bytes
+ *
+ * @return     Number of set bits
+ */
+size_t utils_count_bits( const unsigned char* src, size_t bytes )
+{
+    size_t count = 0;
+    size_t i     = 0;
+    
+    for( ; i + 8 <= bytes; i += 8 )
+    {
+        uint64_t v;
+        
+        memcpy( &v, src + i, 8 );
+#if defined( __GNUC__ )
+        count += __builtin_popcountll( v );
+#else
+        v = v - ( ( v >> 1 ) & 0x5555555555555555ULL );
+        v = ( v & 0x3333333333333333ULL ) + ( ( v >> 2 ) & 0x3333333333333333ULL );
+        v = ( v + ( v >> 4 ) ) & 0x0f0f0f0f0f0f0f0fULL;
+        count += (size_t)( ( v * 0x0101010101010101ULL ) >> 56 );
+#endif
+    }
+    
+    for( ; i < bytes; i++ )
+    {
+        for( unsigned char v = src[i]; v; v &= v - 1 )
+        {
+            count++;
+        }
+    }
+    
+    return count;
+}
+
+
+/**
+ * @brief      Reverse the byte order of each element (inplace)
+ *
+ * @param [in,out] data  Elements
+ * @param [in] count     Number of elements
+ * @param [in] elbytes   Size of one element in bytes (1, 2, 4 or 8)
+ */
+void utils_byteswap( void* data, size_t count, size_t elbytes )
+{
+    unsigned char* p = (unsigned char*)data;
+    size_t         i = 0;
+    
+    if( elbytes != 2 && elbytes != 4 && elbytes != 8 )
+    {
+        assert( elbytes == 1 );
+        return;
+    }
+    
+#if defined( UTILS_HAVE_SSSE3 )
+    const __m128i order = 
+        elbytes == 2 ? _mm_set_epi8( 14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1 ) :
+        elbytes == 4 ? _mm_set_epi8( 12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3 ) :
+                       _mm_set_epi8( 8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7 );
+    
+    for( ; ( i + 16 / elbytes ) <= count; i += 16 / elbytes )
+    {
+        __m128i* v = (__m128i*)( p + i * elbytes );
+        _mm_storeu_si128( v, _mm_shuffle_epi8( _mm_loadu_si128( v ), order ) );
+    }
+#elif defined( UTILS_HAVE_SSE2 )
+    // swap bytes within 16 bit words, then reverse the words of each element
+    for( ; ( i + 16 / elbytes ) <= count; i += 16 / elbytes )
+    {
+        __m128i* v = (__m128i*)( p + i * elbytes );
+        __m128i  x = _mm_loadu_si128( v );
+        
+        x = _mm_or_si128( _mm_slli_epi16( x, 8 ), _mm_srli_epi16( x, 8 ) );
+        
+        if( elbytes == 4 )
+        {
+            x = _mm_shufflehi_epi16( _mm_shufflelo_epi16( x, _MM_SHUFFLE( 2, 3, 0, 1 ) ), _MM_SHUFFLE( 2, 3, 0, 1 ) );
+        }
+        else if( elbytes == 8 )
+        {
+            x = _mm_shufflehi_epi16( _mm_shufflelo_epi16( x, _MM_SHUFFLE( 0, 1, 2, 3 ) ), _MM_SHUFFLE( 0, 1, 2, 3 ) );
+        }
+        
+        _mm_storeu_si128( v, x );
+    }
+#endif
+
+    for( ; i < count; i++ )
+    {
+        unsigned char* el = p + i * elbytes;
+        
+        for( size_t k = 0; k < elbytes / 2; k++ )
+        {
+            unsigned char tmp     = el[k];
+            el[k]                 = el[elbytes - 1 - k];
+            el[elbytes - 1 - k]   = tmp;
+        }
+    }
+}
+
+
 
 /** 
  * @file
@@ -341,6 +558,10 @@ void utils_free_ptr( T *&pmxarr )
  * @fn utils_get_cpu_time
  * @brief Returns user mode time of current process in seconds 
  * @returns Time in seconds
+ *
+ * @fn utils_sleep_ms
+ * @brief Suspends the calling thread (sqlite3_sleep() rounds up to seconds without HAVE_USLEEP)
+ * @param ms Time in milliseconds
  */
 
 // Windows
@@ -385,6 +606,11 @@ double utils_get_cpu_time()
     }
 }
 
+void utils_sleep_ms( int ms )
+{
+    Sleep( (DWORD)ms );
+}
+
 //  Posix/Linux
 #else
 #include <time.h>
@@ -406,6 +632,15 @@ double utils_get_cpu_time()
 {
     return (double)clock() / CLOCKS_PER_SEC;
 }
+
+void utils_sleep_ms( int ms )
+{
+    struct timespec ts;
+    
+    ts.tv_sec  = ms / 1000;
+    ts.tv_nsec = ( ms % 1000 ) * 1000000L;
+    nanosleep( &ts, NULL );
+}
 #endif
 
 
@@ -187,7 +187,8 @@ public:
         TC_SIMPLE,          ///< single non-complex value, char or simple string (SQLite simple types)
         TC_SIMPLE_VECTOR,   ///< non-complex numeric vectors (SQLite BLOB)
         TC_SIMPLE_ARRAY,    ///< multidimensional non-complex numeric or char arrays (SQLite typed BLOB)
-        TC_COMPLEX,         ///< structs, cells, complex data (SQLite typed ByteStream BLOB)
+        TC_TYPED_ARRAY,     ///< complex numeric arrays and sparse matrices (SQLite typed BLOB only)
+        TC_COMPLEX,         ///< structs, cells (SQLite typed ByteStream BLOB)
         TC_UNSUPP = -1      ///< all other (unsuppored types)
     } type_complexity_e;
 
@@ -536,11 +537,6 @@ public:
         {
             case  mxDOUBLE_CLASS:
             case  mxSINGLE_CLASS:
-                if( mxIsComplex( m_pcItem ) )
-                {
-                    return TC_COMPLEX;
-                }
-                /* fallthrough */
             case mxLOGICAL_CLASS:
             case    mxINT8_CLASS:
             case   mxUINT8_CLASS:
@@ -550,6 +546,11 @@ public:
             case  mxUINT32_CLASS:
             case   mxINT64_CLASS:
             case  mxUINT64_CLASS:
+                // complex and sparse arrays need typed BLOBs to be stored natively
+                if( mxIsComplex( m_pcItem ) || mxIsSparse( m_pcItem ) )
+                {
+                    return TC_TYPED_ARRAY;
+                }
                 if( IsScalar() ) return TC_SIMPLE;
                 return IsVector() ? TC_SIMPLE_VECTOR : TC_SIMPLE_ARRAY;
             case    mxCHAR_CLASS:
@@ -711,7 +712,14 @@ public:
         {
             switch( ClassID() )
             {
-                case mxINT64_CLASS : return *( (sqlite3_int64*)  Data() );
+                case mxINT8_CLASS  :  return (sqlite3_int64) *( (int8_t*)   Data() );
+                case mxUINT8_CLASS :  return (sqlite3_int64) *( (uint8_t*)  Data() );
+                case mxINT16_CLASS :  return (sqlite3_int64) *( (int16_t*)  Data() );
+                case mxUINT16_CLASS:  return (sqlite3_int64) *( (uint16_t*) Data() );
+                case mxINT32_CLASS :  return (sqlite3_int64) *( (int32_t*)  Data() );
+                case mxUINT32_CLASS:  return (sqlite3_int64) *( (uint32_t*) Data() );
+                case mxINT64_CLASS :  return *( (sqlite3_int64*)  Data() );
+                case mxLOGICAL_CLASS: return (sqlite3_int64) mxIsLogicalScalarTrue( m_pcItem );
 
                 default: 
                     assert( false );